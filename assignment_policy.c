@@ -0,0 +1,490 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "assignment_policy.h"
+#include "visitor_room.h"
+#include "trace.h"
+#include "fixed_alloc.h"
+
+#define UNDEFINED -1
+#define RANDOM_SEED 2463534242u
+
+static int compare_activities(AssignmentIndex *index, int first, int second);
+
+static FreeSlots *free_slots_of(AssignmentIndex *index, int activity_idx);
+
+static void swap_slots(AssignmentIndex *index, FreeSlots *free_slots,
+                       int first, int second);
+
+static void sift_up(AssignmentIndex *index, FreeSlots *free_slots,
+                    int position);
+
+static void sift_down(AssignmentIndex *index, FreeSlots *free_slots,
+                      int position);
+
+static int choose_from_heap(FreeSlots *free_slots);
+
+static int choose_at_random(AssignmentIndex *index, Level level);
+
+/**
+ * initializes an empty index over the activities of a room with the
+ * lexicographic policy. the slots of all the levels and the positions are
+ * allocated as a single block.
+ * @param index - ptr to the index to initialize
+ * @param activities - the activities table of the room
+ * @param packed - the packed activities table of the room
+ * @param num_activities - the num of activities in the room
+ * @return NULL_PARAMETER: if the ptr to index or activities are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_assignment_index(AssignmentIndex *index,
+                             struct SChallengeActivity **activities,
+                             PackedActivity *packed, int num_activities) {
+    assert(index != NULL && activities != NULL && packed != NULL);
+    if (index == NULL || activities == NULL || packed == NULL) {
+        return NULL_PARAMETER;
+    }
+    index->capacity = 0;
+    index->num_activities = 0;
+    for (int level = Easy; level < All_Levels; ++level) {
+        index->free_slots[level].slots = NULL;
+        index->free_slots[level].size = 0;
+    }
+    index->positions = NULL;
+    Result result = assignment_index_reserve(index, activities, packed,
+                                             num_activities);
+    if (result != OK) {
+        return result;
+    }
+    for (int i = 0; i < num_activities; ++i) {
+        index->positions[i] = UNDEFINED;
+    }
+    index->policy = LEXICOGRAPHIC_POLICY;
+    index->num_activities = num_activities;
+    index->assignment_clock = 0;
+    index->random_state = RANDOM_SEED;
+    return OK;
+}
+
+/**
+ * makes room in the index for a given num of activities, after the
+ * activities tables of the room were grown. the slots and positions are
+ * moved to a bigger block, the activities themselves are never moved.
+ * @param index - ptr to the index
+ * @param activities - the activities table of the room
+ * @param packed - the packed activities table of the room
+ * @param capacity - the num of activities the index should have room for
+ * @return NULL_PARAMETER: if the ptr to index or activities are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result assignment_index_reserve(AssignmentIndex *index,
+                                struct SChallengeActivity **activities,
+                                PackedActivity *packed, int capacity) {
+    assert(index != NULL && activities != NULL && packed != NULL);
+    if (index == NULL || activities == NULL || packed == NULL) {
+        return NULL_PARAMETER;
+    }
+    index->activities = activities;
+    index->packed = packed;
+    if (capacity <= index->capacity) {
+        return OK;
+    }
+    int *block = malloc((size_t) (All_Levels + 1) * capacity *
+                        sizeof(*block));
+    if (block == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    //the slots of the easy level are at the start of the old block
+    int *old_block = index->free_slots[Easy].slots;
+    for (int level = Easy; level < All_Levels; ++level) {
+        FreeSlots *free_slots = index->free_slots + level;
+        if (free_slots->size > 0) {
+            memcpy(block + level * capacity, free_slots->slots,
+                   free_slots->size * sizeof(*block));
+        }
+        free_slots->slots = block + level * capacity;
+    }
+    if (index->num_activities > 0) {
+        memcpy(block + All_Levels * capacity, index->positions,
+               index->num_activities * sizeof(*block));
+    }
+    free(old_block);
+    index->positions = block + All_Levels * capacity;
+    index->capacity = capacity;
+    return OK;
+}
+
+/**
+ * adds the last activity of the activities table to the index, it is taken
+ * until it is released. the index must have room for it.
+ * @param index - ptr to the index
+ */
+void assignment_index_append(AssignmentIndex *index) {
+    assert(index != NULL && index->num_activities < index->capacity);
+    index->positions[index->num_activities] = UNDEFINED;
+    index->num_activities++;
+}
+
+/**
+ * removes a taken activity from the index. the last activity of the
+ * activities table takes its idx, as it does in the table of the room.
+ * @param index - ptr to the index
+ * @param activity_idx - the idx of the activity in the room
+ */
+void assignment_index_remove(AssignmentIndex *index, int activity_idx) {
+    assert(index != NULL && activity_idx >= 0 &&
+           activity_idx < index->num_activities &&
+           index->positions[activity_idx] == UNDEFINED);
+    int last_idx = index->num_activities - 1;
+    int position = index->positions[last_idx];
+    if (position != UNDEFINED) {
+        free_slots_of(index, last_idx)->slots[position] = activity_idx;
+    }
+    index->positions[activity_idx] = position;
+    index->positions[last_idx] = UNDEFINED;
+    index->num_activities--;
+}
+
+/**
+ * frees the slots of an index.
+ * @param index - ptr to the index
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         OK: if everything went well
+ */
+Result reset_assignment_index(AssignmentIndex *index) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(index->free_slots[Easy].slots);
+    for (int level = Easy; level < All_Levels; ++level) {
+        index->free_slots[level].slots = NULL;
+        index->free_slots[level].size = 0;
+    }
+    index->positions = NULL;
+    index->activities = NULL;
+    index->packed = NULL;
+    index->num_activities = 0;
+    index->capacity = 0;
+    return OK;
+}
+
+/**
+ * switches the policy of an index and reorders the free activities by it,
+ * in O(n).
+ * @param index - ptr to the index
+ * @param policy - the wanted policy
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         ILLEGAL_PARAMETER: if the policy is not one of AssignmentPolicy
+ *         OK: if everything went well
+ */
+Result assignment_index_set_policy(AssignmentIndex *index,
+                                   AssignmentPolicy policy) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (policy < LEXICOGRAPHIC_POLICY || policy > RANDOM_POLICY) {
+        return ILLEGAL_PARAMETER;
+    }
+    index->policy = policy;
+    if (policy == RANDOM_POLICY) {
+        return OK;
+    }
+    for (int level = Easy; level < All_Levels; ++level) {
+        FreeSlots *free_slots = index->free_slots + level;
+        for (int i = free_slots->size / 2 - 1; i >= 0; --i) {
+            sift_down(index, free_slots, i);
+        }
+    }
+    return OK;
+}
+
+/**
+ * adds an activity that became free to the index, an activity whose booking
+ * window is open is left out until the window ends.
+ * @param index - ptr to the index
+ * @param activity_idx - the idx of the activity in the room
+ */
+void assignment_index_release(AssignmentIndex *index, int activity_idx) {
+    assert(index != NULL && activity_idx >= 0 &&
+           activity_idx < index->num_activities);
+    if (index->positions[activity_idx] != UNDEFINED ||
+        index->packed[activity_idx].level == UNDEFINED ||
+        index->packed[activity_idx].booked) {
+        return;
+    }
+    FreeSlots *free_slots = free_slots_of(index, activity_idx);
+    free_slots->slots[free_slots->size] = activity_idx;
+    index->positions[activity_idx] = free_slots->size;
+    free_slots->size++;
+    if (index->policy != RANDOM_POLICY) {
+        sift_up(index, free_slots, free_slots->size - 1);
+    }
+}
+
+/**
+ * removes an activity that was given to a visitor from the index, and marks
+ * it as the most recently assigned one for the round robin policy.
+ * @param index - ptr to the index
+ * @param activity_idx - the idx of the activity in the room
+ */
+void assignment_index_take(AssignmentIndex *index, int activity_idx) {
+    assert(index != NULL && activity_idx >= 0 &&
+           activity_idx < index->num_activities);
+    index->activities[activity_idx]->last_assigned =
+            ++index->assignment_clock;
+    assignment_index_withdraw(index, activity_idx);
+}
+
+/**
+ * removes a free activity from the index without assigning it, so it can be
+ * released again after the level of its challenge has changed or its booking
+ * window has ended.
+ * @param index - ptr to the index
+ * @param activity_idx - the idx of the activity in the room
+ */
+void assignment_index_withdraw(AssignmentIndex *index, int activity_idx) {
+    assert(index != NULL && activity_idx >= 0 &&
+           activity_idx < index->num_activities);
+    int position = index->positions[activity_idx];
+    if (position == UNDEFINED) {
+        return;
+    }
+    FreeSlots *free_slots = free_slots_of(index, activity_idx);
+    swap_slots(index, free_slots, position, free_slots->size - 1);
+    free_slots->size--;
+    index->positions[activity_idx] = UNDEFINED;
+    //the last slot took the place of the activity and may be out of order
+    if (position < free_slots->size && index->policy != RANDOM_POLICY) {
+        int moved_idx = free_slots->slots[position];
+        sift_up(index, free_slots, position);
+        sift_down(index, free_slots, index->positions[moved_idx]);
+    }
+}
+
+/**
+ * restores the order of a free activity after a field of its challenge that
+ * the policy depends on has changed.
+ * @param index - ptr to the index
+ * @param activity_idx - the idx of the activity in the room
+ */
+void assignment_index_update(AssignmentIndex *index, int activity_idx) {
+    assert(index != NULL && activity_idx >= 0 &&
+           activity_idx < index->num_activities);
+    if (index->positions[activity_idx] == UNDEFINED ||
+        index->policy == RANDOM_POLICY) {
+        return;
+    }
+    FreeSlots *free_slots = free_slots_of(index, activity_idx);
+    sift_up(index, free_slots, index->positions[activity_idx]);
+    sift_down(index, free_slots, index->positions[activity_idx]);
+}
+
+/**
+ * chooses a free activity of a level by the policy of the index in O(1),
+ * booked activities are not in the index while their window is open. the
+ * chosen activity stays in the index until it is taken.
+ * @param index - ptr to the index
+ * @param level - wanted level of challenge
+ * @return the idx of the activity, UNDEFINED if there is none
+ */
+int assignment_index_choose(AssignmentIndex *index, Level level) {
+    assert(index != NULL);
+    TRACE_BEGIN(assignment_index_choose);
+    int chosen = UNDEFINED;
+    if (index->policy == RANDOM_POLICY) {
+        chosen = choose_at_random(index, level);
+    } else if (level != All_Levels) {
+        chosen = choose_from_heap(index->free_slots + level);
+    } else {
+        for (int i = Easy; i < All_Levels; ++i) {
+            int candidate = choose_from_heap(index->free_slots + i);
+            if (candidate != UNDEFINED && (chosen == UNDEFINED ||
+                compare_activities(index, candidate, chosen) < 0)) {
+                chosen = candidate;
+            }
+        }
+    }
+    TRACE_END(assignment_index_choose);
+    return chosen;
+}
+
+/**
+ * returns the num of free activities of a level.
+ * @param index - ptr to the index
+ * @param level - wanted level of challenge, All_Levels counts all of them
+ * @return the num of free activities
+ */
+int assignment_index_num_free(AssignmentIndex *index, Level level) {
+    assert(index != NULL);
+    if (level != All_Levels) {
+        return index->free_slots[level].size;
+    }
+    int count = 0;
+    for (int i = Easy; i < All_Levels; ++i) {
+        count += index->free_slots[i].size;
+    }
+    return count;
+}
+
+/**
+ * compares two activities by the policy of the index, names are compared
+ * by their ranks in the room.
+ * @param index - ptr to the index
+ * @param first - the idx of the first activity
+ * @param second - the idx of the second activity
+ * @return negative if the first should be chosen before the second, positive
+ *         otherwise
+ */
+static int compare_activities(AssignmentIndex *index, int first, int second) {
+    Challenge *first_challenge = NULL, *second_challenge = NULL;
+    if (index->policy == LEAST_VISITED_POLICY ||
+        index->policy == FASTEST_BEST_TIME_POLICY) {
+        first_challenge = challenge_at(index->activities[first]->challenge);
+        second_challenge = challenge_at(index->activities[second]->challenge);
+    }
+    int first_key = 0, second_key = 0;
+    switch (index->policy) {
+        case LEAST_VISITED_POLICY:
+            first_key = first_challenge->num_visits;
+            second_key = second_challenge->num_visits;
+            break;
+        case FASTEST_BEST_TIME_POLICY:
+            //a best time of 0 means the challenge was never finished
+            first_key = first_challenge->best_time == 0 ? INT_MAX :
+                        first_challenge->best_time;
+            second_key = second_challenge->best_time == 0 ? INT_MAX :
+                         second_challenge->best_time;
+            break;
+        case ROUND_ROBIN_POLICY:
+            first_key = index->activities[first]->last_assigned;
+            second_key = index->activities[second]->last_assigned;
+            break;
+        default:
+            break;
+    }
+    if (first_key != second_key) {
+        return first_key < second_key ? -1 : 1;
+    }
+    first_key = index->packed[first].name_rank;
+    second_key = index->packed[second].name_rank;
+    if (first_key != second_key) {
+        return first_key < second_key ? -1 : 1;
+    }
+    return first - second;
+}
+
+/**
+ * returns the free slots of the level of an activity.
+ * @param index - ptr to the index
+ * @param activity_idx - the idx of the activity
+ * @return ptr to the free slots
+ */
+static FreeSlots *free_slots_of(AssignmentIndex *index, int activity_idx) {
+    Level level = (Level) index->packed[activity_idx].level;
+    assert(level >= Easy && level < All_Levels);
+    return index->free_slots + level;
+}
+
+/**
+ * swaps two slots and updates the positions of their activities.
+ * @param index - ptr to the index
+ * @param free_slots - the slots of the level
+ * @param first - the first position
+ * @param second - the second position
+ */
+static void swap_slots(AssignmentIndex *index, FreeSlots *free_slots,
+                       int first, int second) {
+    int activity_idx = free_slots->slots[first];
+    free_slots->slots[first] = free_slots->slots[second];
+    free_slots->slots[second] = activity_idx;
+    index->positions[free_slots->slots[first]] = first;
+    index->positions[free_slots->slots[second]] = second;
+}
+
+/**
+ * moves a slot up the heap until its parent precedes it.
+ * @param index - ptr to the index
+ * @param free_slots - the heap of the level
+ * @param position - the position of the slot
+ */
+static void sift_up(AssignmentIndex *index, FreeSlots *free_slots,
+                    int position) {
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (compare_activities(index, free_slots->slots[position],
+                               free_slots->slots[parent]) >= 0) {
+            return;
+        }
+        swap_slots(index, free_slots, position, parent);
+        position = parent;
+    }
+}
+
+/**
+ * moves a slot down the heap until it precedes its children.
+ * @param index - ptr to the index
+ * @param free_slots - the heap of the level
+ * @param position - the position of the slot
+ */
+static void sift_down(AssignmentIndex *index, FreeSlots *free_slots,
+                      int position) {
+    while (1) {
+        int smallest = position;
+        for (int child = 2 * position + 1;
+             child <= 2 * position + 2 && child < free_slots->size; ++child) {
+            if (compare_activities(index, free_slots->slots[child],
+                                   free_slots->slots[smallest]) < 0) {
+                smallest = child;
+            }
+        }
+        if (smallest == position) {
+            return;
+        }
+        swap_slots(index, free_slots, position, smallest);
+        position = smallest;
+    }
+}
+
+/**
+ * returns the first activity of a heap.
+ * @param free_slots - the heap of the level
+ * @return the idx of the activity, UNDEFINED if the heap is empty
+ */
+static int choose_from_heap(FreeSlots *free_slots) {
+    return free_slots->size > 0 ? free_slots->slots[0] : UNDEFINED;
+}
+
+/**
+ * chooses a uniformly random free activity of a level. the random sequence
+ * is private to the index, so a room makes the same choices when the same
+ * events are replayed.
+ * @param index - ptr to the index
+ * @param level - wanted level of challenge
+ * @return the idx of the activity, UNDEFINED if there is none
+ */
+static int choose_at_random(AssignmentIndex *index, Level level) {
+    Level slot_level = level == All_Levels ? Easy : level;
+    int total = assignment_index_num_free(index, level);
+    if (total == 0) {
+        return UNDEFINED;
+    }
+    //xorshift32
+    index->random_state ^= index->random_state << 13;
+    index->random_state ^= index->random_state >> 17;
+    index->random_state ^= index->random_state << 5;
+    int slot = (int) (index->random_state % (unsigned int) total);
+    //the free slots of the levels are walked as one array
+    while (slot >= index->free_slots[slot_level].size) {
+        slot -= index->free_slots[slot_level].size;
+        slot_level++;
+    }
+    return index->free_slots[slot_level].slots[slot];
+}
@@ -0,0 +1,79 @@
+#ifndef ASSIGNMENT_POLICY_H_
+#define ASSIGNMENT_POLICY_H_
+
+#include "constants.h"
+
+/*
+ * the rule by which a room chooses a free challenge for an arriving visitor:
+ * LEXICOGRAPHIC_POLICY - the lexicographically smallest name
+ * LEAST_VISITED_POLICY - the challenge with the fewest visits
+ * FASTEST_BEST_TIME_POLICY - the challenge with the lowest best time, ones
+ *                            that were never finished come last
+ * ROUND_ROBIN_POLICY - the challenge that was assigned the longest ago
+ * RANDOM_POLICY - a uniformly random challenge
+ * ties are broken lexicographically.
+ */
+typedef enum EAssignmentPolicy {LEXICOGRAPHIC_POLICY, LEAST_VISITED_POLICY,
+    FASTEST_BEST_TIME_POLICY, ROUND_ROBIN_POLICY, RANDOM_POLICY
+} AssignmentPolicy;
+
+struct SChallengeActivity;
+struct SPackedActivity;
+
+/*
+ * the free activities of one level of a room. a binary heap ordered by the
+ * policy, or an unordered bag for the random policy.
+ */
+typedef struct SFreeSlots
+{
+   int *slots;
+   int size;
+} FreeSlots;
+
+
+/*
+ * the free activities of a room by level, so a challenge is chosen in
+ * O(log n) without scanning the room. positions maps an activity idx to its
+ * place in the slots of its level, -1 while it is taken. activities and packed
+ * are the activities tables of the room, the index has room for capacity of
+ * them.
+ */
+typedef struct SAssignmentIndex
+{
+   AssignmentPolicy policy;
+   struct SChallengeActivity **activities;
+   struct SPackedActivity *packed;
+   int num_activities;
+   int capacity;
+   FreeSlots free_slots[All_Levels];
+   int *positions;
+   int assignment_clock;
+   unsigned int random_state;
+} AssignmentIndex;
+
+
+Result init_assignment_index(AssignmentIndex *index, struct SChallengeActivity **activities, struct SPackedActivity *packed, int num_activities);
+
+Result reset_assignment_index(AssignmentIndex *index);
+
+Result assignment_index_reserve(AssignmentIndex *index, struct SChallengeActivity **activities, struct SPackedActivity *packed, int capacity);
+
+void assignment_index_append(AssignmentIndex *index);
+
+void assignment_index_remove(AssignmentIndex *index, int activity_idx);
+
+Result assignment_index_set_policy(AssignmentIndex *index, AssignmentPolicy policy);
+
+void assignment_index_release(AssignmentIndex *index, int activity_idx);
+
+void assignment_index_take(AssignmentIndex *index, int activity_idx);
+
+void assignment_index_withdraw(AssignmentIndex *index, int activity_idx);
+
+void assignment_index_update(AssignmentIndex *index, int activity_idx);
+
+int assignment_index_choose(AssignmentIndex *index, Level level);
+
+int assignment_index_num_free(AssignmentIndex *index, Level level);
+
+#endif // ASSIGNMENT_POLICY_H_
@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "booking.h"
+#include "fixed_alloc.h"
+
+#define INITIAL_CAPACITY 4
+
+static int first_ending_after(BookingCalendar *calendar, int time);
+
+static int first_visitor_booking(VisitorBookings *bookings, int visitor_id,
+                                 int start_time);
+
+/**
+ * initializes an empty calendar, no memory is allocated until the first
+ * booking is added.
+ * @param calendar - ptr to the calendar to initialize
+ */
+void init_booking_calendar(BookingCalendar *calendar) {
+    assert(calendar != NULL);
+    calendar->bookings = booking_link(NULL);
+    calendar->num_bookings = 0;
+    calendar->capacity = 0;
+}
+
+/**
+ * frees all the bookings of a calendar.
+ * @param calendar - ptr to the calendar
+ * @return NULL_PARAMETER: if the ptr to calendar is NULL
+ *         OK: if everything went well
+ */
+Result reset_booking_calendar(BookingCalendar *calendar) {
+    assert(calendar != NULL);
+    if (calendar == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(booking_at(calendar->bookings));
+    init_booking_calendar(calendar);
+    return OK;
+}
+
+/**
+ * adds a booking of the window [start_time, end_time) to the calendar.
+ * @param calendar - ptr to the calendar
+ * @param start_time - the first time of the window
+ * @param end_time - the time in which the window ends
+ * @param visitor_id - the id of the visitor that booked the window
+ * @return NULL_PARAMETER: if the ptr to calendar is NULL
+ *         ILLEGAL_TIME: if end_time is not greater than start_time
+ *         NO_AVAILABLE_CHALLENGES: if the window overlaps another booking
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result booking_calendar_add(BookingCalendar *calendar, int start_time,
+                            int end_time, int visitor_id) {
+    assert(calendar != NULL);
+    if (calendar == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (end_time <= start_time) {
+        return ILLEGAL_TIME;
+    }
+    //the only booking that may overlap is the first one ending after start
+    int idx = first_ending_after(calendar, start_time);
+    if (idx < calendar->num_bookings &&
+        booking_at(calendar->bookings)[idx].start_time < end_time) {
+        return NO_AVAILABLE_CHALLENGES;
+    }
+    if (calendar->num_bookings == calendar->capacity) {
+        int capacity = calendar->capacity == 0 ? INITIAL_CAPACITY :
+                       2 * calendar->capacity;
+        Booking *bookings = realloc(booking_at(calendar->bookings),
+                                    capacity * sizeof(*bookings));
+        if (bookings == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        calendar->bookings = booking_link(bookings);
+        calendar->capacity = capacity;
+    }
+    Booking *bookings = booking_at(calendar->bookings);
+    memmove(bookings + idx + 1, bookings + idx,
+            (calendar->num_bookings - idx) * sizeof(*bookings));
+    bookings[idx].start_time = start_time;
+    bookings[idx].end_time = end_time;
+    bookings[idx].visitor_id = visitor_id;
+    calendar->num_bookings++;
+    return OK;
+}
+
+/**
+ * removes the booking that starts at a given time.
+ * @param calendar - ptr to the calendar
+ * @param start_time - the start time of the booking
+ * @return NULL_PARAMETER: if the ptr to calendar is NULL
+ *         ILLEGAL_PARAMETER: if no booking starts at start_time
+ *         OK: if everything went well
+ */
+Result booking_calendar_remove(BookingCalendar *calendar, int start_time) {
+    assert(calendar != NULL);
+    if (calendar == NULL) {
+        return NULL_PARAMETER;
+    }
+    int idx = first_ending_after(calendar, start_time);
+    if (idx == calendar->num_bookings ||
+        booking_at(calendar->bookings)[idx].start_time != start_time) {
+        return ILLEGAL_PARAMETER;
+    }
+    Booking *bookings = booking_at(calendar->bookings);
+    memmove(bookings + idx, bookings + idx + 1,
+            (calendar->num_bookings - idx - 1) * sizeof(*bookings));
+    calendar->num_bookings--;
+    return OK;
+}
+
+/**
+ * finds the booking whose window contains a given time.
+ * @param calendar - ptr to the calendar
+ * @param time - the wanted time
+ * @return ptr to the booking, NULL if the time is not booked
+ */
+Booking *booking_calendar_at(BookingCalendar *calendar, int time) {
+    assert(calendar != NULL);
+    if (calendar->num_bookings == 0) {
+        return NULL;
+    }
+    int idx = first_ending_after(calendar, time);
+    Booking *bookings = booking_at(calendar->bookings);
+    if (idx < calendar->num_bookings && bookings[idx].start_time <= time) {
+        return bookings + idx;
+    }
+    return NULL;
+}
+
+/**
+ * finds the first time from which a window of a given length is not booked.
+ * @param calendar - ptr to the calendar
+ * @param after_time - the earliest time the window may start
+ * @param duration - the length of the window
+ * @return the start time of the first free window
+ */
+int booking_calendar_first_free(BookingCalendar *calendar, int after_time,
+                                int duration) {
+    assert(calendar != NULL);
+    Booking *bookings = booking_at(calendar->bookings);
+    int time = after_time;
+    for (int i = first_ending_after(calendar, after_time);
+         i < calendar->num_bookings; ++i) {
+        if (bookings[i].start_time >= time + duration) {
+            break;
+        }
+        time = bookings[i].end_time;
+    }
+    return time;
+}
+
+/**
+ * finds the booking whose window contains a given time or else the first
+ * one that starts after it.
+ * @param calendar - ptr to the calendar
+ * @param time - the wanted time
+ * @return ptr to the booking, NULL if there are no bookings after the time
+ */
+Booking *booking_calendar_next(BookingCalendar *calendar, int time) {
+    assert(calendar != NULL);
+    int idx = first_ending_after(calendar, time);
+    if (idx == calendar->num_bookings) {
+        return NULL;
+    }
+    return booking_at(calendar->bookings) + idx;
+}
+
+/**
+ * removes the bookings that ended before a given time.
+ * @param calendar - ptr to the calendar
+ * @param time - the current time
+ */
+void booking_calendar_prune(BookingCalendar *calendar, int time) {
+    assert(calendar != NULL);
+    int idx = first_ending_after(calendar, time);
+    if (idx == 0) {
+        return;
+    }
+    Booking *bookings = booking_at(calendar->bookings);
+    memmove(bookings, bookings + idx,
+            (calendar->num_bookings - idx) * sizeof(*bookings));
+    calendar->num_bookings -= idx;
+}
+
+/**
+ * initializes an empty index, no memory is allocated until the first booking
+ * is added.
+ * @param bookings - ptr to the index to initialize
+ */
+void init_visitor_bookings(VisitorBookings *bookings) {
+    assert(bookings != NULL);
+    bookings->bookings = visitor_booking_link(NULL);
+    bookings->num_bookings = 0;
+    bookings->capacity = 0;
+}
+
+/**
+ * frees all the bookings of an index.
+ * @param bookings - ptr to the index
+ * @return NULL_PARAMETER: if the ptr to bookings is NULL
+ *         OK: if everything went well
+ */
+Result reset_visitor_bookings(VisitorBookings *bookings) {
+    assert(bookings != NULL);
+    if (bookings == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(visitor_booking_at(bookings->bookings));
+    init_visitor_bookings(bookings);
+    return OK;
+}
+
+/**
+ * adds a booking of an activity to the index, in O(log n) and a move of the
+ * bookings after it.
+ * @param bookings - ptr to the index
+ * @param visitor_id - the id of the visitor that booked the activity
+ * @param start_time - the first time of the window
+ * @param end_time - the time in which the window ends
+ * @param activity - link to the booked activity
+ * @return NULL_PARAMETER: if the ptr to bookings is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result visitor_bookings_add(VisitorBookings *bookings, int visitor_id,
+                            int start_time, int end_time,
+                            LINK(struct SChallengeActivity) activity) {
+    assert(bookings != NULL);
+    if (bookings == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (bookings->num_bookings == bookings->capacity) {
+        int capacity = bookings->capacity == 0 ? INITIAL_CAPACITY :
+                       2 * bookings->capacity;
+        VisitorBooking *table = realloc(visitor_booking_at(bookings->bookings),
+                                        capacity * sizeof(*table));
+        if (table == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        bookings->bookings = visitor_booking_link(table);
+        bookings->capacity = capacity;
+    }
+    int idx = first_visitor_booking(bookings, visitor_id, start_time);
+    VisitorBooking *table = visitor_booking_at(bookings->bookings);
+    memmove(table + idx + 1, table + idx,
+            (bookings->num_bookings - idx) * sizeof(*table));
+    table[idx].visitor_id = visitor_id;
+    table[idx].start_time = start_time;
+    table[idx].end_time = end_time;
+    table[idx].activity = activity;
+    bookings->num_bookings++;
+    return OK;
+}
+
+/**
+ * removes the booking of an activity from the index, a booking that is not
+ * in the index is ignored.
+ * @param bookings - ptr to the index
+ * @param visitor_id - the id of the visitor that booked the activity
+ * @param start_time - the start time of the booking
+ * @param activity - link to the booked activity
+ */
+void visitor_bookings_remove(VisitorBookings *bookings, int visitor_id,
+                             int start_time,
+                             LINK(struct SChallengeActivity) activity) {
+    assert(bookings != NULL);
+    VisitorBooking *table = visitor_booking_at(bookings->bookings);
+    //a visitor may book a few activities for the same time
+    for (int i = first_visitor_booking(bookings, visitor_id, start_time);
+         i < bookings->num_bookings && table[i].visitor_id == visitor_id &&
+         table[i].start_time == start_time; ++i) {
+        if (table[i].activity == activity) {
+            memmove(table + i, table + i + 1,
+                    (bookings->num_bookings - i - 1) * sizeof(*table));
+            bookings->num_bookings--;
+            return;
+        }
+    }
+}
+
+/**
+ * finds the first booking of a visitor, the others follow it by start time.
+ * @param bookings - ptr to the index
+ * @param visitor_id - the id of the visitor
+ * @return the idx of the booking, the idx of a booking of another visitor or
+ *         num_bookings if the visitor has no bookings
+ */
+int visitor_bookings_first(VisitorBookings *bookings, int visitor_id) {
+    assert(bookings != NULL);
+    return first_visitor_booking(bookings, visitor_id, INT_MIN);
+}
+
+/**
+ * binary search for the first booking that ends after a given time.
+ * @param calendar - ptr to the calendar
+ * @param time - the wanted time
+ * @return the idx of the booking, num_bookings if there is none
+ */
+static int first_ending_after(BookingCalendar *calendar, int time) {
+    Booking *bookings = booking_at(calendar->bookings);
+    int low = 0, high = calendar->num_bookings;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (bookings[middle].end_time <= time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * binary search for the first booking of the index that is not before a
+ * visitor and a start time.
+ * @param bookings - ptr to the index
+ * @param visitor_id - the wanted visitor
+ * @param start_time - the wanted start time
+ * @return the idx of the booking, num_bookings if there is none
+ */
+static int first_visitor_booking(VisitorBookings *bookings, int visitor_id,
+                                 int start_time) {
+    VisitorBooking *table = visitor_booking_at(bookings->bookings);
+    int low = 0, high = bookings->num_bookings;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (table[middle].visitor_id < visitor_id ||
+            (table[middle].visitor_id == visitor_id &&
+             table[middle].start_time < start_time)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
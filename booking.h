@@ -0,0 +1,87 @@
+#ifndef BOOKING_H_
+#define BOOKING_H_
+
+#include "constants.h"
+
+struct SChallengeActivity;
+
+/*
+ * a reservation of a challenge activity for the time window [start, end)
+ */
+typedef struct SBooking
+{
+   int start_time;
+   int end_time;
+   int visitor_id;
+} Booking;
+
+DEFINE_LINK(Booking, booking)
+
+
+/*
+ * the reservations of a single challenge activity, kept sorted by start time.
+ * the windows never overlap so they are sorted by end time as well.
+ */
+typedef struct SBookingCalendar
+{
+   LINK(Booking) bookings;
+   int num_bookings;
+   int capacity;
+} BookingCalendar;
+
+
+/*
+ * a booking of one of the activities of a room, as kept by the visitor
+ * bookings of the room
+ */
+typedef struct SVisitorBooking
+{
+   int visitor_id;
+   int start_time;
+   int end_time;
+   LINK(struct SChallengeActivity) activity;
+} VisitorBooking;
+
+DEFINE_LINK(VisitorBooking, visitor_booking)
+
+
+/*
+ * the bookings of all the activities of a room, kept sorted by visitor and
+ * then by start time, so the bookings of a visitor are found by a binary
+ * search instead of a walk over the activities of the room.
+ */
+typedef struct SVisitorBookings
+{
+   LINK(VisitorBooking) bookings;
+   int num_bookings;
+   int capacity;
+} VisitorBookings;
+
+
+void init_booking_calendar(BookingCalendar *calendar);
+
+Result reset_booking_calendar(BookingCalendar *calendar);
+
+Result booking_calendar_add(BookingCalendar *calendar, int start_time, int end_time, int visitor_id);
+
+Result booking_calendar_remove(BookingCalendar *calendar, int start_time);
+
+Booking *booking_calendar_at(BookingCalendar *calendar, int time);
+
+int booking_calendar_first_free(BookingCalendar *calendar, int after_time, int duration);
+
+Booking *booking_calendar_next(BookingCalendar *calendar, int time);
+
+void booking_calendar_prune(BookingCalendar *calendar, int time);
+
+void init_visitor_bookings(VisitorBookings *bookings);
+
+Result reset_visitor_bookings(VisitorBookings *bookings);
+
+Result visitor_bookings_add(VisitorBookings *bookings, int visitor_id, int start_time, int end_time, LINK(struct SChallengeActivity) activity);
+
+void visitor_bookings_remove(VisitorBookings *bookings, int visitor_id, int start_time, LINK(struct SChallengeActivity) activity);
+
+int visitor_bookings_first(VisitorBookings *bookings, int visitor_id);
+
+#endif // BOOKING_H_
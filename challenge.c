@@ -9,6 +9,7 @@
 
 
 #include "challenge.h"
+#include "fixed_alloc.h"
 
 /**
  * initializes all the fields of a 'Challenge' data type.
@@ -16,7 +17,8 @@
  * @param id - value is inserted to challenge
  * @param name - allocates and duplicate the name to the challenge
  * @param level - value is inserted to challenge
- *        best_time & num_visits are initialized to 0
+ *        best_time & num_visits are initialized to 0, the challenge is not
+ *        in any room yet
  * @return NULL_PARAMETER: if the ptr to challenge or name are NULL
  *         MEMORY_PROBLEM: if allocation problems for name have occurred
  *         OK: if everything went well
@@ -36,6 +38,8 @@ Result init_challenge(Challenge *challenge, int id, char *name, Level level) {
     challenge->level = level;
     challenge->best_time = 0;
     challenge->num_visits = 0;
+    challenge->activities = NULL_LINK;
+    challenge->system_idx = 0;
     return OK;
 }
 
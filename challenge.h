@@ -3,6 +3,7 @@
 
 #include "constants.h"
 
+struct SChallengeActivity;
 typedef struct SChallenge
 {
    int id;
@@ -10,8 +11,14 @@ typedef struct SChallenge
    Level level;
    int best_time;
    int num_visits;
+   /* the activities of the challenge in all the rooms, linked through them */
+   LINK(struct SChallengeActivity) activities;
+   /* the idx of the challenge in the challenges table of the system */
+   int system_idx;
 } Challenge;
 
+DEFINE_LINK(Challenge, challenge)
+
 Result init_challenge(Challenge *challenge, int id, char *name, Level level);
 
 Result reset_challenge(Challenge *challenge);
@@ -0,0 +1,220 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "constants.h"
+#include "server_protocol.h"
+
+#define FIRST_VISITOR_ID 1000000
+
+static int connect_to_server(char *socket_path);
+
+static size_t put_arrive(unsigned char *out, int visitor_id, int time,
+                         char *room_name);
+
+static size_t put_quit(unsigned char *out, int visitor_id, int time);
+
+static int write_all(int fd, unsigned char *data, size_t length);
+
+static int read_replies(int fd, int num_replies, int *num_ok);
+
+/**
+ * a load generator for the challenge server. sends num_requests requests,
+ * arrivals to the room and the matching quits, with pipeline_depth requests
+ * in flight, and reports the throughput.
+ * usage: challenge_load_client <socket_path> <room_name> <num_requests>
+ *        <pipeline_depth> [first_time]
+ * server_benchmark.sh runs it against a fresh server at several depths.
+ */
+int main(int argc, char **argv) {
+    if (argc != 5 && argc != 6) {
+        fprintf(stderr, "usage: %s <socket_path> <room_name> <num_requests> "
+                        "<pipeline_depth> [first_time]\n", argv[0]);
+        return 1;
+    }
+    int num_requests = atoi(argv[3]);
+    int depth = atoi(argv[4]);
+    int time = argc == 6 ? atoi(argv[5]) : 0;
+    if (num_requests < 2 || depth < 2 || strlen(argv[2]) > MAX_STRING_LEN) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+    //an arrival and its quit are always sent in the same batch
+    depth -= depth % 2;
+    int fd = connect_to_server(argv[1]);
+    if (fd < 0) {
+        perror("challenge_load_client");
+        return 1;
+    }
+    unsigned char *batch = malloc((size_t) depth * MAX_FRAME_SIZE);
+    if (batch == NULL) {
+        close(fd);
+        return 1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int sent = 0, num_ok = 0, visitor_id = FIRST_VISITOR_ID;
+    while (sent < num_requests) {
+        size_t length = 0;
+        int in_batch = 0;
+        while (in_batch < depth && sent + in_batch < num_requests) {
+            length += put_arrive(batch + length, visitor_id, time, argv[2]);
+            length += put_quit(batch + length, visitor_id, time + 1);
+            visitor_id++;
+            time++;
+            in_batch += 2;
+        }
+        if (!write_all(fd, batch, length) ||
+            !read_replies(fd, in_batch, &num_ok)) {
+            fprintf(stderr, "the server closed the connection\n");
+            break;
+        }
+        sent += in_batch;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (double) (end.tv_sec - start.tv_sec) +
+                     (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%d requests (%d OK) in %.3f s: %.0f requests/s, last time %d\n",
+           sent, num_ok, seconds, seconds > 0 ? sent / seconds : 0.0, time);
+    free(batch);
+    close(fd);
+    return 0;
+}
+
+/**
+ * connects to the server.
+ * @param socket_path - the path of the server's socket
+ * @return the file descriptor of the connection, -1 if it failed
+ */
+static int connect_to_server(char *socket_path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * writes an arrival request that accepts any level.
+ * @param out - where to write the request
+ * @param visitor_id - the id of the visitor, also used for its name
+ * @param time - the time of the arrival
+ * @param room_name - the room
+ * @return the num of bytes written
+ */
+static size_t put_arrive(unsigned char *out, int visitor_id, int time,
+                         char *room_name) {
+    char visitor_name[MAX_STRING_LEN + 1];
+    sprintf(visitor_name, "visitor_%d", visitor_id);
+    size_t length = FRAME_HEADER_SIZE;
+    out[length++] = OP_ARRIVE;
+    length += protocol_put_int(out + length, visitor_id);
+    length += protocol_put_int(out + length, All_Levels);
+    length += protocol_put_int(out + length, time);
+    length += protocol_put_string(out + length, room_name);
+    length += protocol_put_string(out + length, visitor_name);
+    protocol_put_int(out, (int) (length - FRAME_HEADER_SIZE));
+    return length;
+}
+
+/**
+ * writes a quit request.
+ * @param out - where to write the request
+ * @param visitor_id - the id of the visitor
+ * @param time - the time of the quit
+ * @return the num of bytes written
+ */
+static size_t put_quit(unsigned char *out, int visitor_id, int time) {
+    size_t length = FRAME_HEADER_SIZE;
+    out[length++] = OP_QUIT;
+    length += protocol_put_int(out + length, visitor_id);
+    length += protocol_put_int(out + length, time);
+    protocol_put_int(out, (int) (length - FRAME_HEADER_SIZE));
+    return length;
+}
+
+/**
+ * writes a whole buffer to a blocking socket.
+ * @param fd - the socket
+ * @param data - the buffer
+ * @param length - the length of the buffer
+ * @return 1 if everything was written, 0 otherwise
+ */
+static int write_all(int fd, unsigned char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return 0;
+        }
+        data += written;
+        length -= (size_t) written;
+    }
+    return 1;
+}
+
+/**
+ * reads replies from the server until a given num of them arrived.
+ * @param fd - the socket
+ * @param num_replies - the num of replies to wait for
+ * @param num_ok - ptr to the num of OK replies that needs to be updated
+ * @return 1 if all the replies arrived, 0 otherwise
+ */
+static int read_replies(int fd, int num_replies, int *num_ok) {
+    static unsigned char buffer[64 * 1024];
+    static size_t buffered = 0;
+    while (num_replies > 0) {
+        size_t used = 0;
+        while (num_replies > 0 && buffered - used >= FRAME_HEADER_SIZE) {
+            int length = 0;
+            const unsigned char *header = buffer + used;
+            protocol_get_int(&header, header + FRAME_HEADER_SIZE, &length);
+            if (buffered - used < FRAME_HEADER_SIZE + (size_t) length) {
+                break;
+            }
+            if (length > 0 && *header == OK) {
+                (*num_ok)++;
+            }
+            used += FRAME_HEADER_SIZE + (size_t) length;
+            num_replies--;
+        }
+        memmove(buffer, buffer + used, buffered - used);
+        buffered -= used;
+        if (num_replies == 0) {
+            break;
+        }
+        ssize_t received = read(fd, buffer + buffered,
+                                sizeof(buffer) - buffered);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return 0;
+        }
+        buffered += (size_t) received;
+    }
+    return 1;
+}
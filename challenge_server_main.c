@@ -0,0 +1,250 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "challenge_system.h"
+#include "server_connection.h"
+#include "trace.h"
+
+#define MAX_EVENTS 64
+
+/*
+ * a client connection in the list of connections, writing tells whether
+ * the socket is registered for EPOLLOUT because replies are pending
+ */
+typedef struct SConnection {
+    ServerConnection server;
+    int writing;
+    struct SConnection *next;
+    struct SConnection *prev;
+} Connection;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop_signal(int signal_number);
+
+static int set_non_blocking(int fd);
+
+static int open_listening_socket(char *socket_path);
+
+static void accept_connections(int epoll_fd, int listen_fd,
+                               Connection *connections);
+
+static void close_connection(int epoll_fd, Connection *connection);
+
+static int handle_writable(int epoll_fd, Connection *connection);
+
+/**
+ * serves a challenge room system over a unix domain socket until SIGINT or
+ * SIGTERM, see server_protocol.h for the protocol.
+ * usage: challenge_server <init_file> <socket_path>
+ * the tracing build takes a trace file after the socket path, see trace.h.
+ */
+int main(int argc, char **argv) {
+#ifdef ESCAPY_TRACE
+    //the spans are dumped to the trace file when the server stops
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "usage: %s <init_file> <socket_path> [trace_file]\n",
+                argv[0]);
+        return 1;
+    }
+#else
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <init_file> <socket_path>\n", argv[0]);
+        return 1;
+    }
+#endif
+    ChallengeRoomSystem *sys = NULL;
+    if (create_system(argv[1], &sys) != OK) {
+        fprintf(stderr, "can't create the system from %s\n", argv[1]);
+        return 1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = open_listening_socket(argv[2]);
+    int epoll_fd = epoll_create1(0);
+    if (listen_fd < 0 || epoll_fd < 0) {
+        perror("challenge_server");
+        return 1;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+
+    //the head of the list of connections, not a connection itself
+    Connection connections;
+    connections.next = NULL;
+    struct epoll_event events[MAX_EVENTS];
+    while (!stop_requested) {
+        int num_events = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+        for (int i = 0; i < num_events; ++i) {
+            Connection *connection = events[i].data.ptr;
+            if (connection == NULL) {
+                accept_connections(epoll_fd, listen_fd, &connections);
+                continue;
+            }
+            int open = 1;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                open = server_connection_read(sys, &connection->server);
+            }
+            if (open) {
+                open = handle_writable(epoll_fd, connection);
+            }
+            if (!open) {
+                close_connection(epoll_fd, connection);
+            }
+        }
+    }
+    while (connections.next != NULL) {
+        close_connection(epoll_fd, connections.next);
+    }
+    close(epoll_fd);
+    close(listen_fd);
+    unlink(argv[2]);
+
+    char *most_popular = NULL, *best_time = NULL;
+    destroy_system(sys, sys->system_last_known_time, &most_popular,
+                   &best_time);
+    system_free(most_popular);
+    system_free(best_time);
+#ifdef ESCAPY_TRACE
+    if (argc == 4 && trace_dump(argv[3]) != OK) {
+        fprintf(stderr, "can't write the trace to %s\n", argv[3]);
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * asks the main loop to stop.
+ * @param signal_number - the signal that was received
+ */
+static void handle_stop_signal(int signal_number) {
+    (void) signal_number;
+    stop_requested = 1;
+}
+
+/**
+ * makes the operations on a file descriptor non blocking.
+ * @param fd - the file descriptor
+ * @return 0 if everything went well, -1 otherwise
+ */
+static int set_non_blocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * creates the listening socket, an old socket file in the path is removed.
+ * @param socket_path - the path of the socket
+ * @return the file descriptor of the socket, -1 if it can't be created
+ */
+static int open_listening_socket(char *socket_path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+    unlink(socket_path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0 || set_non_blocking(fd) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * accepts all the pending connections and registers them for reading.
+ * @param epoll_fd - the epoll instance
+ * @param listen_fd - the listening socket
+ * @param connections - the head of the list of connections
+ */
+static void accept_connections(int epoll_fd, int listen_fd,
+                               Connection *connections) {
+    int fd = accept(listen_fd, NULL, NULL);
+    while (fd >= 0) {
+        Connection *connection = calloc(1, sizeof(*connection));
+        if (connection == NULL || set_non_blocking(fd) != 0) {
+            free(connection);
+            close(fd);
+            return;
+        }
+        init_server_connection(&connection->server, fd);
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        connection->prev = connections;
+        connection->next = connections->next;
+        if (connections->next != NULL) {
+            connections->next->prev = connection;
+        }
+        connections->next = connection;
+        fd = accept(listen_fd, NULL, NULL);
+    }
+}
+
+/**
+ * closes a connection and frees its buffers.
+ * @param epoll_fd - the epoll instance
+ * @param connection - ptr to the connection
+ */
+static void close_connection(int epoll_fd, Connection *connection) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->server.fd, NULL);
+    close(connection->server.fd);
+    connection->prev->next = connection->next;
+    if (connection->next != NULL) {
+        connection->next->prev = connection->prev;
+    }
+    reset_server_connection(&connection->server);
+    free(connection);
+}
+
+/**
+ * writes as much of the pending replies as the socket takes, when some are
+ * left the connection waits for the socket to become writable.
+ * @param epoll_fd - the epoll instance
+ * @param connection - ptr to the connection
+ * @return 1 if the connection is still open, 0 if it should be closed
+ */
+static int handle_writable(int epoll_fd, Connection *connection) {
+    if (!server_connection_write(&connection->server)) {
+        return 0;
+    }
+    int pending = server_connection_pending(&connection->server);
+    if (pending != connection->writing) {
+        struct epoll_event event;
+        event.events = pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        event.data.ptr = connection;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->server.fd, &event);
+        connection->writing = pending;
+    }
+    return 1;
+}
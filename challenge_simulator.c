@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "venue_simulation.h"
+
+#define MAX_THREADS 64
+
+/* the replications left to run, taken by the worker threads in turn */
+typedef struct SWorkQueue
+{
+   Simulation *simulation;
+   ReplicationResult *results;
+   int next_replication;
+   pthread_mutex_t lock;
+} WorkQueue;
+
+static void *run_replications(void *argument);
+
+static void report_results(Simulation *simulation,
+                           ReplicationResult *results);
+
+static void report_statistic(const char *name, ReplicationResult *results,
+                             int num_results, size_t offset);
+
+static double t_quantile(int degrees_of_freedom);
+
+/**
+ * a discrete event simulator of a venue, for capacity planning. the rooms
+ * and challenges are read from an init file and visitors of each level
+ * arrive at random rooms and stay for random durations, driven through
+ * visitor_arrive and visitor_quit of the real system. a visitor that finds
+ * no free challenge waits in the queue of the room for its level, unless
+ * max_queue visitors already wait there, in which case it is rejected.
+ * the replications run in parallel and the report gives the mean of each
+ * measure over them with a 95% confidence interval.
+ * a level is given as <level>:<rate>:<mean_duration>[:<distribution>]
+ * where level is easy, medium, hard or any, rate is the num of arrivals per
+ * time unit and distribution is exp (the default), uniform or fixed.
+ * usage: challenge_simulator <init_file> <horizon> <replications> <threads>
+ *        <max_queue> <level>... [seed=<seed>]
+ */
+int main(int argc, char **argv) {
+    if (argc < 7) {
+        fprintf(stderr, "usage: %s <init_file> <horizon> <replications> "
+                        "<threads> <max_queue> "
+                        "<level>:<rate>:<mean_duration>[:<distribution>]... "
+                        "[seed=<seed>]\n", argv[0]);
+        return 1;
+    }
+    Simulation simulation;
+    memset(&simulation, 0, sizeof(simulation));
+    simulation.init_file = argv[1];
+    simulation.horizon = atof(argv[2]);
+    simulation.num_replications = atoi(argv[3]);
+    int num_threads = atoi(argv[4]);
+    simulation.max_queue = atoi(argv[5]);
+    simulation.seed = 1;
+    for (int i = 6; i < argc; ++i) {
+        if (strncmp(argv[i], "seed=", 5) == 0) {
+            simulation.seed = strtoul(argv[i] + 5, NULL, 10);
+        } else if (!parse_level_spec(&simulation, argv[i])) {
+            fprintf(stderr, "bad level %s\n", argv[i]);
+            return 1;
+        }
+    }
+    //the engine keeps integer times, so the horizon must fit in an int
+    if (simulation.horizon <= 0 || simulation.horizon > 1e9 ||
+        simulation.num_replications < 1 || num_threads < 1 ||
+        simulation.max_queue < 0) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+#ifdef ESCAPY_FIXED_CAPACITY
+    //the arena is not thread safe
+    num_threads = 1;
+#endif
+    if (num_threads > MAX_THREADS) {
+        num_threads = MAX_THREADS;
+    }
+    if (num_threads > simulation.num_replications) {
+        num_threads = simulation.num_replications;
+    }
+    WorkQueue work;
+    work.simulation = &simulation;
+    work.next_replication = 0;
+    work.results = calloc((size_t) simulation.num_replications,
+                          sizeof(*work.results));
+    if (work.results == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    pthread_mutex_init(&work.lock, NULL);
+    pthread_t threads[MAX_THREADS];
+    int started[MAX_THREADS];
+    //the calling thread is one of the workers
+    for (int i = 1; i < num_threads; ++i) {
+        started[i] = pthread_create(threads + i, NULL, run_replications,
+                                    &work) == 0;
+    }
+    run_replications(&work);
+    for (int i = 1; i < num_threads; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    pthread_mutex_destroy(&work.lock);
+    report_results(&simulation, work.results);
+    free(work.results);
+    return 0;
+}
+
+/**
+ * runs replications until none are left, the body of a worker thread.
+ * @param argument - ptr to the work queue
+ * @return NULL
+ */
+static void *run_replications(void *argument) {
+    WorkQueue *work = argument;
+    for (;;) {
+        pthread_mutex_lock(&work->lock);
+        int replication_idx = work->next_replication++;
+        pthread_mutex_unlock(&work->lock);
+        if (replication_idx >= work->simulation->num_replications) {
+            return NULL;
+        }
+        run_replication(work->simulation, replication_idx,
+                        work->results + replication_idx);
+    }
+}
+
+/**
+ * prints the mean of each measure over the replications that succeeded
+ * with the half width of its 95% confidence interval.
+ * @param simulation - ptr to the simulation
+ * @param results - the results of the replications
+ */
+static void report_results(Simulation *simulation,
+                           ReplicationResult *results) {
+    int num_results = 0;
+    for (int i = 0; i < simulation->num_replications; ++i) {
+        if (!results[i].failed) {
+            results[num_results++] = results[i];
+        }
+    }
+    printf("%d replications of %g time units, %d failed\n", num_results,
+           simulation->horizon, simulation->num_replications - num_results);
+    if (num_results == 0) {
+        return;
+    }
+    report_statistic("arrivals", results, num_results,
+                     offsetof(ReplicationResult, arrivals));
+    report_statistic("completed visits", results, num_results,
+                     offsetof(ReplicationResult, completed));
+    report_statistic("rejection rate", results, num_results,
+                     offsetof(ReplicationResult, rejection_rate));
+    report_statistic("mean wait", results, num_results,
+                     offsetof(ReplicationResult, mean_wait));
+    report_statistic("mean queue length", results, num_results,
+                     offsetof(ReplicationResult, mean_queue_length));
+    report_statistic("max queue length", results, num_results,
+                     offsetof(ReplicationResult, max_queue_length));
+    report_statistic("utilization", results, num_results,
+                     offsetof(ReplicationResult, utilization));
+}
+
+/**
+ * prints the mean of a measure over the replications with the half width
+ * of its 95% confidence interval, by the t distribution.
+ * @param name - the name of the measure
+ * @param results - the results of the replications
+ * @param num_results - the num of results
+ * @param offset - the offset of the measure in a result
+ */
+static void report_statistic(const char *name, ReplicationResult *results,
+                             int num_results, size_t offset) {
+    double sum = 0, sum_of_squares = 0;
+    for (int i = 0; i < num_results; ++i) {
+        double value = *(double *) ((char *) (results + i) + offset);
+        sum += value;
+        sum_of_squares += value * value;
+    }
+    double mean = sum / num_results;
+    double half_width = 0;
+    if (num_results > 1) {
+        double variance = (sum_of_squares - num_results * mean * mean) /
+                          (num_results - 1);
+        half_width = t_quantile(num_results - 1) *
+                     sqrt(variance > 0 ? variance / num_results : 0);
+    }
+    printf("%-20s %12.4f +- %.4f\n", name, mean, half_width);
+}
+
+/**
+ * returns the 0.975 quantile of the t distribution.
+ * @param degrees_of_freedom - the degrees of freedom, at least 1
+ * @return the quantile
+ */
+static double t_quantile(int degrees_of_freedom) {
+    static const double quantiles[] = {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+            2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101,
+            2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052,
+            2.048, 2.045, 2.042};
+    int num_quantiles = (int) (sizeof(quantiles) / sizeof(*quantiles));
+    return degrees_of_freedom <= num_quantiles ?
+           quantiles[degrees_of_freedom - 1] : 1.960;
+}
@@ -6,11 +6,16 @@
 #include <stdlib.h>
 #include <malloc.h>
 #include <string.h>
+#include <ctype.h>
 #include <assert.h>
 
 #include "challenge_system.h"
+#include "init_loader.h"
+#include "trace.h"
+#include "fixed_alloc.h"
 
 #define WORD_MAX_LEN 51
+#define UNDEFINED -1
 
 #define CREATE_RESULT_CHECK(result)\
     if (result != OK){\
@@ -22,6 +27,62 @@
     if (result != OK){\
         return result;\
     }
+#define JOURNAL_RECORD(sys, ...)\
+    if ((sys)->journal != NULL){\
+        journal_append((sys)->journal, __VA_ARGS__);\
+    }
+
+/* marks the arena file dirty before a change of the system, so a crash in
+   the middle of the change is not mistaken for a consistent file */
+#ifdef ESCAPY_PERSISTENT_ARENA
+#define ARENA_CHANGE() fixed_arena_begin_change()
+#else
+#define ARENA_CHANGE()
+#endif
+
+#define JOURNAL_WORD_MAX_LEN 256
+#define JOURNAL_WORD_FORMAT "%255s"
+
+/*
+ * a room of an init file that is reloaded, see reload_system. idx is its
+ * place in the file, so the first of rooms with the same name is kept.
+ * room is the room of the system with the name, NULL for a new room, and
+ * challenge_ids_hash is the hash of the ids of the challenges of the file
+ * in the room, like the one the room keeps.
+ */
+typedef struct SReloadRoom
+{
+   char *name;
+   char *challenge_ids;
+   int num_challenges;
+   int idx;
+   ChallengeRoom *room;
+   unsigned long long challenge_ids_hash;
+} ReloadRoom;
+
+/*
+ * the changes of a reload, found by check_reload before any is applied.
+ * challenges are the challenges of the file by id and rooms the rooms of
+ * the file sorted by name, the challenges and rooms of the system that are
+ * not in the file are removed.
+ */
+typedef struct SReloadPlan
+{
+   IdIndex challenges;
+   ReloadRoom *rooms;
+   int num_rooms;
+   int *removed_challenges;
+   int num_removed_challenges;
+   ChallengeRoom **removed_rooms;
+   int num_removed_rooms;
+} ReloadPlan;
+
+/* an activity of a room by the id of its challenge, see diff_room */
+typedef struct SActivityKey
+{
+   int challenge_id;
+   int occupied;
+} ActivityKey;
 
 /* deceleration for static functions */
 
@@ -31,6 +92,8 @@ static void free_system_challenges_and_previous(ChallengeRoomSystem *sys);
 
 static void free_system_rooms_and_previous(ChallengeRoomSystem *sys);
 
+static void init_system_fields(ChallengeRoomSystem *sys);
+
 static Result update_system_name(ChallengeRoomSystem *sys, FILE *input_file);
 
 static Result create_system_challenges(ChallengeRoomSystem *sys,
@@ -40,12 +103,28 @@ static Result add_challenge_to_room(ChallengeRoomSystem *sys, int challenge_id,
                                     int activity_idx, int room_idx);
 
 static Result rooms_add_challenge_activities(ChallengeRoomSystem *sys,
-                                             FILE *input_file);
+                                             FILE *input_file, int num_rooms);
 
 static Result create_system_rooms(ChallengeRoomSystem *sys, FILE *input_file);
 
+#ifndef ESCAPY_FIXED_CAPACITY
+static Result take_loaded_records(ChallengeRoomSystem *sys,
+                                  InitFileLoad *load);
+#endif
+
+static void *grow_table(void *table, int size, int *capacity,
+                        size_t element_size);
+
+static Result insert_system_challenge(ChallengeRoomSystem *sys, int id,
+                                      char *name, Level level);
+
+static Result insert_system_room(ChallengeRoomSystem *sys, char *name,
+                                 int num_challenges);
+
 static Result create_system_visitor_list_head(ChallengeRoomSystem *sys);
 
+static Result create_system_visit_history(ChallengeRoomSystem *sys);
+
 static Result system_lowest_best_time(ChallengeRoomSystem *sys,
                                       char **challenge_best_time);
 
@@ -59,6 +138,101 @@ static Result create_visitor_node(ChallengeRoomSystem *sys, char *visitor_name,
 static Result find_room_by_name(ChallengeRoomSystem *sys, char *room_name,
                                 int *room_idx);
 
+static Result arrive_at_room(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                             char *visitor_name, int visitor_id, Level level,
+                             int start_time, int wait);
+
+static Result quit_room_and_record(ChallengeRoomSystem *sys, Visitor *visitor,
+                                   int quit_time);
+
+static void drop_waiting_visitors(ChallengeRoomSystem *sys,
+                                  ChallengeRoom *room);
+
+static void start_session_timer(ChallengeRoomSystem *sys, Visitor *visitor);
+
+static Result expire_sessions(ChallengeRoomSystem *sys, int time);
+
+static void pass_booking_boundaries(ChallengeRoomSystem *sys, int time);
+
+static Result remove_room_at(ChallengeRoomSystem *sys, int room_idx);
+
+static Result index_system_names(ChallengeRoomSystem *sys);
+
+static Result window_rates(ChallengeRoomSystem *sys, RateWindow *arrivals,
+                           RateWindow *completions, int time, int span,
+                           int *num_arrivals, int *num_completions);
+
+static void record_rate(RateTable *table, int idx, int completion, int time);
+
+static void fill_challenge_match(Challenge *challenge,
+                                 ChallengeMatch *match);
+
+static void fill_room_match(ChallengeRoom *room, RoomMatch *match);
+
+static Result build_snapshot_tables(ChallengeRoomSystem *sys);
+
+static void drop_snapshot_tables(ChallengeRoomSystem *sys);
+
+static void publish_challenge(ChallengeRoomSystem *sys, Challenge *challenge);
+
+static void publish_room(ChallengeRoomSystem *sys, ChallengeRoom *room);
+
+static void unpublish_record(ChallengeRoomSystem *sys, SnapshotTable **table,
+                             int idx);
+
+static void room_changed(ChallengeRoomSystem *sys, ChallengeRoom *room);
+
+static Result build_free_slot_index(ChallengeRoomSystem *sys);
+
+static void index_free_slots(ChallengeRoomSystem *sys, ChallengeRoom *room);
+
+static Result attach_room_challenge(ChallengeRoomSystem *sys,
+                                    ChallengeRoom *room, Challenge *challenge);
+
+static Result detach_room_challenge(ChallengeRoomSystem *sys,
+                                    ChallengeRoom *room, int challenge_id);
+
+static Result check_reload(ChallengeRoomSystem *sys, InitFileLoad *load,
+                           ReloadPlan *plan);
+
+static Result check_reload_rooms(ChallengeRoomSystem *sys, ReloadPlan *plan);
+
+static Result reload_challenges(ChallengeRoomSystem *sys, InitFileLoad *load,
+                                IdIndex *new_challenges);
+
+static Result reload_rooms(ChallengeRoomSystem *sys, ReloadPlan *plan);
+
+static int room_definition_changed(ReloadRoom *definition);
+
+static Result diff_room(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                        ReloadRoom *definition, IdIndex *new_challenges,
+                        int apply);
+
+static ReloadRoom *find_reload_room(ReloadRoom *rooms, int num_rooms,
+                                    char *name);
+
+static int compare_reload_rooms(const void *first, const void *second);
+
+static int compare_activity_keys(const void *first, const void *second);
+
+static int compare_ids(const void *first, const void *second);
+
+static Result apply_event(ChallengeRoomSystem *sys, BufferedEvent *event);
+
+static void apply_buffered_events(ChallengeRoomSystem *sys, int watermark);
+
+static Result ingest_event_time(ChallengeRoomSystem *sys, int time,
+                                int *watermark);
+
+static int replay_journal_record(ChallengeRoomSystem *sys, FILE *input,
+                                 char type);
+
+static long replay_journal(ChallengeRoomSystem *sys, char *journal_file);
+
+static int journal_accepts_name(ChallengeRoomSystem *sys, const char *name);
+
+static void discard_system(ChallengeRoomSystem **sys);
+
 /**
  * creates the system according to the specifications from the file
  * @param init_file - the file with all the specifications
@@ -77,9 +251,12 @@ Result create_system(char *init_file, ChallengeRoomSystem **sys) {
         return NULL_PARAMETER;
     }
     (*sys) = malloc(sizeof(**sys));
-    (*sys)->system_last_known_time = 0;
-    (*sys)->system_num_rooms = 0;
-    (*sys)->system_num_challenges = 0;
+    if ((*sys) == NULL) {
+        //the persistent build has no arena until one is attached
+        fclose(input);
+        return MEMORY_PROBLEM;
+    }
+    init_system_fields(*sys);
     Result result = update_system_name(*sys, input);
     CREATE_RESULT_CHECK(result);
     result = create_system_challenges(*sys, input);
@@ -88,10 +265,239 @@ Result create_system(char *init_file, ChallengeRoomSystem **sys) {
     CREATE_RESULT_CHECK(result);
     result = create_system_visitor_list_head(*sys);
     CREATE_RESULT_CHECK(result);
+    result = create_system_visit_history(*sys);
+    CREATE_RESULT_CHECK(result);
     fclose(input);
     return OK;
 }
 
+/**
+ * creates the system from the init file like create_system, the file is
+ * parsed and its rooms are linked to the challenges on a pool of threads,
+ * for init files with a very large num of challenges and rooms.
+ * the fixed capacity build creates the system like create_system, as its
+ * arena is not thread safe.
+ * @param init_file - the file with all the specifications
+ * @param num_threads - the num of threads to create the system with
+ * @param sys - ptr to a data type 'ChallengeRoomSystem' for creation
+ * @return NULL_PARAMETER: if the ptr to sys or init_file are NULL, or the
+ *                         file can't be opened
+ *         ILLEGAL_PARAMETER: if num_threads is less than 1 or the file is
+ *                            malformed
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result create_system_parallel(char *init_file, int num_threads,
+                              ChallengeRoomSystem **sys) {
+    if (init_file == NULL || sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (num_threads < 1) {
+        return ILLEGAL_PARAMETER;
+    }
+#ifdef ESCAPY_FIXED_CAPACITY
+    return create_system(init_file, sys);
+#else
+    InitFileLoad load;
+    Result result = load_init_file(&load, init_file, num_threads);
+    RESULT_STANDARD_CHECK(result);
+    (*sys) = malloc(sizeof(**sys));
+    if ((*sys) == NULL) {
+        reset_init_file_load(&load);
+        return MEMORY_PROBLEM;
+    }
+    init_system_fields(*sys);
+    result = take_loaded_records(*sys, &load);
+    if (result == OK) {
+        result = link_loaded_rooms(&load, &(*sys)->challenges_index);
+    }
+    //the records belong to the system now, only the text is freed
+    load.system_name = NULL;
+    load.challenges = NULL;
+    load.rooms = NULL;
+    reset_init_file_load(&load);
+    if (result == OK) {
+        result = create_system_visitor_list_head(*sys);
+    }
+    if (result == OK) {
+        result = create_system_visit_history(*sys);
+    }
+    if (result != OK) {
+        free_system_rooms_and_previous(*sys);
+        free(*sys);
+        return result;
+    }
+    return OK;
+#endif
+}
+
+/**
+ * creates the system from the init file and then recovers the state that
+ * was journaled before a crash by replaying the journal file onto it. from
+ * now on every change of the system is appended to the journal, which is
+ * synced once for every records_per_commit records.
+ * a journal that is replayed must belong to the same init file. while the
+ * journal is on, names with white space or longer than 255 chars are
+ * rejected, since a record keeps a name as a single word.
+ * @param init_file - the file with all the specifications
+ * @param journal_file - the journal file, created if it does not exist
+ * @param records_per_commit - num of records made durable by each fsync,
+ *                             records of an unfinished group may be lost
+ * @param sys - ptr to a data type 'ChallengeRoomSystem' for creation
+ * @return NULL_PARAMETER: if the ptr to sys, init_file or journal_file are
+ *                         NULL
+ *         ILLEGAL_PARAMETER: if records_per_commit is less than 1 or the
+ *                            journal can't be opened
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well, otherwise *sys is set to NULL
+ */
+Result create_journaled_system(char *init_file, char *journal_file,
+                               int records_per_commit,
+                               ChallengeRoomSystem **sys) {
+    if (journal_file == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (records_per_commit < 1) {
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = create_system(init_file, sys);
+    RESULT_STANDARD_CHECK(result);
+    long valid_length = replay_journal(*sys, journal_file);
+    (*sys)->journal = malloc(sizeof(*(*sys)->journal));
+    if ((*sys)->journal == NULL) {
+        discard_system(sys);
+        return MEMORY_PROBLEM;
+    }
+    result = open_journal((*sys)->journal, journal_file, valid_length,
+                          records_per_commit);
+    if (result != OK) {
+        free((*sys)->journal);
+        (*sys)->journal = NULL;
+        discard_system(sys);
+        return result;
+    }
+    return OK;
+}
+
+/**
+ * makes every change of the system that was journaled so far durable,
+ * without waiting for the group to fill
+ * @param sys - ptr to the system
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if the system has no journal
+ *         MEMORY_PROBLEM: if writing to the journal failed
+ *         OK: if everything went well
+ */
+Result system_journal_sync(ChallengeRoomSystem *sys) {
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (sys->journal == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    return journal_commit(sys->journal);
+}
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+/**
+ * opens the system kept in an arena file by an earlier process, or creates
+ * it from the init file if the file keeps none. the arena is mapped back
+ * where it was, so opening takes the same time however large the system is.
+ * the arena keeps raw ptrs and is not relocatable, the file is only opened
+ * at ESCAPY_PERSISTENT_ADDRESS. a file that was changed after its last
+ * durability point (see system_persist_sync) by a process that did not
+ * close it is not opened, as the crash may have cut a change in the middle.
+ * such a file is removed to start over from the init file.
+ * the journal, the timeout handler and the snapshots belong to the process
+ * that made them and are not kept, snapshots that were not released keep
+ * their share of the snapshot tables. a process has at most one system
+ * open, and the systems it made by create_system and the strings they
+ * returned are released before.
+ * @param init_file - the file with all the specifications, only read if the
+ *                    arena file keeps no system
+ * @param path - the arena file, created if it does not exist
+ * @param sys - ptr to a data type 'ChallengeRoomSystem' for creation
+ * @return NULL_PARAMETER: if the ptr to sys or path are NULL, or the arena
+ *                         file keeps no system and init_file is NULL or
+ *                         can't be opened
+ *         ILLEGAL_PARAMETER: if the file is not an arena of this build, or
+ *                            was left dirty by a crash
+ *         MEMORY_PROBLEM: if the file can't be mapped at the address, a
+ *                         system made by create_system is not released
+ *                         or allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result open_system(char *init_file, char *path, ChallengeRoomSystem **sys) {
+    if (path == NULL || sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    FixedArenaStatus status = fixed_arena_attach(path);
+    if (status != FIXED_ARENA_ATTACHED) {
+        return status == FIXED_ARENA_NOT_MAPPED ? MEMORY_PROBLEM :
+               ILLEGAL_PARAMETER;
+    }
+    (*sys) = fixed_arena_root();
+    if ((*sys) == NULL) {
+        Result result = create_system(init_file, sys);
+        if (result != OK) {
+            fixed_arena_detach();
+            return result;
+        }
+        fixed_arena_set_root(*sys);
+        return OK;
+    }
+    if ((*sys)->journal != NULL) {
+        //the file of the journal was closed with the process
+        free((*sys)->journal->buffer);
+        free((*sys)->journal);
+        (*sys)->journal = NULL;
+    }
+    (*sys)->timeout_handler = NULL;
+    (*sys)->timeout_context = NULL;
+    return OK;
+}
+
+/**
+ * a durability point: waits until the system is written to its arena file
+ * and marks the file clean, so it is opened as it is now even after a crash
+ * of the process or the machine. a crash after the next change and before
+ * the next durability point leaves the file dirty, see open_system.
+ * @param sys - ptr to the system
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if the system is not the one of the arena file
+ *         MEMORY_PROBLEM: if writing to the file failed
+ *         OK: if everything went well
+ */
+Result system_persist_sync(ChallengeRoomSystem *sys) {
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (sys != fixed_arena_root()) {
+        return ILLEGAL_PARAMETER;
+    }
+    return fixed_arena_sync() ? OK : MEMORY_PROBLEM;
+}
+
+/**
+ * writes the system to its arena file and unmaps it, the system and the
+ * strings it returned are no longer valid. it stays in the file for
+ * open_system.
+ * @param sys - ptr to the system
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if the system is not the one of the arena file
+ *         MEMORY_PROBLEM: if writing to the file failed, the system is
+ *                         closed anyway
+ *         OK: if everything went well
+ */
+Result close_system(ChallengeRoomSystem *sys) {
+    Result result = system_persist_sync(sys);
+    if (result == OK || result == MEMORY_PROBLEM) {
+        fixed_arena_detach();
+    }
+    return result;
+}
+#endif
+
 /**
  * resets any memory and frees any allocated memory from the system.
  * also force quit for any visitor left in the system.
@@ -115,6 +521,7 @@ Result create_system(char *init_file, ChallengeRoomSystem **sys) {
 Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
                       char **most_popular_challenge_p,
                       char **challenge_best_time) {
+    ARENA_CHANGE();
     if (sys == NULL || most_popular_challenge_p == NULL ||
         challenge_best_time == NULL) {
         return NULL_PARAMETER;
@@ -124,11 +531,39 @@ Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
     }
     Result result = most_popular_challenge(sys, most_popular_challenge_p);
     RESULT_STANDARD_CHECK(result);
+    //the snapshots keep their tables, the system stops publishing to them
+    drop_snapshot_tables(sys);
     result = all_visitors_quit(sys, destroy_time);
     if (result != OK) {
         return result;
     }
+    reset_free_slot_index(&sys->free_slots);
+    reset_rate_table(&sys->challenge_rates);
+    reset_rate_table(&sys->room_rates);
+    if (sys->journal != NULL) {
+        close_journal(sys->journal);
+        free(sys->journal);
+    }
+#ifdef ESCAPY_PERSISTENT_ARENA
+    //the arena file keeps no system from now on, the arena stays mapped for
+    //the strings returned
+    if (sys == fixed_arena_root()) {
+        fixed_arena_set_root(NULL);
+    }
+#endif
     free(sys->visitors_list_head);
+    reset_id_index(&sys->visitors_index);
+    reset_visit_history(sys->visit_history);
+    free(sys->visit_history);
+    if (sys->visitor_profiles != NULL) {
+        reset_profile_store(sys->visitor_profiles);
+        free(sys->visitor_profiles);
+    }
+    if (sys->event_buffer != NULL) {
+        //events that were not flushed are discarded
+        reset_event_buffer(sys->event_buffer);
+        free(sys->event_buffer);
+    }
     result = system_lowest_best_time(sys, challenge_best_time);
     RESULT_STANDARD_CHECK(result);
 
@@ -137,10 +572,22 @@ Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
     return OK;
 }
 
+/**
+ * releases a string the system returned to the caller. in the fixed
+ * capacity build the strings come from the arena of the system, so they
+ * are released here rather than with free().
+ * @param ptr - the string, NULL is ignored
+ */
+void system_free(void *ptr) {
+    free(ptr);
+}
+
 /**
  * receives a request of a visitor to enter a room in a requested level
  * if the visitor is not in the system yet it adds the visitor to the system
  * updates the system accordingly
+ * if wait queues are enabled and there is no available matching challenge
+ * the visitor waits in the room's queue for the level instead
  * @param sys - ptr to the system
  * @param room_name - the room the visitor wants to enter
  * @param visitor_name - the name of the visitor
@@ -150,7 +597,8 @@ Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
  * @return NULL_PARAMETER: if the ptr to sys is NULL
  *         ILLEGAL_TIME: if the start_time is not greater or equal than the
  *                       last time known to the system
- *         ILLEGAL_PARAMETER: if room or visitor are NULL
+ *         ILLEGAL_PARAMETER: if room or visitor are NULL, or the journal
+ *                            can't keep the name of the visitor
  *         MEMORY_PROBLEM: if allocation problems have occurred
  *         ALREADY_IN_ROOM: if the visitor is already in a room
  *         NO_AVAILABLE_CHALLENGES: if there are no available matching
@@ -160,43 +608,114 @@ Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
 Result visitor_arrive(ChallengeRoomSystem *sys, char *room_name,
                       char *visitor_name, int visitor_id, Level level,
                       int start_time) {
+    ARENA_CHANGE();
     if (sys == NULL) {
         return NULL_PARAMETER;
     }
     if (start_time < sys->system_last_known_time) {
         return ILLEGAL_TIME;
     }
-    if (visitor_name == NULL || room_name == NULL) {
+    if (visitor_name == NULL || room_name == NULL ||
+        !journal_accepts_name(sys, visitor_name)) {
         return ILLEGAL_PARAMETER;
     }
+    Result result = expire_sessions(sys, start_time);
+    RESULT_STANDARD_CHECK(result);
+    TRACE_BEGIN(visitor_arrive);
     Visitor *visitor = find_visitor_by_id(sys, visitor_id);
-    if (visitor == NULL) {
-        Result result = create_visitor_node(sys, visitor_name, visitor_id);
-        RESULT_STANDARD_CHECK(result);
-    } else {
-        if (visitor->room_name != NULL) {
-            return ALREADY_IN_ROOM;
-        }
+    if (visitor != NULL) {
+        //a visitor is in the system only while in a room or a queue
+        TRACE_END(visitor_arrive);
+        return ALREADY_IN_ROOM;
     }
     int room_idx = 0;
-    Result result = find_room_by_name(sys, room_name, &room_idx);
-    if (result != OK) {
-        destroy_visitor_node(sys, sys->visitors_list_head->next->visitor);
-        return result;
+    result = find_room_by_name(sys, room_name, &room_idx);
+    if (result == OK) {
+        result = arrive_at_room(sys, sys->system_rooms[room_idx],
+                                visitor_name, visitor_id, level, start_time,
+                                sys->wait_queues_enabled);
+    }
+    TRACE_END(visitor_arrive);
+    return result;
+}
+
+/**
+ * receives a request of a visitor to enter any room in a requested level,
+ * the visitor enters the room with the most free challenges of the level,
+ * out of rooms with as many the first in the rooms table. the room is found
+ * in O(log rooms) by the free slot index, which is built by the first call.
+ * the index doesn't count challenges whose booking window is open, so the
+ * room always has a challenge for the visitor. the visitor never waits in a
+ * queue.
+ * @param sys - ptr to the system
+ * @param visitor_name - the name of the visitor
+ * @param visitor_id - the id of the visitor
+ * @param level - the wanted challenge level
+ * @param start_time - the current time
+ * @param room_name - the ptr that needs to be updated with a copy of the
+ *                    name of the room, which the caller frees, may be NULL
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_TIME: if the start_time is not greater or equal than the
+ *                       last time known to the system
+ *         ILLEGAL_PARAMETER: if visitor_name is NULL, level is not valid or
+ *                            the journal can't keep the name of the visitor
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         ALREADY_IN_ROOM: if the visitor is already in a room
+ *         NO_AVAILABLE_CHALLENGES: if there are no available matching
+ *                                  challenges in any room
+ *         OK: if everything went well
+ */
+Result visitor_arrive_any_room(ChallengeRoomSystem *sys, char *visitor_name,
+                               int visitor_id, Level level, int start_time,
+                               char **room_name) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (start_time < sys->system_last_known_time) {
+        return ILLEGAL_TIME;
+    }
+    if (visitor_name == NULL || level < Easy || level > All_Levels ||
+        !journal_accepts_name(sys, visitor_name)) {
+        return ILLEGAL_PARAMETER;
+    }
+    //the free activities are counted as of the start time
+    Result result = expire_sessions(sys, start_time);
+    RESULT_STANDARD_CHECK(result);
+    if (find_visitor_by_id(sys, visitor_id) != NULL) {
+        return ALREADY_IN_ROOM;
+    }
+    if (sys->free_slots.nodes == NULL && build_free_slot_index(sys) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    int room_idx = free_slot_index_most_free(&sys->free_slots, level);
+    if (room_idx == UNDEFINED) {
+        return NO_AVAILABLE_CHALLENGES;
     }
-    result = visitor_enter_room(sys->system_rooms + room_idx,
-                                sys->visitors_list_head->next->visitor,
-                                level, start_time);
+    ChallengeRoom *room = sys->system_rooms[room_idx];
+    char *name_copy = NULL;
+    if (room_name != NULL) {
+        name_copy = malloc(strlen(room->name) + 1);
+        if (name_copy == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        strcpy(name_copy, room->name);
+    }
+    result = arrive_at_room(sys, room, visitor_name, visitor_id, level,
+                            start_time, 0);
     if (result != OK) {
-        destroy_visitor_node(sys, sys->visitors_list_head->next->visitor);
+        free(name_copy);
         return result;
     }
-    sys->system_last_known_time = start_time;
+    if (room_name != NULL) {
+        *room_name = name_copy;
+    }
     return OK;
 }
 
 /**
- * updates the system when a visitor is getting out of a room
+ * updates the system when a visitor is getting out of a room, a visitor that
+ * is still waiting in a queue leaves the queue
  * @param sys - ptr to the system
  * @param visitor_id - the id of the visitor
  * @param quit_time - the current time
@@ -208,22 +727,34 @@ Result visitor_arrive(ChallengeRoomSystem *sys, char *room_name,
  *         OK: if everything went well
  */
 Result visitor_quit(ChallengeRoomSystem *sys, int visitor_id, int quit_time) {
+    ARENA_CHANGE();
     if (sys == NULL) {
         return NULL_PARAMETER;
     }
     if (quit_time < sys->system_last_known_time) {
         return ILLEGAL_TIME;
     }
+    Result result = expire_sessions(sys, quit_time);
+    RESULT_STANDARD_CHECK(result);
     Visitor *visitor = find_visitor_by_id(sys, visitor_id);
     if (visitor == NULL) {
         return NOT_IN_ROOM;
     }
     sys->system_last_known_time = quit_time;
-    Result result = visitor_quit_room(visitor, quit_time);
+    if (visitor->waiting_room != NULL_LINK) {
+        ChallengeRoom *room = room_at(visitor->waiting_room);
+        visitor_leave_wait_queue(visitor);
+        destroy_visitor_node(sys, visitor);
+        room_changed(sys, room);
+        JOURNAL_RECORD(sys, "Q %d %d\n", visitor_id, quit_time);
+        return OK;
+    }
+    result = quit_room_and_record(sys, visitor, quit_time);
     if (result != OK) {
         return result;
     }
     destroy_visitor_node(sys, visitor);
+    JOURNAL_RECORD(sys, "Q %d %d\n", visitor_id, quit_time);
     return OK;
 }
 
@@ -239,496 +770,3392 @@ Result visitor_quit(ChallengeRoomSystem *sys, int visitor_id, int quit_time) {
  *         OK: if everything went well
  */
 Result all_visitors_quit(ChallengeRoomSystem *sys, int quit_time) {
+    ARENA_CHANGE();
     if (sys == NULL) {
         return NULL_PARAMETER;
     }
     if (quit_time < sys->system_last_known_time) {
         return ILLEGAL_TIME;
     }
+    Result result = expire_sessions(sys, quit_time);
+    RESULT_STANDARD_CHECK(result);
+    //the waiting visitors leave first so no one is dispatched to a freed room
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        drop_waiting_visitors(sys, sys->system_rooms[i]);
+    }
 
     VisitorsList ptr = sys->visitors_list_head->next;
     while (ptr != NULL) {
-        Result result = visitor_quit_room(ptr->visitor, quit_time);
+        result = quit_room_and_record(sys, ptr->visitor, quit_time);
         RESULT_STANDARD_CHECK(result);
         VisitorsList tmp_ptr = ptr->next;
         destroy_visitor_node(sys, ptr->visitor);
         ptr = tmp_ptr;
     }
     sys->system_last_known_time = quit_time;
+    JOURNAL_RECORD(sys, "X %d\n", quit_time);
     return OK;
 }
 
 /**
- * returns the room name in which the visitor is in
+ * moves the time of the system forward without an event, the visitors whose
+ * sessions ended by then are taken out of their challenges, see
+ * set_system_session_limit.
  * @param sys - ptr to the system
- * @param visitor_name - the name of the visitor
- * @param room_name - the ptr that needs to be updated
+ * @param time - the current time
  * @return NULL_PARAMETER: if the ptr to sys is NULL
- *         ILLEGAL_PARAMETER: if a visitor_name or room_name are NULL
- *         NOT_IN_ROOM: if the visitor is not in a room
+ *         ILLEGAL_TIME: if the time is not greater or equal than the last
+ *                       time known to the system
  *         OK: if everything went well
  */
-Result system_room_of_visitor(ChallengeRoomSystem *sys, char *visitor_name,
-                              char **room_name) {
+Result system_advance_time(ChallengeRoomSystem *sys, int time) {
+    ARENA_CHANGE();
     if (sys == NULL) {
         return NULL_PARAMETER;
     }
-    if (visitor_name == NULL || room_name == NULL) {
-        return ILLEGAL_PARAMETER;
-    }
-    VisitorsList ptr = sys->visitors_list_head->next;
-    while (ptr != NULL) {
-        if (strcmp(ptr->visitor->visitor_name, visitor_name) == 0) {
-            Result result = room_of_visitor(ptr->visitor, room_name);
-            return result;
-        }
-        ptr = ptr->next;
+    if (time < sys->system_last_known_time) {
+        return ILLEGAL_TIME;
     }
-    //if we got here it means that the visitor is not in the system
-    return NOT_IN_ROOM;
+    Result result = expire_sessions(sys, time);
+    RESULT_STANDARD_CHECK(result);
+    sys->system_last_known_time = time;
+    return OK;
 }
 
 /**
- * changes the name of a challenge in the system
+ * sets the most time a visit of a challenge of a level may take. a visitor
+ * still in its challenge when the time is up quits it then, once the time of
+ * the system passes it, by an event or by system_advance_time. the limit
+ * applies to the visits that start from now on.
  * @param sys - ptr to the system
- * @param challenge_id - the id of the challenge
- * @param new_name - the wanted name for the challenge
- * @return NULL_PARAMETER: if the ptr to sys or new_name are NULL
- *         ILLEGAL_PARAMETER: if a challenge with the name given is not found
+ * @param level - the level of the challenges, All_Levels sets all of them
+ * @param max_duration - the most time a visit may take, 0 for no limit
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if level is not valid or max_duration is
+ *                            negative
  *         OK: if everything went well
  */
-Result change_challenge_name(ChallengeRoomSystem *sys, int challenge_id,
-                             char *new_name) {
-    if (sys == NULL || new_name == NULL) {
+Result set_system_session_limit(ChallengeRoomSystem *sys, Level level,
+                                int max_duration) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
         return NULL_PARAMETER;
     }
-    for (int i = 0; i < sys->system_num_challenges; ++i) {
-        if ((sys->system_challenges + i)->id == challenge_id) {
-            Result result = change_name(sys->system_challenges + i, new_name);
-            RESULT_STANDARD_CHECK(result);
-            return OK;
+    if (level < Easy || level > All_Levels || max_duration < 0) {
+        return ILLEGAL_PARAMETER;
+    }
+    for (int i = Easy; i < All_Levels; ++i) {
+        if (level == All_Levels || level == i) {
+            sys->session_limits[i] = max_duration;
         }
     }
-    //did'nt find a challenge with the id given
-    return ILLEGAL_PARAMETER;
+    JOURNAL_RECORD(sys, "S %d %d\n", (int) level, max_duration);
+    return OK;
 }
 
 /**
- * changes the name of a room in the system
+ * sets the function that is called for each visitor whose session ended,
+ * see SessionTimeoutHandler.
  * @param sys - ptr to the system
- * @param current_name - the name of the room
- * @param new_name - the wanted name of the room
- * @return NULL_PARAMETER: if the ptr to sys, current_name or new_name are NULL
- *         ILLEGAL_PARAMETER: if a room with the name given is not found
+ * @param handler - the function, NULL for none
+ * @param context - passed to the function as is
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
  *         OK: if everything went well
  */
-Result change_system_room_name(ChallengeRoomSystem *sys, char *current_name,
-                               char *new_name) {
-    if (sys == NULL || current_name == NULL || new_name == NULL) {
+Result set_system_timeout_handler(ChallengeRoomSystem *sys,
+                                  SessionTimeoutHandler handler,
+                                  void *context) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
         return NULL_PARAMETER;
     }
-    int room_idx = 0;
-    Result result = find_room_by_name(sys, current_name, &room_idx);
-    RESULT_STANDARD_CHECK(result);
-    result = change_room_name(sys->system_rooms + room_idx, new_name);
-    return result;
+    sys->timeout_handler = handler;
+    sys->timeout_context = context;
+    return OK;
 }
 
 /**
- * returns the best time for a specific challenge
+ * sets the lateness window of the system. once set, events given through
+ * system_ingest_arrive and system_ingest_quit may arrive up to lateness time
+ * units behind the latest event time and are still applied in time order.
+ * a window of 0 applies every event as soon as it is ingested.
  * @param sys - ptr to the system
- * @param challenge_name - the name of the challenge
- * @param time - the ptr that need to be updated
- * @return NULL_PARAMETER: if the ptr to sys, challenge_name or time are NULL
- *         ILLEGAL_PARAMETER: if a challenge with the name given is not found
+ * @param lateness - the size of the window
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if lateness is negative
+ *         MEMORY_PROBLEM: if allocation problems have occurred
  *         OK: if everything went well
  */
-Result best_time_of_system_challenge(ChallengeRoomSystem *sys,
-                                     char *challenge_name, int *time) {
-    if (sys == NULL || challenge_name == NULL || time == NULL) {
+Result set_system_lateness_window(ChallengeRoomSystem *sys, int lateness) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
         return NULL_PARAMETER;
     }
-    for (int i = 0; i < sys->system_num_challenges; ++i) {
-        if (strcmp((sys->system_challenges + i)->name, challenge_name) == 0) {
-            Result result = best_time_of_challenge(sys->system_challenges + i,
-                                                   time);
-            RESULT_STANDARD_CHECK(result);
-            return OK;
+    if (lateness < 0) {
+        return ILLEGAL_PARAMETER;
+    }
+    if (sys->event_buffer == NULL) {
+        sys->event_buffer = malloc(sizeof(*sys->event_buffer));
+        if (sys->event_buffer == NULL) {
+            return MEMORY_PROBLEM;
         }
+        init_event_buffer(sys->event_buffer, lateness);
+        sys->event_buffer->max_seen_time = sys->system_last_known_time;
+        return OK;
     }
-    //did'nt find a challenge with the name given
-    return ILLEGAL_PARAMETER;
+    sys->event_buffer->lateness = lateness;
+    //a smaller window may release events that are already buffered
+    apply_buffered_events(sys, sys->event_buffer->max_seen_time - lateness);
+    return OK;
 }
 
 /**
- * returns the challenge with the highest num of visits in the room, in case
- * there are more than one, the lexicographically smallest one will be returned
+ * ingests an arrival of a visitor. without a lateness window the arrival is
+ * applied right away. with a window it is buffered and applied, in time
+ * order, once the latest event time is at least lateness units past it. the
+ * result of applying a buffered event is counted in the ingestion stats.
  * @param sys - ptr to the system
- * @param challenge_name - the ptr that needs to be updated
- * @return NULL_PARAMETER: if the ptr to sys or challenge_name are NULL
+ * @param room_name - the room the visitor wants to enter
+ * @param visitor_name - the name of the visitor
+ * @param visitor_id - the id of the visitor
+ * @param level - the wanted challenge level
+ * @param start_time - the time of the arrival
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if room or visitor are NULL
+ *         ILLEGAL_TIME: if the start_time is before an event that was
+ *                       already applied
  *         MEMORY_PROBLEM: if allocation problems have occurred
- *         OK: if everything went well
+ *         OK: if the event was accepted, or without a window any result
+ *             of visitor_arrive
  */
-Result most_popular_challenge(ChallengeRoomSystem *sys, char **challenge_name) {
-    if (sys == NULL || challenge_name == NULL) {
+Result system_ingest_arrive(ChallengeRoomSystem *sys, char *room_name,
+                            char *visitor_name, int visitor_id, Level level,
+                            int start_time) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
         return NULL_PARAMETER;
     }
-    if (sys->system_num_rooms == 0) {
-        *challenge_name = NULL;
-        return OK;
+    if (sys->event_buffer == NULL) {
+        return visitor_arrive(sys, room_name, visitor_name, visitor_id, level,
+                              start_time);
     }
-    int max_idx = 0, max = 0, curr = 0;
-    Result result = num_visits(sys->system_challenges, &max);
-    RESULT_STANDARD_CHECK(result);
-    for (int i = 1; i < sys->system_num_challenges; ++i) {
-        result = num_visits(sys->system_challenges + i, &curr);
-        RESULT_STANDARD_CHECK(result);
-        if (curr > max) {
-            max_idx = i;
-            max = curr;
-        } else if (curr == max && strcmp((sys->system_challenges + i)->name,
-                                         (sys->system_challenges +
-                                          max_idx)->name) < 0) {
-            max_idx = i;
-        }
+    if (visitor_name == NULL || room_name == NULL) {
+        return ILLEGAL_PARAMETER;
     }
-    if (max == 0) {
-        //no visits in any of the rooms
-        *challenge_name = NULL;
-    } else {
-        *challenge_name = malloc(
-                strlen((sys->system_challenges + max_idx)->name) + 1);
-        if (*challenge_name == NULL) {
-            return MEMORY_PROBLEM;
-        }
-        strcpy(*challenge_name, (sys->system_challenges + max_idx)->name);
+    int watermark = 0;
+    Result result = ingest_event_time(sys, start_time, &watermark);
+    RESULT_STANDARD_CHECK(result);
+    if (sys->event_buffer->num_events == 0 && start_time <= watermark) {
+        //nothing is pending before it, no need to buffer
+        BufferedEvent event = {ARRIVE_EVENT, start_time, 0, visitor_id, level,
+                               room_name, visitor_name};
+        apply_event(sys, &event);
+        return OK;
     }
+    result = event_buffer_push_arrive(sys->event_buffer, start_time,
+                                      room_name, visitor_name, visitor_id,
+                                      level);
+    RESULT_STANDARD_CHECK(result);
+    apply_buffered_events(sys, watermark);
     return OK;
 }
 
 /**
- * free the allocated memory of the system
+ * ingests a quit of a visitor, see system_ingest_arrive.
  * @param sys - ptr to the system
+ * @param visitor_id - the id of the visitor
+ * @param quit_time - the time of the quit
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_TIME: if the quit_time is before an event that was
+ *                       already applied
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if the event was accepted, or without a window any result
+ *             of visitor_quit
  */
-static void free_system_name(ChallengeRoomSystem *sys) {
-    free(sys->system_name);
-    return;
+Result system_ingest_quit(ChallengeRoomSystem *sys, int visitor_id,
+                          int quit_time) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (sys->event_buffer == NULL) {
+        return visitor_quit(sys, visitor_id, quit_time);
+    }
+    int watermark = 0;
+    Result result = ingest_event_time(sys, quit_time, &watermark);
+    RESULT_STANDARD_CHECK(result);
+    if (sys->event_buffer->num_events == 0 && quit_time <= watermark) {
+        BufferedEvent event = {QUIT_EVENT, quit_time, 0, visitor_id,
+                               All_Levels, NULL, NULL};
+        apply_event(sys, &event);
+        return OK;
+    }
+    result = event_buffer_push_quit(sys->event_buffer, quit_time,
+                                    visitor_id);
+    RESULT_STANDARD_CHECK(result);
+    apply_buffered_events(sys, watermark);
+    return OK;
 }
 
 /**
- * frees all the memory that was allocated previously and the memory of
- * each challenge and the challenge array itself.
+ * applies all the buffered events regardless of the lateness window, should
+ * be used when no more late events are expected
  * @param sys - ptr to the system
- * @param num_challenges - num of the challenges in the system
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         OK: if everything went well
  */
-static void free_system_challenges_and_previous(ChallengeRoomSystem *sys) {
-    for (int i = 0; i < sys->system_num_challenges; ++i) {
-        reset_challenge(sys->system_challenges + i);
+Result system_ingest_flush(ChallengeRoomSystem *sys) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
     }
-    free(sys->system_challenges);
-    sys->system_num_challenges = 0;
-    free_system_name(sys);
-    return;
+    if (sys->event_buffer != NULL) {
+        apply_buffered_events(sys, sys->event_buffer->max_seen_time);
+    }
+    return OK;
 }
 
 /**
- * frees all the memory that was allocated previously and the memory of
- * each room and the room array itself.
- * @param sys - ptr to system
+ * returns the num of events waiting in the buffer and the num of buffered
+ * events that were applied successfully or failed
+ * @param sys - ptr to the system
+ * @param pending - the ptr that needs to be updated
+ * @param applied - the ptr that needs to be updated
+ * @param failed - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to sys, pending, applied or failed are
+ *                         NULL
+ *         OK: if everything went well
  */
-static void free_system_rooms_and_previous(ChallengeRoomSystem *sys) {
-    for (int i = 0; i < sys->system_num_rooms; ++i) {
-        if ((sys->system_rooms + i) != NULL) {
-            reset_room(sys->system_rooms + i);
-        }
+Result system_ingest_stats(ChallengeRoomSystem *sys, int *pending,
+                           int *applied, int *failed) {
+    if (sys == NULL || pending == NULL || applied == NULL || failed == NULL) {
+        return NULL_PARAMETER;
     }
-    free(sys->system_rooms);
-    sys->system_num_rooms = 0;
-    sys->system_last_known_time = 0;
-    free_system_challenges_and_previous(sys);
-    return;
+    if (sys->event_buffer == NULL) {
+        *pending = *applied = *failed = 0;
+        return OK;
+    }
+    *pending = sys->event_buffer->num_events;
+    *applied = sys->event_buffer->num_applied;
+    *failed = sys->event_buffer->num_failed;
+    return OK;
 }
 
 /**
- * updates the name field in the system
+ * updates the system when all the visitors of a single room are getting out
+ * of it, including the ones waiting in its queues, only the challenge
+ * activities and queues of the room are visited
  * @param sys - ptr to the system
- * @param input_file - the file with the wanted name
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param room_name - the name of the room to evacuate
+ * @param quit_time - the current time
+ * @return NULL_PARAMETER: if the ptr to sys or room_name are NULL
+ *         ILLEGAL_TIME: if the quit_time is not greater or equal than the
+ *                       last time known to the system
+ *         ILLEGAL_PARAMETER: if a room with the name given is not found
  *         OK: if everything went well
  */
-static Result update_system_name(ChallengeRoomSystem *sys, FILE *input_file) {
-    char name[WORD_MAX_LEN] = "";
-    fscanf(input_file, "%s\n", name);
-    sys->system_name = malloc(strlen(name) + 1);
-    if (sys->system_name == NULL) {
-        free(sys);
-        return MEMORY_PROBLEM;
+Result room_visitors_quit(ChallengeRoomSystem *sys, char *room_name,
+                          int quit_time) {
+    ARENA_CHANGE();
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
     }
-    strcpy(sys->system_name, name);
+    if (quit_time < sys->system_last_known_time) {
+        return ILLEGAL_TIME;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    result = expire_sessions(sys, quit_time);
+    RESULT_STANDARD_CHECK(result);
+
+    drop_waiting_visitors(sys, sys->system_rooms[room_idx]);
+    RoomOccupantIterator iterator;
+    init_room_occupant_iterator(&iterator, sys->system_rooms[room_idx]);
+    ChallengeActivity *activity = room_occupant_iterator_next(&iterator);
+    while (activity != NULL) {
+        Visitor *visitor = visitor_at(activity->visitor);
+        result = quit_room_and_record(sys, visitor, quit_time);
+        RESULT_STANDARD_CHECK(result);
+        destroy_visitor_node(sys, visitor);
+        activity = room_occupant_iterator_next(&iterator);
+    }
+    sys->system_last_known_time = quit_time;
+    JOURNAL_RECORD(sys, "E %s %d\n", room_name, quit_time);
     return OK;
 }
 
 /**
- * creates the challenges array in the system
+ * initializes an iterator over the challenge activities that are currently
+ * taken in a room
  * @param sys - ptr to the system
- * @param input_file - the file with the specifications for the challenges
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param room_name - the name of the room
+ * @param iterator - the iterator that needs to be initialized
+ * @return NULL_PARAMETER: if the ptr to sys, room_name or iterator are NULL
+ *         ILLEGAL_PARAMETER: if a room with the name given is not found
  *         OK: if everything went well
  */
-static Result create_system_challenges(ChallengeRoomSystem *sys,
-                                       FILE *input_file) {
-    char challenge_name[WORD_MAX_LEN] = "";
-    fscanf(input_file, "%d\n", &sys->system_num_challenges);
-    sys->system_challenges = malloc(sys->system_num_challenges *
-                                    sizeof(*sys->system_challenges));
-    if (sys->system_challenges == NULL) {
-        free_system_name(sys);
-        return MEMORY_PROBLEM;
-    }
-
-    for (int i = 0; i < sys->system_num_challenges; ++i) {
-        int level = 0, id = 0;
-        fscanf(input_file, "%s %d %d\n", challenge_name, &id, &level);
-        Result result = init_challenge((sys->system_challenges + i), id,
-                                       challenge_name, (Level) level - 1);
-        if (result != OK) {
-            free_system_challenges_and_previous(sys);
-            return result;
-        }
+Result system_room_occupants(ChallengeRoomSystem *sys, char *room_name,
+                             RoomOccupantIterator *iterator) {
+    if (sys == NULL || room_name == NULL || iterator == NULL) {
+        return NULL_PARAMETER;
     }
-    return OK;
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    return init_room_occupant_iterator(iterator, sys->system_rooms[room_idx]);
 }
 
 /**
- * finds the right challenge by id and initialize the activity accordingly
+ * turns the wait queues of the rooms on or off, when off a visitor that finds
+ * no available challenge is rejected. visitors that are already waiting stay
+ * in their queues.
  * @param sys - ptr to the system
- * @param challenge_id - the id of the wanted challenge
- * @param activity_idx - the idx of the current activity
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param enabled - non zero to turn the wait queues on
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
  *         OK: if everything went well
  */
-static Result add_challenge_to_room(ChallengeRoomSystem *sys, int challenge_id,
-                                    int activity_idx, int room_idx) {
-    for (int i = 0; i < sys->system_num_challenges; ++i) {
-        if ((sys->system_challenges + i)->id == challenge_id) {
-            Result result = init_challenge_activity(
-                    ((sys->system_rooms + room_idx)->challenges + activity_idx),
-                    sys->system_challenges + i);
-            if (result != OK) {
-                free_system_rooms_and_previous(sys);
-                return result;
-            }
-            return OK;
-        }
+Result set_system_wait_queues(ChallengeRoomSystem *sys, int enabled) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
     }
+    sys->wait_queues_enabled = enabled;
+    JOURNAL_RECORD(sys, "W %d\n", enabled);
     return OK;
 }
 
 /**
- * adds the challenge activities to each room
+ * turns the profiles of the visitors on or off. when on, every completed
+ * visit is also recorded in the profile of its visitor, which is kept after
+ * the visitor quits. turning them off drops all the profiles.
  * @param sys - ptr to the system
- * @param input_file - the file with the specifications for the activities
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param enabled - non zero to turn the profiles on
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
  *         OK: if everything went well
  */
-static Result rooms_add_challenge_activities(ChallengeRoomSystem *sys,
-                                             FILE *input_file) {
-    char room_name[WORD_MAX_LEN] = "";
-    for (int i = 0; i < sys->system_num_rooms; ++i) {
-        int num_challenges_in_room = 0;
-        fscanf(input_file, "%s %d", room_name, &num_challenges_in_room);
-        if (num_challenges_in_room == 0) {
-            free_system_rooms_and_previous(sys);
-            return ILLEGAL_PARAMETER;
-        }
-        Result result = init_room((sys->system_rooms + i), room_name,
-                                  num_challenges_in_room);
-        if (result != OK) {
-            free_system_rooms_and_previous(sys);
-            return result;
+Result set_system_visitor_profiles(ChallengeRoomSystem *sys, int enabled) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (enabled && sys->visitor_profiles == NULL) {
+        sys->visitor_profiles = malloc(sizeof(*sys->visitor_profiles));
+        if (sys->visitor_profiles == NULL) {
+            return MEMORY_PROBLEM;
         }
-        for (int j = 0; j < num_challenges_in_room; ++j) {
-            int challenge_id = 0;
-            if (j != num_challenges_in_room - 1) {
-                fscanf(input_file, "%d", &challenge_id);
-            } else {
-                //if that's the last id move cursor to the start of next line
-                fscanf(input_file, "%d\n", &challenge_id);
-            }
-            result = add_challenge_to_room(sys, challenge_id, j, i);
-            if (result != OK) {
-                free_system_rooms_and_previous(sys);
-                return result;
-            }
+        if (init_profile_store(sys->visitor_profiles) != OK) {
+            free(sys->visitor_profiles);
+            sys->visitor_profiles = NULL;
+            return MEMORY_PROBLEM;
         }
+    } else if (!enabled && sys->visitor_profiles != NULL) {
+        reset_profile_store(sys->visitor_profiles);
+        free(sys->visitor_profiles);
+        sys->visitor_profiles = NULL;
     }
+    JOURNAL_RECORD(sys, "V %d\n", enabled);
     return OK;
 }
 
 /**
- * creates the rooms array in the system
+ * returns the profile of a visitor: the num of completed visits and, for
+ * every challenge the visitor completed, the num of completions and the
+ * personal best time. the profile belongs to the system and may change with
+ * the next visit the visitor completes.
  * @param sys - ptr to the system
- * @param input_file - the file with the specifications for the rooms
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param visitor_id - the id of the visitor
+ * @param profile - the ptr to the profile that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to sys or profile are NULL
+ *         ILLEGAL_PARAMETER: if the profiles are off or the visitor has not
+ *                            completed a visit since they were turned on
  *         OK: if everything went well
  */
-static Result create_system_rooms(ChallengeRoomSystem *sys, FILE *input_file) {
-    fscanf(input_file, "%d\n", &sys->system_num_rooms);
-    sys->system_rooms = calloc((size_t) sys->system_num_rooms,
-                               sizeof(*sys->system_rooms));
-    if (sys->system_rooms == NULL) {
-        free_system_challenges_and_previous(sys);
+Result system_visitor_profile(ChallengeRoomSystem *sys, int visitor_id,
+                              VisitorProfile **profile) {
+    if (sys == NULL || profile == NULL) {
         return NULL_PARAMETER;
     }
-    return rooms_add_challenge_activities(sys, input_file);
+    if (sys->visitor_profiles == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    *profile = profile_store_find(sys->visitor_profiles, visitor_id);
+    return *profile == NULL ? ILLEGAL_PARAMETER : OK;
 }
 
 /**
- * creates the head of the head of the linked list of visitors
+ * initializes an iterator over the completed visits whose time overlaps a
+ * range, in the order they ended
  * @param sys - ptr to the system
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param from_time - the start of the range
+ * @param to_time - the end of the range, inclusive
+ * @param iterator - the iterator that needs to be initialized
+ * @return NULL_PARAMETER: if the ptr to sys or iterator are NULL
+ *         ILLEGAL_TIME: if to_time is before from_time
  *         OK: if everything went well
  */
-static Result create_system_visitor_list_head(ChallengeRoomSystem *sys) {
-    sys->visitors_list_head = malloc(sizeof(*(sys->visitors_list_head)));
-    if (sys->visitors_list_head == NULL) {
-        return MEMORY_PROBLEM;
+Result system_visits_in_range(ChallengeRoomSystem *sys, int from_time,
+                              int to_time, VisitHistoryIterator *iterator) {
+    if (sys == NULL || iterator == NULL) {
+        return NULL_PARAMETER;
     }
-    sys->visitors_list_head->visitor = NULL;
-    sys->visitors_list_head->next = NULL;
-    return OK;
+    return init_visit_history_iterator(iterator, sys->visit_history,
+                                       VISITS_IN_RANGE, from_time, to_time);
 }
 
 /**
- * returns the challenge with the lowest best_time in the system
+ * initializes an iterator over the completed visits of a challenge, in the
+ * order they ended
  * @param sys - ptr to the system
- * @param challenge_best_time - the ptr that needs to be updated
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param challenge_id - the id of the challenge
+ * @param iterator - the iterator that needs to be initialized
+ * @return NULL_PARAMETER: if the ptr to sys or iterator are NULL
  *         OK: if everything went well
  */
-static Result system_lowest_best_time(ChallengeRoomSystem *sys,
-                                      char **challenge_best_time) {
-    assert(sys != NULL);
-    int min_idx = 0, min = 0;
-    for (int i = 0; i < sys->system_num_challenges; ++i) {
-        if ((sys->system_challenges + i)->num_visits > 0) {
-            min = (sys->system_challenges + i)->best_time;
-            break;
-        }
-    }
-    if (min == 0) {
-        *challenge_best_time = NULL;
-        return OK;
-    }
-    for (int i = 0; i < sys->system_num_challenges; ++i) {
-        if ((sys->system_challenges + i)->best_time != 0) {
-            if (((sys->system_challenges + i)->best_time < min)) {
-                min = (sys->system_challenges + i)->best_time;
-                min_idx = i;
-            } else if ((sys->system_challenges + i)->best_time == min &&
-                       strcmp((sys->system_challenges + i)->name,
-                              (sys->system_challenges + min_idx)->name) < 0) {
-                min_idx = i;
-            }
-        }
-    }
-    *challenge_best_time = malloc(strlen((sys->system_challenges + min_idx)
-                                                 ->name) + 1);
-    if (*challenge_best_time == NULL) {
-        return MEMORY_PROBLEM;
+Result system_visits_of_challenge(ChallengeRoomSystem *sys, int challenge_id,
+                                  VisitHistoryIterator *iterator) {
+    if (sys == NULL || iterator == NULL) {
+        return NULL_PARAMETER;
     }
-    strcpy(*challenge_best_time, (sys->system_challenges + min_idx)->name);
-    return OK;
+    return init_visit_history_iterator(iterator, sys->visit_history,
+                                       VISITS_OF_CHALLENGE, challenge_id, 0);
 }
 
 /**
- * creates a new node to the visitor list
- * initialize the new visitor
+ * initializes an iterator over the completed visits of a visitor, in the
+ * order they ended
  * @param sys - ptr to the system
- * @param visitor_name - the name of the visitor
  * @param visitor_id - the id of the visitor
- * @return MEMORY_PROBLEM: if allocation problems have occurred
+ * @param iterator - the iterator that needs to be initialized
+ * @return NULL_PARAMETER: if the ptr to sys or iterator are NULL
  *         OK: if everything went well
  */
-static Result create_visitor_node(ChallengeRoomSystem *sys, char *visitor_name,
-                                  int visitor_id) {
-    assert(sys != NULL && visitor_name != NULL);
-    VisitorsList new_node = malloc(sizeof(*new_node));
-    if (new_node == NULL) {
-        return MEMORY_PROBLEM;
+Result system_visits_of_visitor(ChallengeRoomSystem *sys, int visitor_id,
+                                VisitHistoryIterator *iterator) {
+    if (sys == NULL || iterator == NULL) {
+        return NULL_PARAMETER;
     }
-    new_node->visitor = malloc(sizeof(*new_node->visitor));
-    if (new_node->visitor == NULL) {
-        free(new_node);
+    return init_visit_history_iterator(iterator, sys->visit_history,
+                                       VISITS_OF_VISITOR, visitor_id, 0);
+}
+
+/**
+ * returns the num of completed visits in the history and the num of bytes
+ * it takes. visits are dropped from the history only if memory ran out.
+ * @param sys - ptr to the system
+ * @param num_visits - the ptr to the num of visits that needs to be updated
+ * @param num_bytes - the ptr to the num of bytes that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to sys, num_visits or num_bytes are NULL
+ *         OK: if everything went well
+ */
+Result system_visit_history_stats(ChallengeRoomSystem *sys, long *num_visits,
+                                  size_t *num_bytes) {
+    if (sys == NULL || num_visits == NULL || num_bytes == NULL) {
+        return NULL_PARAMETER;
+    }
+    *num_visits = sys->visit_history->num_visits;
+    *num_bytes = visit_history_size(sys->visit_history);
+    return OK;
+}
+
+/**
+ * returns the num of visitors that arrived and of visits that were
+ * completed in the whole system in the last span time units, in O(1).
+ * dividing by span gives the rates.
+ * @param sys - ptr to the system
+ * @param time - the current time
+ * @param span - the num of time units, from 1 to RATE_WINDOW_SPAN
+ * @param arrivals - the ptr to the num of arrivals that needs to be updated
+ * @param completions - the ptr to the num of completions that needs to be
+ *                      updated
+ * @return NULL_PARAMETER: if the ptr to sys, arrivals or completions are
+ *                         NULL
+ *         ILLEGAL_PARAMETER: if span is out of range
+ *         ILLEGAL_TIME: if the time is before the last time known to the
+ *                       system
+ *         OK: if everything went well
+ */
+Result system_rates(ChallengeRoomSystem *sys, int time, int span,
+                    int *arrivals, int *completions) {
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    return window_rates(sys, &sys->arrivals, &sys->completions, time, span,
+                        arrivals, completions);
+}
+
+/**
+ * returns the num of visitors that arrived to a room and of visits of the
+ * room that were completed in the last span time units, like system_rates.
+ * the rooms are counted from the first request for the rates of a room on,
+ * which allocates their windows.
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @param time - the current time
+ * @param span - the num of time units, from 1 to RATE_WINDOW_SPAN
+ * @param arrivals - the ptr to the num of arrivals that needs to be updated
+ * @param completions - the ptr to the num of completions that needs to be
+ *                      updated
+ * @return NULL_PARAMETER: if the ptr to sys, room_name, arrivals or
+ *                         completions are NULL
+ *         ILLEGAL_PARAMETER: if the room is not found or span is out of
+ *                            range
+ *         ILLEGAL_TIME: if the time is before the last time known to the
+ *                       system
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_room_rates(ChallengeRoomSystem *sys, char *room_name, int time,
+                         int span, int *arrivals, int *completions) {
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    result = rate_table_start(&sys->room_rates, sys->system_num_rooms);
+    RESULT_STANDARD_CHECK(result);
+    RateWindows *rates = rate_table_at(&sys->room_rates, room_idx);
+    return window_rates(sys, &rates->arrivals, &rates->completions, time,
+                        span, arrivals, completions);
+}
+
+/**
+ * returns the num of visits of a challenge that started and that were
+ * completed in the last span time units, like system_rates. the challenges
+ * are counted from the first request for the rates of a challenge on, which
+ * allocates their windows.
+ * @param sys - ptr to the system
+ * @param challenge_id - the id of the challenge
+ * @param time - the current time
+ * @param span - the num of time units, from 1 to RATE_WINDOW_SPAN
+ * @param arrivals - the ptr to the num of started visits that needs to be
+ *                   updated
+ * @param completions - the ptr to the num of completions that needs to be
+ *                      updated
+ * @return NULL_PARAMETER: if the ptr to sys, arrivals or completions are
+ *                         NULL
+ *         ILLEGAL_PARAMETER: if the challenge is not found or span is out of
+ *                            range
+ *         ILLEGAL_TIME: if the time is before the last time known to the
+ *                       system
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_challenge_rates(ChallengeRoomSystem *sys, int challenge_id,
+                              int time, int span, int *arrivals,
+                              int *completions) {
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    Challenge *challenge = id_index_find(&sys->challenges_index,
+                                         challenge_id);
+    if (challenge == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = rate_table_start(&sys->challenge_rates,
+                                     sys->system_num_challenges);
+    RESULT_STANDARD_CHECK(result);
+    RateWindows *rates = rate_table_at(&sys->challenge_rates,
+                                       challenge->system_idx);
+    return window_rates(sys, &rates->arrivals, &rates->completions, time,
+                        span, arrivals, completions);
+}
+
+/**
+ * takes an immutable view of the statistics of the challenges and the rooms
+ * as they are now, for reports that scan all of them while the system keeps
+ * changing. taking a snapshot is O(1), apart from the first one which builds
+ * the tables shared with the snapshots in O(n). the system then writes its
+ * changes to its own copies of the pages of the tables that snapshots hold,
+ * so a room written while snapshots are held also costs O(n) in the room.
+ * @param sys - ptr to the system
+ * @param snapshot - the snapshot that needs to be initialized
+ * @return NULL_PARAMETER: if the ptr to sys or snapshot are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_snapshot_acquire(ChallengeRoomSystem *sys,
+                               SystemSnapshot *snapshot) {
+    ARENA_CHANGE();
+    if (sys == NULL || snapshot == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (sys->challenge_stats == NULL) {
+        Result result = build_snapshot_tables(sys);
+        RESULT_STANDARD_CHECK(result);
+    }
+    snapshot->time = sys->system_last_known_time;
+    snapshot->num_challenges = sys->challenge_stats->size;
+    snapshot->num_rooms = sys->room_stats->size;
+    snapshot->challenges = snapshot_table_acquire(sys->challenge_stats);
+    snapshot->rooms = snapshot_table_acquire(sys->room_stats);
+    return OK;
+}
+
+/**
+ * releases a snapshot, the pages that only it held are freed.
+ * @param snapshot - ptr to the snapshot
+ * @return NULL_PARAMETER: if the ptr to snapshot is NULL
+ *         OK: if everything went well
+ */
+Result system_snapshot_release(SystemSnapshot *snapshot) {
+    ARENA_CHANGE();
+    if (snapshot == NULL) {
+        return NULL_PARAMETER;
+    }
+    snapshot_table_release(snapshot->challenges);
+    snapshot_table_release(snapshot->rooms);
+    snapshot->challenges = NULL;
+    snapshot->rooms = NULL;
+    snapshot->num_challenges = 0;
+    snapshot->num_rooms = 0;
+    return OK;
+}
+
+/**
+ * returns the statistics of a challenge as of a snapshot. the challenges
+ * are in the order of the challenges table of the system when it was taken.
+ * @param snapshot - ptr to the snapshot
+ * @param idx - the idx of the challenge, smaller than num_challenges
+ * @param match - ptr to the match that needs to be filled, its name is
+ *                valid until the snapshot is released
+ * @return NULL_PARAMETER: if the ptr to snapshot or match are NULL
+ *         ILLEGAL_PARAMETER: if idx is out of range
+ *         OK: if everything went well
+ */
+Result system_snapshot_challenge(SystemSnapshot *snapshot, int idx,
+                                 ChallengeMatch *match) {
+    if (snapshot == NULL || match == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (idx < 0 || idx >= snapshot->num_challenges) {
+        return ILLEGAL_PARAMETER;
+    }
+    ChallengeStats *stats = &snapshot_table_read(snapshot->challenges,
+                                                 idx)->challenge;
+    match->name = stats->name->text;
+    match->id = stats->id;
+    match->level = stats->level;
+    match->num_visits = stats->num_visits;
+    match->best_time = stats->best_time;
+    return OK;
+}
+
+/**
+ * returns the statistics of a room as of a snapshot, like
+ * system_snapshot_challenge.
+ * @param snapshot - ptr to the snapshot
+ * @param idx - the idx of the room, smaller than num_rooms
+ * @param match - ptr to the match that needs to be filled, its name is
+ *                valid until the snapshot is released
+ * @return NULL_PARAMETER: if the ptr to snapshot or match are NULL
+ *         ILLEGAL_PARAMETER: if idx is out of range
+ *         OK: if everything went well
+ */
+Result system_snapshot_room(SystemSnapshot *snapshot, int idx,
+                            RoomMatch *match) {
+    if (snapshot == NULL || match == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (idx < 0 || idx >= snapshot->num_rooms) {
+        return ILLEGAL_PARAMETER;
+    }
+    RoomStats *stats = &snapshot_table_read(snapshot->rooms, idx)->room;
+    match->name = stats->name->text;
+    match->id = stats->id;
+    match->num_challenges = stats->num_challenges;
+    match->num_visitors = stats->num_visitors;
+    match->num_free = stats->num_free;
+    match->num_waiting = stats->num_waiting;
+    return OK;
+}
+
+/**
+ * returns the most popular challenge as of a snapshot, like
+ * most_popular_challenge.
+ * @param snapshot - ptr to the snapshot
+ * @param challenge_name - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to snapshot or challenge_name are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_snapshot_most_popular(SystemSnapshot *snapshot,
+                                    char **challenge_name) {
+    if (snapshot == NULL || challenge_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    *challenge_name = NULL;
+    if (snapshot->num_rooms == 0) {
+        return OK;
+    }
+    ChallengeStats *max = NULL;
+    for (int i = 0; i < snapshot->num_challenges; ++i) {
+        ChallengeStats *stats = &snapshot_table_read(snapshot->challenges,
+                                                     i)->challenge;
+        if (max == NULL || stats->num_visits > max->num_visits ||
+            (stats->num_visits == max->num_visits &&
+             strcmp(stats->name->text, max->name->text) < 0)) {
+            max = stats;
+        }
+    }
+    if (max == NULL || max->num_visits == 0) {
+        //no visits in any of the rooms
+        return OK;
+    }
+    *challenge_name = malloc(strlen(max->name->text) + 1);
+    if (*challenge_name == NULL) {
         return MEMORY_PROBLEM;
     }
-    Result result = init_visitor(new_node->visitor, visitor_name, visitor_id);
-    if (result != OK) {
-        free(new_node);
-        return result;
+    strcpy(*challenge_name, max->name->text);
+    return OK;
+}
+
+/**
+ * counts the bytes taken by the records of the system, to see how much the
+ * compact build (ESCAPY_COMPACT_LINKS) saves. rooms include their assignment
+ * indexes, activities include their bookings and visitors include their
+ * list nodes and the visitors index.
+ * @param sys - ptr to the system
+ * @param usage - ptr to the usage to fill
+ * @return NULL_PARAMETER: if the ptr to sys or usage are NULL
+ *         OK: if everything went well
+ */
+Result system_memory_usage(ChallengeRoomSystem *sys, MemoryUsage *usage) {
+    if (sys == NULL || usage == NULL) {
+        return NULL_PARAMETER;
+    }
+    usage->challenges = sys->system_num_challenges * sizeof(Challenge) +
+                        sys->system_challenges_capacity * sizeof(Challenge *) +
+                        sys->challenges_index.capacity * sizeof(IdIndexEntry) +
+                        sys->challenges_by_name.capacity *
+                        sizeof(NameIndexEntry) +
+                        sys->challenge_names.capacity *
+                        sizeof(PrefixIndexEntry) +
+                        sys->challenge_rates.capacity * sizeof(RateWindows);
+    usage->rooms = sys->system_num_rooms * sizeof(ChallengeRoom) +
+                   sys->system_rooms_capacity * sizeof(ChallengeRoom *) +
+                   sys->room_names.capacity * sizeof(PrefixIndexEntry) +
+                   sys->room_rates.capacity * sizeof(RateWindows);
+    usage->activities = 0;
+    usage->visitors = sys->visitors_index.capacity * sizeof(IdIndexEntry);
+    usage->names = strlen(sys->system_name) + 1;
+    usage->profiles = sys->visitor_profiles == NULL ? 0 :
+                      profile_store_size(sys->visitor_profiles);
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        usage->names += strlen(sys->system_challenges[i]->name) + 1;
+    }
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        ChallengeRoom *room = sys->system_rooms[i];
+        usage->names += strlen(room->name) + 1;
+        usage->rooms += room->assignment.capacity * (All_Levels + 1) *
+                        sizeof(int);
+        usage->activities += room->num_of_challenges *
+                             sizeof(ChallengeActivity) +
+                             room->challenges_capacity *
+                             (sizeof(ChallengeActivity *) +
+                              sizeof(PackedActivity));
+        for (int j = 0; j < room->num_of_challenges; ++j) {
+            usage->activities += room->challenges[j]->bookings.capacity *
+                                 sizeof(Booking);
+        }
+        usage->activities += room->visitor_bookings.capacity *
+                             sizeof(VisitorBooking);
+    }
+    for (VisitorsList ptr = sys->visitors_list_head->next; ptr != NULL;
+         ptr = ptr->next) {
+        usage->visitors += sizeof(*ptr) + sizeof(Visitor);
+        usage->names += strlen(ptr->visitor->visitor_name) + 1;
     }
-    VisitorsList tmp_node = sys->visitors_list_head->next;
-    sys->visitors_list_head->next = new_node;
-    new_node->next = tmp_node;
     return OK;
 }
 
 /**
- * finds a room by its name
+ * writes a report of the system to a file in one pass: its name and time,
+ * then every challenge and every room with their statistics, and every
+ * visitor in a challenge. the records are streamed in chunks through a
+ * single buffer, so the report takes no allocation per record, see
+ * report_writer.h for the formats.
  * @param sys - ptr to the system
- * @param room_name - the name of the wanted room
- * @param room_idx - ptr to the room's idx
- * @return ILLEGAL_PARAMETER: if a challenge with the name given is not found
+ * @param output - the file to write to, which is flushed but not closed
+ * @param format - CSV_REPORT or JSON_REPORT
+ * @return NULL_PARAMETER: if the ptr to sys or output are NULL
+ *         ILLEGAL_PARAMETER: if the format is not a known one
+ *         MEMORY_PROBLEM: if allocation problems have occurred or writing
+ *                         to the file failed, part of the report may have
+ *                         been written
  *         OK: if everything went well
  */
-static Result find_room_by_name(ChallengeRoomSystem *sys, char *room_name,
-                                int *room_idx) {
-    assert(sys != NULL && room_name != NULL && room_idx != NULL);
+Result system_write_report(ChallengeRoomSystem *sys, FILE *output,
+                           ReportFormat format) {
+    static const char *const system_fields[] = {"name", "time"};
+    static const char *const challenge_fields[] = {"id", "name", "level",
+            "num_visits", "best_time"};
+    static const char *const room_fields[] = {"id", "name", "num_challenges",
+            "num_visitors", "num_free", "num_waiting"};
+    static const char *const occupant_fields[] = {"visitor_id",
+            "visitor_name", "room", "challenge", "start_time"};
+    static const char *const level_names[] = {"easy", "medium", "hard"};
+    if (sys == NULL || output == NULL) {
+        return NULL_PARAMETER;
+    }
+    ReportWriter writer;
+    Result result = init_report_writer(&writer, output, format);
+    RESULT_STANDARD_CHECK(result);
+    report_begin_section(&writer, "system", system_fields, 2, 1);
+    report_begin_record(&writer);
+    report_string_field(&writer, sys->system_name);
+    report_int_field(&writer, sys->system_last_known_time);
+    report_end_record(&writer);
+    report_end_section(&writer);
+
+    report_begin_section(&writer, "challenges", challenge_fields, 5, 0);
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        Challenge *challenge = sys->system_challenges[i];
+        report_begin_record(&writer);
+        report_int_field(&writer, challenge->id);
+        report_string_field(&writer, challenge->name);
+        report_string_field(&writer, level_names[challenge->level]);
+        report_int_field(&writer, challenge->num_visits);
+        report_int_field(&writer, challenge->best_time);
+        report_end_record(&writer);
+    }
+    report_end_section(&writer);
+
+    report_begin_section(&writer, "rooms", room_fields, 6, 0);
     for (int i = 0; i < sys->system_num_rooms; ++i) {
-        if (strcmp((sys->system_rooms + i)->name, room_name) == 0) {
-            *room_idx = i;
-            return OK;
+        RoomMatch match;
+        fill_room_match(sys->system_rooms[i], &match);
+        report_begin_record(&writer);
+        report_int_field(&writer, match.id);
+        report_string_field(&writer, match.name);
+        report_int_field(&writer, match.num_challenges);
+        report_int_field(&writer, match.num_visitors);
+        report_int_field(&writer, match.num_free);
+        report_int_field(&writer, match.num_waiting);
+        report_end_record(&writer);
+    }
+    report_end_section(&writer);
+
+    report_begin_section(&writer, "occupants", occupant_fields, 5, 0);
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        RoomOccupantIterator iterator;
+        init_room_occupant_iterator(&iterator, sys->system_rooms[i]);
+        ChallengeActivity *activity = NULL;
+        while ((activity = room_occupant_iterator_next(&iterator)) != NULL) {
+            Visitor *visitor = visitor_at(activity->visitor);
+            report_begin_record(&writer);
+            report_int_field(&writer, visitor->visitor_id);
+            report_string_field(&writer, visitor->visitor_name);
+            report_string_field(&writer, sys->system_rooms[i]->name);
+            report_string_field(&writer,
+                                challenge_at(activity->challenge)->name);
+            report_int_field(&writer, activity->start_time);
+            report_end_record(&writer);
         }
     }
-    return ILLEGAL_PARAMETER;
+    report_end_section(&writer);
+    return finish_report_writer(&writer);
 }
 
 /**
- * resets and frees the allocated memory of a visitor and its node in the list
+ * changes the rule by which all the rooms choose challenges for arriving
+ * visitors, see AssignmentPolicy. the default is LEXICOGRAPHIC_POLICY.
  * @param sys - ptr to the system
- * @param visitor - the wanted visitor to be destroyed
+ * @param policy - the wanted policy
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if the policy is not one of AssignmentPolicy
+ *         OK: if everything went well
  */
-static void destroy_visitor_node(ChallengeRoomSystem *sys, Visitor *visitor) {
-    assert(sys != NULL && visitor != NULL);
-    VisitorsList ptr = sys->visitors_list_head;
-    while (ptr->next != NULL && ptr->next->visitor != visitor) {
-        ptr = ptr->next;
+Result set_system_assignment_policy(ChallengeRoomSystem *sys,
+                                    AssignmentPolicy policy) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (policy < LEXICOGRAPHIC_POLICY || policy > RANDOM_POLICY) {
+        return ILLEGAL_PARAMETER;
+    }
+    sys->system_assignment_policy = policy;
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        set_room_assignment_policy(sys->system_rooms[i], policy);
     }
-    VisitorsList tmp_node = ptr->next->next;
-    reset_visitor(ptr->next->visitor);
-    free(ptr->next->visitor);
-    free(ptr->next);
-    ptr->next = tmp_node;
+    JOURNAL_RECORD(sys, "P %d\n", (int) policy);
+    return OK;
 }
 
 /**
- * finds a visitor by its id and returns a ptr to it
+ * returns the num of visitors waiting in a room for a challenge level
  * @param sys - ptr to the system
- * @param visitor - the ptr that needs to be updated
- * @param visitor_id - the id of the wanted visitor
- * @return NOT_IN_ROOM: if the visitor is not in a room or visitor_id is not
- *         found in the system
+ * @param room_name - the name of the room
+ * @param level - the level of the queue
+ * @param length - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to sys, room_name or length are NULL
+ *         ILLEGAL_PARAMETER: if a room with the name given is not found
  *         OK: if everything went well
  */
-static Visitor *find_visitor_by_id(ChallengeRoomSystem *sys, int visitor_id) {
-    assert(sys != NULL);
-    VisitorsList ptr = sys->visitors_list_head->next;
-    while (ptr != NULL && ptr->visitor->visitor_id != visitor_id) {
-        ptr = ptr->next;
+Result system_wait_queue_length(ChallengeRoomSystem *sys, char *room_name,
+                                Level level, int *length) {
+    if (sys == NULL || room_name == NULL || length == NULL) {
+        return NULL_PARAMETER;
     }
-    if (ptr == NULL) {
-        return NULL;
-    } else {
-        return ptr->visitor;
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    return room_wait_queue_length(sys->system_rooms[room_idx], level, length);
+}
+
+/**
+ * returns for how long a visitor has been waiting for a challenge
+ * @param sys - ptr to the system
+ * @param visitor_id - the id of the visitor
+ * @param time - the current time
+ * @param wait_time - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to sys or wait_time are NULL
+ *         ILLEGAL_TIME: if the time is not greater or equal than the last
+ *                       time known to the system
+ *         NOT_IN_ROOM: if the visitor is not waiting or visitor_id is not
+ *                      found in the system
+ *         OK: if everything went well
+ */
+Result system_visitor_wait_time(ChallengeRoomSystem *sys, int visitor_id,
+                                int time, int *wait_time) {
+    if (sys == NULL || wait_time == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (time < sys->system_last_known_time) {
+        return ILLEGAL_TIME;
+    }
+    Visitor *visitor = find_visitor_by_id(sys, visitor_id);
+    if (visitor == NULL) {
+        return NOT_IN_ROOM;
+    }
+    return visitor_wait_time(visitor, time, wait_time);
+}
+
+/**
+ * books a challenge in a room for a visitor in the window [start, end), the
+ * challenge will not be given to other visitors during the window
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @param challenge_id - the id of the challenge
+ * @param visitor_id - the id of the visitor
+ * @param start_time - the time the window starts
+ * @param end_time - the time the window ends
+ * @return NULL_PARAMETER: if the ptr to sys or room_name are NULL
+ *         ILLEGAL_TIME: if the start_time is not greater or equal than the
+ *                       last time known to the system or end_time is not
+ *                       greater than start_time
+ *         ILLEGAL_PARAMETER: if the room is not found or the challenge is not
+ *                            in it
+ *         NO_AVAILABLE_CHALLENGES: if the window overlaps another booking
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_book_challenge(ChallengeRoomSystem *sys, char *room_name,
+                             int challenge_id, int visitor_id, int start_time,
+                             int end_time) {
+    ARENA_CHANGE();
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (start_time < sys->system_last_known_time) {
+        return ILLEGAL_TIME;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    result = room_book_challenge(sys->system_rooms[room_idx], challenge_id,
+                                 visitor_id, start_time, end_time);
+    RESULT_STANDARD_CHECK(result);
+    pass_booking_boundaries(sys, sys->system_last_known_time);
+    room_changed(sys, sys->system_rooms[room_idx]);
+    JOURNAL_RECORD(sys, "B %s %d %d %d %d\n", room_name, challenge_id,
+                   visitor_id, start_time, end_time);
+    return OK;
+}
+
+/**
+ * cancels the booking of a challenge in a room
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @param challenge_id - the id of the challenge
+ * @param start_time - the time the booking starts
+ * @return NULL_PARAMETER: if the ptr to sys or room_name are NULL
+ *         ILLEGAL_PARAMETER: if the room, the challenge or the booking are
+ *                            not found
+ *         OK: if everything went well
+ */
+Result system_cancel_booking(ChallengeRoomSystem *sys, char *room_name,
+                             int challenge_id, int start_time) {
+    ARENA_CHANGE();
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    result = room_cancel_booking(sys->system_rooms[room_idx], challenge_id,
+                                 start_time);
+    RESULT_STANDARD_CHECK(result);
+    room_changed(sys, sys->system_rooms[room_idx]);
+    JOURNAL_RECORD(sys, "K %s %d %d\n", room_name, challenge_id, start_time);
+    return OK;
+}
+
+/**
+ * finds the first window of a given length, not before after_time, in which
+ * a challenge of the level in the room is not booked
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @param level - wanted level of challenge
+ * @param after_time - the earliest time the window may start
+ * @param duration - the length of the window
+ * @param slot_time - the ptr to the start of the window that needs to be
+ *                    updated
+ * @param challenge_id - the ptr to the id of the challenge that needs to be
+ *                       updated
+ * @return NULL_PARAMETER: if the ptr to sys, room_name, slot_time or
+ *                         challenge_id are NULL
+ *         ILLEGAL_PARAMETER: if the room is not found or duration is not
+ *                            positive
+ *         NO_AVAILABLE_CHALLENGES: if the room has no challenge of the level
+ *         OK: if everything went well
+ */
+Result system_first_free_slot(ChallengeRoomSystem *sys, char *room_name,
+                              Level level, int after_time, int duration,
+                              int *slot_time, int *challenge_id) {
+    if (sys == NULL || room_name == NULL || slot_time == NULL ||
+        challenge_id == NULL) {
+        return NULL_PARAMETER;
     }
-}
\ No newline at end of file
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    ChallengeRoom *room = sys->system_rooms[room_idx];
+    int challenge_idx = 0;
+    result = room_first_free_slot(room, level, after_time, duration,
+                                  slot_time, &challenge_idx);
+    RESULT_STANDARD_CHECK(result);
+    ChallengeActivity *activity = room->challenges[challenge_idx];
+    *challenge_id = challenge_at(activity->challenge)->id;
+    return OK;
+}
+
+/**
+ * returns the room name in which the visitor is in
+ * @param sys - ptr to the system
+ * @param visitor_name - the name of the visitor
+ * @param room_name - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if a visitor_name or room_name are NULL
+ *         NOT_IN_ROOM: if the visitor is not in a room
+ *         OK: if everything went well
+ */
+Result system_room_of_visitor(ChallengeRoomSystem *sys, char *visitor_name,
+                              char **room_name) {
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (visitor_name == NULL || room_name == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    VisitorsList ptr = sys->visitors_list_head->next;
+    while (ptr != NULL) {
+        if (strcmp(ptr->visitor->visitor_name, visitor_name) == 0) {
+            Result result = room_of_visitor(ptr->visitor, room_name);
+            return result;
+        }
+        ptr = ptr->next;
+    }
+    //if we got here it means that the visitor is not in the system
+    return NOT_IN_ROOM;
+}
+
+/**
+ * changes the name of a challenge in the system
+ * @param sys - ptr to the system
+ * @param challenge_id - the id of the challenge
+ * @param new_name - the wanted name for the challenge
+ * @return NULL_PARAMETER: if the ptr to sys or new_name are NULL
+ *         ILLEGAL_PARAMETER: if a challenge with the name given is not found
+ *                            or the journal can't keep the new name
+ *         OK: if everything went well
+ */
+Result change_challenge_name(ChallengeRoomSystem *sys, int challenge_id,
+                             char *new_name) {
+    ARENA_CHANGE();
+    if (sys == NULL || new_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    Challenge *challenge = id_index_find(&sys->challenges_index,
+                                         challenge_id);
+    if (challenge == NULL || !journal_accepts_name(sys, new_name)) {
+        //did'nt find a challenge with the id given
+        return ILLEGAL_PARAMETER;
+    }
+    //the old name stops resolving as the new one starts, the inserts right
+    //after the removals never fail
+    name_index_remove(&sys->challenges_by_name, challenge->name, challenge);
+    prefix_index_remove(&sys->challenge_names, challenge->name, challenge);
+    Result result = change_name(challenge, new_name);
+    name_index_insert(&sys->challenges_by_name, challenge->name, challenge);
+    prefix_index_insert(&sys->challenge_names, challenge->name, challenge);
+    RESULT_STANDARD_CHECK(result);
+    rename_challenge_activities(challenge);
+    publish_challenge(sys, challenge);
+    JOURNAL_RECORD(sys, "C %d %s\n", challenge_id, new_name);
+    return OK;
+}
+
+/**
+ * changes the level of a challenge in the system, its free activities are
+ * offered for the new level right away and the occupied ones once they are
+ * freed. visitors already in the challenge keep it.
+ * @param sys - ptr to the system
+ * @param challenge_id - the id of the challenge
+ * @param level - the new level of the challenge
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if the challenge is not in the system or the
+ *                            level is not one of Easy, Medium and Hard
+ *         OK: if everything went well
+ */
+Result change_system_challenge_level(ChallengeRoomSystem *sys,
+                                     int challenge_id, Level level) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    Challenge *challenge = id_index_find(&sys->challenges_index,
+                                         challenge_id);
+    if (challenge == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = change_challenge_level(challenge, level);
+    RESULT_STANDARD_CHECK(result);
+    publish_challenge(sys, challenge);
+    //the free activities of the challenge moved to the new level
+    for (ChallengeActivity *activity = activity_at(challenge->activities);
+         activity != NULL; activity = activity_at(activity->next_instance)) {
+        index_free_slots(sys, room_at(activity->room));
+    }
+    JOURNAL_RECORD(sys, "L %d %d\n", challenge_id, (int) level);
+    return OK;
+}
+
+/**
+ * changes the name of a room in the system
+ * @param sys - ptr to the system
+ * @param current_name - the name of the room
+ * @param new_name - the wanted name of the room
+ * @return NULL_PARAMETER: if the ptr to sys, current_name or new_name are NULL
+ *         ILLEGAL_PARAMETER: if a room with the name given is not found or
+ *                            the journal can't keep the new name
+ *         OK: if everything went well
+ */
+Result change_system_room_name(ChallengeRoomSystem *sys, char *current_name,
+                               char *new_name) {
+    ARENA_CHANGE();
+    if (sys == NULL || current_name == NULL || new_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (!journal_accepts_name(sys, new_name)) {
+        return ILLEGAL_PARAMETER;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, current_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    ChallengeRoom *room = sys->system_rooms[room_idx];
+    prefix_index_remove(&sys->room_names, room->name, room);
+    result = change_room_name(room, new_name);
+    prefix_index_insert(&sys->room_names, room->name, room);
+    RESULT_STANDARD_CHECK(result);
+    room_changed(sys, room);
+    JOURNAL_RECORD(sys, "R %s %s\n", current_name, new_name);
+    return OK;
+}
+
+/**
+ * adds a challenge to the system at runtime, it is in no room until it is
+ * attached to one.
+ * @param sys - ptr to the system
+ * @param challenge_id - the id of the challenge
+ * @param name - the name of the challenge
+ * @param level - the level of the challenge
+ * @return NULL_PARAMETER: if the ptr to sys or name are NULL
+ *         ILLEGAL_PARAMETER: if the id is already in the system, the level
+ *                            is not one of Easy, Medium and Hard or the
+ *                            journal can't keep the name
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_add_challenge(ChallengeRoomSystem *sys, int challenge_id,
+                            char *name, Level level) {
+    ARENA_CHANGE();
+    if (sys == NULL || name == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (level < Easy || level >= All_Levels ||
+        id_index_find(&sys->challenges_index, challenge_id) != NULL ||
+        !journal_accepts_name(sys, name)) {
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = insert_system_challenge(sys, challenge_id, name, level);
+    RESULT_STANDARD_CHECK(result);
+    publish_challenge(sys,
+                      sys->system_challenges[sys->system_num_challenges - 1]);
+    JOURNAL_RECORD(sys, "N %d %d %s\n", challenge_id, (int) level, name);
+    return OK;
+}
+
+/**
+ * retires a challenge of the system at runtime, it is detached from all the
+ * rooms, their bookings of it are cancelled and its statistics are lost.
+ * the last challenge of the challenges table takes its place.
+ * @param sys - ptr to the system
+ * @param challenge_id - the id of the challenge
+ * @return NULL_PARAMETER: if the ptr to sys is NULL
+ *         ILLEGAL_PARAMETER: if the challenge is not in the system
+ *         ALREADY_IN_ROOM: if a visitor is in one of its activities
+ *         OK: if everything went well
+ */
+Result system_remove_challenge(ChallengeRoomSystem *sys, int challenge_id) {
+    ARENA_CHANGE();
+    if (sys == NULL) {
+        return NULL_PARAMETER;
+    }
+    Challenge *challenge = id_index_find(&sys->challenges_index,
+                                         challenge_id);
+    if (challenge == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    for (ChallengeActivity *activity = activity_at(challenge->activities);
+         activity != NULL; activity = activity_at(activity->next_instance)) {
+        if (activity->visitor != NULL_LINK) {
+            return ALREADY_IN_ROOM;
+        }
+    }
+    while (challenge->activities != NULL_LINK) {
+        ChallengeActivity *activity = activity_at(challenge->activities);
+        ChallengeRoom *room = room_at(activity->room);
+        room_detach_activity(activity);
+        room_changed(sys, room);
+    }
+    id_index_remove(&sys->challenges_index, challenge_id);
+    name_index_remove(&sys->challenges_by_name, challenge->name, challenge);
+    prefix_index_remove(&sys->challenge_names, challenge->name, challenge);
+    Challenge *last = sys->system_challenges[sys->system_num_challenges - 1];
+    sys->system_challenges[challenge->system_idx] = last;
+    last->system_idx = challenge->system_idx;
+    sys->system_num_challenges--;
+    rate_table_remove(&sys->challenge_rates, challenge->system_idx);
+    unpublish_record(sys, &sys->challenge_stats, challenge->system_idx);
+    reset_challenge(challenge);
+    free(challenge);
+    JOURNAL_RECORD(sys, "D %d\n", challenge_id);
+    return OK;
+}
+
+/**
+ * adds an empty room to the system at runtime, challenges are attached to
+ * it with system_attach_challenge. the room gets the assignment policy of
+ * the system.
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @return NULL_PARAMETER: if the ptr to sys or room_name are NULL
+ *         ILLEGAL_PARAMETER: if a room with the name is already in the system
+ *                            or the journal can't keep the name
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_add_room(ChallengeRoomSystem *sys, char *room_name) {
+    ARENA_CHANGE();
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    int room_idx = 0;
+    if (find_room_by_name(sys, room_name, &room_idx) == OK ||
+        !journal_accepts_name(sys, room_name)) {
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = insert_system_room(sys, room_name, 0);
+    RESULT_STANDARD_CHECK(result);
+    room_changed(sys, sys->system_rooms[sys->system_num_rooms - 1]);
+    JOURNAL_RECORD(sys, "M %s\n", room_name);
+    return OK;
+}
+
+/**
+ * retires a room of the system at runtime. the visitors waiting in its
+ * queues are removed from the system, as in room_visitors_quit. the last
+ * room of the rooms table takes its place, its id is never reused.
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @return NULL_PARAMETER: if the ptr to sys or room_name are NULL
+ *         ILLEGAL_PARAMETER: if a room with the name given is not found
+ *         ALREADY_IN_ROOM: if a visitor is in one of its activities
+ *         OK: if everything went well
+ */
+Result system_remove_room(ChallengeRoomSystem *sys, char *room_name) {
+    ARENA_CHANGE();
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    return remove_room_at(sys, room_idx);
+}
+
+/**
+ * attaches a challenge of the system to a room at runtime, as a new free
+ * activity of the room.
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @param challenge_id - the id of the challenge
+ * @return NULL_PARAMETER: if the ptr to sys or room_name are NULL
+ *         ILLEGAL_PARAMETER: if the room or the challenge is not found
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result system_attach_challenge(ChallengeRoomSystem *sys, char *room_name,
+                               int challenge_id) {
+    ARENA_CHANGE();
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    Challenge *challenge = id_index_find(&sys->challenges_index,
+                                         challenge_id);
+    if (challenge == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    return attach_room_challenge(sys, sys->system_rooms[room_idx], challenge);
+}
+
+/**
+ * detaches a free activity of a challenge from a room at runtime, its
+ * bookings are cancelled.
+ * @param sys - ptr to the system
+ * @param room_name - the name of the room
+ * @param challenge_id - the id of the challenge
+ * @return NULL_PARAMETER: if the ptr to sys or room_name are NULL
+ *         ILLEGAL_PARAMETER: if the room is not found or the challenge is
+ *                            not in it
+ *         ALREADY_IN_ROOM: if all the activities of the challenge in the
+ *                          room are occupied by visitors
+ *         OK: if everything went well
+ */
+Result system_detach_challenge(ChallengeRoomSystem *sys, char *room_name,
+                               int challenge_id) {
+    ARENA_CHANGE();
+    if (sys == NULL || room_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    int room_idx = 0;
+    Result result = find_room_by_name(sys, room_name, &room_idx);
+    RESULT_STANDARD_CHECK(result);
+    return detach_room_challenge(sys, sys->system_rooms[room_idx],
+                                 challenge_id);
+}
+
+/**
+ * applies the changes of an init file to the running system without
+ * recreating it. the challenges are matched by id and the rooms by name:
+ * challenges and rooms that are new are added, ones that are not in the
+ * file any more are removed, a challenge whose name or level changed is
+ * updated in place and the challenges of a room are attached or detached
+ * to match the file. the records that are kept keep their statistics,
+ * visitors and bookings, and an occupied activity is never detached.
+ * the name of the system is not changed. the changes are journaled, the
+ * journal stays the one of the init file the system was created from.
+ * the whole file is checked before anything changes. past reading the file
+ * and matching its challenges and rooms to the system, a reload costs as
+ * much as its changes: a room whose challenges are the same is not
+ * compared, and the snapshot tables and the free slot index follow each
+ * change rather than being built again.
+ * in the fixed capacity build the file is loaded into the spare of the
+ * arena, so it must be small.
+ * @param sys - ptr to the system
+ * @param init_file - the file with the new specifications
+ * @return NULL_PARAMETER: if the ptr to sys or init_file are NULL, or the
+ *                         file can't be opened
+ *         ILLEGAL_PARAMETER: if the file is malformed or the journal can't
+ *                            keep a name of a new or renamed challenge or
+ *                            room, in which case nothing is changed
+ *         ALREADY_IN_ROOM: if the file removes a challenge or room that a
+ *                          visitor is in, in which case nothing is changed
+ *         MEMORY_PROBLEM: if allocation problems have occurred, in which
+ *                         case some of the changes may have been applied
+ *         OK: if everything went well
+ */
+Result reload_system(ChallengeRoomSystem *sys, char *init_file) {
+    ARENA_CHANGE();
+    if (sys == NULL || init_file == NULL) {
+        return NULL_PARAMETER;
+    }
+    InitFileLoad load;
+    Result result = load_init_file(&load, init_file, 1);
+    RESULT_STANDARD_CHECK(result);
+    ReloadPlan plan;
+    plan.num_rooms = load.num_rooms;
+    plan.removed_challenges = NULL;
+    plan.num_removed_challenges = 0;
+    plan.removed_rooms = NULL;
+    plan.num_removed_rooms = 0;
+    plan.rooms = malloc(((size_t) load.num_rooms + 1) * sizeof(*plan.rooms));
+    if (plan.rooms == NULL ||
+        init_id_index(&plan.challenges, load.num_challenges) != OK) {
+        free(plan.rooms);
+        reset_init_file_load(&load);
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < load.num_challenges && result == OK; ++i) {
+        if (id_index_find(&plan.challenges, load.challenges[i]->id) == NULL) {
+            result = id_index_insert(&plan.challenges, load.challenges[i]->id,
+                                     load.challenges[i]);
+        }
+    }
+    for (int i = 0; i < load.num_rooms; ++i) {
+        plan.rooms[i].name = load.rooms[i]->name;
+        plan.rooms[i].challenge_ids = load.room_challenge_ids[i];
+        plan.rooms[i].num_challenges = load.rooms[i]->num_of_challenges;
+        plan.rooms[i].idx = i;
+        plan.rooms[i].room = NULL;
+        plan.rooms[i].challenge_ids_hash = 0;
+    }
+    qsort(plan.rooms, (size_t) load.num_rooms, sizeof(*plan.rooms),
+          compare_reload_rooms);
+    if (result == OK) {
+        result = check_reload(sys, &load, &plan);
+    }
+    if (result == OK) {
+        result = reload_challenges(sys, &load, &plan.challenges);
+    }
+    if (result == OK) {
+        result = reload_rooms(sys, &plan);
+    }
+    //the challenges that are not in the file are removed last, after the
+    //rooms that are removed with them
+    for (int i = 0; i < plan.num_removed_challenges && result == OK; ++i) {
+        result = system_remove_challenge(sys, plan.removed_challenges[i]);
+    }
+    reset_id_index(&plan.challenges);
+    free(plan.rooms);
+    free(plan.removed_challenges);
+    free(plan.removed_rooms);
+    reset_init_file_load(&load);
+    return result;
+}
+
+/**
+ * returns the best time for a specific challenge, found by name in O(1) on
+ * average. out of challenges with the same name the first one in the
+ * challenges table is used.
+ * @param sys - ptr to the system
+ * @param challenge_name - the name of the challenge
+ * @param time - the ptr that need to be updated
+ * @return NULL_PARAMETER: if the ptr to sys, challenge_name or time are NULL
+ *         ILLEGAL_PARAMETER: if a challenge with the name given is not found
+ *         OK: if everything went well
+ */
+Result best_time_of_system_challenge(ChallengeRoomSystem *sys,
+                                     char *challenge_name, int *time) {
+    if (sys == NULL || challenge_name == NULL || time == NULL) {
+        return NULL_PARAMETER;
+    }
+    Challenge *first = NULL, *challenge = NULL;
+    int cursor = 0;
+    while ((challenge = name_index_find(&sys->challenges_by_name,
+                                        challenge_name, &cursor)) != NULL) {
+        if (first == NULL || challenge->system_idx < first->system_idx) {
+            first = challenge;
+        }
+    }
+    if (first == NULL) {
+        //did'nt find a challenge with the name given
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = best_time_of_challenge(first, time);
+    RESULT_STANDARD_CHECK(result);
+    return OK;
+}
+
+/**
+ * initializes an iterator over the challenges whose name starts with a
+ * prefix, in name order. the first one is found in O(log n) and each next
+ * one in O(1). the system must not change during the search.
+ * @param sys - ptr to the system
+ * @param prefix - the prefix, which is not copied, "" finds all of them
+ * @param iterator - the iterator that needs to be initialized
+ * @return NULL_PARAMETER: if the ptr to sys, prefix or iterator are NULL
+ *         OK: if everything went well
+ */
+Result system_search_challenges(ChallengeRoomSystem *sys, char *prefix,
+                                PrefixIterator *iterator) {
+    if (sys == NULL || prefix == NULL || iterator == NULL) {
+        return NULL_PARAMETER;
+    }
+    return init_prefix_iterator(iterator, &sys->challenge_names, prefix);
+}
+
+/**
+ * returns the next challenge of a search with its statistics.
+ * @param iterator - ptr to an iterator of system_search_challenges
+ * @param match - ptr to the match that needs to be filled
+ * @return 1 if a challenge was found, 0 if there are no more
+ */
+int system_next_challenge_match(PrefixIterator *iterator,
+                                ChallengeMatch *match) {
+    assert(iterator != NULL && match != NULL);
+    Challenge *challenge = prefix_iterator_next(iterator);
+    if (challenge == NULL) {
+        return 0;
+    }
+    fill_challenge_match(challenge, match);
+    return 1;
+}
+
+/**
+ * initializes an iterator over the rooms whose name starts with a prefix,
+ * like system_search_challenges.
+ * @param sys - ptr to the system
+ * @param prefix - the prefix, which is not copied, "" finds all of them
+ * @param iterator - the iterator that needs to be initialized
+ * @return NULL_PARAMETER: if the ptr to sys, prefix or iterator are NULL
+ *         OK: if everything went well
+ */
+Result system_search_rooms(ChallengeRoomSystem *sys, char *prefix,
+                           PrefixIterator *iterator) {
+    if (sys == NULL || prefix == NULL || iterator == NULL) {
+        return NULL_PARAMETER;
+    }
+    return init_prefix_iterator(iterator, &sys->room_names, prefix);
+}
+
+/**
+ * returns the next room of a search with its statistics, counting its
+ * visitors is O(n) in the room.
+ * @param iterator - ptr to an iterator of system_search_rooms
+ * @param match - ptr to the match that needs to be filled
+ * @return 1 if a room was found, 0 if there are no more
+ */
+int system_next_room_match(PrefixIterator *iterator, RoomMatch *match) {
+    assert(iterator != NULL && match != NULL);
+    ChallengeRoom *room = prefix_iterator_next(iterator);
+    if (room == NULL) {
+        return 0;
+    }
+    fill_room_match(room, match);
+    return 1;
+}
+
+/**
+ * returns the challenge with the highest num of visits in the room, in case
+ * there are more than one, the lexicographically smallest one will be returned
+ * @param sys - ptr to the system
+ * @param challenge_name - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to sys or challenge_name are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result most_popular_challenge(ChallengeRoomSystem *sys, char **challenge_name) {
+    if (sys == NULL || challenge_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (sys->system_num_rooms == 0 || sys->system_num_challenges == 0) {
+        *challenge_name = NULL;
+        return OK;
+    }
+    int max_idx = 0, max = 0, curr = 0;
+    Result result = num_visits(sys->system_challenges[0], &max);
+    RESULT_STANDARD_CHECK(result);
+    for (int i = 1; i < sys->system_num_challenges; ++i) {
+        result = num_visits(sys->system_challenges[i], &curr);
+        RESULT_STANDARD_CHECK(result);
+        if (curr > max) {
+            max_idx = i;
+            max = curr;
+        } else if (curr == max &&
+                   strcmp(sys->system_challenges[i]->name,
+                          sys->system_challenges[max_idx]->name) < 0) {
+            max_idx = i;
+        }
+    }
+    if (max == 0) {
+        //no visits in any of the rooms
+        *challenge_name = NULL;
+    } else {
+        *challenge_name = malloc(
+                strlen(sys->system_challenges[max_idx]->name) + 1);
+        if (*challenge_name == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        strcpy(*challenge_name, sys->system_challenges[max_idx]->name);
+    }
+    return OK;
+}
+
+/**
+ * free the allocated memory of the system
+ * @param sys - ptr to the system
+ */
+static void free_system_name(ChallengeRoomSystem *sys) {
+    free(sys->system_name);
+    return;
+}
+
+/**
+ * frees all the memory that was allocated previously and the memory of
+ * each challenge, the challenge table and the index of the challenges.
+ * @param sys - ptr to the system
+ * @param num_challenges - num of the challenges in the system
+ */
+static void free_system_challenges_and_previous(ChallengeRoomSystem *sys) {
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        reset_challenge(sys->system_challenges[i]);
+        free(sys->system_challenges[i]);
+    }
+    free(sys->system_challenges);
+    reset_id_index(&sys->challenges_index);
+    reset_name_index(&sys->challenges_by_name);
+    reset_prefix_index(&sys->challenge_names);
+    sys->system_num_challenges = 0;
+    free_system_name(sys);
+    return;
+}
+
+/**
+ * frees all the memory that was allocated previously and the memory of
+ * each room and the room table itself.
+ * @param sys - ptr to system
+ */
+static void free_system_rooms_and_previous(ChallengeRoomSystem *sys) {
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        reset_room(sys->system_rooms[i]);
+        free(sys->system_rooms[i]);
+    }
+    free(sys->system_rooms);
+    reset_prefix_index(&sys->room_names);
+    sys->system_num_rooms = 0;
+    sys->system_last_known_time = 0;
+    free_system_challenges_and_previous(sys);
+    return;
+}
+
+/**
+ * sets the fields of a new system that don't come from the init file
+ * @param sys - ptr to the system
+ */
+static void init_system_fields(ChallengeRoomSystem *sys) {
+    sys->system_name = NULL;
+    sys->system_challenges = NULL;
+    sys->system_rooms = NULL;
+    sys->challenges_index.entries = NULL;
+    sys->challenges_by_name.entries = NULL;
+    sys->challenge_names.entries = NULL;
+    sys->room_names.entries = NULL;
+    sys->system_last_known_time = 0;
+    sys->system_num_rooms = 0;
+    sys->system_num_challenges = 0;
+    sys->system_next_room_id = 0;
+    sys->system_assignment_policy = LEXICOGRAPHIC_POLICY;
+    sys->wait_queues_enabled = 0;
+    sys->event_buffer = NULL;
+    sys->journal = NULL;
+    sys->visitor_profiles = NULL;
+    sys->challenge_stats = NULL;
+    sys->room_stats = NULL;
+    sys->free_slots.nodes = NULL;
+    sys->free_slots.size = 0;
+    sys->free_slots.capacity = 0;
+    for (int level = Easy; level < All_Levels; ++level) {
+        sys->session_limits[level] = 0;
+    }
+    init_timer_wheel(&sys->session_timers, 0);
+    init_timer_wheel(&sys->booking_timers, 0);
+    sys->timeout_handler = NULL;
+    sys->timeout_context = NULL;
+    init_rate_window(&sys->arrivals);
+    init_rate_window(&sys->completions);
+    init_rate_table(&sys->challenge_rates);
+    init_rate_table(&sys->room_rates);
+    return;
+}
+
+/**
+ * updates the name field in the system
+ * @param sys - ptr to the system
+ * @param input_file - the file with the wanted name
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result update_system_name(ChallengeRoomSystem *sys, FILE *input_file) {
+    char name[WORD_MAX_LEN] = "";
+    fscanf(input_file, "%s\n", name);
+    sys->system_name = malloc(strlen(name) + 1);
+    if (sys->system_name == NULL) {
+        free(sys);
+        return MEMORY_PROBLEM;
+    }
+    strcpy(sys->system_name, name);
+    return OK;
+}
+
+/**
+ * creates the challenges table in the system and the indexes of the
+ * challenges by id and by name
+ * @param sys - ptr to the system
+ * @param input_file - the file with the specifications for the challenges
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result create_system_challenges(ChallengeRoomSystem *sys,
+                                       FILE *input_file) {
+    char challenge_name[WORD_MAX_LEN] = "";
+    int num_challenges = 0;
+    fscanf(input_file, "%d\n", &num_challenges);
+    sys->system_challenges_capacity = num_challenges > 0 ? num_challenges : 1;
+    sys->system_challenges = malloc(sys->system_challenges_capacity *
+                                    sizeof(*sys->system_challenges));
+    if (sys->system_challenges == NULL) {
+        free_system_name(sys);
+        return MEMORY_PROBLEM;
+    }
+    if (init_id_index(&sys->challenges_index, num_challenges) != OK) {
+        free(sys->system_challenges);
+        free_system_name(sys);
+        return MEMORY_PROBLEM;
+    }
+    if (init_name_index(&sys->challenges_by_name, num_challenges) != OK) {
+        reset_id_index(&sys->challenges_index);
+        free(sys->system_challenges);
+        free_system_name(sys);
+        return MEMORY_PROBLEM;
+    }
+
+    for (int i = 0; i < num_challenges; ++i) {
+        int level = 0, id = 0;
+        fscanf(input_file, "%s %d %d\n", challenge_name, &id, &level);
+        Result result = insert_system_challenge(sys, id, challenge_name,
+                                                (Level) level - 1);
+        if (result != OK) {
+            free_system_challenges_and_previous(sys);
+            return result;
+        }
+    }
+    return OK;
+}
+
+/**
+ * finds the right challenge by id and initialize the activity accordingly,
+ * its name is ranked with the rest of the room by rank_room_activities
+ * @param sys - ptr to the system
+ * @param challenge_id - the id of the wanted challenge
+ * @param activity_idx - the idx of the current activity
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result add_challenge_to_room(ChallengeRoomSystem *sys, int challenge_id,
+                                    int activity_idx, int room_idx) {
+    Challenge *challenge = id_index_find(&sys->challenges_index,
+                                         challenge_id);
+    if (challenge == NULL) {
+        return OK;
+    }
+    ChallengeActivity *activity =
+            sys->system_rooms[room_idx]->challenges[activity_idx];
+    Result result = init_room_challenge_activity(activity, challenge);
+    if (result != OK) {
+        free_system_rooms_and_previous(sys);
+        return result;
+    }
+    link_challenge_instance(activity);
+    return OK;
+}
+
+/**
+ * adds the challenge activities to each room
+ * @param sys - ptr to the system
+ * @param input_file - the file with the specifications for the activities
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result rooms_add_challenge_activities(ChallengeRoomSystem *sys,
+                                             FILE *input_file,
+                                             int num_rooms) {
+    char room_name[WORD_MAX_LEN] = "";
+    for (int i = 0; i < num_rooms; ++i) {
+        int num_challenges_in_room = 0;
+        fscanf(input_file, "%s %d", room_name, &num_challenges_in_room);
+        if (num_challenges_in_room == 0) {
+            free_system_rooms_and_previous(sys);
+            return ILLEGAL_PARAMETER;
+        }
+        Result result = insert_system_room(sys, room_name,
+                                           num_challenges_in_room);
+        if (result != OK) {
+            free_system_rooms_and_previous(sys);
+            return result;
+        }
+        for (int j = 0; j < num_challenges_in_room; ++j) {
+            int challenge_id = 0;
+            if (j != num_challenges_in_room - 1) {
+                fscanf(input_file, "%d", &challenge_id);
+            } else {
+                //if that's the last id move cursor to the start of next line
+                fscanf(input_file, "%d\n", &challenge_id);
+            }
+            result = add_challenge_to_room(sys, challenge_id, j, i);
+            if (result != OK) {
+                free_system_rooms_and_previous(sys);
+                return result;
+            }
+        }
+        result = rank_room_activities(sys->system_rooms[i]);
+        if (result != OK) {
+            free_system_rooms_and_previous(sys);
+            return result;
+        }
+    }
+    return OK;
+}
+
+/**
+ * creates the rooms table in the system
+ * @param sys - ptr to the system
+ * @param input_file - the file with the specifications for the rooms
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result create_system_rooms(ChallengeRoomSystem *sys, FILE *input_file) {
+    int num_rooms = 0;
+    fscanf(input_file, "%d\n", &num_rooms);
+    sys->system_rooms_capacity = num_rooms > 0 ? num_rooms : 1;
+    sys->system_rooms = malloc(sys->system_rooms_capacity *
+                               sizeof(*sys->system_rooms));
+    if (sys->system_rooms == NULL) {
+        free_system_challenges_and_previous(sys);
+        return NULL_PARAMETER;
+    }
+    Result result = rooms_add_challenge_activities(sys, input_file, num_rooms);
+    RESULT_STANDARD_CHECK(result);
+    result = index_system_names(sys);
+    if (result != OK) {
+        free_system_rooms_and_previous(sys);
+    }
+    return result;
+}
+
+#ifndef ESCAPY_FIXED_CAPACITY
+/**
+ * takes over the name, challenges and rooms of a load and indexes the
+ * challenges by id and by name. the first challenge with an id is kept in
+ * the index by id, like insert_system_challenge. the load keeps its ptrs to
+ * them until its rooms are linked, then they must be set to NULL in the load.
+ * @param sys - ptr to the system
+ * @param load - ptr to the load of the init file
+ * @return MEMORY_PROBLEM: if allocation problems have occurred, in which
+ *                         case the records are still taken over
+ *         OK: if everything went well
+ */
+static Result take_loaded_records(ChallengeRoomSystem *sys,
+                                  InitFileLoad *load) {
+    sys->system_name = load->system_name;
+    sys->system_challenges = load->challenges;
+    sys->system_num_challenges = load->num_challenges;
+    sys->system_challenges_capacity = load->num_challenges > 0 ?
+                                      load->num_challenges : 1;
+    sys->system_rooms = load->rooms;
+    sys->system_num_rooms = load->num_rooms;
+    sys->system_rooms_capacity = load->num_rooms > 0 ? load->num_rooms : 1;
+    Result result = init_id_index(&sys->challenges_index,
+                                  sys->system_num_challenges);
+    if (result != OK) {
+        return result;
+    }
+    result = init_name_index(&sys->challenges_by_name,
+                             sys->system_num_challenges);
+    if (result != OK) {
+        return result;
+    }
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        Challenge *challenge = sys->system_challenges[i];
+        challenge->system_idx = i;
+        result = name_index_insert(&sys->challenges_by_name, challenge->name,
+                                   challenge);
+        if (result != OK) {
+            return result;
+        }
+        if (id_index_find(&sys->challenges_index, challenge->id) == NULL) {
+            result = id_index_insert(&sys->challenges_index, challenge->id,
+                                     challenge);
+            if (result != OK) {
+                return result;
+            }
+        }
+    }
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        sys->system_rooms[i]->id = sys->system_next_room_id++;
+        sys->system_rooms[i]->system_idx = i;
+        sys->system_rooms[i]->booking_timers = &sys->booking_timers;
+        set_room_assignment_policy(sys->system_rooms[i],
+                                   sys->system_assignment_policy);
+    }
+    return index_system_names(sys);
+}
+#endif
+
+/**
+ * doubles the capacity of a table of records when it is full. the records
+ * are not moved, only the table of ptrs to them.
+ * @param table - the table
+ * @param size - the num of records in the table
+ * @param capacity - ptr to the capacity of the table, updated if it grows
+ * @param element_size - the size of an entry of the table
+ * @return the table, which may have moved, NULL if allocation problems have
+ *         occurred, in which case the table is not changed
+ */
+static void *grow_table(void *table, int size, int *capacity,
+                        size_t element_size) {
+    if (size < *capacity) {
+        return table;
+    }
+    int new_capacity = *capacity > 0 ? 2 * *capacity : 1;
+    void *new_table = realloc(table, new_capacity * element_size);
+    if (new_table != NULL) {
+        *capacity = new_capacity;
+    }
+    return new_table;
+}
+
+/**
+ * allocates a challenge and adds it to the challenges table and indexes of
+ * the system, in amortized O(1) apart from the sorted names, which are
+ * indexed in bulk while the system is created, see index_system_names.
+ * a challenge whose id is already in the system is not found by id, as the
+ * first one with the id is kept.
+ * @param sys - ptr to the system
+ * @param id - the id of the challenge
+ * @param name - the name of the challenge
+ * @param level - the level of the challenge
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result insert_system_challenge(ChallengeRoomSystem *sys, int id,
+                                      char *name, Level level) {
+    PrefixIndex *names = &sys->challenge_names;
+    if (names->entries != NULL &&
+        prefix_index_reserve(names, names->size + 1) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    Challenge **challenges = grow_table(sys->system_challenges,
+                                        sys->system_num_challenges,
+                                        &sys->system_challenges_capacity,
+                                        sizeof(*challenges));
+    if (challenges == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    sys->system_challenges = challenges;
+    if (rate_table_reserve(&sys->challenge_rates,
+                           sys->system_num_challenges + 1) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    Challenge *challenge = malloc(sizeof(*challenge));
+    if (challenge == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    Result result = init_challenge(challenge, id, name, level);
+    if (result != OK) {
+        free(challenge);
+        return result;
+    }
+    result = name_index_insert(&sys->challenges_by_name, challenge->name,
+                               challenge);
+    if (result == OK && id_index_find(&sys->challenges_index, id) == NULL) {
+        result = id_index_insert(&sys->challenges_index, id, challenge);
+        if (result != OK) {
+            name_index_remove(&sys->challenges_by_name, challenge->name,
+                              challenge);
+        }
+    }
+    if (result != OK) {
+        reset_challenge(challenge);
+        free(challenge);
+        return result;
+    }
+    challenge->system_idx = sys->system_num_challenges;
+    challenges[sys->system_num_challenges++] = challenge;
+    rate_table_append(&sys->challenge_rates);
+    if (names->entries != NULL) {
+        prefix_index_insert(names, challenge->name, challenge);
+    }
+    return OK;
+}
+
+/**
+ * allocates a room with a new id and adds it to the rooms table of the
+ * system, in amortized O(1) apart from the sorted names, like
+ * insert_system_challenge.
+ * @param sys - ptr to the system
+ * @param name - the name of the room
+ * @param num_challenges - the num of activities to create in the room
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result insert_system_room(ChallengeRoomSystem *sys, char *name,
+                                 int num_challenges) {
+    PrefixIndex *names = &sys->room_names;
+    if (names->entries != NULL &&
+        prefix_index_reserve(names, names->size + 1) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    ChallengeRoom **rooms = grow_table(sys->system_rooms,
+                                       sys->system_num_rooms,
+                                       &sys->system_rooms_capacity,
+                                       sizeof(*rooms));
+    if (rooms == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    sys->system_rooms = rooms;
+    if (rate_table_reserve(&sys->room_rates, sys->system_num_rooms + 1) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    ChallengeRoom *room = malloc(sizeof(*room));
+    if (room == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    Result result = init_room(room, name, num_challenges);
+    if (result != OK) {
+        free(room);
+        return result;
+    }
+    room->id = sys->system_next_room_id++;
+    room->system_idx = sys->system_num_rooms;
+    room->booking_timers = &sys->booking_timers;
+    set_room_assignment_policy(room, sys->system_assignment_policy);
+    rooms[sys->system_num_rooms++] = room;
+    rate_table_append(&sys->room_rates);
+    if (names->entries != NULL) {
+        prefix_index_insert(names, room->name, room);
+    }
+    return OK;
+}
+
+/**
+ * indexes the names of the challenges and the rooms of a new system in
+ * O(n log n), from now on insert_system_challenge and insert_system_room
+ * keep the indexes sorted.
+ * @param sys - ptr to the system
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result index_system_names(ChallengeRoomSystem *sys) {
+    if (init_prefix_index(&sys->challenge_names,
+                          sys->system_num_challenges) != OK ||
+        init_prefix_index(&sys->room_names, sys->system_num_rooms) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        prefix_index_append(&sys->challenge_names,
+                            sys->system_challenges[i]->name,
+                            sys->system_challenges[i]);
+    }
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        prefix_index_append(&sys->room_names, sys->system_rooms[i]->name,
+                            sys->system_rooms[i]);
+    }
+    prefix_index_sort(&sys->challenge_names);
+    prefix_index_sort(&sys->room_names);
+    return OK;
+}
+
+/**
+ * creates the head of the head of the linked list of visitors and the index
+ * of the list nodes by visitor id
+ * @param sys - ptr to the system
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result create_system_visitor_list_head(ChallengeRoomSystem *sys) {
+    sys->visitors_list_head = malloc(sizeof(*(sys->visitors_list_head)));
+    if (sys->visitors_list_head == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    sys->visitors_list_head->visitor = NULL;
+    sys->visitors_list_head->next = NULL;
+    sys->visitors_list_head->prev = NULL;
+    Result result = init_id_index(&sys->visitors_index, 0);
+    if (result != OK) {
+        free(sys->visitors_list_head);
+        return result;
+    }
+    return OK;
+}
+
+/**
+ * creates the empty history of the completed visits
+ * @param sys - ptr to the system
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result create_system_visit_history(ChallengeRoomSystem *sys) {
+    sys->visit_history = malloc(sizeof(*(sys->visit_history)));
+    if (sys->visit_history == NULL) {
+        free(sys->visitors_list_head);
+        reset_id_index(&sys->visitors_index);
+        return MEMORY_PROBLEM;
+    }
+    init_visit_history(sys->visit_history);
+    return OK;
+}
+
+/**
+ * returns the challenge with the lowest best_time in the system
+ * @param sys - ptr to the system
+ * @param challenge_best_time - the ptr that needs to be updated
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result system_lowest_best_time(ChallengeRoomSystem *sys,
+                                      char **challenge_best_time) {
+    assert(sys != NULL);
+    int min_idx = 0, min = 0;
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        if (sys->system_challenges[i]->num_visits > 0) {
+            min = sys->system_challenges[i]->best_time;
+            break;
+        }
+    }
+    if (min == 0) {
+        *challenge_best_time = NULL;
+        return OK;
+    }
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        if (sys->system_challenges[i]->best_time != 0) {
+            if ((sys->system_challenges[i]->best_time < min)) {
+                min = sys->system_challenges[i]->best_time;
+                min_idx = i;
+            } else if (sys->system_challenges[i]->best_time == min &&
+                       strcmp(sys->system_challenges[i]->name,
+                              sys->system_challenges[min_idx]->name) < 0) {
+                min_idx = i;
+            }
+        }
+    }
+    *challenge_best_time = malloc(strlen(sys->system_challenges[min_idx]
+                                                 ->name) + 1);
+    if (*challenge_best_time == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    strcpy(*challenge_best_time, sys->system_challenges[min_idx]->name);
+    return OK;
+}
+
+/**
+ * creates a new node to the visitor list
+ * initialize the new visitor
+ * @param sys - ptr to the system
+ * @param visitor_name - the name of the visitor
+ * @param visitor_id - the id of the visitor
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result create_visitor_node(ChallengeRoomSystem *sys, char *visitor_name,
+                                  int visitor_id) {
+    assert(sys != NULL && visitor_name != NULL);
+    VisitorsList new_node = malloc(sizeof(*new_node));
+    if (new_node == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    new_node->visitor = malloc(sizeof(*new_node->visitor));
+    if (new_node->visitor == NULL) {
+        free(new_node);
+        return MEMORY_PROBLEM;
+    }
+    Result result = init_visitor(new_node->visitor, visitor_name, visitor_id);
+    if (result != OK) {
+        free(new_node);
+        return result;
+    }
+    result = id_index_insert(&sys->visitors_index, visitor_id, new_node);
+    if (result != OK) {
+        reset_visitor(new_node->visitor);
+        free(new_node->visitor);
+        free(new_node);
+        return result;
+    }
+    VisitorsList tmp_node = sys->visitors_list_head->next;
+    sys->visitors_list_head->next = new_node;
+    new_node->prev = sys->visitors_list_head;
+    new_node->next = tmp_node;
+    if (tmp_node != NULL) {
+        tmp_node->prev = new_node;
+    }
+    return OK;
+}
+
+/**
+ * finds a room by its name
+ * @param sys - ptr to the system
+ * @param room_name - the name of the wanted room
+ * @param room_idx - ptr to the room's idx
+ * @return ILLEGAL_PARAMETER: if a challenge with the name given is not found
+ *         OK: if everything went well
+ */
+static Result find_room_by_name(ChallengeRoomSystem *sys, char *room_name,
+                                int *room_idx) {
+    assert(sys != NULL && room_name != NULL && room_idx != NULL);
+    TRACE_BEGIN(find_room_by_name);
+    Result result = ILLEGAL_PARAMETER;
+    for (int i = 0; i < sys->system_num_rooms && result != OK; ++i) {
+        if (strcmp(sys->system_rooms[i]->name, room_name) == 0) {
+            *room_idx = i;
+            result = OK;
+        }
+    }
+    TRACE_END(find_room_by_name);
+    return result;
+}
+
+/**
+ * resets and frees the allocated memory of a visitor and its node in the list,
+ * the node is found through the visitors index so no scan of the list is done
+ * @param sys - ptr to the system
+ * @param visitor - the wanted visitor to be destroyed
+ */
+static void destroy_visitor_node(ChallengeRoomSystem *sys, Visitor *visitor) {
+    assert(sys != NULL && visitor != NULL);
+    TRACE_BEGIN(destroy_visitor_node);
+    VisitorsList node = id_index_find(&sys->visitors_index,
+                                      visitor->visitor_id);
+    assert(node != NULL && node->visitor == visitor);
+    id_index_remove(&sys->visitors_index, visitor->visitor_id);
+    node->prev->next = node->next;
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+    reset_visitor(node->visitor);
+    free(node->visitor);
+    free(node);
+    TRACE_END(destroy_visitor_node);
+}
+
+/**
+ * finds a visitor by its id and returns a ptr to it
+ * @param sys - ptr to the system
+ * @param visitor - the ptr that needs to be updated
+ * @param visitor_id - the id of the wanted visitor
+ * @return NOT_IN_ROOM: if the visitor is not in a room or visitor_id is not
+ *         found in the system
+ *         OK: if everything went well
+ */
+static Visitor *find_visitor_by_id(ChallengeRoomSystem *sys, int visitor_id) {
+    assert(sys != NULL);
+    VisitorsList ptr = id_index_find(&sys->visitors_index, visitor_id);
+    if (ptr == NULL) {
+        return NULL;
+    } else {
+        return ptr->visitor;
+    }
+}
+
+/**
+ * takes a visitor out of its room and appends the completed visit to the
+ * history. a visit that can't be stored is counted as dropped by the history
+ * and doesn't fail the quit.
+ * @param sys - ptr to the system
+ * @param visitor - ptr to the visitor
+ * @param quit_time - the time in which the visitor has left
+ * @return NOT_IN_ROOM: if the visitor is currently not in a room
+ *         OK: if everything went well
+ */
+static Result quit_room_and_record(ChallengeRoomSystem *sys, Visitor *visitor,
+                                   int quit_time) {
+    assert(sys != NULL && visitor != NULL);
+    ChallengeActivity *activity = activity_at(visitor->current_challenge);
+    if (activity == NULL) {
+        return visitor_quit_room(visitor, quit_time);
+    }
+    Challenge *challenge = challenge_at(activity->challenge);
+    ChallengeRoom *room = room_at(visitor->current_room);
+    VisitRecord record;
+    record.visitor_id = visitor->visitor_id;
+    record.challenge_id = challenge->id;
+    record.room_id = room->id;
+    record.start_time = activity->start_time;
+    record.duration = quit_time - record.start_time;
+    Result result = visitor_quit_room(visitor, quit_time);
+    RESULT_STANDARD_CHECK(result);
+    timer_wheel_cancel(&sys->session_timers, &visitor->session_timer);
+    if (activity->visitor != NULL_LINK) {
+        start_session_timer(sys, visitor_at(activity->visitor));
+    }
+    visit_history_append(sys->visit_history, &record);
+    rate_window_record(&sys->completions, quit_time);
+    record_rate(&sys->room_rates, room->system_idx, 1, quit_time);
+    record_rate(&sys->challenge_rates, challenge->system_idx, 1, quit_time);
+    if (activity->visitor != NULL_LINK) {
+        record_rate(&sys->challenge_rates, challenge->system_idx, 0,
+                    quit_time);
+    }
+    //a visitor waiting for the freed activity is dispatched to the same
+    //challenge, so no other challenge of the room changed, and its session
+    //starts now
+    publish_challenge(sys, challenge);
+    room_changed(sys, room);
+    if (sys->visitor_profiles != NULL) {
+        profile_store_record(sys->visitor_profiles, record.visitor_id,
+                             record.challenge_id, record.duration);
+    }
+    return OK;
+}
+
+/**
+ * removes all the visitors waiting in the queues of a room from the system
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ */
+static void drop_waiting_visitors(ChallengeRoomSystem *sys,
+                                  ChallengeRoom *room) {
+    assert(sys != NULL && room != NULL);
+    for (int level = Easy; level <= All_Levels; ++level) {
+        while (room->wait_queues[level].head != NULL_LINK) {
+            Visitor *visitor = visitor_at(room->wait_queues[level].head);
+            visitor_leave_wait_queue(visitor);
+            destroy_visitor_node(sys, visitor);
+        }
+    }
+    room_changed(sys, room);
+}
+
+/**
+ * adds a visitor that is not in the system to a room of the system, see
+ * visitor_arrive. the arguments were checked and the sessions that ended by
+ * the start time were expired already.
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ * @param visitor_name - the name of the visitor
+ * @param visitor_id - the id of the visitor
+ * @param level - the wanted challenge level
+ * @param start_time - the current time
+ * @param wait - 1 if the visitor waits in the queue of the room when there
+ *               is no available matching challenge, 0 otherwise
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         NO_AVAILABLE_CHALLENGES: if there are no available matching
+ *                                  challenges in the room
+ *         OK: if everything went well
+ */
+static Result arrive_at_room(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                             char *visitor_name, int visitor_id, Level level,
+                             int start_time, int wait) {
+    Result result = create_visitor_node(sys, visitor_name, visitor_id);
+    RESULT_STANDARD_CHECK(result);
+    Visitor *visitor = sys->visitors_list_head->next->visitor;
+    result = visitor_enter_room(room, visitor, level, start_time);
+    if (result == NO_AVAILABLE_CHALLENGES && wait) {
+        result = visitor_wait_for_room(room, visitor, level, start_time);
+    }
+    if (result != OK) {
+        destroy_visitor_node(sys, visitor);
+        return result;
+    }
+    sys->system_last_known_time = start_time;
+    rate_window_record(&sys->arrivals, start_time);
+    record_rate(&sys->room_rates, room->system_idx, 0, start_time);
+    ChallengeActivity *activity = activity_at(visitor->current_challenge);
+    if (activity != NULL) {
+        record_rate(&sys->challenge_rates,
+                    challenge_at(activity->challenge)->system_idx, 0,
+                    start_time);
+        publish_challenge(sys, challenge_at(activity->challenge));
+        start_session_timer(sys, visitor);
+    }
+    room_changed(sys, room);
+    JOURNAL_RECORD(sys, "A %s %s %d %d %d\n", room->name, visitor_name,
+                   visitor_id, (int) level, start_time);
+    return OK;
+}
+
+/**
+ * schedules the end of the session of a visitor that entered a challenge,
+ * by the session limit of the level of the challenge.
+ * @param sys - ptr to the system
+ * @param visitor - ptr to the visitor, in a challenge
+ */
+static void start_session_timer(ChallengeRoomSystem *sys, Visitor *visitor) {
+    assert(sys != NULL && visitor != NULL);
+    ChallengeActivity *activity = activity_at(visitor->current_challenge);
+    int limit = sys->session_limits[challenge_at(activity->challenge)->level];
+    if (limit > 0) {
+        timer_wheel_schedule(&sys->session_timers, &visitor->session_timer,
+                             activity->start_time + limit);
+    }
+}
+
+/**
+ * takes the visitors whose sessions ended by a time out of their challenges
+ * and the system, in the order their sessions ended. each quits at the end
+ * of its session and is reported to the timeout handler, and a visitor
+ * waiting for its challenge is dispatched to it then. the booking windows
+ * that open or close by the time are passed in order with the sessions.
+ * @param sys - ptr to the system
+ * @param time - the current time, not before the last known time
+ * @return NOT_IN_ROOM: if for some reason a timed visitor is not in a room
+ *         OK: if everything went well
+ */
+static Result expire_sessions(ChallengeRoomSystem *sys, int time) {
+    Timer *timer = NULL;
+    while ((timer = timer_wheel_expire(&sys->session_timers, time)) != NULL) {
+        Visitor *visitor = (Visitor *) ((char *) timer -
+                                        offsetof(Visitor, session_timer));
+        ChallengeRoom *room = room_at(visitor->current_room);
+        int quit_time = timer->expiry > sys->system_last_known_time ?
+                        timer->expiry : sys->system_last_known_time;
+        pass_booking_boundaries(sys, quit_time);
+        Result result = quit_room_and_record(sys, visitor, quit_time);
+        RESULT_STANDARD_CHECK(result);
+        sys->system_last_known_time = quit_time;
+        if (sys->timeout_handler != NULL) {
+            sys->timeout_handler(visitor->visitor_id, visitor->visitor_name,
+                                 room->name, quit_time, sys->timeout_context);
+        }
+        JOURNAL_RECORD(sys, "Q %d %d\n", visitor->visitor_id, quit_time);
+        destroy_visitor_node(sys, visitor);
+    }
+    pass_booking_boundaries(sys, time);
+    return OK;
+}
+
+/**
+ * passes the starts and ends of the booking windows up to a time, in order,
+ * so the activities whose window is open are out of the free activities of
+ * their rooms by then.
+ * @param sys - ptr to the system
+ * @param time - the current time
+ */
+static void pass_booking_boundaries(ChallengeRoomSystem *sys, int time) {
+    Timer *timer = NULL;
+    while ((timer = timer_wheel_expire(&sys->booking_timers, time)) != NULL) {
+        ChallengeActivity *activity =
+                (ChallengeActivity *) ((char *) timer -
+                                       offsetof(ChallengeActivity,
+                                                booking_timer));
+        room_pass_booking_boundary(activity, timer->expiry);
+        room_changed(sys, room_at(activity->room));
+    }
+}
+
+/**
+ * retires a room of the system, see system_remove_room.
+ * @param sys - ptr to the system
+ * @param room_idx - the idx of the room in the rooms table
+ * @return ALREADY_IN_ROOM: if a visitor is in one of its activities
+ *         OK: if everything went well
+ */
+static Result remove_room_at(ChallengeRoomSystem *sys, int room_idx) {
+    assert(sys != NULL && room_idx >= 0 && room_idx < sys->system_num_rooms);
+    ChallengeRoom *room = sys->system_rooms[room_idx];
+    RoomOccupantIterator iterator;
+    init_room_occupant_iterator(&iterator, room);
+    if (room_occupant_iterator_next(&iterator) != NULL) {
+        return ALREADY_IN_ROOM;
+    }
+    JOURNAL_RECORD(sys, "Z %s\n", room->name);
+    drop_waiting_visitors(sys, room);
+    prefix_index_remove(&sys->room_names, room->name, room);
+    reset_room(room);
+    free(room);
+    sys->system_rooms[room_idx] = sys->system_rooms[--sys->system_num_rooms];
+    if (room_idx < sys->system_num_rooms) {
+        sys->system_rooms[room_idx]->system_idx = room_idx;
+    }
+    rate_table_remove(&sys->room_rates, room_idx);
+    unpublish_record(sys, &sys->room_stats, room_idx);
+    if (sys->free_slots.nodes != NULL) {
+        free_slot_index_remove(&sys->free_slots, room_idx);
+    }
+    return OK;
+}
+
+/**
+ * attaches a challenge to a room of the system, see system_attach_challenge.
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ * @param challenge - ptr to the challenge
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result attach_room_challenge(ChallengeRoomSystem *sys,
+                                    ChallengeRoom *room, Challenge *challenge) {
+    assert(sys != NULL && room != NULL && challenge != NULL);
+    Result result = room_attach_challenge(room, challenge);
+    RESULT_STANDARD_CHECK(result);
+    room_changed(sys, room);
+    JOURNAL_RECORD(sys, "T %s %d\n", room->name, challenge->id);
+    return OK;
+}
+
+/**
+ * detaches a free activity of a challenge from a room of the system, see
+ * system_detach_challenge.
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ * @param challenge_id - the id of the challenge
+ * @return ILLEGAL_PARAMETER: if the challenge is not in the room
+ *         ALREADY_IN_ROOM: if all the activities of the challenge in the
+ *                          room are occupied by visitors
+ *         OK: if everything went well
+ */
+static Result detach_room_challenge(ChallengeRoomSystem *sys,
+                                    ChallengeRoom *room, int challenge_id) {
+    assert(sys != NULL && room != NULL);
+    Result result = room_detach_challenge(room, challenge_id);
+    RESULT_STANDARD_CHECK(result);
+    room_changed(sys, room);
+    JOURNAL_RECORD(sys, "U %s %d\n", room->name, challenge_id);
+    return OK;
+}
+
+/**
+ * checks a reload before any of it is applied and fills the plan with its
+ * changes: the journal can keep the names of the challenges and rooms that
+ * are new or renamed, their levels are valid, no challenge or room that is
+ * removed is occupied, and every room keeps an activity for each of its
+ * visitors. the challenges of the system are only walked if some are
+ * removed.
+ * @param sys - ptr to the system
+ * @param load - ptr to the load of the file
+ * @param plan - ptr to the plan, with the challenges and the rooms of the
+ *               file
+ * @return ILLEGAL_PARAMETER: if a name or a level can't be applied
+ *         ALREADY_IN_ROOM: if the reload would take a visitor out
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result check_reload(ChallengeRoomSystem *sys, InitFileLoad *load,
+                           ReloadPlan *plan) {
+    int num_kept = 0;
+    for (int i = 0; i < load->num_challenges; ++i) {
+        Challenge *loaded = load->challenges[i];
+        if (id_index_find(&plan->challenges, loaded->id) != loaded) {
+            continue;
+        }
+        Challenge *challenge = id_index_find(&sys->challenges_index,
+                                             loaded->id);
+        if (loaded->level < Easy || loaded->level >= All_Levels ||
+            ((challenge == NULL || strcmp(challenge->name, loaded->name) != 0)
+             && !journal_accepts_name(sys, loaded->name))) {
+            return ILLEGAL_PARAMETER;
+        }
+        num_kept += challenge != NULL;
+    }
+    if (num_kept == sys->system_num_challenges) {
+        return check_reload_rooms(sys, plan);
+    }
+    plan->removed_challenges = malloc(
+            (size_t) (sys->system_num_challenges - num_kept) *
+            sizeof(*plan->removed_challenges));
+    if (plan->removed_challenges == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        Challenge *challenge = sys->system_challenges[i];
+        if (id_index_find(&plan->challenges, challenge->id) != NULL) {
+            continue;
+        }
+        for (ChallengeActivity *activity = activity_at(challenge->activities);
+             activity != NULL;
+             activity = activity_at(activity->next_instance)) {
+            if (activity->visitor != NULL_LINK) {
+                return ALREADY_IN_ROOM;
+            }
+        }
+        plan->removed_challenges[plan->num_removed_challenges++] =
+                challenge->id;
+    }
+    return check_reload_rooms(sys, plan);
+}
+
+/**
+ * checks the rooms of a reload, see check_reload. the rooms of the system
+ * are matched to the rooms of the file by name, and only the rooms whose
+ * challenges differ from the file are compared activity by activity.
+ * @param sys - ptr to the system
+ * @param plan - ptr to the plan
+ * @return ILLEGAL_PARAMETER: if the journal can't keep the name of a new
+ *                            room
+ *         ALREADY_IN_ROOM: if the reload would take a visitor out
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result check_reload_rooms(ChallengeRoomSystem *sys, ReloadPlan *plan) {
+    plan->removed_rooms = malloc(((size_t) sys->system_num_rooms + 1) *
+                                 sizeof(*plan->removed_rooms));
+    if (plan->removed_rooms == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        ChallengeRoom *room = sys->system_rooms[i];
+        ReloadRoom *definition = find_reload_room(plan->rooms,
+                                                  plan->num_rooms, room->name);
+        if (definition != NULL) {
+            definition->room = room;
+            continue;
+        }
+        RoomOccupantIterator iterator;
+        init_room_occupant_iterator(&iterator, room);
+        if (room_occupant_iterator_next(&iterator) != NULL) {
+            return ALREADY_IN_ROOM;
+        }
+        plan->removed_rooms[plan->num_removed_rooms++] = room;
+    }
+    for (int i = 0; i < plan->num_rooms; ++i) {
+        ReloadRoom *definition = plan->rooms + i;
+        if (i > 0 && strcmp(definition[-1].name, definition->name) == 0) {
+            continue;
+        }
+        char *cursor = definition->challenge_ids;
+        for (int j = 0; j < definition->num_challenges; ++j) {
+            int id = (int) strtol(cursor, &cursor, 10);
+            if (id_index_find(&plan->challenges, id) != NULL) {
+                definition->challenge_ids_hash += id_set_hash(id);
+            }
+        }
+        if (definition->room == NULL) {
+            if (!journal_accepts_name(sys, definition->name)) {
+                return ILLEGAL_PARAMETER;
+            }
+        } else if (room_definition_changed(definition)) {
+            Result result = diff_room(sys, definition->room, definition,
+                                      &plan->challenges, 0);
+            RESULT_STANDARD_CHECK(result);
+        }
+    }
+    return OK;
+}
+
+/**
+ * adds the challenges of a reloaded file that are new to the system and
+ * updates the name and level of the ones that changed, which check_reload
+ * found valid.
+ * @param sys - ptr to the system
+ * @param load - ptr to the load of the file
+ * @param new_challenges - the challenges of the file by id
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result reload_challenges(ChallengeRoomSystem *sys, InitFileLoad *load,
+                                IdIndex *new_challenges) {
+    for (int i = 0; i < load->num_challenges; ++i) {
+        Challenge *loaded = load->challenges[i];
+        if (id_index_find(new_challenges, loaded->id) != loaded) {
+            continue;
+        }
+        Challenge *challenge = id_index_find(&sys->challenges_index,
+                                             loaded->id);
+        Result result = OK;
+        if (challenge == NULL) {
+            result = system_add_challenge(sys, loaded->id, loaded->name,
+                                          loaded->level);
+        } else {
+            if (strcmp(challenge->name, loaded->name) != 0) {
+                result = change_challenge_name(sys, loaded->id, loaded->name);
+            }
+            if (result == OK && challenge->level != loaded->level) {
+                result = change_system_challenge_level(sys, loaded->id,
+                                                       loaded->level);
+            }
+        }
+        RESULT_STANDARD_CHECK(result);
+    }
+    return OK;
+}
+
+/**
+ * removes the rooms of the system that are not in a reloaded file, adds the
+ * rooms of the file that are new to the system and matches the challenges
+ * of the rooms that changed to the file.
+ * @param sys - ptr to the system
+ * @param plan - ptr to the plan, filled by check_reload
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result reload_rooms(ChallengeRoomSystem *sys, ReloadPlan *plan) {
+    for (int i = 0; i < plan->num_removed_rooms; ++i) {
+        Result result = remove_room_at(sys,
+                                       plan->removed_rooms[i]->system_idx);
+        RESULT_STANDARD_CHECK(result);
+    }
+    for (int i = 0; i < plan->num_rooms; ++i) {
+        ReloadRoom *definition = plan->rooms + i;
+        //only the first room of a name is applied
+        if (i > 0 && strcmp(definition[-1].name, definition->name) == 0) {
+            continue;
+        }
+        if (definition->room == NULL) {
+            Result result = insert_system_room(sys, definition->name, 0);
+            RESULT_STANDARD_CHECK(result);
+            definition->room = sys->system_rooms[sys->system_num_rooms - 1];
+            room_changed(sys, definition->room);
+            JOURNAL_RECORD(sys, "M %s\n", definition->name);
+        }
+        if (room_definition_changed(definition)) {
+            Result result = diff_room(sys, definition->room, definition,
+                                      &plan->challenges, 1);
+            RESULT_STANDARD_CHECK(result);
+        }
+    }
+    return OK;
+}
+
+/**
+ * tells whether the challenges of a room differ from its definition in a
+ * reloaded file, in O(1) by the hashes of their ids.
+ * @param definition - ptr to the room in the file, matched to its room
+ * @return 1 if the room is attached and detached challenges by the reload,
+ *         0 otherwise
+ */
+static int room_definition_changed(ReloadRoom *definition) {
+    return definition->challenge_ids_hash !=
+           definition->room->challenge_ids_hash;
+}
+
+/**
+ * matches the challenges of a room to its definition in a reloaded file, in
+ * O(n log n) for the n challenges of the room. the activities of challenges
+ * that are not in the file are left to be removed with their challenge,
+ * ids that are not in the file are ignored.
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ * @param definition - ptr to the room in the file
+ * @param new_challenges - the challenges of the file by id
+ * @param apply - 0 to only check that the free activities of the room are
+ *                enough for the detaches, 1 to attach and detach
+ * @return ALREADY_IN_ROOM: if an occupied activity would be detached
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result diff_room(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                        ReloadRoom *definition, IdIndex *new_challenges,
+                        int apply) {
+    ActivityKey *keys = malloc(((size_t) room->num_of_challenges + 1) *
+                               sizeof(*keys));
+    int *ids = malloc(((size_t) definition->num_challenges + 1) *
+                      sizeof(*ids));
+    if (keys == NULL || ids == NULL) {
+        free(keys);
+        free(ids);
+        return MEMORY_PROBLEM;
+    }
+    int num_keys = 0, num_ids = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        PackedActivity *packed = room->packed + i;
+        if (packed->level != -1 &&
+            id_index_find(new_challenges, packed->challenge_id) != NULL) {
+            keys[num_keys].challenge_id = packed->challenge_id;
+            keys[num_keys].occupied = packed->occupied;
+            num_keys++;
+        }
+    }
+    char *cursor = definition->challenge_ids;
+    for (int i = 0; i < definition->num_challenges; ++i) {
+        int id = (int) strtol(cursor, &cursor, 10);
+        if (id_index_find(new_challenges, id) != NULL) {
+            ids[num_ids++] = id;
+        }
+    }
+    qsort(keys, (size_t) num_keys, sizeof(*keys), compare_activity_keys);
+    qsort(ids, (size_t) num_ids, sizeof(*ids), compare_ids);
+    Result result = OK;
+    int key = 0, idx = 0;
+    while ((key < num_keys || idx < num_ids) && result == OK) {
+        int id = key < num_keys && (idx >= num_ids ||
+                                    keys[key].challenge_id <= ids[idx]) ?
+                 keys[key].challenge_id : ids[idx];
+        int num_old = 0, num_free = 0, num_new = 0;
+        for (; key < num_keys && keys[key].challenge_id == id; ++key) {
+            num_old++;
+            num_free += !keys[key].occupied;
+        }
+        for (; idx < num_ids && ids[idx] == id; ++idx) {
+            num_new++;
+        }
+        if (num_old - num_new > num_free) {
+            result = ALREADY_IN_ROOM;
+        }
+        for (int i = num_new; i < num_old && apply && result == OK; ++i) {
+            result = detach_room_challenge(sys, room, id);
+        }
+        for (int i = num_old; i < num_new && apply && result == OK; ++i) {
+            result = attach_room_challenge(sys, room,
+                                           id_index_find(&sys->challenges_index,
+                                                         id));
+        }
+    }
+    free(keys);
+    free(ids);
+    return result;
+}
+
+/**
+ * finds the first room of a name in the rooms of a reloaded file.
+ * @param rooms - the rooms of the file, sorted by name
+ * @param num_rooms - the num of rooms
+ * @param name - the name of the room
+ * @return ptr to the room, NULL if it is not in the file
+ */
+static ReloadRoom *find_reload_room(ReloadRoom *rooms, int num_rooms,
+                                    char *name) {
+    int low = 0, high = num_rooms;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (strcmp(rooms[middle].name, name) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < num_rooms && strcmp(rooms[low].name, name) == 0 ?
+           rooms + low : NULL;
+}
+
+/**
+ * compares two rooms of a reloaded file by name and then by their place in
+ * the file, for qsort.
+ */
+static int compare_reload_rooms(const void *first, const void *second) {
+    const ReloadRoom *first_room = first, *second_room = second;
+    int order = strcmp(first_room->name, second_room->name);
+    return order != 0 ? order : first_room->idx - second_room->idx;
+}
+
+/**
+ * compares two activities by the id of their challenge, for qsort.
+ */
+static int compare_activity_keys(const void *first, const void *second) {
+    const ActivityKey *first_key = first, *second_key = second;
+    return first_key->challenge_id < second_key->challenge_id ? -1 :
+           first_key->challenge_id > second_key->challenge_id;
+}
+
+/**
+ * compares two ids, for qsort.
+ */
+static int compare_ids(const void *first, const void *second) {
+    const int *first_id = first, *second_id = second;
+    return *first_id < *second_id ? -1 : *first_id > *second_id;
+}
+
+/**
+ * applies a single ingested event to the system and counts its result
+ * @param sys - ptr to the system
+ * @param event - ptr to the event
+ * @return the result of applying the event
+ */
+static Result apply_event(ChallengeRoomSystem *sys, BufferedEvent *event) {
+    assert(sys != NULL && sys->event_buffer != NULL && event != NULL);
+    Result result = OK;
+    if (event->type == ARRIVE_EVENT) {
+        result = visitor_arrive(sys, event->room_name, event->visitor_name,
+                                event->visitor_id, event->level, event->time);
+    } else {
+        result = visitor_quit(sys, event->visitor_id, event->time);
+    }
+    if (result == OK) {
+        sys->event_buffer->num_applied++;
+    } else {
+        sys->event_buffer->num_failed++;
+    }
+    return result;
+}
+
+/**
+ * applies, in time order, all the buffered events up to the watermark
+ * @param sys - ptr to the system
+ * @param watermark - the latest time of an event that may be applied
+ */
+static void apply_buffered_events(ChallengeRoomSystem *sys, int watermark) {
+    assert(sys != NULL && sys->event_buffer != NULL);
+    BufferedEvent *top = event_buffer_top(sys->event_buffer);
+    while (top != NULL && top->time <= watermark) {
+        BufferedEvent event;
+        event_buffer_pop(sys->event_buffer, &event);
+        apply_event(sys, &event);
+        release_buffered_event(&event);
+        top = event_buffer_top(sys->event_buffer);
+    }
+}
+
+/**
+ * checks the time of an ingested event and advances the latest event time
+ * @param sys - ptr to the system
+ * @param time - the time of the event
+ * @param watermark - the ptr to the latest time that may be applied, needs
+ *                    to be updated
+ * @return ILLEGAL_TIME: if an event after time was already applied
+ *         OK: if everything went well
+ */
+static Result ingest_event_time(ChallengeRoomSystem *sys, int time,
+                                int *watermark) {
+    assert(sys != NULL && sys->event_buffer != NULL && watermark != NULL);
+    if (time < sys->system_last_known_time) {
+        return ILLEGAL_TIME;
+    }
+    if (time > sys->event_buffer->max_seen_time) {
+        sys->event_buffer->max_seen_time = time;
+    }
+    *watermark = sys->event_buffer->max_seen_time - sys->event_buffer->lateness;
+    return OK;
+}
+
+/**
+ * applies one record of the journal to the system, the record must end with
+ * a newline or it is considered torn
+ * @param sys - ptr to the system
+ * @param input - the journal file, positioned after the record type
+ * @param type - the type of the record
+ * @return 1 if a complete record was read, 0 otherwise
+ */
+static int replay_journal_record(ChallengeRoomSystem *sys, FILE *input,
+                                 char type) {
+    char first[JOURNAL_WORD_MAX_LEN] = "", second[JOURNAL_WORD_MAX_LEN] = "";
+    int values[4] = {0};
+    switch (type) {
+        case 'A':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT " " JOURNAL_WORD_FORMAT
+                       " %d %d %d", first, second, values, values + 1,
+                       values + 2) != 5 || fgetc(input) != '\n') {
+                return 0;
+            }
+            visitor_arrive(sys, first, second, values[0], (Level) values[1],
+                           values[2]);
+            return 1;
+        case 'Q':
+            if (fscanf(input, "%d %d", values, values + 1) != 2 ||
+                fgetc(input) != '\n') {
+                return 0;
+            }
+            visitor_quit(sys, values[0], values[1]);
+            return 1;
+        case 'X':
+            if (fscanf(input, "%d", values) != 1 || fgetc(input) != '\n') {
+                return 0;
+            }
+            all_visitors_quit(sys, values[0]);
+            return 1;
+        case 'E':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT " %d", first,
+                       values) != 2 || fgetc(input) != '\n') {
+                return 0;
+            }
+            room_visitors_quit(sys, first, values[0]);
+            return 1;
+        case 'W':
+            if (fscanf(input, "%d", values) != 1 || fgetc(input) != '\n') {
+                return 0;
+            }
+            set_system_wait_queues(sys, values[0]);
+            return 1;
+        case 'S':
+            if (fscanf(input, "%d %d", values, values + 1) != 2 ||
+                fgetc(input) != '\n') {
+                return 0;
+            }
+            set_system_session_limit(sys, (Level) values[0], values[1]);
+            return 1;
+        case 'V':
+            if (fscanf(input, "%d", values) != 1 || fgetc(input) != '\n') {
+                return 0;
+            }
+            set_system_visitor_profiles(sys, values[0]);
+            return 1;
+        case 'P':
+            if (fscanf(input, "%d", values) != 1 || fgetc(input) != '\n') {
+                return 0;
+            }
+            set_system_assignment_policy(sys, (AssignmentPolicy) values[0]);
+            return 1;
+        case 'B':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT " %d %d %d %d", first,
+                       values, values + 1, values + 2, values + 3) != 5 ||
+                fgetc(input) != '\n') {
+                return 0;
+            }
+            system_book_challenge(sys, first, values[0], values[1], values[2],
+                                  values[3]);
+            return 1;
+        case 'K':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT " %d %d", first, values,
+                       values + 1) != 3 || fgetc(input) != '\n') {
+                return 0;
+            }
+            system_cancel_booking(sys, first, values[0], values[1]);
+            return 1;
+        case 'C':
+            if (fscanf(input, "%d " JOURNAL_WORD_FORMAT, values, first) != 2 ||
+                fgetc(input) != '\n') {
+                return 0;
+            }
+            change_challenge_name(sys, values[0], first);
+            return 1;
+        case 'R':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT " " JOURNAL_WORD_FORMAT,
+                       first, second) != 2 || fgetc(input) != '\n') {
+                return 0;
+            }
+            change_system_room_name(sys, first, second);
+            return 1;
+        case 'L':
+            if (fscanf(input, "%d %d", values, values + 1) != 2 ||
+                fgetc(input) != '\n') {
+                return 0;
+            }
+            change_system_challenge_level(sys, values[0], (Level) values[1]);
+            return 1;
+        case 'N':
+            if (fscanf(input, "%d %d " JOURNAL_WORD_FORMAT, values,
+                       values + 1, first) != 3 || fgetc(input) != '\n') {
+                return 0;
+            }
+            system_add_challenge(sys, values[0], first, (Level) values[1]);
+            return 1;
+        case 'D':
+            if (fscanf(input, "%d", values) != 1 || fgetc(input) != '\n') {
+                return 0;
+            }
+            system_remove_challenge(sys, values[0]);
+            return 1;
+        case 'M':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT, first) != 1 ||
+                fgetc(input) != '\n') {
+                return 0;
+            }
+            system_add_room(sys, first);
+            return 1;
+        case 'Z':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT, first) != 1 ||
+                fgetc(input) != '\n') {
+                return 0;
+            }
+            system_remove_room(sys, first);
+            return 1;
+        case 'T':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT " %d", first,
+                       values) != 2 || fgetc(input) != '\n') {
+                return 0;
+            }
+            system_attach_challenge(sys, first, values[0]);
+            return 1;
+        case 'U':
+            if (fscanf(input, " " JOURNAL_WORD_FORMAT " %d", first,
+                       values) != 2 || fgetc(input) != '\n') {
+                return 0;
+            }
+            system_detach_challenge(sys, first, values[0]);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * replays all the complete records of a journal file onto the system, the
+ * system has no journal attached yet so nothing is journaled again
+ * @param sys - ptr to the system
+ * @param journal_file - the journal file
+ * @return the num of bytes of complete records in the file
+ */
+static long replay_journal(ChallengeRoomSystem *sys, char *journal_file) {
+    assert(sys != NULL && sys->journal == NULL && journal_file != NULL);
+    FILE *input = fopen(journal_file, "r");
+    if (input == NULL) {
+        return 0;
+    }
+    long valid_length = 0;
+    char type = 0;
+    while (fscanf(input, "%c", &type) == 1 &&
+           replay_journal_record(sys, input, type)) {
+        valid_length = ftell(input);
+    }
+    fclose(input);
+    return valid_length;
+}
+
+/**
+ * checks that the journal of the system can keep a name, a record keeps it
+ * as a single word that replay reads back with JOURNAL_WORD_FORMAT.
+ * @param sys - ptr to the system
+ * @param name - the name
+ * @return 1 if the system has no journal or the name is a non empty word of
+ *         less than JOURNAL_WORD_MAX_LEN chars, 0 otherwise
+ */
+static int journal_accepts_name(ChallengeRoomSystem *sys, const char *name) {
+    if (sys->journal == NULL) {
+        return 1;
+    }
+    size_t length = 0;
+    for (; name[length] != '\0'; ++length) {
+        if (isspace((unsigned char) name[length]) ||
+            length + 1 >= JOURNAL_WORD_MAX_LEN) {
+            return 0;
+        }
+    }
+    return length > 0;
+}
+
+/**
+ * destroys a system that could not be created whole and sets it to NULL.
+ * @param sys - ptr to the system
+ */
+static void discard_system(ChallengeRoomSystem **sys) {
+    char *most_popular = NULL, *best_time = NULL;
+    destroy_system(*sys, (*sys)->system_last_known_time, &most_popular,
+                   &best_time);
+    free(most_popular);
+    free(best_time);
+    *sys = NULL;
+}
+
+/**
+ * counts the events of a pair of windows, see system_rates.
+ * @param sys - ptr to the system
+ * @param arrivals - ptr to the window of the arrivals
+ * @param completions - ptr to the window of the completions
+ * @param time - the current time
+ * @param span - the num of time units
+ * @param num_arrivals - the ptr that needs to be updated
+ * @param num_completions - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to num_arrivals or num_completions are
+ *                         NULL
+ *         ILLEGAL_PARAMETER: if span is out of range
+ *         ILLEGAL_TIME: if the time is before the last time known to the
+ *                       system
+ *         OK: if everything went well
+ */
+static Result window_rates(ChallengeRoomSystem *sys, RateWindow *arrivals,
+                           RateWindow *completions, int time, int span,
+                           int *num_arrivals, int *num_completions) {
+    if (num_arrivals == NULL || num_completions == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (span < 1 || span > RATE_WINDOW_SPAN) {
+        return ILLEGAL_PARAMETER;
+    }
+    if (time < sys->system_last_known_time) {
+        return ILLEGAL_TIME;
+    }
+    *num_arrivals = rate_window_count(arrivals, time, span);
+    *num_completions = rate_window_count(completions, time, span);
+    return OK;
+}
+
+/**
+ * counts an arrival or a completion of a challenge or a room, if the rates
+ * of its table were started.
+ * @param table - ptr to the rate table of the challenges or the rooms
+ * @param idx - the idx of the challenge or the room in its table
+ * @param completion - 1 for a completion, 0 for an arrival
+ * @param time - the time of the event
+ */
+static void record_rate(RateTable *table, int idx, int completion, int time) {
+    RateWindows *rates = rate_table_at(table, idx);
+    if (rates != NULL) {
+        rate_window_record(completion ? &rates->completions :
+                           &rates->arrivals, time);
+    }
+}
+
+/**
+ * fills a match with the statistics of a challenge.
+ * @param challenge - ptr to the challenge
+ * @param match - ptr to the match that needs to be filled
+ */
+static void fill_challenge_match(Challenge *challenge,
+                                 ChallengeMatch *match) {
+    match->name = challenge->name;
+    match->id = challenge->id;
+    match->level = challenge->level;
+    match->num_visits = challenge->num_visits;
+    match->best_time = challenge->best_time;
+}
+
+/**
+ * fills a match with the statistics of a room, counting its visitors is
+ * O(n) in the room.
+ * @param room - ptr to the room
+ * @param match - ptr to the match that needs to be filled
+ */
+static void fill_room_match(ChallengeRoom *room, RoomMatch *match) {
+    match->name = room->name;
+    match->id = room->id;
+    match->num_challenges = room->num_of_challenges;
+    match->num_visitors = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        match->num_visitors += room->packed[i].occupied;
+    }
+    match->num_free = assignment_index_num_free(&room->assignment,
+                                                All_Levels);
+    match->num_waiting = 0;
+    for (int level = Easy; level <= All_Levels; ++level) {
+        match->num_waiting += room->wait_queues[level].length;
+    }
+}
+
+/**
+ * builds the tables of statistics shared with the snapshots in O(n), from
+ * now on the changes of the system are published to them.
+ * @param sys - ptr to the system
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result build_snapshot_tables(ChallengeRoomSystem *sys) {
+    if (init_snapshot_table(&sys->challenge_stats,
+                            sys->system_num_challenges) != OK ||
+        init_snapshot_table(&sys->room_stats, sys->system_num_rooms) != OK) {
+        drop_snapshot_tables(sys);
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < sys->system_num_challenges; ++i) {
+        publish_challenge(sys, sys->system_challenges[i]);
+    }
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        publish_room(sys, sys->system_rooms[i]);
+    }
+    //a failed publish drops the tables
+    return sys->room_stats != NULL ? OK : MEMORY_PROBLEM;
+}
+
+/**
+ * drops the references of the system to the tables of statistics, the
+ * snapshots keep theirs. the tables are built again by the next snapshot.
+ * @param sys - ptr to the system
+ */
+static void drop_snapshot_tables(ChallengeRoomSystem *sys) {
+    snapshot_table_release(sys->challenge_stats);
+    snapshot_table_release(sys->room_stats);
+    sys->challenge_stats = NULL;
+    sys->room_stats = NULL;
+}
+
+/**
+ * writes the statistics of a challenge to its record in the tables shared
+ * with the snapshots, a challenge that was just added gets a new record.
+ * if the write fails the tables are dropped rather than failing the change
+ * that is published.
+ * @param sys - ptr to the system
+ * @param challenge - ptr to the challenge
+ */
+static void publish_challenge(ChallengeRoomSystem *sys, Challenge *challenge) {
+    if (sys->challenge_stats == NULL) {
+        return;
+    }
+    SnapshotRecord *record =
+            challenge->system_idx == sys->challenge_stats->size ?
+            snapshot_table_append(&sys->challenge_stats) :
+            snapshot_table_write(&sys->challenge_stats, challenge->system_idx);
+    if (record == NULL || snapshot_record_name(record, challenge->name) != OK) {
+        drop_snapshot_tables(sys);
+        return;
+    }
+    record->challenge.id = challenge->id;
+    record->challenge.level = challenge->level;
+    record->challenge.num_visits = challenge->num_visits;
+    record->challenge.best_time = challenge->best_time;
+}
+
+/**
+ * writes the statistics of a room to its record in the tables shared with
+ * the snapshots, like publish_challenge.
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ */
+static void publish_room(ChallengeRoomSystem *sys, ChallengeRoom *room) {
+    if (sys->room_stats == NULL) {
+        return;
+    }
+    SnapshotRecord *record = room->system_idx == sys->room_stats->size ?
+                             snapshot_table_append(&sys->room_stats) :
+                             snapshot_table_write(&sys->room_stats,
+                                                  room->system_idx);
+    if (record == NULL || snapshot_record_name(record, room->name) != OK) {
+        drop_snapshot_tables(sys);
+        return;
+    }
+    RoomMatch match;
+    fill_room_match(room, &match);
+    record->room.id = match.id;
+    record->room.num_challenges = match.num_challenges;
+    record->room.num_visitors = match.num_visitors;
+    record->room.num_free = match.num_free;
+    record->room.num_waiting = match.num_waiting;
+}
+
+/**
+ * removes the record of a challenge or a room that was removed from the
+ * system from the tables shared with the snapshots, the last record takes
+ * its place like in the table of the system.
+ * @param sys - ptr to the system
+ * @param table - ptr to the ptr to the table
+ * @param idx - the idx of the record
+ */
+static void unpublish_record(ChallengeRoomSystem *sys, SnapshotTable **table,
+                             int idx) {
+    if (*table != NULL && snapshot_table_remove(table, idx) != OK) {
+        drop_snapshot_tables(sys);
+    }
+}
+
+/**
+ * publishes the statistics of a room after it changed and updates its num
+ * of free activities in the free slot index.
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ */
+static void room_changed(ChallengeRoomSystem *sys, ChallengeRoom *room) {
+    publish_room(sys, room);
+    index_free_slots(sys, room);
+}
+
+/**
+ * builds the free slot index of the rooms in O(rooms log rooms), from now on
+ * the changes of the rooms are followed by it.
+ * @param sys - ptr to the system
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result build_free_slot_index(ChallengeRoomSystem *sys) {
+    if (init_free_slot_index(&sys->free_slots,
+                             sys->system_num_rooms) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < sys->system_num_rooms; ++i) {
+        index_free_slots(sys, sys->system_rooms[i]);
+    }
+    return OK;
+}
+
+/**
+ * writes the num of free activities of each level of a room to the free
+ * slot index, if it was built. the index is dropped if it can't grow, and
+ * built again by the next routed arrival.
+ * @param sys - ptr to the system
+ * @param room - ptr to the room
+ */
+static void index_free_slots(ChallengeRoomSystem *sys, ChallengeRoom *room) {
+    if (sys->free_slots.nodes == NULL) {
+        return;
+    }
+    int num_free[All_Levels + 1];
+    for (int level = Easy; level <= All_Levels; ++level) {
+        num_free[level] = assignment_index_num_free(&room->assignment,
+                                                    (Level) level);
+    }
+    if (free_slot_index_set(&sys->free_slots, room->system_idx,
+                            num_free) != OK) {
+        reset_free_slot_index(&sys->free_slots);
+    }
+}
@@ -3,6 +3,25 @@
 
 #include "visitor_room.h"
 #include "system_additional_types.h"
+#include "hash_index.h"
+#include "prefix_index.h"
+#include "event_buffer.h"
+#include "journal.h"
+#include "visit_history.h"
+#include "visitor_profile.h"
+#include "snapshot.h"
+#include "free_slot_index.h"
+#include "report_writer.h"
+#include "rate_window.h"
+
+/*
+ * called for each visitor that is taken out of its challenge by the session
+ * limit of its level, see set_system_session_limit. the names are valid
+ * during the call only.
+ */
+typedef void (*SessionTimeoutHandler)(int visitor_id, char *visitor_name,
+                                      char *room_name, int quit_time,
+                                      void *context);
 
 typedef struct SChallengeRoomSystem
 {
@@ -11,37 +30,351 @@ typedef struct SChallengeRoomSystem
 
     char *system_name;
     int system_last_known_time;
-    Challenge *system_challenges;
+    /* tables of the challenges and rooms, the records themselves are never
+       moved so visitors and activities may point to them */
+    Challenge **system_challenges;
     int system_num_challenges;
-    ChallengeRoom *system_rooms;
+    int system_challenges_capacity;
+    ChallengeRoom **system_rooms;
     int system_num_rooms;
+    int system_rooms_capacity;
+    int system_next_room_id;
+    IdIndex challenges_index;
+    NameIndex challenges_by_name;
+    /* the challenges and the rooms sorted by name, for name searches */
+    PrefixIndex challenge_names;
+    PrefixIndex room_names;
+    AssignmentPolicy system_assignment_policy;
     VisitorsList visitors_list_head;
+    IdIndex visitors_index;
+    int wait_queues_enabled;
+    EventBuffer *event_buffer;
+    Journal *journal;
+    VisitHistory *visit_history;
+    /* NULL unless the profiles are turned on */
+    ProfileStore *visitor_profiles;
+    /* the visitors that arrived and the visits completed recently */
+    RateWindow arrivals;
+    RateWindow completions;
+    /* the same windows for each challenge and each room, by their idx in
+       the tables of the system, started by the first request for the rates
+       of a challenge or a room */
+    RateTable challenge_rates;
+    RateTable room_rates;
+    /* the statistics of the challenges and the rooms shared with the
+       snapshots, NULL until the first snapshot is taken */
+    SnapshotTable *challenge_stats;
+    SnapshotTable *room_stats;
+    /* the free activities of each level by room, for visitor_arrive_any_room,
+       its nodes are NULL until the first call */
+    FreeSlotIndex free_slots;
+    /* the timers of the activities at the next start or end of a window of
+       their bookings */
+    TimerWheel booking_timers;
+    /* the most time a visit of a challenge of each level may take, 0 for no
+       limit, and the timers of the visits that have one */
+    int session_limits[All_Levels];
+    TimerWheel session_timers;
+    SessionTimeoutHandler timeout_handler;
+    void *timeout_context;
 
 } ChallengeRoomSystem;
 
+/*
+ * the bytes taken by each kind of record of a system, see
+ * system_memory_usage. names are counted apart from the records holding them.
+ */
+typedef struct SMemoryUsage
+{
+    size_t challenges;
+    size_t rooms;
+    size_t activities;
+    size_t visitors;
+    size_t names;
+    size_t profiles;
+} MemoryUsage;
+
+
+/*
+ * a challenge found by a name search with its statistics, see
+ * system_search_challenges. the name is the one of the challenge itself.
+ */
+typedef struct SChallengeMatch
+{
+    char *name;
+    int id;
+    Level level;
+    int num_visits;
+    int best_time;
+} ChallengeMatch;
+
+
+/*
+ * a room found by a name search with its statistics, see system_search_rooms.
+ * the name is the one of the room itself.
+ */
+typedef struct SRoomMatch
+{
+    char *name;
+    int id;
+    int num_challenges;
+    int num_visitors;
+    int num_free;
+    int num_waiting;
+} RoomMatch;
+
+
+/*
+ * an immutable view of the statistics of the challenges and the rooms at the
+ * time it was taken, see system_snapshot_acquire. it stays valid while the
+ * system changes, and after the system is destroyed, until it is released.
+ */
+typedef struct SSystemSnapshot
+{
+    int time;
+    int num_challenges;
+    int num_rooms;
+    SnapshotTable *challenges;
+    SnapshotTable *rooms;
+} SystemSnapshot;
+
+
+#ifdef ESCAPY_FIXED_CAPACITY
+/*
+ * the size of the arena of the fixed capacity build. every allocation takes
+ * whole 16 byte units and a unit for its header. a growable table may hold
+ * its old copy and a copy of twice the size while it grows, and so may the
+ * id indexes.
+ */
+#define ESCAPY_FIXED_BLOCK(size) ((((size) + 15) / 16 + 1) * 16)
+#define ESCAPY_FIXED_TABLE(count, size) \
+    (3 * ESCAPY_FIXED_BLOCK((count) * (size)))
+#define ESCAPY_FIXED_ID_INDEX(count) \
+    (2 * ESCAPY_FIXED_BLOCK(4 * ((count) + 8) * sizeof(IdIndexEntry)))
+#define ESCAPY_FIXED_NAME_INDEX(count) \
+    (2 * ESCAPY_FIXED_BLOCK(4 * ((count) + 8) * sizeof(NameIndexEntry)))
+#define ESCAPY_FIXED_NAME ESCAPY_FIXED_BLOCK(ESCAPY_MAX_NAME_LEN + 1)
+#define ESCAPY_FIXED_FOOTPRINT \
+    (ESCAPY_FIXED_BLOCK(sizeof(ChallengeRoomSystem)) + ESCAPY_FIXED_NAME + \
+     ESCAPY_FIXED_TABLE(ESCAPY_MAX_CHALLENGES, sizeof(Challenge *)) + \
+     ESCAPY_MAX_CHALLENGES * (ESCAPY_FIXED_BLOCK(sizeof(Challenge)) + \
+                              ESCAPY_FIXED_NAME) + \
+     ESCAPY_FIXED_ID_INDEX(ESCAPY_MAX_CHALLENGES) + \
+     ESCAPY_FIXED_NAME_INDEX(ESCAPY_MAX_CHALLENGES) + \
+     ESCAPY_FIXED_TABLE(ESCAPY_MAX_CHALLENGES, sizeof(PrefixIndexEntry)) + \
+     ESCAPY_FIXED_TABLE(ESCAPY_MAX_ROOMS, sizeof(ChallengeRoom *)) + \
+     ESCAPY_FIXED_TABLE(ESCAPY_MAX_ROOMS, sizeof(PrefixIndexEntry)) + \
+     ESCAPY_FIXED_TABLE(4 * ESCAPY_MAX_ROOMS, sizeof(FreeSlotNode)) + \
+     ESCAPY_FIXED_TABLE(ESCAPY_MAX_CHALLENGES, sizeof(RateWindows)) + \
+     ESCAPY_FIXED_TABLE(ESCAPY_MAX_ROOMS, sizeof(RateWindows)) + \
+     ESCAPY_MAX_ROOMS * (ESCAPY_FIXED_BLOCK(sizeof(ChallengeRoom)) + \
+             ESCAPY_FIXED_NAME + \
+             ESCAPY_FIXED_TABLE(ESCAPY_MAX_ROOM_CHALLENGES, \
+                                sizeof(ChallengeActivity *)) + \
+             ESCAPY_FIXED_TABLE(ESCAPY_MAX_ROOM_CHALLENGES, \
+                                sizeof(PackedActivity)) + \
+             ESCAPY_FIXED_TABLE((All_Levels + 1) * \
+                                ESCAPY_MAX_ROOM_CHALLENGES, sizeof(int)) + \
+             ESCAPY_MAX_ROOM_CHALLENGES * \
+             ESCAPY_FIXED_BLOCK(sizeof(ChallengeActivity))) + \
+     (ESCAPY_MAX_VISITORS + 1) * \
+     ESCAPY_FIXED_BLOCK(sizeof(struct SVisitorsList)) + \
+     ESCAPY_MAX_VISITORS * (ESCAPY_FIXED_BLOCK(sizeof(Visitor)) + \
+                            ESCAPY_FIXED_NAME) + \
+     ESCAPY_FIXED_ID_INDEX(ESCAPY_MAX_VISITORS) + \
+     ESCAPY_FIXED_BLOCK(sizeof(VisitHistory)) + ESCAPY_MAX_HISTORY_BYTES + \
+     ESCAPY_FIXED_BLOCK(sizeof(ProfileStore)) + \
+     ESCAPY_FIXED_ID_INDEX(ESCAPY_MAX_PROFILES) + ESCAPY_MAX_PROFILE_BYTES + \
+     (ESCAPY_MAX_PROFILES + 1) * ESCAPY_FIXED_BLOCK(0) + \
+     ESCAPY_MAX_SNAPSHOT_BYTES + \
+     ESCAPY_FIXED_BLOCK(2 * REPORT_CHUNK_SIZE) + ESCAPY_FIXED_SPARE)
+#endif
+
 
 Result create_system(char *init_file, ChallengeRoomSystem **sys);
 
 
+Result create_system_parallel(char *init_file, int num_threads,
+                              ChallengeRoomSystem **sys);
+
+
+Result create_journaled_system(char *init_file, char *journal_file, int records_per_commit, ChallengeRoomSystem **sys);
+
+
+Result system_journal_sync(ChallengeRoomSystem *sys);
+
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+Result open_system(char *init_file, char *path, ChallengeRoomSystem **sys);
+
+
+Result system_persist_sync(ChallengeRoomSystem *sys);
+
+
+Result close_system(ChallengeRoomSystem *sys);
+#endif
+
+
 Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
                       char **most_popular_challenge_p, char **challenge_best_time);
 
 
+void system_free(void *ptr);
+
+
 Result visitor_arrive(ChallengeRoomSystem *sys, char *room_name, char *visitor_name, int visitor_id, Level level, int start_time);
 
 
+Result visitor_arrive_any_room(ChallengeRoomSystem *sys, char *visitor_name, int visitor_id, Level level, int start_time, char **room_name);
+
+
 Result visitor_quit(ChallengeRoomSystem *sys, int visitor_id, int quit_time);
 
 
 Result all_visitors_quit(ChallengeRoomSystem *sys, int quit_time);
 
 
+Result system_advance_time(ChallengeRoomSystem *sys, int time);
+
+
+Result set_system_session_limit(ChallengeRoomSystem *sys, Level level, int max_duration);
+
+
+Result set_system_timeout_handler(ChallengeRoomSystem *sys, SessionTimeoutHandler handler, void *context);
+
+
+Result set_system_lateness_window(ChallengeRoomSystem *sys, int lateness);
+
+
+Result system_ingest_arrive(ChallengeRoomSystem *sys, char *room_name, char *visitor_name, int visitor_id, Level level, int start_time);
+
+
+Result system_ingest_quit(ChallengeRoomSystem *sys, int visitor_id, int quit_time);
+
+
+Result system_ingest_flush(ChallengeRoomSystem *sys);
+
+
+Result system_ingest_stats(ChallengeRoomSystem *sys, int *pending, int *applied, int *failed);
+
+
+Result room_visitors_quit(ChallengeRoomSystem *sys, char *room_name, int quit_time);
+
+
+Result system_room_occupants(ChallengeRoomSystem *sys, char *room_name, RoomOccupantIterator *iterator);
+
+
+Result set_system_wait_queues(ChallengeRoomSystem *sys, int enabled);
+
+
+Result set_system_visitor_profiles(ChallengeRoomSystem *sys, int enabled);
+
+
+Result system_visitor_profile(ChallengeRoomSystem *sys, int visitor_id, VisitorProfile **profile);
+
+
+Result system_visits_in_range(ChallengeRoomSystem *sys, int from_time, int to_time, VisitHistoryIterator *iterator);
+
+
+Result system_visits_of_challenge(ChallengeRoomSystem *sys, int challenge_id, VisitHistoryIterator *iterator);
+
+
+Result system_visits_of_visitor(ChallengeRoomSystem *sys, int visitor_id, VisitHistoryIterator *iterator);
+
+
+Result system_visit_history_stats(ChallengeRoomSystem *sys, long *num_visits, size_t *num_bytes);
+
+
+Result system_rates(ChallengeRoomSystem *sys, int time, int span, int *arrivals, int *completions);
+
+
+Result system_room_rates(ChallengeRoomSystem *sys, char *room_name, int time, int span, int *arrivals, int *completions);
+
+
+Result system_challenge_rates(ChallengeRoomSystem *sys, int challenge_id, int time, int span, int *arrivals, int *completions);
+
+
+Result system_snapshot_acquire(ChallengeRoomSystem *sys, SystemSnapshot *snapshot);
+
+
+Result system_snapshot_release(SystemSnapshot *snapshot);
+
+
+Result system_snapshot_challenge(SystemSnapshot *snapshot, int idx, ChallengeMatch *match);
+
+
+Result system_snapshot_room(SystemSnapshot *snapshot, int idx, RoomMatch *match);
+
+
+Result system_snapshot_most_popular(SystemSnapshot *snapshot, char **challenge_name);
+
+
+Result system_memory_usage(ChallengeRoomSystem *sys, MemoryUsage *usage);
+
+
+Result system_write_report(ChallengeRoomSystem *sys, FILE *output, ReportFormat format);
+
+
+Result set_system_assignment_policy(ChallengeRoomSystem *sys, AssignmentPolicy policy);
+
+
+Result system_add_challenge(ChallengeRoomSystem *sys, int challenge_id, char *name, Level level);
+
+
+Result system_remove_challenge(ChallengeRoomSystem *sys, int challenge_id);
+
+
+Result system_add_room(ChallengeRoomSystem *sys, char *room_name);
+
+
+Result system_remove_room(ChallengeRoomSystem *sys, char *room_name);
+
+
+Result system_attach_challenge(ChallengeRoomSystem *sys, char *room_name, int challenge_id);
+
+
+Result system_detach_challenge(ChallengeRoomSystem *sys, char *room_name, int challenge_id);
+
+
+Result reload_system(ChallengeRoomSystem *sys, char *init_file);
+
+
+Result system_wait_queue_length(ChallengeRoomSystem *sys, char *room_name, Level level, int *length);
+
+
+Result system_visitor_wait_time(ChallengeRoomSystem *sys, int visitor_id, int time, int *wait_time);
+
+
+Result system_book_challenge(ChallengeRoomSystem *sys, char *room_name, int challenge_id, int visitor_id, int start_time, int end_time);
+
+
+Result system_cancel_booking(ChallengeRoomSystem *sys, char *room_name, int challenge_id, int start_time);
+
+
+Result system_first_free_slot(ChallengeRoomSystem *sys, char *room_name, Level level, int after_time, int duration, int *slot_time, int *challenge_id);
+
+
 Result system_room_of_visitor(ChallengeRoomSystem *sys, char *visitor_name, char **room_name);
 
 
+Result system_search_challenges(ChallengeRoomSystem *sys, char *prefix, PrefixIterator *iterator);
+
+
+int system_next_challenge_match(PrefixIterator *iterator, ChallengeMatch *match);
+
+
+Result system_search_rooms(ChallengeRoomSystem *sys, char *prefix, PrefixIterator *iterator);
+
+
+int system_next_room_match(PrefixIterator *iterator, RoomMatch *match);
+
+
 Result change_challenge_name(ChallengeRoomSystem *sys, int challenge_id, char *new_name);
 
 
+Result change_system_challenge_level(ChallengeRoomSystem *sys, int challenge_id, Level level);
+
+
 Result change_system_room_name(ChallengeRoomSystem *sys, char *current_name, char *new_name);
 
 
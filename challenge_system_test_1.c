@@ -55,16 +55,16 @@ int main(int argc, char **argv)
    char *namep=NULL;
    r=most_popular_challenge(sys, &namep);
    ASSERT("1.9" , namep!=NULL && strcmp(namep, "challenge_1111")==0)
-   free(namep);
+   system_free(namep);
 
    char *room=NULL;
    r=system_room_of_visitor(sys, "visitor_4", &room);
    ASSERT("1.10" , r==NOT_IN_ROOM)
-   free(room);
+   system_free(room);
 
    r=system_room_of_visitor(sys, "visitor_3", &room);
    ASSERT("1.11" , r==OK && room!=NULL && strcmp(room, "room_111")==0)
-   free(room);
+   system_free(room);
 
    r=all_visitors_quit(sys, 17);
 
@@ -79,9 +79,9 @@ int main(int argc, char **argv)
    ASSERT("1.14" , most_popular_challenge!=NULL && strcmp(most_popular_challenge, "challenge_1111")==0)
    ASSERT("1.15" , challenge_best_time!=NULL && strcmp(challenge_best_time, "challenge_4")==0)
 
-   free(most_popular_challenge);
+   system_free(most_popular_challenge);
 
-   free(challenge_best_time);
+   system_free(challenge_best_time);
 
    return 0;
 }
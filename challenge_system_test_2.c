@@ -0,0 +1,934 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <malloc.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "challenge_system.h"
+#include "server_protocol.h"
+#include "server_connection.h"
+#include "trace.h"
+#include "venue_simulation.h"
+
+#define ASSERT(test_number, test_condition)  \
+   if (!(test_condition)) {printf("\nTEST %s FAILED", test_number); } \
+   else printf("\nTEST %s OK", test_number);
+
+static void count_timeout(int visitor_id, char *visitor_name, char *room_name,
+                          int quit_time, void *context)
+{
+   int *timeouts=context;
+   timeouts[0]++;
+   timeouts[1]=visitor_id;
+   timeouts[2]=quit_time;
+}
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+static int copy_file(char *from, char *to)
+{
+   FILE *input=fopen(from, "rb"), *output=fopen(to, "wb");
+   char buffer[4096];
+   size_t length=0;
+   while (input!=NULL && output!=NULL &&
+          (length=fread(buffer, 1, sizeof(buffer), input))>0) {
+      fwrite(buffer, 1, length, output);
+   }
+   int copied=input!=NULL && output!=NULL;
+   if (input!=NULL) fclose(input);
+   if (output!=NULL) fclose(output);
+   return copied;
+}
+#endif
+
+static int open_test_connection(ServerConnection *connection, int *peer)
+{
+   int fds[2];
+   if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)!=0) return 0;
+   int flags=fcntl(fds[0], F_GETFL, 0);
+   if (flags<0 || fcntl(fds[0], F_SETFL, flags | O_NONBLOCK)!=0) return 0;
+   init_server_connection(connection, fds[0]);
+   *peer=fds[1];
+   return 1;
+}
+
+static void close_test_connection(ServerConnection *connection, int peer)
+{
+   close(connection->fd);
+   close(peer);
+   reset_server_connection(connection);
+}
+
+static size_t put_name_request(unsigned char *out, ServerOp op, char *name)
+{
+   size_t size=FRAME_HEADER_SIZE;
+   out[size++]=(unsigned char)op;
+   size+=protocol_put_string(out+size, name);
+   protocol_put_int(out, (int)(size-FRAME_HEADER_SIZE));
+   return size;
+}
+
+static size_t read_all(int fd, unsigned char *buffer, size_t size)
+{
+   size_t received=0;
+   while (received<size) {
+      ssize_t chunk=read(fd, buffer+received, size-received);
+      if (chunk<=0) break;
+      received+=(size_t)chunk;
+   }
+   return received;
+}
+
+static int same_system(ChallengeRoomSystem *first, ChallengeRoomSystem *second)
+{
+   if (strcmp(first->system_name, second->system_name)!=0 ||
+       first->system_num_challenges!=second->system_num_challenges ||
+       first->system_num_rooms!=second->system_num_rooms) return 0;
+   for (int i=0; i<first->system_num_challenges; ++i) {
+      Challenge *a=first->system_challenges[i], *b=second->system_challenges[i];
+      if (a->id!=b->id || strcmp(a->name, b->name)!=0 || a->level!=b->level ||
+          a->system_idx!=b->system_idx) return 0;
+      ChallengeActivity *x=activity_at(a->activities), *y=activity_at(b->activities);
+      while (x!=NULL && y!=NULL &&
+             strcmp(room_at(x->room)->name, room_at(y->room)->name)==0) {
+         x=activity_at(x->next_instance);
+         y=activity_at(y->next_instance);
+      }
+      if (x!=NULL || y!=NULL) return 0;
+   }
+   for (int i=0; i<first->system_num_rooms; ++i) {
+      ChallengeRoom *a=first->system_rooms[i], *b=second->system_rooms[i];
+      if (strcmp(a->name, b->name)!=0 || a->system_idx!=b->system_idx ||
+          a->num_of_challenges!=b->num_of_challenges ||
+          a->challenge_ids_hash!=b->challenge_ids_hash) return 0;
+      for (int j=0; j<a->num_of_challenges; ++j) {
+         if (challenge_at(a->challenges[j]->challenge)->id!=
+             challenge_at(b->challenges[j]->challenge)->id ||
+             a->challenges[j]->idx!=b->challenges[j]->idx ||
+             a->packed[j].challenge_id!=b->packed[j].challenge_id ||
+             a->packed[j].name_rank!=b->packed[j].name_rank ||
+             a->packed[j].level!=b->packed[j].level) return 0;
+      }
+   }
+   return 1;
+}
+
+int main(int argc, char **argv)
+{
+
+   ChallengeRoomSystem *sys=NULL;
+   Result r=OK;
+
+   r=create_system("test_1.txt", &sys);
+   ASSERT("2.1" , r==OK)
+
+   r=visitor_arrive(sys, "room_4", "visitor_1", 301, Easy, 1);
+   r=visitor_arrive(sys, "room_4", "visitor_2", 302, Hard, 2);
+   r=visitor_arrive(sys, "room_1", "visitor_3", 303, Easy, 3);
+   ASSERT("2.2" , r==OK)
+
+   RoomOccupantIterator iterator;
+   r=system_room_occupants(sys, "room_4", &iterator);
+   int occupants=0;
+   ChallengeActivity *activity=room_occupant_iterator_next(&iterator);
+   while (activity!=NULL) {
+      occupants++;
+      activity=room_occupant_iterator_next(&iterator);
+   }
+   ASSERT("2.3" , r==OK && occupants==2)
+
+   r=room_visitors_quit(sys, "room_5", 4);
+   ASSERT("2.4" , r==ILLEGAL_PARAMETER)
+
+   r=room_visitors_quit(sys, "room_4", 4);
+   ASSERT("2.5" , r==OK)
+
+   char *room=NULL;
+   r=system_room_of_visitor(sys, "visitor_1", &room);
+   ASSERT("2.6" , r==NOT_IN_ROOM)
+
+   r=system_room_of_visitor(sys, "visitor_3", &room);
+   ASSERT("2.7" , r==OK && room!=NULL && strcmp(room, "room_1")==0)
+   system_free(room);
+
+   int time;
+   r=best_time_of_system_challenge(sys, "challenge_4", &time);
+   ASSERT("2.8" , r==OK && time==3)
+
+   r=visitor_arrive(sys, "room_4", "visitor_1", 301, Easy, 5);
+   ASSERT("2.9" , r==OK)
+
+   r=visitor_arrive(sys, "room_2", "visitor_4", 304, Medium, 6);
+   r=visitor_arrive(sys, "room_2", "visitor_5", 305, Medium, 7);
+   ASSERT("2.10" , r==NO_AVAILABLE_CHALLENGES)
+
+   r=set_system_wait_queues(sys, 1);
+   r=visitor_arrive(sys, "room_2", "visitor_5", 305, Medium, 7);
+   r=visitor_arrive(sys, "room_2", "visitor_6", 306, All_Levels, 8);
+   ASSERT("2.11" , r==OK)
+
+   int length=0;
+   r=system_wait_queue_length(sys, "room_2", Medium, &length);
+   ASSERT("2.12" , r==OK && length==1)
+
+   int wait_time=0;
+   r=system_visitor_wait_time(sys, 305, 9, &wait_time);
+   ASSERT("2.13" , r==OK && wait_time==2)
+
+   r=visitor_arrive(sys, "room_2", "visitor_5", 305, Medium, 9);
+   ASSERT("2.14" , r==ALREADY_IN_ROOM)
+
+   r=visitor_quit(sys, 304, 10);
+   r=system_room_of_visitor(sys, "visitor_5", &room);
+   ASSERT("2.15" , r==OK && room!=NULL && strcmp(room, "room_2")==0)
+   system_free(room);
+
+   r=system_wait_queue_length(sys, "room_2", Medium, &length);
+   ASSERT("2.16" , r==OK && length==0)
+
+   r=visitor_quit(sys, 306, 11);
+   ASSERT("2.17" , r==OK)
+   r=system_wait_queue_length(sys, "room_2", All_Levels, &length);
+   ASSERT("2.18" , r==OK && length==0)
+
+   r=visitor_arrive(sys, "room_2", "visitor_6", 306, All_Levels, 12);
+
+   r=system_book_challenge(sys, "room_3", 11, 307, 20, 30);
+   ASSERT("2.19" , r==OK)
+   r=system_book_challenge(sys, "room_3", 11, 308, 25, 35);
+   ASSERT("2.20" , r==NO_AVAILABLE_CHALLENGES)
+   r=system_book_challenge(sys, "room_3", 22, 308, 25, 35);
+   ASSERT("2.21" , r==ILLEGAL_PARAMETER)
+
+   int slot_time=0, challenge_id=0;
+   r=system_first_free_slot(sys, "room_3", Easy, 15, 10, &slot_time,
+                            &challenge_id);
+   ASSERT("2.22" , r==OK && slot_time==30 && challenge_id==11)
+
+   r=set_system_wait_queues(sys, 0);
+   r=visitor_arrive(sys, "room_3", "visitor_8", 308, Easy, 21);
+   ASSERT("2.23" , r==NO_AVAILABLE_CHALLENGES)
+   r=visitor_arrive(sys, "room_3", "visitor_7", 307, Easy, 22);
+   ASSERT("2.24" , r==OK)
+
+   r=set_system_lateness_window(sys, 3);
+   r=system_ingest_arrive(sys, "room_4", "visitor_9", 309, Medium, 26);
+   r=system_ingest_quit(sys, 309, 28);
+   r=system_ingest_arrive(sys, "room_1", "visitor_10", 310, Hard, 24);
+   ASSERT("2.25" , r==OK)
+   r=system_ingest_arrive(sys, "room_1", "visitor_11", 311, Hard, 22);
+   ASSERT("2.26" , r==ILLEGAL_TIME)
+
+   int pending=0, applied=0, failed=0;
+   r=system_ingest_stats(sys, &pending, &applied, &failed);
+   ASSERT("2.27" , r==OK && pending==2 && applied==1 && failed==0)
+
+   r=system_room_of_visitor(sys, "visitor_10", &room);
+   ASSERT("2.28" , r==OK && room!=NULL && strcmp(room, "room_1")==0)
+   system_free(room);
+
+   r=system_ingest_flush(sys);
+   r=system_ingest_stats(sys, &pending, &applied, &failed);
+   ASSERT("2.29" , r==OK && pending==0 && applied==3 && failed==0)
+
+   char *most_popular_challenge=NULL, *challenge_best_time=NULL;
+   r=destroy_system(sys, 30, &most_popular_challenge, &challenge_best_time);
+   ASSERT("2.30" , r==OK)
+
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   remove("test_2_journal.txt");
+   r=create_journaled_system("test_1.txt", "test_2_journal.txt", 2, &sys);
+   ASSERT("2.31" , r==OK)
+   r=visitor_arrive(sys, "room_2", "visitor_1", 401, Medium, 1);
+   r=visitor_quit(sys, 401, 5);
+   r=change_challenge_name(sys, 22, "challenge_22");
+   r=system_journal_sync(sys);
+   ASSERT("2.32" , r==OK)
+   r=destroy_system(sys, 6, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_journaled_system("test_1.txt", "test_2_journal.txt", 2, &sys);
+   r=best_time_of_system_challenge(sys, "challenge_22", &time);
+   ASSERT("2.33" , r==OK && time==4)
+   r=visitor_arrive(sys, "room_2", "visitor_1", 401, Medium, 5);
+   ASSERT("2.34" , r==ILLEGAL_TIME)
+   r=destroy_system(sys, 7, &most_popular_challenge, &challenge_best_time);
+   ASSERT("2.35" , r==OK && most_popular_challenge!=NULL &&
+                   strcmp(most_popular_challenge, "challenge_22")==0)
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   remove("test_2_journal.txt");
+
+   r=create_system("test_1.txt", &sys);
+   r=set_system_assignment_policy(sys, LEAST_VISITED_POLICY);
+   ASSERT("2.36" , r==OK)
+   r=visitor_arrive(sys, "room_4", "visitor_1", 501, Hard, 1);
+   r=visitor_quit(sys, 501, 3);
+   r=visitor_arrive(sys, "room_4", "visitor_2", 502, Hard, 4);
+   r=system_room_occupants(sys, "room_4", &iterator);
+   activity=room_occupant_iterator_next(&iterator);
+   ASSERT("2.37" , r==OK && activity!=NULL &&
+                   strcmp(challenge_at(activity->challenge)->name, "challenge_6")==0)
+   r=visitor_quit(sys, 502, 10);
+   r=set_system_assignment_policy(sys, FASTEST_BEST_TIME_POLICY);
+   r=visitor_arrive(sys, "room_4", "visitor_3", 503, Hard, 11);
+   r=system_room_occupants(sys, "room_4", &iterator);
+   activity=room_occupant_iterator_next(&iterator);
+   ASSERT("2.38" , r==OK && activity!=NULL &&
+                   strcmp(challenge_at(activity->challenge)->name, "challenge_5")==0)
+   r=visitor_quit(sys, 503, 12);
+   r=set_system_assignment_policy(sys, ROUND_ROBIN_POLICY);
+   r=visitor_arrive(sys, "room_4", "visitor_4", 504, Hard, 13);
+   r=system_room_occupants(sys, "room_4", &iterator);
+   activity=room_occupant_iterator_next(&iterator);
+   ASSERT("2.39" , r==OK && activity!=NULL &&
+                   strcmp(challenge_at(activity->challenge)->name, "challenge_6")==0)
+   r=set_system_assignment_policy(sys, (AssignmentPolicy) 7);
+   ASSERT("2.40" , r==ILLEGAL_PARAMETER)
+
+   VisitHistoryIterator visits;
+   VisitRecord visit;
+   int num_found=0;
+   r=system_visits_of_challenge(sys, 55, &visits);
+   ASSERT("2.41" , r==OK && visit_history_iterator_next(&visits, &visit) &&
+                   visit.visitor_id==501 && visit.start_time==1 &&
+                   visit.duration==2)
+   r=system_visits_in_range(sys, 5, 11, &visits);
+   while (visit_history_iterator_next(&visits, &visit)) {
+      num_found++;
+   }
+   ASSERT("2.42" , r==OK && num_found==2)
+   long num_visits=0;
+   size_t num_bytes=0;
+   r=system_visit_history_stats(sys, &num_visits, &num_bytes);
+   ASSERT("2.43" , r==OK && num_visits==3 && num_bytes>0)
+   MemoryUsage usage;
+   r=system_memory_usage(sys, &usage);
+   ASSERT("2.44" , r==OK && usage.challenges>0 && usage.rooms>0 &&
+                   usage.activities>0 && usage.visitors>0 && usage.names>0)
+
+   r=system_add_challenge(sys, 77, "challenge_7", Medium);
+   ASSERT("2.45" , r==OK &&
+                   system_add_challenge(sys, 77, "challenge_8", Easy)==ILLEGAL_PARAMETER)
+   r=system_add_room(sys, "room_5");
+   r=system_attach_challenge(sys, "room_5", 77);
+   r=visitor_arrive(sys, "room_5", "visitor_5", 505, Medium, 14);
+   ASSERT("2.46" , r==OK)
+   r=system_remove_challenge(sys, 77);
+   ASSERT("2.47" , r==ALREADY_IN_ROOM)
+   r=visitor_quit(sys, 505, 15);
+   r=system_remove_challenge(sys, 77);
+   ASSERT("2.48" , r==OK &&
+                   visitor_arrive(sys, "room_5", "visitor_5", 505, Medium, 16)==NO_AVAILABLE_CHALLENGES)
+   r=system_detach_challenge(sys, "room_4", 22);
+   ASSERT("2.49" , r==OK &&
+                   system_detach_challenge(sys, "room_4", 22)==ILLEGAL_PARAMETER)
+   r=system_remove_room(sys, "room_5");
+   ASSERT("2.50" , r==OK && room_visitors_quit(sys, "room_5", 17)==ILLEGAL_PARAMETER)
+   r=destroy_system(sys, 18, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system_parallel("test_1.txt", 4, &sys);
+   ASSERT("2.51" , r==OK && sys->system_num_challenges==6 &&
+                   sys->system_num_rooms==4)
+   r=visitor_arrive(sys, "room_4", "visitor_1", 601, Hard, 1);
+   r=system_room_occupants(sys, "room_4", &iterator);
+   activity=room_occupant_iterator_next(&iterator);
+   ASSERT("2.52" , r==OK && activity!=NULL &&
+                   strcmp(challenge_at(activity->challenge)->name, "challenge_5")==0)
+   r=visitor_arrive(sys, "room_4", "visitor_2", 602, Hard, 2);
+
+   FILE *reload_file=fopen("test_2_reload.txt", "w");
+   fputs("system_1\n5\nchallenge_2 22 2\nchallenge_3 33 1\n"
+         "challenge_5 55 3\nchallenge_6 66 3\nchallenge_7 77 2\n3\n"
+         "room_1 2 66 77\nroom_3 2 55 33\nroom_5 1 77\n", reload_file);
+   fclose(reload_file);
+   r=reload_system(sys, "test_2_reload.txt");
+   ASSERT("2.53" , r==ALREADY_IN_ROOM &&
+                   system_room_of_visitor(sys, "visitor_1", &room)==OK)
+   system_free(room);
+   r=visitor_quit(sys, 601, 3);
+   reload_file=fopen("test_2_reload.txt", "w");
+   fputs("system_1\n5\nchallenge_22 22 2\nchallenge_3 33 1\n"
+         "challenge_5 55 3\nchallenge_6 66 3\nchallenge_7 77 2\n4\n"
+         "room_1 2 66 77\nroom_3 2 55 33\nroom_4 2 55 66\nroom_5 1 77\n",
+         reload_file);
+   fclose(reload_file);
+   r=reload_system(sys, "test_2_reload.txt");
+   ASSERT("2.54" , r==OK && sys->system_num_challenges==5 &&
+                   sys->system_num_rooms==4)
+   r=system_room_of_visitor(sys, "visitor_2", &room);
+   ASSERT("2.55" , r==OK && room!=NULL && strcmp(room, "room_4")==0)
+   system_free(room);
+   r=best_time_of_system_challenge(sys, "challenge_5", &time);
+   ASSERT("2.56" , r==OK && time==2)
+   r=visitor_arrive(sys, "room_3", "visitor_3", 603, Easy, 4);
+   ASSERT("2.57" , r==OK &&
+                   visitor_arrive(sys, "room_5", "visitor_4", 604, Medium, 4)==OK &&
+                   room_visitors_quit(sys, "room_2", 5)==ILLEGAL_PARAMETER)
+   r=destroy_system(sys, 6, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   remove("test_2_reload.txt");
+
+   r=create_system("test_1.txt", &sys);
+   r=set_system_visitor_profiles(sys, 1);
+   r=visitor_arrive(sys, "room_1", "visitor_1", 701, Easy, 1);
+   r=visitor_quit(sys, 701, 6);
+   r=visitor_arrive(sys, "room_1", "visitor_1", 701, Easy, 7);
+   r=visitor_quit(sys, 701, 10);
+   r=visitor_arrive(sys, "room_1", "visitor_1", 701, Hard, 11);
+   r=visitor_quit(sys, 701, 20);
+   VisitorProfile *profile=NULL;
+   r=system_visitor_profile(sys, 701, &profile);
+   ProfileEntry *entry=profile==NULL ? NULL : visitor_profile_entry(profile, 11);
+   ASSERT("2.58" , r==OK && profile->num_visits==3 && profile->num_entries==2 &&
+                   entry!=NULL && entry->num_completions==2 && entry->best_time==3)
+   r=system_visitor_profile(sys, 702, &profile);
+   ASSERT("2.59" , r==ILLEGAL_PARAMETER)
+   r=destroy_system(sys, 21, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system("test_1.txt", &sys);
+   r=change_challenge_name(sys, 44, "a_challenge");
+   r=visitor_arrive(sys, "room_1", "visitor_1", 801, Easy, 1);
+   r=change_challenge_name(sys, 11, "Z_challenge");
+   r=visitor_arrive(sys, "room_4", "visitor_2", 802, Easy, 2);
+   r=system_room_occupants(sys, "room_1", &iterator);
+   activity=room_occupant_iterator_next(&iterator);
+   ASSERT("2.60" , r==OK && activity!=NULL &&
+                   challenge_at(activity->challenge)->id==44 &&
+                   visitor_arrive(sys, "room_3", "visitor_3", 803, Easy, 3)==OK &&
+                   visitor_arrive(sys, "room_4", "visitor_4", 804, Easy, 4)==
+                   NO_AVAILABLE_CHALLENGES)
+   r=visitor_quit(sys, 801, 5);
+   r=change_challenge_name(sys, 44, "b_challenge");
+   ASSERT("2.61" , best_time_of_system_challenge(sys, "a_challenge", &time)==
+                   ILLEGAL_PARAMETER &&
+                   best_time_of_system_challenge(sys, "b_challenge", &time)==OK &&
+                   time==4)
+   r=destroy_system(sys, 6, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system_parallel("test_1.txt", 2, &sys);
+   r=visitor_arrive(sys, "room_4", "visitor_1", 901, Hard, 1);
+   r=change_system_room_name(sys, "room_4", "east_wing_1");
+   r=change_challenge_name(sys, 55, "challenge_10");
+   PrefixIterator search;
+   ChallengeMatch challenge_match;
+   RoomMatch room_match;
+   int num_matches=0;
+   r=system_search_challenges(sys, "challenge_1", &search);
+   while (system_next_challenge_match(&search, &challenge_match)) {
+      num_matches++;
+   }
+   ASSERT("2.62" , r==OK && num_matches==2 &&
+                   strcmp(challenge_match.name, "challenge_10")==0 &&
+                   challenge_match.id==55 && challenge_match.num_visits==1)
+   r=system_search_rooms(sys, "east_", &search);
+   ASSERT("2.63" , r==OK && system_next_room_match(&search, &room_match) &&
+                   room_match.num_challenges==4 && room_match.num_visitors==1 &&
+                   !system_next_room_match(&search, &room_match) &&
+                   system_search_rooms(sys, "room_4", &search)==OK &&
+                   !system_next_room_match(&search, &room_match))
+   r=destroy_system(sys, 2, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system("test_1.txt", &sys);
+   int arrivals=0, completions=0;
+   r=system_room_rates(sys, "room_1", 0, 1, &arrivals, &completions);
+   r=system_challenge_rates(sys, 22, 0, 1, &arrivals, &completions);
+   r=visitor_arrive(sys, "room_1", "visitor_1", 1001, Easy, 1);
+   r=visitor_arrive(sys, "room_2", "visitor_2", 1002, Medium, 3);
+   r=visitor_arrive(sys, "room_1", "visitor_3", 1003, Easy, 4);
+   r=visitor_quit(sys, 1001, 6);
+   r=system_rates(sys, 6, 3, &arrivals, &completions);
+   ASSERT("2.64" , r==OK && arrivals==1 && completions==1 &&
+                   system_room_rates(sys, "room_1", 10, 10, &arrivals,
+                                     &completions)==OK &&
+                   arrivals==2 && completions==1 &&
+                   system_challenge_rates(sys, 22, 10, 7, &arrivals,
+                                          &completions)==OK &&
+                   arrivals==0 && completions==0)
+   ASSERT("2.65" , system_rates(sys, 5, 3, &arrivals, &completions)==
+                   ILLEGAL_TIME &&
+                   system_rates(sys, 6, 0, &arrivals, &completions)==
+                   ILLEGAL_PARAMETER)
+   r=destroy_system(sys, 7, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system("test_1.txt", &sys);
+   r=visitor_arrive(sys, "room_1", "visitor_1", 1001, Easy, 1);
+   SystemSnapshot snapshot, later_snapshot;
+   ChallengeMatch snapshot_challenge;
+   RoomMatch snapshot_room;
+   r=system_snapshot_acquire(sys, &snapshot);
+   r=change_challenge_name(sys, 11, "challenge_7");
+   r=visitor_quit(sys, 1001, 5);
+   r=system_remove_room(sys, "room_2");
+   ASSERT("2.66" , r==OK && snapshot.num_challenges==6 &&
+                   snapshot.num_rooms==4 &&
+                   system_snapshot_challenge(&snapshot, 5,
+                                             &snapshot_challenge)==OK &&
+                   strcmp(snapshot_challenge.name, "challenge_1")==0 &&
+                   snapshot_challenge.num_visits==1 &&
+                   system_snapshot_room(&snapshot, 1, &snapshot_room)==OK &&
+                   strcmp(snapshot_room.name, "room_1")==0 &&
+                   snapshot_room.num_visitors==1 &&
+                   snapshot_room.num_free==2 &&
+                   system_snapshot_room(&snapshot, 4, &snapshot_room)==
+                   ILLEGAL_PARAMETER)
+   r=system_snapshot_acquire(sys, &later_snapshot);
+   r=destroy_system(sys, 6, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   r=system_snapshot_most_popular(&snapshot, &most_popular_challenge);
+   ASSERT("2.67" , r==OK &&
+                   strcmp(most_popular_challenge, "challenge_1")==0 &&
+                   later_snapshot.num_rooms==3 &&
+                   system_snapshot_challenge(&later_snapshot, 5,
+                                             &snapshot_challenge)==OK &&
+                   strcmp(snapshot_challenge.name, "challenge_7")==0)
+   system_free(most_popular_challenge);
+   system_snapshot_release(&snapshot);
+   system_snapshot_release(&later_snapshot);
+
+   r=create_system("test_1.txt", &sys);
+   char *routed_room=NULL, *routed_room_2=NULL;
+   r=visitor_arrive_any_room(sys, "visitor_1", 2001, Hard, 1, &routed_room);
+   r=visitor_arrive_any_room(sys, "visitor_2", 2002, Hard, 1, &routed_room_2);
+   ASSERT("2.68" , r==OK && strcmp(routed_room, "room_3")==0 &&
+                   strcmp(routed_room_2, "room_4")==0 &&
+                   visitor_arrive_any_room(sys, "visitor_1", 2001, Easy, 2,
+                                           NULL)==ALREADY_IN_ROOM)
+   system_free(routed_room);
+   system_free(routed_room_2);
+   r=change_system_challenge_level(sys, 11, Hard);
+   r=visitor_arrive_any_room(sys, "visitor_3", 2003, Hard, 2, &routed_room);
+   ASSERT("2.69" , r==OK && strcmp(routed_room, "room_1")==0 &&
+                   visitor_arrive_any_room(sys, "visitor_4", 2004, Medium, 3,
+                                           NULL)==OK &&
+                   visitor_arrive_any_room(sys, "visitor_5", 2005, Medium, 3,
+                                           NULL)==OK &&
+                   visitor_arrive_any_room(sys, "visitor_6", 2006, Medium, 3,
+                                           NULL)==NO_AVAILABLE_CHALLENGES &&
+                   visitor_quit(sys, 2004, 4)==OK &&
+                   visitor_arrive_any_room(sys, "visitor_6", 2006, Medium, 4,
+                                           NULL)==OK)
+   system_free(routed_room);
+   r=destroy_system(sys, 5, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system("test_1.txt", &sys);
+   int timeouts[3]={0, 0, 0}, best_time=0;
+   r=set_system_session_limit(sys, Easy, 5);
+   r=set_system_timeout_handler(sys, count_timeout, timeouts);
+   r=set_system_wait_queues(sys, 1);
+   r=visitor_arrive(sys, "room_1", "visitor_1", 1001, Easy, 1);
+   r=visitor_arrive(sys, "room_1", "visitor_2", 1002, Easy, 2);
+   r=visitor_arrive(sys, "room_1", "visitor_3", 1003, Easy, 3);
+   r=system_advance_time(sys, 6);
+   ASSERT("2.70" , r==OK && timeouts[0]==1 && timeouts[1]==1001 &&
+                   timeouts[2]==6 &&
+                   visitor_quit(sys, 1001, 6)==NOT_IN_ROOM &&
+                   system_visitor_wait_time(sys, 1003, 6, &wait_time)==
+                   NOT_IN_ROOM &&
+                   set_system_session_limit(sys, Easy, -1)==ILLEGAL_PARAMETER)
+   r=visitor_arrive(sys, "room_3", "visitor_4", 1004, Hard, 12);
+   ASSERT("2.71" , r==OK && timeouts[0]==3 && timeouts[1]==1003 &&
+                   timeouts[2]==11 &&
+                   best_time_of_system_challenge(sys, "challenge_1",
+                                                 &best_time)==OK &&
+                   best_time==5 && system_advance_time(sys, 11)==ILLEGAL_TIME)
+   r=destroy_system(sys, 12, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system("test_1.txt", &sys);
+   char report[2048];
+   size_t report_length=0;
+   FILE *report_file=tmpfile();
+   r=visitor_arrive(sys, "room_2", "visitor_1", 1001, Medium, 3);
+   r=system_write_report(sys, report_file, CSV_REPORT);
+   rewind(report_file);
+   report_length=fread(report, 1, sizeof(report)-1, report_file);
+   report[report_length]='\0';
+   ASSERT("2.72" , r==OK && strncmp(report, "name,time\nsystem_1,3\n\n", 22)==0 &&
+                   strstr(report, "\n11,challenge_1,easy,0,0\n")!=NULL &&
+                   strstr(report, "\n1001,visitor_1,room_2,challenge_2,3\n")!=NULL &&
+                   system_write_report(sys, report_file, 2)==ILLEGAL_PARAMETER)
+   fclose(report_file);
+   report_file=tmpfile();
+   r=system_write_report(sys, report_file, JSON_REPORT);
+   rewind(report_file);
+   report_length=fread(report, 1, sizeof(report)-1, report_file);
+   report[report_length]='\0';
+   ASSERT("2.73" , r==OK && strncmp(report, "{\n\"system\":{\"name\":\"system_1\",\"time\":3},", 40)==0 &&
+                   strstr(report, "{\"visitor_id\":1001,\"visitor_name\":\"visitor_1\",\"room\":\"room_2\"")!=NULL &&
+                   strcmp(report + report_length - 5, "\n]\n}\n")==0)
+   fclose(report_file);
+   r=destroy_system(sys, 4, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   remove("test_2_journal.txt");
+   r=create_journaled_system("test_1.txt", "test_2_journal.txt", 1, &sys);
+   char long_name[300];
+   memset(long_name, 'a', sizeof(long_name)-1);
+   long_name[sizeof(long_name)-1]='\0';
+   ASSERT("2.74" , r==OK &&
+                   visitor_arrive(sys, "room_2", "visitor one", 501, Medium, 1)==ILLEGAL_PARAMETER &&
+                   change_challenge_name(sys, 22, "challenge\t22")==ILLEGAL_PARAMETER &&
+                   system_add_room(sys, long_name)==ILLEGAL_PARAMETER &&
+                   visitor_arrive(sys, "room_2", "visitor_1", 501, Medium, 1)==OK)
+   r=destroy_system(sys, 2, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   remove("test_2_journal.txt");
+   r=create_journaled_system("test_1.txt", "no_such_dir/journal.txt", 1, &sys);
+   ASSERT("2.75" , r==ILLEGAL_PARAMETER && sys==NULL)
+
+   r=create_system("test_1.txt", &sys);
+   r=set_system_wait_queues(sys, 0);
+   r=system_book_challenge(sys, "room_2", 22, 601, 5, 10);
+   ASSERT("2.76" , r==OK &&
+                   visitor_arrive(sys, "room_2", "visitor_2", 602, Medium, 6)==NO_AVAILABLE_CHALLENGES &&
+                   visitor_arrive(sys, "room_2", "visitor_1", 601, Medium, 7)==OK &&
+                   visitor_quit(sys, 601, 8)==OK &&
+                   visitor_arrive(sys, "room_2", "visitor_3", 603, Medium, 9)==NO_AVAILABLE_CHALLENGES &&
+                   visitor_arrive(sys, "room_2", "visitor_3", 603, Medium, 10)==OK)
+   r=system_book_challenge(sys, "room_2", 22, 604, 12, 20);
+   ASSERT("2.77" , r==OK && visitor_quit(sys, 603, 13)==OK &&
+                   visitor_arrive(sys, "room_2", "visitor_5", 605, Medium, 14)==NO_AVAILABLE_CHALLENGES &&
+                   system_cancel_booking(sys, "room_2", 22, 12)==OK &&
+                   visitor_arrive(sys, "room_2", "visitor_5", 605, Medium, 15)==OK)
+   r=destroy_system(sys, 16, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system("test_1.txt", &sys);
+   r=system_room_rates(sys, "room_4", 0, 1, &arrivals, &completions);
+   r=visitor_arrive(sys, "room_4", "visitor_1", 701, Hard, 1);
+   r=visitor_quit(sys, 701, 2);
+   r=system_remove_room(sys, "room_2");
+   r=system_add_room(sys, "room_5");
+   ASSERT("2.78" , r==OK &&
+                   system_room_rates(sys, "room_4", 3, 5, &arrivals, &completions)==OK &&
+                   arrivals==1 && completions==1 &&
+                   system_room_rates(sys, "room_5", 3, 5, &arrivals, &completions)==OK &&
+                   arrivals==0 && completions==0)
+   r=destroy_system(sys, 4, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   r=create_system("test_1.txt", &sys);
+   r=set_system_wait_queues(sys, 1);
+   r=system_book_challenge(sys, "room_2", 22, 801, 1, 10);
+   r=system_book_challenge(sys, "room_4", 22, 802, 1, 10);
+   ASSERT("2.79" , r==OK &&
+                   visitor_arrive_any_room(sys, "visitor_3", 803, Medium, 2, &routed_room)==NO_AVAILABLE_CHALLENGES &&
+                   system_wait_queue_length(sys, "room_2", Medium, &length)==OK && length==0 &&
+                   visitor_arrive(sys, "room_2", "visitor_3", 803, Medium, 3)==OK &&
+                   system_wait_queue_length(sys, "room_2", Medium, &length)==OK && length==1)
+   r=destroy_system(sys, 4, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   remove("test_2_journal.txt");
+   r=create_journaled_system("test_1.txt", "test_2_journal.txt", 1, &sys);
+   r=set_system_session_limit(sys, Medium, 3);
+   r=visitor_arrive(sys, "room_2", "visitor_1", 901, Medium, 1);
+   ChallengeRoomSystem *replayed=NULL;
+   r=create_journaled_system("test_1.txt", "test_2_journal.txt", 1, &replayed);
+   ASSERT("2.80" , r==OK && system_advance_time(replayed, 10)==OK &&
+                   visitor_quit(replayed, 901, 10)==NOT_IN_ROOM &&
+                   best_time_of_system_challenge(replayed, "challenge_2", &time)==OK &&
+                   time==3)
+   r=destroy_system(replayed, 11, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   r=destroy_system(sys, 11, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   remove("test_2_journal.txt");
+
+   remove("test_2_journal.txt");
+   r=create_journaled_system("test_1.txt", "test_2_journal.txt", 1, &sys);
+   reload_file=fopen("test_2_reload.txt", "w");
+   fprintf(reload_file, "system_1\n7\nchallenge_2 22 2\nchallenge_3 33 3\n"
+           "challenge_4 44 1\nchallenge_5 55 3\nchallenge_6 66 3\n"
+           "challenge_1 11 1\n%s 77 2\n4\nroom_2 2 22 77\n"
+           "room_1 3 11 44 66\nroom_3 3 55 33 11\nroom_4 4 22 44 55 66\n",
+           long_name);
+   fclose(reload_file);
+   r=reload_system(sys, "test_2_reload.txt");
+   ASSERT("2.83" , r==ILLEGAL_PARAMETER && sys->system_num_challenges==6 &&
+                   sys->system_rooms[0]->num_of_challenges==1)
+   reload_file=fopen("test_2_reload.txt", "w");
+   fprintf(reload_file, "system_1\n6\nchallenge_2 22 2\nchallenge_3 33 3\n"
+           "challenge_4 44 1\nchallenge_5 55 3\nchallenge_6 66 3\n"
+           "challenge_1 11 1\n4\nroom_2 1 22\nroom_1 3 11 44 66\n"
+           "room_3 3 55 33 11\n%s 4 22 44 55 66\n", long_name);
+   fclose(reload_file);
+   r=reload_system(sys, "test_2_reload.txt");
+   ASSERT("2.84" , r==ILLEGAL_PARAMETER && sys->system_num_rooms==4)
+   r=visitor_arrive_any_room(sys, "visitor_1", 1101, Easy, 1, NULL);
+   r=system_snapshot_acquire(sys, &snapshot);
+   r=system_snapshot_release(&snapshot);
+   reload_file=fopen("test_2_reload.txt", "w");
+   fputs("system_1\n6\nchallenge_2 22 2\nchallenge_3 33 3\n"
+         "challenge_4 44 1\nchallenge_5 55 3\nchallenge_6 66 3\n"
+         "challenge_1 11 1\n5\nroom_2 1 22\nroom_1 3 11 44 66\n"
+         "room_3 3 55 33 11\nroom_4 4 22 44 55 66\nroom_5 1 33\n",
+         reload_file);
+   fclose(reload_file);
+   r=reload_system(sys, "test_2_reload.txt");
+   r=create_journaled_system("test_1.txt", "test_2_journal.txt", 1, &replayed);
+   ASSERT("2.85" , r==OK && sys->system_num_rooms==5 &&
+                   sys->free_slots.nodes!=NULL && sys->room_stats!=NULL &&
+                   replayed->system_num_rooms==5 &&
+                   visitor_arrive(replayed, "room_5", "visitor_2", 1102, Hard, 2)==OK)
+   r=destroy_system(replayed, 3, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   r=destroy_system(sys, 3, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   remove("test_2_reload.txt");
+   remove("test_2_journal.txt");
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+   remove("test_2_arena.bin");
+   r=open_system("test_1.txt", "test_2_arena.bin", &sys);
+   r=visitor_arrive(sys, "room_2", "visitor_1", 1001, Medium, 1);
+   r=visitor_quit(sys, 1001, 4);
+   r=visitor_arrive(sys, "room_4", "visitor_2", 1002, Hard, 5);
+   r=close_system(sys);
+   ASSERT("2.86" , r==OK)
+   r=open_system(NULL, "test_2_arena.bin", &sys);
+   ASSERT("2.87" , r==OK && sys->system_last_known_time==5 &&
+                   best_time_of_system_challenge(sys, "challenge_2", &time)==OK &&
+                   time==3 &&
+                   system_room_of_visitor(sys, "visitor_2", &room)==OK &&
+                   strcmp(room, "room_4")==0 &&
+                   system_room_of_visitor(sys, "visitor_1", &routed_room)==NOT_IN_ROOM)
+   system_free(room);
+   r=visitor_quit(sys, 1002, 6);
+   int copied=copy_file("test_2_arena.bin", "test_2_arena_crash.bin");
+   r=close_system(sys);
+   r=open_system(NULL, "test_2_arena_crash.bin", &sys);
+   ASSERT("2.88" , copied && r==ILLEGAL_PARAMETER)
+   r=open_system(NULL, "test_2_arena.bin", &sys);
+   ASSERT("2.89" , r==OK && sys->system_last_known_time==6 &&
+                   system_room_of_visitor(sys, "visitor_2", &room)==NOT_IN_ROOM)
+   r=destroy_system(sys, 7, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   remove("test_2_arena.bin");
+   remove("test_2_arena_crash.bin");
+#endif
+
+   unsigned char message[MAX_FRAME_SIZE], replies[64];
+   const unsigned char *in=message, *cut=message+4;
+   char decoded[MAX_STRING_LEN+1];
+   int value=0;
+   size_t size=protocol_put_int(message, -7);
+   size+=protocol_put_string(message+size, long_name);
+   ASSERT("2.90" , size==4+1+MAX_STRING_LEN &&
+                   protocol_get_int(&in, message+size, &value) && value==-7 &&
+                   protocol_get_string(&in, message+size, decoded) &&
+                   strlen(decoded)==MAX_STRING_LEN && in==message+size &&
+                   !protocol_get_int(&in, message+size, &value) &&
+                   !protocol_get_string(&cut, message+size-1, decoded))
+
+   r=create_system("test_1.txt", &sys);
+   ServerConnection connection;
+   int peer=-1;
+   int opened=open_test_connection(&connection, &peer);
+   size=FRAME_HEADER_SIZE;
+   message[size++]=OP_ARRIVE;
+   size+=protocol_put_int(message+size, 2001);
+   size+=protocol_put_int(message+size, Easy);
+   size+=protocol_put_int(message+size, 10);
+   size+=protocol_put_string(message+size, "room_4");
+   size+=protocol_put_string(message+size, "visitor_p");
+   protocol_put_int(message, (int)(size-FRAME_HEADER_SIZE));
+   write(peer, message, 5);
+   int open=server_connection_read(sys, &connection);
+   ASSERT("2.91" , opened && r==OK && open && connection.input_size==5 &&
+                   !server_connection_pending(&connection))
+   write(peer, message+5, size-5);
+   open=server_connection_read(sys, &connection) &&
+        server_connection_write(&connection);
+   in=replies;
+   ASSERT("2.92" , open && connection.input_size==0 &&
+                   !server_connection_pending(&connection) &&
+                   read_all(peer, replies, 5)==5 &&
+                   protocol_get_int(&in, replies+5, &value) && value==1 &&
+                   replies[4]==OK)
+
+   size=put_name_request(message, OP_ROOM_OF_VISITOR, "visitor_p");
+   size_t quit=size;
+   message[size+FRAME_HEADER_SIZE]=OP_QUIT;
+   protocol_put_int(message+size+FRAME_HEADER_SIZE+1, 2001);
+   protocol_put_int(message+size+FRAME_HEADER_SIZE+5, 12);
+   protocol_put_int(message+size, 9);
+   size+=FRAME_HEADER_SIZE+9;
+   size+=put_name_request(message+size, OP_ROOM_OF_VISITOR, "visitor_p");
+   write(peer, message, size);
+   open=server_connection_read(sys, &connection) &&
+        server_connection_write(&connection);
+   in=replies+FRAME_HEADER_SIZE+1;
+   ASSERT("2.93" , open && quit==15 &&
+                   read_all(peer, replies, 12+5+5)==12+5+5 &&
+                   replies[4]==OK &&
+                   protocol_get_string(&in, replies+12, decoded) &&
+                   strcmp(decoded, "room_4")==0 &&
+                   replies[12+4]==OK && replies[12+5+4]==NOT_IN_ROOM)
+
+   protocol_put_int(message, 0);
+   protocol_put_int(message+4, 3);
+   message[8]=OP_QUIT;
+   message[9]=message[10]=0;
+   write(peer, message, 11);
+   open=server_connection_read(sys, &connection) &&
+        server_connection_write(&connection);
+   ASSERT("2.94" , open && read_all(peer, replies, 10)==10 &&
+                   replies[4]==ILLEGAL_PARAMETER &&
+                   replies[9]==ILLEGAL_PARAMETER)
+
+   protocol_put_int(message, MAX_FRAME_SIZE);
+   write(peer, message, 4);
+   int closed_big=!server_connection_read(sys, &connection);
+   close_test_connection(&connection, peer);
+   opened=open_test_connection(&connection, &peer);
+   protocol_put_int(message, -1);
+   write(peer, message, 4);
+   int closed_negative=!server_connection_read(sys, &connection);
+   close_test_connection(&connection, peer);
+   ASSERT("2.95" , closed_big && opened && closed_negative)
+
+   opened=open_test_connection(&connection, &peer);
+   unsigned char requests[100*12];
+   size=0;
+   for (int i=0; i<100; ++i) {
+      size+=put_name_request(requests+size, OP_ROOM_OF_VISITOR, "nobody");
+   }
+   size_t num_requests=0;
+   open=1;
+   while (open && !server_connection_pending(&connection) &&
+          num_requests<100000) {
+      write(peer, requests, size);
+      num_requests+=100;
+      open=server_connection_read(sys, &connection) &&
+           server_connection_write(&connection);
+   }
+   int was_pending=server_connection_pending(&connection);
+   size_t drained=0;
+   while (open && server_connection_pending(&connection)) {
+      unsigned char chunk[4096];
+      ssize_t received=read(peer, chunk, sizeof(chunk));
+      drained+=received>0 ? (size_t)received : 0;
+      open=server_connection_write(&connection);
+   }
+   while (drained<num_requests*5) {
+      unsigned char chunk[4096];
+      size_t left=num_requests*5-drained;
+      size_t received=read_all(peer, chunk,
+                               left<sizeof(chunk) ? left : sizeof(chunk));
+      if (received==0) break;
+      drained+=received;
+   }
+   ASSERT("2.96" , opened && open && was_pending &&
+                   !server_connection_pending(&connection) &&
+                   connection.output_end==0 && drained==num_requests*5)
+   close_test_connection(&connection, peer);
+   r=destroy_system(sys, 20, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+#ifdef ESCAPY_TRACE
+   r=create_system("test_1.txt", &sys);
+   r=visitor_arrive(sys, "room_4", "visitor_t", 3001, Easy, 1);
+   Result dumped=trace_dump("test_2_trace.json");
+   FILE *trace=fopen("test_2_trace.json", "r");
+   char line[256], span_name[64];
+   int tid=0, arrive_tid=-1, lookup_tid=-2, lines_ok=0;
+   double ts=0, dur=0, arrive_ts=0, arrive_dur=0, lookup_ts=0, lookup_dur=0;
+   if (trace!=NULL && fgets(line, sizeof(line), trace)!=NULL &&
+       strcmp(line, "{\"traceEvents\":[\n")==0) {
+      lines_ok=1;
+      while (fgets(line, sizeof(line), trace)!=NULL && line[0]=='{') {
+         if (sscanf(line, "{\"name\":\"%63[^\"]\",\"ph\":\"X\",\"pid\":1,"
+                          "\"tid\":%d,\"ts\":%lf,\"dur\":%lf}",
+                    span_name, &tid, &ts, &dur)!=4) {
+            lines_ok=0;
+         } else if (strcmp(span_name, "find_room_by_name")==0) {
+            lookup_tid=tid; lookup_ts=ts; lookup_dur=dur;
+         } else if (strcmp(span_name, "visitor_arrive")==0) {
+            arrive_tid=tid; arrive_ts=ts; arrive_dur=dur;
+         }
+      }
+      lines_ok=lines_ok && strncmp(line, "],\"displayTimeUnit\":", 19)==0;
+   }
+   if (trace!=NULL) fclose(trace);
+   ASSERT("2.97" , r==OK && dumped==OK && lines_ok &&
+                   lookup_tid==arrive_tid && lookup_ts>=arrive_ts &&
+                   lookup_ts+lookup_dur<=arrive_ts+arrive_dur)
+   r=destroy_system(sys, 2, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   remove("test_2_trace.json");
+#endif
+
+   Simulation simulation;
+   memset(&simulation, 0, sizeof(simulation));
+   simulation.init_file="test_1.txt";
+   simulation.horizon=1000;
+   simulation.num_replications=2;
+   simulation.max_queue=2;
+   simulation.seed=7;
+   int parsed=parse_level_spec(&simulation, "easy:0.5:4") &&
+              parse_level_spec(&simulation, "any:0.2:10:uniform") &&
+              !parse_level_spec(&simulation, "hard:-1:4");
+   ReplicationResult first, again, other;
+   run_replication(&simulation, 0, &first);
+   run_replication(&simulation, 0, &again);
+   run_replication(&simulation, 1, &other);
+   ASSERT("2.98" , parsed && !first.failed && !again.failed && !other.failed &&
+                   first.arrivals==again.arrivals && first.completed==again.completed &&
+                   first.rejection_rate==again.rejection_rate &&
+                   first.mean_wait==again.mean_wait &&
+                   first.mean_queue_length==again.mean_queue_length &&
+                   first.utilization==again.utilization &&
+                   first.arrivals>500 && first.arrivals<900 &&
+                   first.completed<=first.arrivals &&
+                   first.rejection_rate>=0 && first.rejection_rate<=1 &&
+                   first.max_queue_length<=2*4*NUM_WAIT_LEVELS &&
+                   first.utilization>0 && first.utilization<=1 &&
+                   first.arrivals!=other.arrivals)
+
+   r=create_system("test_1.txt", &sys);
+   Result parallel=create_system_parallel("test_1.txt", 4, &replayed);
+   ASSERT("2.99" , r==OK && parallel==OK && same_system(sys, replayed))
+   r=destroy_system(sys, 1, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+   r=destroy_system(replayed, 1, &most_popular_challenge, &challenge_best_time);
+   system_free(most_popular_challenge);
+   system_free(challenge_best_time);
+
+   return 0;
+}
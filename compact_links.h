@@ -0,0 +1,52 @@
+#ifndef COMPACT_LINKS_H_
+#define COMPACT_LINKS_H_
+
+#include <stddef.h>
+
+/*
+ * the links between the records of the system: activities, visitors, rooms,
+ * challenges and bookings. by default a link is a ptr. in the compact build
+ * (ESCAPY_COMPACT_LINKS, which implies the fixed capacity build) a link is
+ * the 32 bit offset of its target in the arena, which holds every record of
+ * the system, so the records that are made of links take about half the
+ * size. a link declared with LINK(type) is read with <name>_at and written
+ * with <name>_link, where DEFINE_LINK(type, name) defines both, and
+ * NULL_LINK links to nothing. in the default build they compile to nothing.
+ */
+#ifdef ESCAPY_COMPACT_LINKS
+
+#include <stdint.h>
+
+/* offset 0 is the header of the arena, so it is never the target of a link */
+extern char *fixed_arena_base;
+
+#define LINK(type) uint32_t
+
+#define NULL_LINK 0
+
+#define DEFINE_LINK(type, name) \
+    static inline type *name##_at(uint32_t link) { \
+        return link == 0 ? NULL : (type *) (fixed_arena_base + link); \
+    } \
+    static inline uint32_t name##_link(type *target) { \
+        return target == NULL ? 0 : \
+               (uint32_t) ((char *) target - fixed_arena_base); \
+    }
+
+#else
+
+#define LINK(type) type *
+
+#define NULL_LINK NULL
+
+#define DEFINE_LINK(type, name) \
+    static inline type *name##_at(type *link) { \
+        return link; \
+    } \
+    static inline type *name##_link(type *target) { \
+        return target; \
+    }
+
+#endif // ESCAPY_COMPACT_LINKS
+
+#endif // COMPACT_LINKS_H_
@@ -4,6 +4,9 @@
 #ifndef CONSTANTS_H_
 #define CONSTANTS_H_
 
+#include "fixed_capacity.h"
+#include "compact_links.h"
+
 typedef enum ELevel {Easy, Medium, Hard, All_Levels} Level;
 
 typedef enum EResult {OK, NULL_PARAMETER, MEMORY_PROBLEM, ILLEGAL_PARAMETER,
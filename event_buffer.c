@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <assert.h>
+
+#include "event_buffer.h"
+#include "fixed_alloc.h"
+
+#define INITIAL_CAPACITY 64
+
+static int event_before(BufferedEvent *first, BufferedEvent *second);
+
+static Result event_buffer_push(EventBuffer *buffer, BufferedEvent *event);
+
+static void sift_down(EventBuffer *buffer, int idx);
+
+/**
+ * initializes an empty buffer, no memory is allocated until the first event
+ * is pushed.
+ * @param buffer - ptr to the buffer to initialize
+ * @param lateness - how far behind the latest event time an event may arrive
+ */
+void init_event_buffer(EventBuffer *buffer, int lateness) {
+    assert(buffer != NULL);
+    buffer->events = NULL;
+    buffer->num_events = 0;
+    buffer->capacity = 0;
+    buffer->next_sequence = 0;
+    buffer->lateness = lateness;
+    buffer->max_seen_time = 0;
+    buffer->num_applied = 0;
+    buffer->num_failed = 0;
+}
+
+/**
+ * frees the buffer and all the events that are still in it.
+ * @param buffer - ptr to the buffer
+ * @return NULL_PARAMETER: if the ptr to buffer is NULL
+ *         OK: if everything went well
+ */
+Result reset_event_buffer(EventBuffer *buffer) {
+    assert(buffer != NULL);
+    if (buffer == NULL) {
+        return NULL_PARAMETER;
+    }
+    for (int i = 0; i < buffer->num_events; ++i) {
+        release_buffered_event(buffer->events + i);
+    }
+    free(buffer->events);
+    buffer->events = NULL;
+    buffer->num_events = 0;
+    buffer->capacity = 0;
+    return OK;
+}
+
+/**
+ * pushes an arrival of a visitor to the buffer, the names are duplicated
+ * into a single allocation.
+ * @param buffer - ptr to the buffer
+ * @param time - the time of the event
+ * @param room_name - the room the visitor wants to enter
+ * @param visitor_name - the name of the visitor
+ * @param visitor_id - the id of the visitor
+ * @param level - the wanted challenge level
+ * @return NULL_PARAMETER: if the ptr to buffer, room_name or visitor_name are
+ *                         NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result event_buffer_push_arrive(EventBuffer *buffer, int time,
+                                char *room_name, char *visitor_name,
+                                int visitor_id, Level level) {
+    assert(buffer != NULL && room_name != NULL && visitor_name != NULL);
+    if (buffer == NULL || room_name == NULL || visitor_name == NULL) {
+        return NULL_PARAMETER;
+    }
+    size_t room_length = strlen(room_name) + 1;
+    BufferedEvent event;
+    event.type = ARRIVE_EVENT;
+    event.time = time;
+    event.visitor_id = visitor_id;
+    event.level = level;
+    event.room_name = malloc(room_length + strlen(visitor_name) + 1);
+    if (event.room_name == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    strcpy(event.room_name, room_name);
+    event.visitor_name = event.room_name + room_length;
+    strcpy(event.visitor_name, visitor_name);
+    Result result = event_buffer_push(buffer, &event);
+    if (result != OK) {
+        release_buffered_event(&event);
+    }
+    return result;
+}
+
+/**
+ * pushes a quit of a visitor to the buffer.
+ * @param buffer - ptr to the buffer
+ * @param time - the time of the event
+ * @param visitor_id - the id of the visitor
+ * @return NULL_PARAMETER: if the ptr to buffer is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result event_buffer_push_quit(EventBuffer *buffer, int time, int visitor_id) {
+    assert(buffer != NULL);
+    if (buffer == NULL) {
+        return NULL_PARAMETER;
+    }
+    BufferedEvent event;
+    event.type = QUIT_EVENT;
+    event.time = time;
+    event.visitor_id = visitor_id;
+    event.level = All_Levels;
+    event.room_name = NULL;
+    event.visitor_name = NULL;
+    return event_buffer_push(buffer, &event);
+}
+
+/**
+ * returns the earliest event in the buffer without removing it.
+ * @param buffer - ptr to the buffer
+ * @return ptr to the earliest event, NULL if the buffer is empty
+ */
+BufferedEvent *event_buffer_top(EventBuffer *buffer) {
+    assert(buffer != NULL);
+    return buffer->num_events == 0 ? NULL : buffer->events;
+}
+
+/**
+ * removes the earliest event from the buffer, the names of the event are now
+ * owned by the caller and should be freed with release_buffered_event.
+ * @param buffer - ptr to the buffer
+ * @param event - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to buffer or event are NULL
+ *         ILLEGAL_PARAMETER: if the buffer is empty
+ *         OK: if everything went well
+ */
+Result event_buffer_pop(EventBuffer *buffer, BufferedEvent *event) {
+    assert(buffer != NULL && event != NULL);
+    if (buffer == NULL || event == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (buffer->num_events == 0) {
+        return ILLEGAL_PARAMETER;
+    }
+    *event = buffer->events[0];
+    buffer->num_events--;
+    buffer->events[0] = buffer->events[buffer->num_events];
+    sift_down(buffer, 0);
+    return OK;
+}
+
+/**
+ * frees the names of an event that was popped from the buffer.
+ * @param event - ptr to the event
+ */
+void release_buffered_event(BufferedEvent *event) {
+    assert(event != NULL);
+    //the visitor name shares the allocation of the room name
+    free(event->room_name);
+    event->room_name = NULL;
+    event->visitor_name = NULL;
+}
+
+/**
+ * checks whether an event should be applied before another.
+ * @param first - ptr to the first event
+ * @param second - ptr to the second event
+ * @return 1 if first comes before second, 0 otherwise
+ */
+static int event_before(BufferedEvent *first, BufferedEvent *second) {
+    return first->time < second->time ||
+           (first->time == second->time && first->sequence < second->sequence);
+}
+
+/**
+ * inserts an event to the heap, the event gets the next sequence num.
+ * @param buffer - ptr to the buffer
+ * @param event - ptr to the event to insert
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result event_buffer_push(EventBuffer *buffer, BufferedEvent *event) {
+    if (buffer->num_events == buffer->capacity) {
+        int capacity = buffer->capacity == 0 ? INITIAL_CAPACITY :
+                       2 * buffer->capacity;
+        BufferedEvent *events = realloc(buffer->events,
+                                        capacity * sizeof(*events));
+        if (events == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        buffer->events = events;
+        buffer->capacity = capacity;
+    }
+    event->sequence = buffer->next_sequence++;
+    int idx = buffer->num_events++;
+    while (idx > 0 && event_before(event, buffer->events + (idx - 1) / 2)) {
+        buffer->events[idx] = buffer->events[(idx - 1) / 2];
+        idx = (idx - 1) / 2;
+    }
+    buffer->events[idx] = *event;
+    return OK;
+}
+
+/**
+ * moves an event down the heap until both its children come after it.
+ * @param buffer - ptr to the buffer
+ * @param idx - the idx of the event
+ */
+static void sift_down(EventBuffer *buffer, int idx) {
+    if (buffer->num_events == 0) {
+        return;
+    }
+    BufferedEvent event = buffer->events[idx];
+    while (2 * idx + 1 < buffer->num_events) {
+        int child = 2 * idx + 1;
+        if (child + 1 < buffer->num_events &&
+            event_before(buffer->events + child + 1, buffer->events + child)) {
+            child++;
+        }
+        if (!event_before(buffer->events + child, &event)) {
+            break;
+        }
+        buffer->events[idx] = buffer->events[child];
+        idx = child;
+    }
+    buffer->events[idx] = event;
+}
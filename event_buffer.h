@@ -0,0 +1,57 @@
+#ifndef EVENT_BUFFER_H_
+#define EVENT_BUFFER_H_
+
+#include "constants.h"
+
+typedef enum EEventType {ARRIVE_EVENT, QUIT_EVENT} EventType;
+
+/*
+ * an event that was received but not applied to the system yet, the names
+ * are owned by the event
+ */
+typedef struct SBufferedEvent
+{
+   EventType type;
+   int time;
+   unsigned long sequence;
+   int visitor_id;
+   Level level;
+   char *room_name;
+   char *visitor_name;
+} BufferedEvent;
+
+
+/*
+ * a min heap of events ordered by time, events with the same time keep the
+ * order in which they were received.
+ * lateness, max_seen_time and the counters are the ingestion state that the
+ * system keeps next to the heap.
+ */
+typedef struct SEventBuffer
+{
+   BufferedEvent *events;
+   int num_events;
+   int capacity;
+   unsigned long next_sequence;
+   int lateness;
+   int max_seen_time;
+   int num_applied;
+   int num_failed;
+} EventBuffer;
+
+
+void init_event_buffer(EventBuffer *buffer, int lateness);
+
+Result reset_event_buffer(EventBuffer *buffer);
+
+Result event_buffer_push_arrive(EventBuffer *buffer, int time, char *room_name, char *visitor_name, int visitor_id, Level level);
+
+Result event_buffer_push_quit(EventBuffer *buffer, int time, int visitor_id);
+
+BufferedEvent *event_buffer_top(EventBuffer *buffer);
+
+Result event_buffer_pop(EventBuffer *buffer, BufferedEvent *event);
+
+void release_buffered_event(BufferedEvent *event);
+
+#endif // EVENT_BUFFER_H_
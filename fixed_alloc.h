@@ -0,0 +1,52 @@
+#ifndef FIXED_ALLOC_H_
+#define FIXED_ALLOC_H_
+
+/*
+ * the allocation of the files of the library, which include this header
+ * after all their other headers. in the fixed capacity build malloc and the
+ * rest are served from the arena (see fixed_capacity.h). this header is
+ * private, the public headers leave the allocation of the caller alone.
+ */
+
+#include <stdlib.h>
+#include <malloc.h>
+
+#include "fixed_capacity.h"
+
+#ifdef ESCAPY_FIXED_CAPACITY
+
+void *fixed_malloc(size_t size);
+
+void *fixed_calloc(size_t count, size_t size);
+
+void *fixed_realloc(void *ptr, size_t size);
+
+void fixed_free(void *ptr);
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+typedef enum EFixedArenaStatus {FIXED_ARENA_ATTACHED, FIXED_ARENA_NOT_MAPPED,
+    FIXED_ARENA_MISMATCH, FIXED_ARENA_DIRTY} FixedArenaStatus;
+
+FixedArenaStatus fixed_arena_attach(const char *path);
+
+int fixed_arena_sync(void);
+
+void fixed_arena_begin_change(void);
+
+void fixed_arena_detach(void);
+
+void *fixed_arena_root(void);
+
+void fixed_arena_set_root(void *root);
+
+size_t *fixed_arena_snapshot_bytes(void);
+#endif
+
+#define malloc(size) fixed_malloc(size)
+#define calloc(count, size) fixed_calloc(count, size)
+#define realloc(ptr, size) fixed_realloc(ptr, size)
+#define free(ptr) fixed_free(ptr)
+
+#endif // ESCAPY_FIXED_CAPACITY
+
+#endif // FIXED_ALLOC_H_
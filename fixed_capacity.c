@@ -0,0 +1,459 @@
+#ifdef ESCAPY_PERSISTENT_ARENA
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "challenge_system.h"
+#include "fixed_alloc.h"
+
+#ifdef ESCAPY_FIXED_CAPACITY
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+ * the header of a block of the arena, a block is a whole num of units and
+ * its first unit is the header. free blocks are kept in a circular list
+ * sorted by address so neighbours are merged when a block is freed.
+ */
+typedef union UBlockHeader {
+    struct {
+        union UBlockHeader *next;
+        size_t units;
+    } block;
+    long double align;
+    unsigned char unit[16];
+} BlockHeader;
+
+/* fails to compile if a header is not exactly one 16 byte unit */
+typedef char block_header_is_one_unit[sizeof(BlockHeader) == 16 ? 1 : -1];
+
+#define ARENA_UNITS ((ESCAPY_FIXED_FOOTPRINT) / sizeof(BlockHeader))
+#define ARENA_BYTES (ARENA_UNITS * sizeof(BlockHeader))
+
+/*
+ * the state of the allocator. the base is an empty block that is always in
+ * the free list so it is never empty, and free_list is the free block the
+ * last search stopped at.
+ */
+typedef struct SArenaState {
+    BlockHeader free_list_base;
+    BlockHeader *free_list;
+    size_t units_in_use;
+} ArenaState;
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+/*
+ * the start of an arena file, the arena follows it. the file is always
+ * mapped at the address it was created at, so the pointers kept in the
+ * arena, and the allocator state and the root kept here, stay valid from
+ * one process to the next. the magic is written last, so a file whose
+ * creation didn't finish is created again. dirty is set before the first
+ * change after a durability point and cleared by the next one, see
+ * fixed_arena_begin_change.
+ */
+typedef struct SArenaFile {
+    char magic[8];
+    size_t units;
+    void *address;
+    int dirty;
+    ArenaState state;
+    size_t snapshot_bytes;
+    void *root;
+} ArenaFile;
+
+#define ARENA_FILE_HEADER \
+    ((sizeof(ArenaFile) + sizeof(BlockHeader) - 1) / sizeof(BlockHeader) * \
+     sizeof(BlockHeader))
+#define ARENA_FILE_SIZE (ARENA_FILE_HEADER + ARENA_BYTES)
+
+/* the compact build lays the records out differently */
+#ifdef ESCAPY_COMPACT_LINKS
+#define ARENA_FILE_MAGIC "ESCAPYC"
+#else
+#define ARENA_FILE_MAGIC "ESCAPYF"
+#endif
+
+static ArenaFile *arena_file = NULL;
+static int arena_descriptor = -1;
+static ArenaState *state = NULL;
+static BlockHeader *arena = NULL;
+#else
+static BlockHeader arena[ARENA_UNITS];
+static ArenaState arena_state;
+static ArenaState *state = &arena_state;
+#endif
+
+#ifdef ESCAPY_COMPACT_LINKS
+/* fails to compile if an offset in the arena may not fit in a link */
+typedef char arena_fits_in_links[ARENA_BYTES <= UINT32_MAX ? 1 : -1];
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+char *fixed_arena_base = NULL;
+#else
+char *fixed_arena_base = (char *) arena;
+#endif
+#endif
+
+static void init_arena(void);
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+static int attach_anonymous_arena(void);
+#endif
+
+/**
+ * allocates a block from the arena, first fit.
+ * @param size - the wanted num of bytes
+ * @return ptr to the block, NULL if no free block is big enough
+ */
+void *fixed_malloc(size_t size) {
+#ifdef ESCAPY_PERSISTENT_ARENA
+    if (state == NULL && !attach_anonymous_arena()) {
+        return NULL;
+    }
+    fixed_arena_begin_change();
+#else
+    if (state->free_list == NULL) {
+        init_arena();
+    }
+#endif
+    size_t units = (size + sizeof(BlockHeader) - 1) / sizeof(BlockHeader) + 1;
+    BlockHeader *previous = state->free_list;
+    for (BlockHeader *block = previous->block.next;;
+         previous = block, block = block->block.next) {
+        if (block->block.units >= units) {
+            if (block->block.units == units) {
+                previous->block.next = block->block.next;
+            } else {
+                //the end of the block is given, the rest stays free
+                block->block.units -= units;
+                block += block->block.units;
+                block->block.units = units;
+            }
+            state->free_list = previous;
+            state->units_in_use += units;
+            return block + 1;
+        }
+        if (block == state->free_list) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * allocates a zeroed array from the arena.
+ * @param count - the num of elements
+ * @param size - the size of an element
+ * @return ptr to the array, NULL if no free block is big enough
+ */
+void *fixed_calloc(size_t count, size_t size) {
+    if (size != 0 && count > (size_t) -1 / size) {
+        return NULL;
+    }
+    void *ptr = fixed_malloc(count * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+/**
+ * resizes a block of the arena, the block is kept when it is big enough.
+ * @param ptr - the block, NULL to allocate a new one
+ * @param size - the wanted num of bytes
+ * @return ptr to the resized block, NULL if no free block is big enough, in
+ *         which case the old block is not changed
+ */
+void *fixed_realloc(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return fixed_malloc(size);
+    }
+    BlockHeader *block = (BlockHeader *) ptr - 1;
+    size_t capacity = (block->block.units - 1) * sizeof(BlockHeader);
+    if (size <= capacity) {
+        return ptr;
+    }
+    void *new_ptr = fixed_malloc(size);
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, capacity);
+    fixed_free(ptr);
+    return new_ptr;
+}
+
+/**
+ * returns a block to the arena and merges it with free neighbours.
+ * @param ptr - the block, NULL is ignored
+ */
+void fixed_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    BlockHeader *block = (BlockHeader *) ptr - 1;
+    assert(block >= arena && block < arena + ARENA_UNITS);
+#ifdef ESCAPY_PERSISTENT_ARENA
+    fixed_arena_begin_change();
+#endif
+    state->units_in_use -= block->block.units;
+    BlockHeader *previous = state->free_list;
+    while (!(block > previous && block < previous->block.next)) {
+        //the block is after the last free block or before the first one
+        if (previous >= previous->block.next &&
+            (block > previous || block < previous->block.next)) {
+            break;
+        }
+        previous = previous->block.next;
+    }
+    if (previous->block.next != &state->free_list_base &&
+        block + block->block.units == previous->block.next) {
+        block->block.units += previous->block.next->block.units;
+        block->block.next = previous->block.next->block.next;
+    } else {
+        block->block.next = previous->block.next;
+    }
+    if (previous != &state->free_list_base &&
+        previous + previous->block.units == block) {
+        previous->block.units += block->block.units;
+        previous->block.next = block->block.next;
+    } else {
+        previous->block.next = block;
+    }
+    state->free_list = previous;
+}
+
+/**
+ * returns the num of bytes reserved for the arena.
+ * @return the size of the arena
+ */
+size_t fixed_capacity_footprint(void) {
+    return ARENA_BYTES;
+}
+
+/**
+ * returns the num of bytes of the arena that are allocated, headers included.
+ * @return the num of bytes in use
+ */
+size_t fixed_capacity_in_use(void) {
+    return state == NULL ? 0 : state->units_in_use * sizeof(BlockHeader);
+}
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+/**
+ * maps the arena from a file at ESCAPY_PERSISTENT_ADDRESS, the address it
+ * was created at, so the arena and everything kept in it are back without
+ * reading them. the pages are loaded as they are touched, so attaching
+ * takes the same time however much the arena holds. an empty file, or one
+ * whose creation didn't finish, gets an empty arena.
+ * @param path - the path of the file, created if it does not exist
+ * the arena that is not kept in a file (see attach_anonymous_arena) is
+ * given up for it once nothing is allocated from it.
+ * @return FIXED_ARENA_NOT_MAPPED: if an arena file is attached already, or
+ *                                 the arena that is not kept in a file is in
+ *                                 use, or the file can't be opened, sized or
+ *                                 mapped at the address
+ *         FIXED_ARENA_MISMATCH: if the file is not an arena of this build
+ *         FIXED_ARENA_DIRTY: if the file was changed after its last
+ *                            durability point, so a change may have been
+ *                            cut in the middle
+ *         FIXED_ARENA_ATTACHED: if everything went well
+ */
+FixedArenaStatus fixed_arena_attach(const char *path) {
+    if (path == NULL || (arena_file != NULL && (arena_descriptor != -1 ||
+                                                state->units_in_use != 0))) {
+        return FIXED_ARENA_NOT_MAPPED;
+    }
+    fixed_arena_detach();
+    int descriptor = open(path, O_RDWR | O_CREAT, 0644);
+    if (descriptor == -1) {
+        return FIXED_ARENA_NOT_MAPPED;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 ||
+        (status.st_size == 0 &&
+         ftruncate(descriptor, (off_t) ARENA_FILE_SIZE) != 0)) {
+        close(descriptor);
+        return FIXED_ARENA_NOT_MAPPED;
+    }
+    if (status.st_size != 0 && status.st_size != (off_t) ARENA_FILE_SIZE) {
+        close(descriptor);
+        return FIXED_ARENA_MISMATCH;
+    }
+    void *address = (void *) (uintptr_t) ESCAPY_PERSISTENT_ADDRESS;
+    void *mapped = mmap(address, ARENA_FILE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, descriptor, 0);
+    if (mapped != address) {
+        //the address is only a hint, another mapping may hold it
+        if (mapped != MAP_FAILED) {
+            munmap(mapped, ARENA_FILE_SIZE);
+        }
+        close(descriptor);
+        return FIXED_ARENA_NOT_MAPPED;
+    }
+    ArenaFile *file = mapped;
+    int created = file->magic[0] == '\0';
+    if (!created && (memcmp(file->magic, ARENA_FILE_MAGIC,
+                            sizeof(file->magic)) != 0 ||
+                     file->units != ARENA_UNITS || file->address != mapped)) {
+        munmap(mapped, ARENA_FILE_SIZE);
+        close(descriptor);
+        return FIXED_ARENA_MISMATCH;
+    }
+    if (!created && file->dirty) {
+        munmap(mapped, ARENA_FILE_SIZE);
+        close(descriptor);
+        return FIXED_ARENA_DIRTY;
+    }
+    arena_file = file;
+    arena_descriptor = descriptor;
+    state = &file->state;
+    arena = (BlockHeader *) ((char *) mapped + ARENA_FILE_HEADER);
+#ifdef ESCAPY_COMPACT_LINKS
+    fixed_arena_base = (char *) arena;
+#endif
+    if (created) {
+        file->units = ARENA_UNITS;
+        file->address = mapped;
+        file->dirty = 0;
+        file->snapshot_bytes = 0;
+        file->root = NULL;
+        init_arena();
+        memcpy(file->magic, ARENA_FILE_MAGIC, sizeof(file->magic));
+    }
+    return FIXED_ARENA_ATTACHED;
+}
+
+/**
+ * a durability point: writes the arena to its file and waits for the
+ * write, then clears the dirty mark of the file. everything done before
+ * survives a crash of the process or of the machine.
+ * @return 1 if the arena was written, 0 if no arena file is attached or the
+ *         write failed, in which case the file stays dirty
+ */
+int fixed_arena_sync(void) {
+    if (arena_file == NULL || arena_descriptor == -1) {
+        return 0;
+    }
+    if (msync(arena_file, ARENA_FILE_SIZE, MS_SYNC) != 0 ||
+        fsync(arena_descriptor) != 0) {
+        return 0;
+    }
+    //the mark is cleared only once the arena it covers is in the file
+    arena_file->dirty = 0;
+    return msync(arena_file, ARENA_FILE_HEADER, MS_SYNC) == 0 &&
+           fsync(arena_descriptor) == 0;
+}
+
+/**
+ * marks the attached arena file dirty before a change of the records kept
+ * in it, and waits until the mark is in the file, so a crash in the middle
+ * of the change leaves a file that is not opened again. only the first
+ * change after a durability point writes the mark, see fixed_arena_sync.
+ */
+void fixed_arena_begin_change(void) {
+    if (arena_file == NULL || arena_descriptor == -1 || arena_file->dirty) {
+        return;
+    }
+    arena_file->dirty = 1;
+    msync(arena_file, ARENA_FILE_HEADER, MS_SYNC);
+}
+
+/**
+ * unmaps the arena, the ptrs into it are no longer valid. the arena is
+ * written to its file by the system in its own time, see fixed_arena_sync.
+ */
+void fixed_arena_detach(void) {
+    if (arena_file == NULL) {
+        return;
+    }
+    munmap(arena_file, ARENA_FILE_SIZE);
+    if (arena_descriptor != -1) {
+        close(arena_descriptor);
+    }
+    arena_file = NULL;
+    arena_descriptor = -1;
+    state = NULL;
+    arena = NULL;
+#ifdef ESCAPY_COMPACT_LINKS
+    fixed_arena_base = NULL;
+#endif
+}
+
+/**
+ * maps an arena that is not kept in a file, for the systems that are made
+ * by create_system while no arena file is attached. it is mapped wherever
+ * there is room, since no process will map it again, and it stays until an
+ * arena file is attached in its place.
+ * @return 1 if the arena was mapped, 0 otherwise
+ */
+static int attach_anonymous_arena(void) {
+    void *mapped = mmap(NULL, ARENA_FILE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return 0;
+    }
+    arena_file = mapped;
+    arena_descriptor = -1;
+    arena_file->units = ARENA_UNITS;
+    arena_file->address = mapped;
+    state = &arena_file->state;
+    arena = (BlockHeader *) ((char *) mapped + ARENA_FILE_HEADER);
+#ifdef ESCAPY_COMPACT_LINKS
+    fixed_arena_base = (char *) arena;
+#endif
+    init_arena();
+    return 1;
+}
+
+/**
+ * returns the root kept with the attached arena.
+ * @return the root, NULL if there is none or no arena is attached
+ */
+void *fixed_arena_root(void) {
+    return arena_file == NULL ? NULL : arena_file->root;
+}
+
+/**
+ * keeps a ptr into the attached arena with it, to find the records again
+ * once it is attached by the next process.
+ * @param root - the root, NULL for none
+ */
+void fixed_arena_set_root(void *root) {
+    assert(arena_file != NULL);
+    arena_file->root = root;
+}
+
+/**
+ * returns the counter of the bytes of the attached arena taken by the
+ * snapshot tables, which is kept with the arena like the tables are.
+ * @return ptr to the counter
+ */
+size_t *fixed_arena_snapshot_bytes(void) {
+    assert(arena_file != NULL);
+    return &arena_file->snapshot_bytes;
+}
+#endif
+
+/**
+ * makes the whole arena a single free block, the base is an empty block
+ * that is always in the list so it is never empty.
+ */
+static void init_arena(void) {
+    state->free_list_base.block.units = 0;
+    state->free_list_base.block.next = arena;
+    arena[0].block.units = ARENA_UNITS;
+    arena[0].block.next = &state->free_list_base;
+    state->free_list = &state->free_list_base;
+    state->units_in_use = 0;
+}
+
+#endif // ESCAPY_FIXED_CAPACITY
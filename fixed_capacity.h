@@ -0,0 +1,104 @@
+#ifndef FIXED_CAPACITY_H_
+#define FIXED_CAPACITY_H_
+
+/*
+ * the fixed capacity build, for devices where the heap can't be used.
+ * when ESCAPY_FIXED_CAPACITY is defined every allocation of the system,
+ * including the strings returned to the caller, is served from a statically
+ * sized arena (see fixed_capacity.c) instead of the heap. the arena is sized
+ * at compile time from the maximums below, which may be overridden with -D.
+ * only the files of the library allocate from the arena (see fixed_alloc.h),
+ * so the caller releases the strings the system returns with system_free.
+ * the arena is shared by all the systems of the process and is not locked,
+ * so a process uses the library from one thread at a time in this build.
+ */
+
+/* the compact build links the records by their offsets in the arena */
+#if defined(ESCAPY_COMPACT_LINKS) && !defined(ESCAPY_FIXED_CAPACITY)
+#define ESCAPY_FIXED_CAPACITY
+#endif
+
+/*
+ * the persistent build keeps the arena in a file that is mapped into memory
+ * (see open_system in challenge_system.h), so the system outlives the
+ * process. a change marks the file dirty before it starts, and only a
+ * durability point clears the mark, so a file left in the middle of a
+ * change is never opened. a system made by create_system while no arena
+ * file is attached
+ * gets an arena that is not kept in a file, which an arena file replaces
+ * once nothing is allocated from it.
+ */
+#if defined(ESCAPY_PERSISTENT_ARENA) && !defined(ESCAPY_FIXED_CAPACITY)
+#define ESCAPY_FIXED_CAPACITY
+#endif
+
+#ifdef ESCAPY_FIXED_CAPACITY
+
+#include <stddef.h>
+
+#ifndef ESCAPY_MAX_CHALLENGES
+#define ESCAPY_MAX_CHALLENGES 64
+#endif
+
+#ifndef ESCAPY_MAX_ROOMS
+#define ESCAPY_MAX_ROOMS 16
+#endif
+
+/* the max num of challenges in a single room */
+#ifndef ESCAPY_MAX_ROOM_CHALLENGES
+#define ESCAPY_MAX_ROOM_CHALLENGES ESCAPY_MAX_CHALLENGES
+#endif
+
+#ifndef ESCAPY_MAX_VISITORS
+#define ESCAPY_MAX_VISITORS 256
+#endif
+
+#ifndef ESCAPY_MAX_NAME_LEN
+#define ESCAPY_MAX_NAME_LEN 50
+#endif
+
+/* the most the visit history may take, older visits are kept and newer
+   ones are dropped once it is full */
+#ifndef ESCAPY_MAX_HISTORY_BYTES
+#define ESCAPY_MAX_HISTORY_BYTES (32 * 1024)
+#endif
+
+/* the most visitors with a profile, and the most the profiles may take
+   apart from their index. visits that don't fit are not recorded in the
+   profiles */
+#ifndef ESCAPY_MAX_PROFILES
+#define ESCAPY_MAX_PROFILES 256
+#endif
+
+#ifndef ESCAPY_MAX_PROFILE_BYTES
+#define ESCAPY_MAX_PROFILE_BYTES (16 * 1024)
+#endif
+
+/* the most the snapshot tables may take, the system and all the snapshots
+   taken of it together. a snapshot can't be taken once they are full */
+#ifndef ESCAPY_MAX_SNAPSHOT_BYTES
+#define ESCAPY_MAX_SNAPSHOT_BYTES (32 * 1024)
+#endif
+
+/* room for returned strings, bookings, buffered events and the journal */
+#ifndef ESCAPY_FIXED_SPARE
+#define ESCAPY_FIXED_SPARE (16 * 1024)
+#endif
+
+size_t fixed_capacity_footprint(void);
+
+size_t fixed_capacity_in_use(void);
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+/* the address every arena file is mapped at, free in the usual layout of a
+   64 bit process. the records keep raw ptrs to each other, so the arena is
+   not relocatable: a file is only opened at this address, and not at all
+   if another mapping of the process holds it */
+#ifndef ESCAPY_PERSISTENT_ADDRESS
+#define ESCAPY_PERSISTENT_ADDRESS 0x200000000000ULL
+#endif
+#endif
+
+#endif // ESCAPY_FIXED_CAPACITY
+
+#endif // FIXED_CAPACITY_H_
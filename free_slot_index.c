@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "free_slot_index.h"
+#include "fixed_alloc.h"
+
+#define UNDEFINED -1
+
+static void update_path(FreeSlotIndex *index, int idx);
+
+static void combine_children(FreeSlotIndex *index, int node);
+
+static int first_free_under(FreeSlotIndex *index, int node, int start,
+                            int width, Level level, int from);
+
+/**
+ * initializes an index without rooms.
+ * @param index - ptr to the index to initialize
+ * @param expected_size - num of rooms the index should hold without growing
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_free_slot_index(FreeSlotIndex *index, int expected_size) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    int capacity = 1;
+    while (capacity < expected_size) {
+        capacity *= 2;
+    }
+    index->nodes = calloc(2 * (size_t) capacity, sizeof(*index->nodes));
+    if (index->nodes == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    index->size = 0;
+    index->capacity = capacity;
+    return OK;
+}
+
+/**
+ * frees the memory of an index.
+ * @param index - ptr to the index
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         OK: if everything went well
+ */
+Result reset_free_slot_index(FreeSlotIndex *index) {
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(index->nodes);
+    index->nodes = NULL;
+    index->size = 0;
+    index->capacity = 0;
+    return OK;
+}
+
+/**
+ * sets the num of free activities of a room in O(log rooms), a room with the
+ * idx of the size of the index is added to it, doubling the tree if it is
+ * full.
+ * @param index - ptr to the index
+ * @param idx - the idx of the room, at most the size of the index
+ * @param num_free - the num of free activities of each level and of
+ *                   All_Levels
+ * @return MEMORY_PROBLEM: if allocation problems have occurred, in which
+ *                         case the index is not changed
+ *         OK: if everything went well
+ */
+Result free_slot_index_set(FreeSlotIndex *index, int idx,
+                           const int *num_free) {
+    assert(index != NULL && num_free != NULL);
+    assert(idx >= 0 && idx <= index->size);
+    if (idx == index->capacity) {
+        int capacity = 2 * index->capacity;
+        FreeSlotNode *nodes = calloc(2 * (size_t) capacity, sizeof(*nodes));
+        if (nodes == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        memcpy(nodes + capacity, index->nodes + index->capacity,
+               index->size * sizeof(*nodes));
+        free(index->nodes);
+        index->nodes = nodes;
+        index->capacity = capacity;
+        for (int node = capacity - 1; node > 0; --node) {
+            combine_children(index, node);
+        }
+    }
+    if (idx == index->size) {
+        index->size++;
+    }
+    memcpy(index->nodes[index->capacity + idx].free, num_free,
+           sizeof(index->nodes->free));
+    update_path(index, idx);
+    return OK;
+}
+
+/**
+ * removes a room from the index in O(log rooms), the last room takes its
+ * place like in the rooms table of the system.
+ * @param index - ptr to the index
+ * @param idx - the idx of the room, smaller than the size of the index
+ */
+void free_slot_index_remove(FreeSlotIndex *index, int idx) {
+    assert(index != NULL && idx >= 0 && idx < index->size);
+    int last = --index->size;
+    if (idx != last) {
+        index->nodes[index->capacity + idx] =
+                index->nodes[index->capacity + last];
+        update_path(index, idx);
+    }
+    memset(index->nodes + index->capacity + last, 0, sizeof(*index->nodes));
+    update_path(index, last);
+}
+
+/**
+ * returns the room with the most free activities of a level in O(log rooms),
+ * out of rooms with as many the one with the smallest idx.
+ * @param index - ptr to the index
+ * @param level - wanted level of challenge, All_Levels counts all of them
+ * @return the idx of the room, -1 if no room has a free activity of the level
+ */
+int free_slot_index_most_free(FreeSlotIndex *index, Level level) {
+    assert(index != NULL);
+    int most = index->nodes[1].free[level];
+    if (most == 0) {
+        return UNDEFINED;
+    }
+    int node = 1;
+    while (node < index->capacity) {
+        node = index->nodes[2 * node].free[level] == most ?
+               2 * node : 2 * node + 1;
+    }
+    return node - index->capacity;
+}
+
+/**
+ * returns the first room from an idx on with a free activity of a level, in
+ * O(log rooms).
+ * @param index - ptr to the index
+ * @param level - wanted level of challenge, All_Levels counts all of them
+ * @param from - the smallest idx of a room to return
+ * @return the idx of the room, -1 if there is none
+ */
+int free_slot_index_first_free(FreeSlotIndex *index, Level level, int from) {
+    assert(index != NULL && from >= 0);
+    if (from >= index->size) {
+        return UNDEFINED;
+    }
+    return first_free_under(index, 1, 0, index->capacity, level, from);
+}
+
+/**
+ * updates the nodes above a leaf after it changed.
+ * @param index - ptr to the index
+ * @param idx - the idx of the room of the leaf
+ */
+static void update_path(FreeSlotIndex *index, int idx) {
+    for (int node = (index->capacity + idx) / 2; node > 0; node /= 2) {
+        combine_children(index, node);
+    }
+}
+
+/**
+ * sets a node to the most of each level of its two children.
+ * @param index - ptr to the index
+ * @param node - the node, not a leaf
+ */
+static void combine_children(FreeSlotIndex *index, int node) {
+    FreeSlotNode *left = index->nodes + 2 * node;
+    FreeSlotNode *right = left + 1;
+    for (int level = Easy; level <= All_Levels; ++level) {
+        int most = left->free[level] > right->free[level] ?
+                   left->free[level] : right->free[level];
+        index->nodes[node].free[level] = most;
+    }
+}
+
+/**
+ * finds the first room from an idx on with a free activity of a level under
+ * a node. a node without one is skipped whole, so at most two paths of the
+ * tree are walked.
+ * @param index - ptr to the index
+ * @param node - the node
+ * @param start - the idx of the first room under the node
+ * @param width - the num of leaves under the node
+ * @param level - wanted level of challenge
+ * @param from - the smallest idx of a room to return
+ * @return the idx of the room, -1 if there is none
+ */
+static int first_free_under(FreeSlotIndex *index, int node, int start,
+                            int width, Level level, int from) {
+    if (index->nodes[node].free[level] == 0 || start + width <= from) {
+        return UNDEFINED;
+    }
+    if (width == 1) {
+        return start;
+    }
+    int found = first_free_under(index, 2 * node, start, width / 2, level,
+                                 from);
+    return found != UNDEFINED ? found :
+           first_free_under(index, 2 * node + 1, start + width / 2, width / 2,
+                            level, from);
+}
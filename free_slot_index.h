@@ -0,0 +1,37 @@
+#ifndef FREE_SLOT_INDEX_H_
+#define FREE_SLOT_INDEX_H_
+
+#include "constants.h"
+
+/* the most free activities of each level, All_Levels counts all of them,
+   out of the rooms under a node of the tree */
+typedef struct SFreeSlotNode {
+    int free[All_Levels + 1];
+} FreeSlotNode;
+
+/*
+ * the num of free activities of each level in every room of the system, by
+ * the idx of the room in the rooms table. a segment tree keeping the most of
+ * each level under each node, so the room with the most free activities of
+ * a level and the first room with one are found in O(log rooms). the leaves
+ * are nodes[capacity + idx] and the root is nodes[1].
+ */
+typedef struct SFreeSlotIndex {
+    FreeSlotNode *nodes;
+    int size;
+    int capacity;
+} FreeSlotIndex;
+
+Result init_free_slot_index(FreeSlotIndex *index, int expected_size);
+
+Result reset_free_slot_index(FreeSlotIndex *index);
+
+Result free_slot_index_set(FreeSlotIndex *index, int idx, const int *num_free);
+
+void free_slot_index_remove(FreeSlotIndex *index, int idx);
+
+int free_slot_index_most_free(FreeSlotIndex *index, Level level);
+
+int free_slot_index_first_free(FreeSlotIndex *index, Level level, int from);
+
+#endif // FREE_SLOT_INDEX_H_
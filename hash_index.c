@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <assert.h>
+
+#include "hash_index.h"
+#include "fixed_alloc.h"
+
+#define MIN_CAPACITY 16
+
+static unsigned int hash_id(int key);
+
+static int id_index_slot(IdIndex *index, int key);
+
+static Result id_index_grow(IdIndex *index);
+
+static unsigned int hash_name(const char *key);
+
+static Result name_index_grow(NameIndex *index);
+
+/**
+ * initializes an empty index.
+ * @param index - ptr to the index to initialize
+ * @param expected_size - num of keys the index should hold without growing
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_id_index(IdIndex *index, int expected_size) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    int capacity = MIN_CAPACITY;
+    while (capacity < 2 * expected_size) {
+        capacity *= 2;
+    }
+    //an entry with a NULL value is an empty slot
+    index->entries = calloc((size_t) capacity, sizeof(*index->entries));
+    if (index->entries == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    index->capacity = capacity;
+    index->size = 0;
+    return OK;
+}
+
+/**
+ * frees the memory of the index. the values themselves are not freed.
+ * @param index - ptr to the index
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         OK: if everything went well
+ */
+Result reset_id_index(IdIndex *index) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->size = 0;
+    return OK;
+}
+
+/**
+ * inserts a key to the index, if the key is already in the index its value
+ * is replaced.
+ * @param index - ptr to the index
+ * @param key - the key
+ * @param value - the value, must not be NULL
+ * @return NULL_PARAMETER: if the ptr to index or value are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result id_index_insert(IdIndex *index, int key, void *value) {
+    assert(index != NULL && value != NULL);
+    if (index == NULL || value == NULL) {
+        return NULL_PARAMETER;
+    }
+    int slot = id_index_slot(index, key);
+    //replacing the value of a key never grows the index
+    if (index->entries[slot].value == NULL) {
+        if (2 * (index->size + 1) > index->capacity) {
+            Result result = id_index_grow(index);
+            if (result != OK) {
+                return result;
+            }
+            slot = id_index_slot(index, key);
+        }
+        index->size++;
+    }
+    index->entries[slot].key = key;
+    index->entries[slot].value = value;
+    return OK;
+}
+
+/**
+ * finds the value of a key.
+ * @param index - ptr to the index
+ * @param key - the wanted key
+ * @return the value of the key, NULL if the key is not in the index
+ */
+void *id_index_find(IdIndex *index, int key) {
+    assert(index != NULL);
+    return index->entries[id_index_slot(index, key)].value;
+}
+
+/**
+ * removes a key from the index, the entries after it in the same cluster are
+ * shifted back so no tombstones are needed.
+ * @param index - ptr to the index
+ * @param key - the key to remove
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         ILLEGAL_PARAMETER: if the key is not in the index
+ *         OK: if everything went well
+ */
+Result id_index_remove(IdIndex *index, int key) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    int mask = index->capacity - 1;
+    int hole = id_index_slot(index, key);
+    if (index->entries[hole].value == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    int next = (hole + 1) & mask;
+    while (index->entries[next].value != NULL) {
+        int home = (int) (hash_id(index->entries[next].key) & mask);
+        //moves the entry back if its home slot is not between hole and next
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->entries[hole] = index->entries[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->entries[hole].value = NULL;
+    index->size--;
+    return OK;
+}
+
+/**
+ * mixes an id into 64 bits. the sum of the hashes of the ids of a multiset
+ * tells it apart from another one whatever the order of the ids, so a set
+ * that changes keeps its hash up to date in O(1) per change.
+ * @param key - the id
+ * @return the hash of the id
+ */
+unsigned long long id_set_hash(int key) {
+    unsigned long long hash = (unsigned long long) (unsigned int) key +
+                              0x9e3779b97f4a7c15ull;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+/**
+ * mixes the bits of a key so sequential ids spread over the table.
+ * @param key - the key
+ * @return the hash of the key
+ */
+static unsigned int hash_id(int key) {
+    unsigned int hash = (unsigned int) key;
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/**
+ * finds the slot of a key, or the empty slot where it should be inserted.
+ * @param index - ptr to the index
+ * @param key - the wanted key
+ * @return the idx of the slot
+ */
+static int id_index_slot(IdIndex *index, int key) {
+    int mask = index->capacity - 1;
+    int slot = (int) (hash_id(key) & mask);
+    while (index->entries[slot].value != NULL &&
+           index->entries[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * doubles the capacity of the index and rehashes all the entries.
+ * @param index - ptr to the index
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result id_index_grow(IdIndex *index) {
+    IdIndex bigger;
+    Result result = init_id_index(&bigger, index->capacity);
+    if (result != OK) {
+        return result;
+    }
+    for (int i = 0; i < index->capacity; ++i) {
+        if (index->entries[i].value != NULL) {
+            int slot = id_index_slot(&bigger, index->entries[i].key);
+            bigger.entries[slot] = index->entries[i];
+            bigger.size++;
+        }
+    }
+    free(index->entries);
+    *index = bigger;
+    return OK;
+}
+
+/**
+ * initializes an empty index of names.
+ * @param index - ptr to the index to initialize
+ * @param expected_size - num of keys the index should hold without growing
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_name_index(NameIndex *index, int expected_size) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    int capacity = MIN_CAPACITY;
+    while (capacity < 2 * expected_size) {
+        capacity *= 2;
+    }
+    //an entry with a NULL value is an empty slot
+    index->entries = calloc((size_t) capacity, sizeof(*index->entries));
+    if (index->entries == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    index->capacity = capacity;
+    index->size = 0;
+    return OK;
+}
+
+/**
+ * frees the memory of the index. the keys and values are not freed.
+ * @param index - ptr to the index
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         OK: if everything went well
+ */
+Result reset_name_index(NameIndex *index) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->size = 0;
+    return OK;
+}
+
+/**
+ * adds a value of a key to the index, the other values of the key are kept.
+ * inserting right after a removal never grows the index, so it never fails.
+ * @param index - ptr to the index
+ * @param key - the key, which is not copied
+ * @param value - the value, must not be NULL
+ * @return NULL_PARAMETER: if the ptr to index, key or value are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result name_index_insert(NameIndex *index, const char *key, void *value) {
+    assert(index != NULL && key != NULL && value != NULL);
+    if (index == NULL || key == NULL || value == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (2 * (index->size + 1) > index->capacity) {
+        Result result = name_index_grow(index);
+        if (result != OK) {
+            return result;
+        }
+    }
+    unsigned int hash = hash_name(key);
+    int mask = index->capacity - 1;
+    int slot = (int) (hash & mask);
+    while (index->entries[slot].value != NULL) {
+        slot = (slot + 1) & mask;
+    }
+    index->entries[slot].key = key;
+    index->entries[slot].hash = hash;
+    index->entries[slot].value = value;
+    index->size++;
+    return OK;
+}
+
+/**
+ * finds the values of a key one at a time.
+ * @param index - ptr to the index
+ * @param key - the wanted key
+ * @param cursor - ptr to 0 to find the first value, it is advanced past the
+ *                 value found so the next call finds the next one
+ * @return the value, NULL if the key has no more values
+ */
+void *name_index_find(NameIndex *index, const char *key, int *cursor) {
+    assert(index != NULL && key != NULL && cursor != NULL);
+    unsigned int hash = hash_name(key);
+    int mask = index->capacity - 1;
+    //the cursor counts the slots already probed from the home slot
+    for (int slot = (int) ((hash + *cursor) & mask);
+         index->entries[slot].value != NULL; slot = (slot + 1) & mask) {
+        (*cursor)++;
+        if (index->entries[slot].hash == hash &&
+            strcmp(index->entries[slot].key, key) == 0) {
+            return index->entries[slot].value;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * removes a value of a key from the index, the entries after it in the same
+ * cluster are shifted back as in id_index_remove.
+ * @param index - ptr to the index
+ * @param key - the key
+ * @param value - the value to remove
+ * @return NULL_PARAMETER: if the ptr to index or key are NULL
+ *         ILLEGAL_PARAMETER: if the key doesn't have the value
+ *         OK: if everything went well
+ */
+Result name_index_remove(NameIndex *index, const char *key, void *value) {
+    assert(index != NULL && key != NULL);
+    if (index == NULL || key == NULL) {
+        return NULL_PARAMETER;
+    }
+    int mask = index->capacity - 1;
+    int hole = (int) (hash_name(key) & mask);
+    while (index->entries[hole].value != NULL &&
+           index->entries[hole].value != value) {
+        hole = (hole + 1) & mask;
+    }
+    if (index->entries[hole].value == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    int next = (hole + 1) & mask;
+    while (index->entries[next].value != NULL) {
+        int home = (int) (index->entries[next].hash & mask);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->entries[hole] = index->entries[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->entries[hole].value = NULL;
+    index->size--;
+    return OK;
+}
+
+/**
+ * hashes a name with FNV-1a.
+ * @param key - the name
+ * @return the hash of the name
+ */
+static unsigned int hash_name(const char *key) {
+    unsigned int hash = 2166136261u;
+    for (; *key != '\0'; ++key) {
+        hash ^= (unsigned char) *key;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * doubles the capacity of the index and moves all the entries, their hashes
+ * are kept so the names are not hashed again.
+ * @param index - ptr to the index
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result name_index_grow(NameIndex *index) {
+    NameIndex bigger;
+    Result result = init_name_index(&bigger, index->capacity);
+    if (result != OK) {
+        return result;
+    }
+    int mask = bigger.capacity - 1;
+    for (int i = 0; i < index->capacity; ++i) {
+        if (index->entries[i].value != NULL) {
+            int slot = (int) (index->entries[i].hash & mask);
+            while (bigger.entries[slot].value != NULL) {
+                slot = (slot + 1) & mask;
+            }
+            bigger.entries[slot] = index->entries[i];
+            bigger.size++;
+        }
+    }
+    free(index->entries);
+    *index = bigger;
+    return OK;
+}
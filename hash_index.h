@@ -0,0 +1,62 @@
+#ifndef HASH_INDEX_H_
+#define HASH_INDEX_H_
+
+#include "constants.h"
+
+/*
+ * an open addressing hash table (linear probing) mapping an int key to a ptr.
+ * the capacity is always a power of 2 and the table grows when it is more
+ * than half full, so every operation is O(1) on average.
+ */
+typedef struct SIdIndexEntry {
+    int key;
+    void *value;
+} IdIndexEntry;
+
+typedef struct SIdIndex {
+    IdIndexEntry *entries;
+    int capacity;
+    int size;
+} IdIndex;
+
+Result init_id_index(IdIndex *index, int expected_size);
+
+Result reset_id_index(IdIndex *index);
+
+Result id_index_insert(IdIndex *index, int key, void *value);
+
+void *id_index_find(IdIndex *index, int key);
+
+Result id_index_remove(IdIndex *index, int key);
+
+unsigned long long id_set_hash(int key);
+
+
+/*
+ * an open addressing hash table like IdIndex, mapping a string key to ptrs.
+ * a key may have a few values. the keys are not copied, so a key must be
+ * removed before its string is changed or freed.
+ */
+typedef struct SNameIndexEntry {
+    const char *key;
+    unsigned int hash;
+    void *value;
+} NameIndexEntry;
+
+typedef struct SNameIndex {
+    NameIndexEntry *entries;
+    int capacity;
+    int size;
+} NameIndex;
+
+Result init_name_index(NameIndex *index, int expected_size);
+
+Result reset_name_index(NameIndex *index);
+
+Result name_index_insert(NameIndex *index, const char *key, void *value);
+
+void *name_index_find(NameIndex *index, const char *key, int *cursor);
+
+Result name_index_remove(NameIndex *index, const char *key, void *value);
+
+#endif // HASH_INDEX_H_
@@ -3,24 +3,22 @@
 #include <string.h>
 
 char *flat_text(char **words, int n) {
-    char *result = NULL;
-    char *tmp_result = NULL;
-    int total_length = 0;
+    //the length is summed first so the result is allocated and copied once
+    size_t total_length = 0;
     for (int i = 0; i < n; ++i) {
-        int length = (int)strlen(words[i]);
-        total_length += length;
-        tmp_result = malloc((size_t) total_length + 1);
-        if (tmp_result == NULL) {
-            free(result);
-            return NULL;
-        }
-        if (result != NULL) {
-            strcpy(tmp_result, result);
-        }
-        strcpy(tmp_result + (total_length - length), words[i]);
-        free(result);
-        result = tmp_result;
+        total_length += strlen(words[i]);
     }
+    char *result = malloc(total_length + 1);
+    if (result == NULL) {
+        return NULL;
+    }
+    char *end = result;
+    for (int i = 0; i < n; ++i) {
+        size_t length = strlen(words[i]);
+        memcpy(end, words[i], length);
+        end += length;
+    }
+    *end = '\0';
     return result;
 }
 
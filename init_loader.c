@@ -0,0 +1,533 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+#ifndef ESCAPY_FIXED_CAPACITY
+#include <pthread.h>
+#endif
+
+#include "init_loader.h"
+#include "fixed_alloc.h"
+
+#define MAX_THREADS 64
+
+/*
+ * the share of one thread of a phase of the load. a chunk of the text for
+ * counting and parsing the lines, or a range of rooms for linking them.
+ */
+typedef struct SLoadTask
+{
+   InitFileLoad *load;
+   /* the line of the first challenge, where the first chunk begins */
+   char *body;
+   char *begin;
+   char *end;
+   /* the first line that starts in the chunk and its idx from the body */
+   char *first_start;
+   int first_line;
+   int num_lines;
+   int first_room;
+   int end_room;
+   IdIndex *challenges_index;
+   Result result;
+} LoadTask;
+
+static Result read_text(InitFileLoad *load, char *init_file, size_t *length);
+
+static char *parse_header(InitFileLoad *load);
+
+static int is_line_start(LoadTask *task, char *position);
+
+static int is_blank_line(char *line);
+
+static char *next_line(char *line);
+
+static char *terminate_token(char *line);
+
+static char *find_line(LoadTask *task, int line);
+
+static void *count_lines(void *argument);
+
+static void *parse_lines(void *argument);
+
+static Result parse_challenge(InitFileLoad *load, char *line, int idx);
+
+static Result parse_room(InitFileLoad *load, char *line, int idx);
+
+static void *link_rooms(void *argument);
+
+static Result run_tasks(LoadTask *tasks, int num_tasks,
+                        void *(*work)(void *));
+
+/**
+ * reads an init file and creates its challenges and rooms on a pool of
+ * threads, the rooms are created with empty activities until the load is
+ * linked. the fixed capacity build loads on a single thread, since its
+ * arena is not thread safe.
+ * @param load - ptr to the load to initialize
+ * @param init_file - the file with all the specifications
+ * @param num_threads - the num of threads to load with
+ * @return NULL_PARAMETER: if the ptr to load or init_file are NULL, or the
+ *                         file can't be opened
+ *         ILLEGAL_PARAMETER: if num_threads is less than 1 or the file is
+ *                            malformed
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result load_init_file(InitFileLoad *load, char *init_file, int num_threads) {
+    if (load == NULL || init_file == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (num_threads < 1) {
+        return ILLEGAL_PARAMETER;
+    }
+    memset(load, 0, sizeof(*load));
+#ifdef ESCAPY_FIXED_CAPACITY
+    num_threads = 1;
+#endif
+    load->num_threads = num_threads < MAX_THREADS ? num_threads : MAX_THREADS;
+    size_t length = 0;
+    Result result = read_text(load, init_file, &length);
+    if (result != OK) {
+        return result;
+    }
+    char *body = parse_header(load);
+    if (body == NULL) {
+        reset_init_file_load(load);
+        return load->system_name == NULL ? MEMORY_PROBLEM : ILLEGAL_PARAMETER;
+    }
+    //every chunk counts the lines that start in it
+    LoadTask tasks[MAX_THREADS];
+    size_t chunk = (size_t) (load->text + length - body) / load->num_threads;
+    for (int i = 0; i < load->num_threads; ++i) {
+        tasks[i].load = load;
+        tasks[i].body = body;
+        tasks[i].begin = body + i * chunk;
+        tasks[i].end = i == load->num_threads - 1 ? load->text + length :
+                       body + (i + 1) * chunk;
+    }
+    run_tasks(tasks, load->num_threads, count_lines);
+    int num_lines = 0;
+    for (int i = 0; i < load->num_threads; ++i) {
+        tasks[i].first_line = num_lines;
+        num_lines += tasks[i].num_lines;
+    }
+    //the line after the challenges holds the num of rooms
+    int rooms_line = load->num_challenges;
+    char *line = NULL;
+    for (int i = 0; i < load->num_threads && line == NULL; ++i) {
+        line = find_line(tasks + i, rooms_line);
+    }
+    if (line == NULL || sscanf(line, "%d", &load->num_rooms) != 1 ||
+        load->num_rooms < 0 || num_lines <= rooms_line + load->num_rooms) {
+        reset_init_file_load(load);
+        return ILLEGAL_PARAMETER;
+    }
+    load->challenges = calloc((size_t) load->num_challenges + 1,
+                              sizeof(*load->challenges));
+    load->rooms = calloc((size_t) load->num_rooms + 1, sizeof(*load->rooms));
+    load->room_challenge_ids = calloc((size_t) load->num_rooms + 1,
+                                      sizeof(*load->room_challenge_ids));
+    if (load->challenges == NULL || load->rooms == NULL ||
+        load->room_challenge_ids == NULL) {
+        reset_init_file_load(load);
+        return MEMORY_PROBLEM;
+    }
+    result = run_tasks(tasks, load->num_threads, parse_lines);
+    if (result != OK) {
+        reset_init_file_load(load);
+    }
+    return result;
+}
+
+/**
+ * links the activities of the loaded rooms to the challenges by id, the
+ * rooms are split between the threads and every thread only touches its
+ * own rooms. the challenges are then given their instances in order, on a
+ * single thread, as the instances of a challenge are shared by the rooms.
+ * @param load - ptr to the load
+ * @param challenges_index - the challenges of the load by id
+ * @return NULL_PARAMETER: if the ptr to load or challenges_index are NULL
+ *         OK: if everything went well
+ */
+Result link_loaded_rooms(InitFileLoad *load, IdIndex *challenges_index) {
+    if (load == NULL || challenges_index == NULL) {
+        return NULL_PARAMETER;
+    }
+    LoadTask tasks[MAX_THREADS];
+    int num_tasks = load->num_threads < load->num_rooms ? load->num_threads :
+                    load->num_rooms;
+    for (int i = 0; i < num_tasks; ++i) {
+        tasks[i].load = load;
+        tasks[i].challenges_index = challenges_index;
+        tasks[i].first_room = (int) ((long) load->num_rooms * i / num_tasks);
+        tasks[i].end_room = (int) ((long) load->num_rooms * (i + 1) /
+                                   num_tasks);
+    }
+    Result result = run_tasks(tasks, num_tasks, link_rooms);
+    if (result != OK) {
+        return result;
+    }
+    for (int i = 0; i < load->num_rooms; ++i) {
+        ChallengeRoom *room = load->rooms[i];
+        for (int j = 0; j < room->num_of_challenges; ++j) {
+            if (room->challenges[j]->challenge != NULL_LINK) {
+                link_challenge_instance(room->challenges[j]);
+            }
+        }
+    }
+    return OK;
+}
+
+/**
+ * frees the text of a load and the records that the system did not take
+ * over, a table that was taken over is set to NULL by the system.
+ * @param load - ptr to the load
+ */
+void reset_init_file_load(InitFileLoad *load) {
+    assert(load != NULL);
+    if (load->challenges != NULL) {
+        for (int i = 0; i < load->num_challenges; ++i) {
+            if (load->challenges[i] != NULL) {
+                reset_challenge(load->challenges[i]);
+                free(load->challenges[i]);
+            }
+        }
+        free(load->challenges);
+    }
+    if (load->rooms != NULL) {
+        for (int i = 0; i < load->num_rooms; ++i) {
+            if (load->rooms[i] != NULL) {
+                reset_room(load->rooms[i]);
+                free(load->rooms[i]);
+            }
+        }
+        free(load->rooms);
+    }
+    free(load->room_challenge_ids);
+    free(load->system_name);
+    free(load->text);
+    memset(load, 0, sizeof(*load));
+}
+
+/**
+ * reads the whole init file into the text of the load, which is terminated
+ * by '\0'.
+ * @param load - ptr to the load
+ * @param init_file - the file with all the specifications
+ * @param length - the ptr to the length of the text that needs to be updated
+ * @return NULL_PARAMETER: if the file can't be opened or read
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result read_text(InitFileLoad *load, char *init_file, size_t *length) {
+    FILE *input = fopen(init_file, "rb");
+    if (input == NULL) {
+        return NULL_PARAMETER;
+    }
+    long size = -1;
+    if (fseek(input, 0, SEEK_END) == 0) {
+        size = ftell(input);
+    }
+    if (size < 0 || fseek(input, 0, SEEK_SET) != 0) {
+        fclose(input);
+        return NULL_PARAMETER;
+    }
+    load->text = malloc((size_t) size + 1);
+    if (load->text == NULL) {
+        fclose(input);
+        return MEMORY_PROBLEM;
+    }
+    *length = fread(load->text, 1, (size_t) size, input);
+    load->text[*length] = '\0';
+    fclose(input);
+    return OK;
+}
+
+/**
+ * parses the name of the system and the num of challenges.
+ * @param load - ptr to the load
+ * @return the start of the line after the num of challenges, NULL if the
+ *         header is malformed or allocation problems have occurred, in
+ *         which case the name of the system is NULL
+ */
+static char *parse_header(InitFileLoad *load) {
+    char *name = load->text + strspn(load->text, " \t\r\n");
+    size_t name_length = strcspn(name, " \t\r\n");
+    char *cursor = name + name_length;
+    long num_challenges = strtol(cursor, &cursor, 10);
+    if (name_length == 0 || num_challenges < 0 || num_challenges > INT_MAX) {
+        return NULL;
+    }
+    load->system_name = malloc(name_length + 1);
+    if (load->system_name == NULL) {
+        return NULL;
+    }
+    memcpy(load->system_name, name, name_length);
+    load->system_name[name_length] = '\0';
+    load->num_challenges = (int) num_challenges;
+    cursor = strchr(cursor, '\n');
+    return cursor == NULL ? NULL : cursor + 1;
+}
+
+/**
+ * checks whether a line that is not blank starts at a position of the text.
+ * @param task - ptr to a task of the load
+ * @param position - the position
+ * @return 1 if a line that is not blank starts at the position, 0 otherwise
+ */
+static int is_line_start(LoadTask *task, char *position) {
+    return (position == task->body || position[-1] == '\n') &&
+           !is_blank_line(position);
+}
+
+/**
+ * checks whether a line holds only white spaces.
+ * @param line - the start of the line
+ * @return 1 if the line is blank, 0 otherwise
+ */
+static int is_blank_line(char *line) {
+    line += strspn(line, " \t\r");
+    return *line == '\n' || *line == '\0';
+}
+
+/**
+ * finds the next line that is not blank.
+ * @param line - the start of a line
+ * @return the start of the next line, NULL if there is none
+ */
+static char *next_line(char *line) {
+    char *end = strchr(line, '\n');
+    while (end != NULL && is_blank_line(end + 1)) {
+        end = strchr(end + 1, '\n');
+    }
+    return end == NULL ? NULL : end + 1;
+}
+
+/**
+ * terminates the token that starts a line by '\0', the line must go on
+ * after it.
+ * @param line - the line, starting with white spaces or the token
+ * @return the start of the token, the rest of the line starts after the
+ *         '\0'. NULL if the token ends the line
+ */
+static char *terminate_token(char *line) {
+    char *token = line + strspn(line, " \t\r");
+    char *token_end = token + strcspn(token, " \t\r\n");
+    if (*token_end == '\n' || *token_end == '\0') {
+        return NULL;
+    }
+    *token_end = '\0';
+    return token;
+}
+
+/**
+ * finds a line in the chunk of a task.
+ * @param task - ptr to the task of the chunk, whose lines were counted
+ * @param line - the idx of the line, from the first challenge
+ * @return the start of the line, NULL if it is not in the chunk
+ */
+static char *find_line(LoadTask *task, int line) {
+    if (line < task->first_line ||
+        line >= task->first_line + task->num_lines) {
+        return NULL;
+    }
+    int current = task->first_line;
+    for (char *position = task->begin; position < task->end; ++position) {
+        if (is_line_start(task, position)) {
+            if (current == line) {
+                return position;
+            }
+            current++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * counts the lines that start in the chunk of a task.
+ * @param argument - ptr to the task
+ * @return NULL
+ */
+static void *count_lines(void *argument) {
+    LoadTask *task = argument;
+    task->num_lines = 0;
+    task->first_start = NULL;
+    for (char *position = task->begin; position < task->end; ++position) {
+        if (is_line_start(task, position)) {
+            if (task->num_lines == 0) {
+                task->first_start = position;
+            }
+            task->num_lines++;
+        }
+    }
+    task->result = OK;
+    return NULL;
+}
+
+/**
+ * creates the challenges and rooms of the lines that start in the chunk of
+ * a task, the line of the num of rooms and the lines after the rooms are
+ * skipped. the tokens are terminated in place, so a task only reads past
+ * its last line start before the task of the next chunk writes to it.
+ * @param argument - ptr to the task
+ * @return NULL
+ */
+static void *parse_lines(void *argument) {
+    LoadTask *task = argument;
+    InitFileLoad *load = task->load;
+    char *position = task->first_start;
+    task->result = OK;
+    for (int i = 0; i < task->num_lines && task->result == OK; ++i) {
+        int line = task->first_line + i;
+        //the next line is found before the tokens of this one are cut
+        char *next = i + 1 < task->num_lines ? next_line(position) : NULL;
+        if (line < load->num_challenges) {
+            task->result = parse_challenge(load, position, line);
+        } else if (line > load->num_challenges &&
+                   line <= load->num_challenges + load->num_rooms) {
+            task->result = parse_room(load, position,
+                                      line - load->num_challenges - 1);
+        }
+        position = next;
+    }
+    return NULL;
+}
+
+/**
+ * creates a challenge from its line, "name id level".
+ * @param load - ptr to the load
+ * @param line - the start of the line
+ * @param idx - the idx of the challenge
+ * @return ILLEGAL_PARAMETER: if the line is malformed
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result parse_challenge(InitFileLoad *load, char *line, int idx) {
+    char *name = terminate_token(line);
+    if (name == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    char *cursor = name + strlen(name) + 1;
+    int id = (int) strtol(cursor, &cursor, 10);
+    int level = (int) strtol(cursor, &cursor, 10);
+    if (level < 1 || level > All_Levels) {
+        return ILLEGAL_PARAMETER;
+    }
+    Challenge *challenge = malloc(sizeof(*challenge));
+    if (challenge == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    Result result = init_challenge(challenge, id, name, (Level) level - 1);
+    if (result != OK) {
+        free(challenge);
+        return result;
+    }
+    load->challenges[idx] = challenge;
+    return OK;
+}
+
+/**
+ * creates a room from its line, "name num_challenges id...", the ids are
+ * read when the load is linked.
+ * @param load - ptr to the load
+ * @param line - the start of the line
+ * @param idx - the idx of the room
+ * @return ILLEGAL_PARAMETER: if the line is malformed or the room has no
+ *                            challenges
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result parse_room(InitFileLoad *load, char *line, int idx) {
+    char *name = terminate_token(line);
+    if (name == NULL) {
+        return ILLEGAL_PARAMETER;
+    }
+    char *cursor = name + strlen(name) + 1;
+    int num_challenges = (int) strtol(cursor, &cursor, 10);
+    if (num_challenges < 1) {
+        return ILLEGAL_PARAMETER;
+    }
+    ChallengeRoom *room = malloc(sizeof(*room));
+    if (room == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    Result result = init_room(room, name, num_challenges);
+    if (result != OK) {
+        free(room);
+        return result;
+    }
+    load->rooms[idx] = room;
+    load->room_challenge_ids[idx] = cursor;
+    return OK;
+}
+
+/**
+ * links the activities of the rooms of a task to their challenges and ranks
+ * their names, an id that is not in the index leaves its activity empty.
+ * @param argument - ptr to the task
+ * @return NULL
+ */
+static void *link_rooms(void *argument) {
+    LoadTask *task = argument;
+    InitFileLoad *load = task->load;
+    task->result = OK;
+    for (int i = task->first_room;
+         i < task->end_room && task->result == OK; ++i) {
+        ChallengeRoom *room = load->rooms[i];
+        char *cursor = load->room_challenge_ids[i];
+        for (int j = 0; j < room->num_of_challenges; ++j) {
+            int id = (int) strtol(cursor, &cursor, 10);
+            Challenge *challenge = id_index_find(task->challenges_index, id);
+            if (challenge != NULL) {
+                init_room_challenge_activity(room->challenges[j], challenge);
+            }
+        }
+        task->result = rank_room_activities(room);
+    }
+    return NULL;
+}
+
+/**
+ * runs a phase of the load, every task on its own thread. the first task
+ * runs on the calling thread, as does a task whose thread can't be started.
+ * @param tasks - the tasks
+ * @param num_tasks - the num of tasks
+ * @param work - the work of the phase
+ * @return the first result of a task that is not OK, OK otherwise
+ */
+static Result run_tasks(LoadTask *tasks, int num_tasks,
+                        void *(*work)(void *)) {
+#ifndef ESCAPY_FIXED_CAPACITY
+    pthread_t threads[MAX_THREADS];
+    int started[MAX_THREADS] = {0};
+    for (int i = 1; i < num_tasks; ++i) {
+        started[i] = pthread_create(threads + i, NULL, work, tasks + i) == 0;
+    }
+    if (num_tasks > 0) {
+        work(tasks);
+    }
+    for (int i = 1; i < num_tasks; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            work(tasks + i);
+        }
+    }
+#else
+    for (int i = 0; i < num_tasks; ++i) {
+        work(tasks + i);
+    }
+#endif
+    for (int i = 0; i < num_tasks; ++i) {
+        if (tasks[i].result != OK) {
+            return tasks[i].result;
+        }
+    }
+    return OK;
+}
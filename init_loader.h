@@ -0,0 +1,34 @@
+#ifndef INIT_LOADER_H_
+#define INIT_LOADER_H_
+
+#include "visitor_room.h"
+#include "hash_index.h"
+
+/*
+ * an init file that was parsed on a pool of threads, see load_init_file.
+ * the file is split into chunks at line boundaries and every challenge and
+ * room line is turned into a record by the thread of its chunk. the system
+ * takes over the tables and then links the rooms to the challenges with
+ * link_loaded_rooms, also on the pool.
+ */
+typedef struct SInitFileLoad
+{
+   char *text;
+   char *system_name;
+   Challenge **challenges;
+   int num_challenges;
+   ChallengeRoom **rooms;
+   int num_rooms;
+   /* where the challenge ids of each room start in the text */
+   char **room_challenge_ids;
+   int num_threads;
+} InitFileLoad;
+
+
+Result load_init_file(InitFileLoad *load, char *init_file, int num_threads);
+
+Result link_loaded_rooms(InitFileLoad *load, IdIndex *challenges_index);
+
+void reset_init_file_load(InitFileLoad *load);
+
+#endif // INIT_LOADER_H_
@@ -0,0 +1,132 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "journal.h"
+#include "fixed_alloc.h"
+
+#ifdef ESCAPY_FIXED_CAPACITY
+//the buffer comes out of the spare part of the arena
+#define JOURNAL_BUFFER_SIZE (4 * 1024)
+#else
+#define JOURNAL_BUFFER_SIZE (64 * 1024)
+#endif
+
+/**
+ * opens a journal for appending. anything after valid_length in the file is
+ * a record that was torn by a crash and is cut off.
+ * @param journal - ptr to the journal to initialize
+ * @param path - the path of the journal file, created if it does not exist
+ * @param valid_length - the num of bytes of complete records in the file
+ * @param records_per_commit - num of records made durable by each fsync
+ * @return NULL_PARAMETER: if the ptr to journal or path are NULL
+ *         ILLEGAL_PARAMETER: if records_per_commit is less than 1 or the file
+ *                            can't be opened
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result open_journal(Journal *journal, char *path, long valid_length,
+                    int records_per_commit) {
+    assert(journal != NULL && path != NULL);
+    if (journal == NULL || path == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (records_per_commit < 1) {
+        return ILLEGAL_PARAMETER;
+    }
+    journal->buffer = malloc(JOURNAL_BUFFER_SIZE);
+    if (journal->buffer == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    journal->file = fopen(path, "a");
+    if (journal->file == NULL ||
+        ftruncate(fileno(journal->file), (off_t) valid_length) != 0) {
+        if (journal->file != NULL) {
+            fclose(journal->file);
+        }
+        free(journal->buffer);
+        return ILLEGAL_PARAMETER;
+    }
+    setvbuf(journal->file, journal->buffer, _IOFBF, JOURNAL_BUFFER_SIZE);
+    journal->records_per_commit = records_per_commit;
+    journal->pending_records = 0;
+    journal->failed = 0;
+    return OK;
+}
+
+/**
+ * appends a record to the journal, the record is durable only after the
+ * commit of its group.
+ * @param journal - ptr to the journal
+ * @param format - printf like format of the record, must end with a newline
+ * @return NULL_PARAMETER: if the ptr to journal or format are NULL
+ *         MEMORY_PROBLEM: if writing to the file failed
+ *         OK: if everything went well
+ */
+Result journal_append(Journal *journal, const char *format, ...) {
+    assert(journal != NULL && format != NULL);
+    if (journal == NULL || format == NULL) {
+        return NULL_PARAMETER;
+    }
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vfprintf(journal->file, format, arguments);
+    va_end(arguments);
+    if (written < 0) {
+        journal->failed = 1;
+        return MEMORY_PROBLEM;
+    }
+    journal->pending_records++;
+    if (journal->pending_records >= journal->records_per_commit) {
+        return journal_commit(journal);
+    }
+    return OK;
+}
+
+/**
+ * writes all the pending records and waits until they are on disk.
+ * @param journal - ptr to the journal
+ * @return NULL_PARAMETER: if the ptr to journal is NULL
+ *         MEMORY_PROBLEM: if writing to the file failed, now or in an
+ *                         earlier append
+ *         OK: if everything went well
+ */
+Result journal_commit(Journal *journal) {
+    assert(journal != NULL);
+    if (journal == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (journal->pending_records > 0) {
+        if (fflush(journal->file) != 0 || fsync(fileno(journal->file)) != 0) {
+            journal->failed = 1;
+        }
+        journal->pending_records = 0;
+    }
+    return journal->failed ? MEMORY_PROBLEM : OK;
+}
+
+/**
+ * commits the pending records and closes the journal.
+ * @param journal - ptr to the journal
+ * @return NULL_PARAMETER: if the ptr to journal is NULL
+ *         MEMORY_PROBLEM: if writing to the file failed
+ *         OK: if everything went well
+ */
+Result close_journal(Journal *journal) {
+    assert(journal != NULL);
+    if (journal == NULL) {
+        return NULL_PARAMETER;
+    }
+    Result result = journal_commit(journal);
+    fclose(journal->file);
+    free(journal->buffer);
+    journal->file = NULL;
+    journal->buffer = NULL;
+    return result;
+}
@@ -0,0 +1,30 @@
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdio.h>
+
+#include "constants.h"
+
+/*
+ * an append only file of records. records are buffered in memory and made
+ * durable together, one fsync for every records_per_commit records.
+ */
+typedef struct SJournal
+{
+   FILE *file;
+   char *buffer;
+   int records_per_commit;
+   int pending_records;
+   int failed;
+} Journal;
+
+
+Result open_journal(Journal *journal, char *path, long valid_length, int records_per_commit);
+
+Result journal_append(Journal *journal, const char *format, ...);
+
+Result journal_commit(Journal *journal);
+
+Result close_journal(Journal *journal);
+
+#endif // JOURNAL_H_
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <assert.h>
+
+#include "prefix_index.h"
+#include "fixed_alloc.h"
+
+static int lower_bound(PrefixIndex *index, const char *name);
+
+static int compare_entries(const void *first, const void *second);
+
+/**
+ * initializes an empty index.
+ * @param index - ptr to the index to initialize
+ * @param expected_size - num of names the index should hold without growing
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_prefix_index(PrefixIndex *index, int expected_size) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    index->capacity = expected_size > 0 ? expected_size : 1;
+    index->entries = malloc(index->capacity * sizeof(*index->entries));
+    if (index->entries == NULL) {
+        index->capacity = 0;
+        return MEMORY_PROBLEM;
+    }
+    index->size = 0;
+    return OK;
+}
+
+/**
+ * frees the memory of the index. the names and values are not freed.
+ * @param index - ptr to the index
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         OK: if everything went well
+ */
+Result reset_prefix_index(PrefixIndex *index) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(index->entries);
+    index->entries = NULL;
+    index->size = 0;
+    index->capacity = 0;
+    return OK;
+}
+
+/**
+ * makes room in the index for a num of names, doubling its capacity until
+ * they fit, so inserting up to that num never fails.
+ * @param index - ptr to the index
+ * @param size - the num of names the index should have room for
+ * @return NULL_PARAMETER: if the ptr to index is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result prefix_index_reserve(PrefixIndex *index, int size) {
+    assert(index != NULL);
+    if (index == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (size <= index->capacity) {
+        return OK;
+    }
+    int capacity = index->capacity > 0 ? index->capacity : 1;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    PrefixIndexEntry *entries = realloc(index->entries,
+                                        capacity * sizeof(*entries));
+    if (entries == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    index->entries = entries;
+    index->capacity = capacity;
+    return OK;
+}
+
+/**
+ * inserts a name to its place in the index, after the values the name
+ * already has. this is O(n) as the names after it are moved.
+ * @param index - ptr to the index
+ * @param name - the name, which is not copied
+ * @param value - the value
+ * @return NULL_PARAMETER: if the ptr to index or name are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result prefix_index_insert(PrefixIndex *index, const char *name,
+                           void *value) {
+    assert(index != NULL && name != NULL);
+    if (index == NULL || name == NULL) {
+        return NULL_PARAMETER;
+    }
+    Result result = prefix_index_reserve(index, index->size + 1);
+    if (result != OK) {
+        return result;
+    }
+    int position = lower_bound(index, name);
+    while (position < index->size &&
+           strcmp(index->entries[position].name, name) == 0) {
+        position++;
+    }
+    memmove(index->entries + position + 1, index->entries + position,
+            (index->size - position) * sizeof(*index->entries));
+    index->entries[position].name = name;
+    index->entries[position].value = value;
+    index->size++;
+    return OK;
+}
+
+/**
+ * removes a value of a name from the index, in O(n).
+ * @param index - ptr to the index
+ * @param name - the name
+ * @param value - the value to remove
+ * @return NULL_PARAMETER: if the ptr to index or name are NULL
+ *         ILLEGAL_PARAMETER: if the name doesn't have the value
+ *         OK: if everything went well
+ */
+Result prefix_index_remove(PrefixIndex *index, const char *name,
+                           void *value) {
+    assert(index != NULL && name != NULL);
+    if (index == NULL || name == NULL) {
+        return NULL_PARAMETER;
+    }
+    for (int position = lower_bound(index, name);
+         position < index->size &&
+         strcmp(index->entries[position].name, name) == 0; ++position) {
+        if (index->entries[position].value == value) {
+            memmove(index->entries + position, index->entries + position + 1,
+                    (index->size - position - 1) * sizeof(*index->entries));
+            index->size--;
+            return OK;
+        }
+    }
+    return ILLEGAL_PARAMETER;
+}
+
+/**
+ * adds a name at the end of the index without keeping the order, for
+ * building an index in bulk. the index must have room for it and must be
+ * sorted with prefix_index_sort before it is searched.
+ * @param index - ptr to the index
+ * @param name - the name, which is not copied
+ * @param value - the value
+ */
+void prefix_index_append(PrefixIndex *index, const char *name, void *value) {
+    assert(index != NULL && name != NULL && index->size < index->capacity);
+    index->entries[index->size].name = name;
+    index->entries[index->size].value = value;
+    index->size++;
+}
+
+/**
+ * sorts the names of an index built by prefix_index_append, in O(n log n).
+ * @param index - ptr to the index
+ */
+void prefix_index_sort(PrefixIndex *index) {
+    assert(index != NULL);
+    qsort(index->entries, (size_t) index->size, sizeof(*index->entries),
+          compare_entries);
+}
+
+/**
+ * initializes an iterator over the values of the names with a prefix, the
+ * first of them is found in O(log n).
+ * @param iterator - ptr to the iterator to initialize
+ * @param index - ptr to the index
+ * @param prefix - the prefix, "" walks over all the names
+ * @return NULL_PARAMETER: if the ptr to iterator, index or prefix are NULL
+ *         OK: if everything went well
+ */
+Result init_prefix_iterator(PrefixIterator *iterator, PrefixIndex *index,
+                            const char *prefix) {
+    assert(iterator != NULL && index != NULL && prefix != NULL);
+    if (iterator == NULL || index == NULL || prefix == NULL) {
+        return NULL_PARAMETER;
+    }
+    iterator->index = index;
+    iterator->prefix = prefix;
+    iterator->prefix_length = strlen(prefix);
+    iterator->position = lower_bound(index, prefix);
+    return OK;
+}
+
+/**
+ * returns the value of the next name with the prefix.
+ * @param iterator - ptr to the iterator
+ * @return the value, NULL if there are no more names with the prefix
+ */
+void *prefix_iterator_next(PrefixIterator *iterator) {
+    assert(iterator != NULL);
+    PrefixIndex *index = iterator->index;
+    if (iterator->position >= index->size ||
+        strncmp(index->entries[iterator->position].name, iterator->prefix,
+                iterator->prefix_length) != 0) {
+        return NULL;
+    }
+    return index->entries[iterator->position++].value;
+}
+
+/**
+ * finds the first name that is not smaller than a given one.
+ * @param index - ptr to the index
+ * @param name - the name
+ * @return the position of the name, size if all the names are smaller
+ */
+static int lower_bound(PrefixIndex *index, const char *name) {
+    int low = 0, high = index->size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (strcmp(index->entries[middle].name, name) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * compares two entries by name, for qsort.
+ * @param first - ptr to the first entry
+ * @param second - ptr to the second entry
+ * @return negative, 0 or positive like strcmp
+ */
+static int compare_entries(const void *first, const void *second) {
+    const PrefixIndexEntry *first_entry = first;
+    const PrefixIndexEntry *second_entry = second;
+    return strcmp(first_entry->name, second_entry->name);
+}
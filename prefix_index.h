@@ -0,0 +1,55 @@
+#ifndef PREFIX_INDEX_H_
+#define PREFIX_INDEX_H_
+
+#include <stddef.h>
+
+#include "constants.h"
+
+/*
+ * a table of names sorted by strcmp, mapping each name to a ptr. the names
+ * with a prefix are next to each other, so they are found by a binary search
+ * for the prefix and walked in O(results). a name may have a few values.
+ * the names are not copied, so a name must be removed before its string is
+ * changed or freed.
+ */
+typedef struct SPrefixIndexEntry {
+    const char *name;
+    void *value;
+} PrefixIndexEntry;
+
+typedef struct SPrefixIndex {
+    PrefixIndexEntry *entries;
+    int size;
+    int capacity;
+} PrefixIndex;
+
+/*
+ * walks over the values of the names with a prefix, in name order. the
+ * prefix is not copied and the index must not change during the walk.
+ */
+typedef struct SPrefixIterator {
+    PrefixIndex *index;
+    const char *prefix;
+    size_t prefix_length;
+    int position;
+} PrefixIterator;
+
+Result init_prefix_index(PrefixIndex *index, int expected_size);
+
+Result reset_prefix_index(PrefixIndex *index);
+
+Result prefix_index_reserve(PrefixIndex *index, int size);
+
+Result prefix_index_insert(PrefixIndex *index, const char *name, void *value);
+
+Result prefix_index_remove(PrefixIndex *index, const char *name, void *value);
+
+void prefix_index_append(PrefixIndex *index, const char *name, void *value);
+
+void prefix_index_sort(PrefixIndex *index);
+
+Result init_prefix_iterator(PrefixIterator *iterator, PrefixIndex *index, const char *prefix);
+
+void *prefix_iterator_next(PrefixIterator *iterator);
+
+#endif // PREFIX_INDEX_H_
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "rate_window.h"
+#include "fixed_alloc.h"
+
+#define UNDEFINED -1
+
+/**
+ * initializes a window without events.
+ * @param window - ptr to the window to initialize
+ */
+void init_rate_window(RateWindow *window) {
+    assert(window != NULL);
+    window->last_bucket = UNDEFINED;
+    window->total = 0;
+}
+
+/**
+ * counts an event at a time. the buckets skipped since the last event are
+ * started empty, at most once each, so this is O(1) amortized and never more
+ * than O(buckets).
+ * @param window - ptr to the window
+ * @param time - the time of the event, not before the last event
+ */
+void rate_window_record(RateWindow *window, int time) {
+    assert(window != NULL && time >= 0);
+    int bucket = time / ESCAPY_RATE_BUCKET_WIDTH;
+    if (bucket > window->last_bucket) {
+        int first = window->last_bucket + 1;
+        if (first < bucket - ESCAPY_RATE_BUCKETS + 1) {
+            first = bucket - ESCAPY_RATE_BUCKETS + 1;
+        }
+        for (int i = first; i <= bucket; ++i) {
+            window->before[i % ESCAPY_RATE_BUCKETS] = window->total;
+        }
+        window->last_bucket = bucket;
+    }
+    window->total++;
+}
+
+/**
+ * counts the events of the last span time units up to a time, in O(1). the
+ * span is rounded to whole buckets.
+ * @param window - ptr to the window
+ * @param time - the current time, not before the last event
+ * @param span - the num of time units, from 1 to RATE_WINDOW_SPAN
+ * @return the num of events with a time in (time - span, time]
+ */
+int rate_window_count(RateWindow *window, int time, int span) {
+    assert(window != NULL && span > 0 && span <= RATE_WINDOW_SPAN);
+    int start = time - span + 1;
+    if (start < 0) {
+        return window->total;
+    }
+    int first = start / ESCAPY_RATE_BUCKET_WIDTH;
+    if (first > window->last_bucket) {
+        return 0;
+    }
+    assert(first > window->last_bucket - ESCAPY_RATE_BUCKETS);
+    return window->total - window->before[first % ESCAPY_RATE_BUCKETS];
+}
+
+/**
+ * initializes a table that is not started.
+ * @param table - ptr to the table to initialize
+ */
+void init_rate_table(RateTable *table) {
+    assert(table != NULL);
+    table->windows = NULL;
+    table->size = 0;
+    table->capacity = 0;
+}
+
+/**
+ * frees the windows of a table, which is no longer started.
+ * @param table - ptr to the table
+ * @return NULL_PARAMETER: if the ptr to table is NULL
+ *         OK: if everything went well
+ */
+Result reset_rate_table(RateTable *table) {
+    assert(table != NULL);
+    if (table == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(table->windows);
+    init_rate_table(table);
+    return OK;
+}
+
+/**
+ * starts counting the events of the records of a table, with empty windows
+ * for each of them. a table that was started already is left as is.
+ * @param table - ptr to the table
+ * @param size - the num of records in the table of the system
+ * @return NULL_PARAMETER: if the ptr to table is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result rate_table_start(RateTable *table, int size) {
+    assert(table != NULL && size >= 0);
+    if (table == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (table->windows != NULL) {
+        return OK;
+    }
+    int capacity = size > 0 ? size : 1;
+    table->windows = malloc(capacity * sizeof(*table->windows));
+    if (table->windows == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    table->capacity = capacity;
+    table->size = 0;
+    while (table->size < size) {
+        rate_table_append(table);
+    }
+    return OK;
+}
+
+/**
+ * makes room in a started table for a num of records, the capacity doubles
+ * when it grows. a table that is not started needs no room.
+ * @param table - ptr to the table
+ * @param size - the wanted num of records
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result rate_table_reserve(RateTable *table, int size) {
+    assert(table != NULL);
+    if (table->windows == NULL || size <= table->capacity) {
+        return OK;
+    }
+    int capacity = 2 * table->capacity > size ? 2 * table->capacity : size;
+    RateWindows *windows = realloc(table->windows,
+                                   capacity * sizeof(*windows));
+    if (windows == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    table->windows = windows;
+    table->capacity = capacity;
+    return OK;
+}
+
+/**
+ * adds empty windows for a record appended to the table of the system,
+ * there must be room for them.
+ * @param table - ptr to the table
+ */
+void rate_table_append(RateTable *table) {
+    assert(table != NULL);
+    if (table->windows == NULL) {
+        return;
+    }
+    assert(table->size < table->capacity);
+    init_rate_window(&table->windows[table->size].arrivals);
+    init_rate_window(&table->windows[table->size].completions);
+    table->size++;
+}
+
+/**
+ * removes the windows of a record removed from the table of the system, the
+ * windows of the last record take their place like the last record does.
+ * @param table - ptr to the table
+ * @param idx - the idx of the record
+ */
+void rate_table_remove(RateTable *table, int idx) {
+    assert(table != NULL);
+    if (table->windows == NULL) {
+        return;
+    }
+    assert(idx >= 0 && idx < table->size);
+    table->windows[idx] = table->windows[--table->size];
+}
+
+/**
+ * returns the windows of a record.
+ * @param table - ptr to the table
+ * @param idx - the idx of the record
+ * @return ptr to the windows, NULL if the table is not started
+ */
+RateWindows *rate_table_at(RateTable *table, int idx) {
+    assert(table != NULL);
+    if (table->windows == NULL) {
+        return NULL;
+    }
+    assert(idx >= 0 && idx < table->size);
+    return table->windows + idx;
+}
@@ -0,0 +1,75 @@
+#ifndef RATE_WINDOW_H_
+#define RATE_WINDOW_H_
+
+#include "constants.h"
+
+/* the num of buckets of a window and the time units each bucket covers,
+   a window counts the events of the last buckets * width time units */
+#ifndef ESCAPY_RATE_BUCKETS
+#define ESCAPY_RATE_BUCKETS 60
+#endif
+
+#ifndef ESCAPY_RATE_BUCKET_WIDTH
+#define ESCAPY_RATE_BUCKET_WIDTH 1
+#endif
+
+#define RATE_WINDOW_SPAN (ESCAPY_RATE_BUCKETS * ESCAPY_RATE_BUCKET_WIDTH)
+
+/*
+ * a ring of time buckets counting events, such as arrivals, of the recent
+ * past. each bucket holds the num of events before it, so the events of any
+ * suffix of the ring are counted in O(1). the times of the events must not
+ * go back, like the times known to the system.
+ */
+typedef struct SRateWindow
+{
+   int last_bucket;
+   int total;
+   int before[ESCAPY_RATE_BUCKETS];
+} RateWindow;
+
+
+/*
+ * the windows of the visits that started and that were completed recently
+ */
+typedef struct SRateWindows
+{
+   RateWindow arrivals;
+   RateWindow completions;
+} RateWindows;
+
+
+/*
+ * the windows of the records of a table of the system, such as its
+ * challenges, by the idx of the record in the table. nothing is allocated
+ * and no events are counted until the table is started.
+ */
+typedef struct SRateTable
+{
+   RateWindows *windows;
+   int size;
+   int capacity;
+} RateTable;
+
+
+void init_rate_window(RateWindow *window);
+
+void rate_window_record(RateWindow *window, int time);
+
+int rate_window_count(RateWindow *window, int time, int span);
+
+void init_rate_table(RateTable *table);
+
+Result reset_rate_table(RateTable *table);
+
+Result rate_table_start(RateTable *table, int size);
+
+Result rate_table_reserve(RateTable *table, int size);
+
+void rate_table_append(RateTable *table);
+
+void rate_table_remove(RateTable *table, int idx);
+
+RateWindows *rate_table_at(RateTable *table, int idx);
+
+#endif // RATE_WINDOW_H_
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "report_writer.h"
+
+static void append(ReportWriter *writer, const char *text, size_t length);
+
+static void append_text(ReportWriter *writer, const char *text);
+
+static void begin_field(ReportWriter *writer);
+
+static void append_csv_string(ReportWriter *writer, const char *value);
+
+static void append_json_string(ReportWriter *writer, const char *value);
+
+static void flush_report(ReportWriter *writer);
+
+/**
+ * initializes a writer of a report to a file.
+ * @param writer - ptr to the writer to initialize
+ * @param output - the file to write to
+ * @param format - the format of the report
+ * @return NULL_PARAMETER: if the ptr to writer or output are NULL
+ *         ILLEGAL_PARAMETER: if the format is not a known one
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_report_writer(ReportWriter *writer, FILE *output,
+                          ReportFormat format) {
+    if (writer == NULL || output == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (format != CSV_REPORT && format != JSON_REPORT) {
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = init_string_builder(&writer->text,
+                                        2 * REPORT_CHUNK_SIZE);
+    if (result != OK) {
+        return result;
+    }
+    writer->output = output;
+    writer->format = format;
+    writer->fields = NULL;
+    writer->num_fields = 0;
+    writer->single = 0;
+    writer->num_sections = 0;
+    writer->num_records = 0;
+    writer->field = 0;
+    writer->result = OK;
+    if (format == JSON_REPORT) {
+        append_text(writer, "{");
+    }
+    return OK;
+}
+
+/**
+ * starts a section of the report.
+ * @param writer - ptr to the writer
+ * @param name - the name of the section, used as the JSON member
+ * @param fields - the names of the fields of the records, in their order
+ * @param num_fields - the num of fields
+ * @param single - 1 if the section has exactly one record, 0 otherwise
+ */
+void report_begin_section(ReportWriter *writer, const char *name,
+                          const char *const *fields, int num_fields,
+                          int single) {
+    assert(writer != NULL && name != NULL && fields != NULL);
+    writer->fields = fields;
+    writer->num_fields = num_fields;
+    writer->single = single;
+    writer->num_records = 0;
+    if (writer->format == CSV_REPORT) {
+        if (writer->num_sections > 0) {
+            append_text(writer, "\n");
+        }
+        for (int i = 0; i < num_fields; ++i) {
+            if (i > 0) {
+                append_text(writer, ",");
+            }
+            append_csv_string(writer, fields[i]);
+        }
+        append_text(writer, "\n");
+    } else {
+        append_text(writer, writer->num_sections > 0 ? ",\n" : "\n");
+        append_json_string(writer, name);
+        append_text(writer, single ? ":" : ":[");
+    }
+    writer->num_sections++;
+}
+
+/**
+ * starts a record of the current section, its fields follow in order.
+ * @param writer - ptr to the writer
+ */
+void report_begin_record(ReportWriter *writer) {
+    assert(writer != NULL && writer->fields != NULL);
+    assert(!writer->single || writer->num_records == 0);
+    writer->field = 0;
+    if (writer->format == JSON_REPORT) {
+        if (writer->single) {
+            append_text(writer, "{");
+        } else {
+            append_text(writer, writer->num_records > 0 ? ",\n{" : "\n{");
+        }
+    }
+}
+
+/**
+ * writes the next field of the record as a string, quoted as the format
+ * needs it.
+ * @param writer - ptr to the writer
+ * @param value - the string
+ */
+void report_string_field(ReportWriter *writer, const char *value) {
+    assert(value != NULL);
+    begin_field(writer);
+    if (writer->format == CSV_REPORT) {
+        append_csv_string(writer, value);
+    } else {
+        append_json_string(writer, value);
+    }
+}
+
+/**
+ * writes the next field of the record as a num.
+ * @param writer - ptr to the writer
+ * @param value - the num
+ */
+void report_int_field(ReportWriter *writer, long long value) {
+    begin_field(writer);
+    if (writer->result == OK) {
+        writer->result = string_builder_append_int(&writer->text, value);
+    }
+}
+
+/**
+ * ends the record, the report is written out once a chunk of it is ready.
+ * @param writer - ptr to the writer
+ */
+void report_end_record(ReportWriter *writer) {
+    assert(writer != NULL && writer->field == writer->num_fields);
+    append_text(writer, writer->format == CSV_REPORT ? "\n" : "}");
+    writer->num_records++;
+    if (writer->text.length >= REPORT_CHUNK_SIZE) {
+        flush_report(writer);
+    }
+}
+
+/**
+ * ends the current section.
+ * @param writer - ptr to the writer
+ */
+void report_end_section(ReportWriter *writer) {
+    assert(writer != NULL && writer->fields != NULL);
+    if (writer->format == JSON_REPORT && !writer->single) {
+        append_text(writer, writer->num_records > 0 ? "\n]" : "]");
+    }
+    writer->fields = NULL;
+}
+
+/**
+ * ends the report, writes out what is left of it and frees the memory of
+ * the writer. the file is flushed but not closed.
+ * @param writer - ptr to the writer
+ * @return MEMORY_PROBLEM: if allocation problems have occurred or writing
+ *                         to the file failed
+ *         OK: if everything went well
+ */
+Result finish_report_writer(ReportWriter *writer) {
+    assert(writer != NULL && writer->fields == NULL);
+    if (writer->format == JSON_REPORT) {
+        append_text(writer, "\n}\n");
+    }
+    flush_report(writer);
+    if (writer->result == OK && fflush(writer->output) != 0) {
+        writer->result = MEMORY_PROBLEM;
+    }
+    reset_string_builder(&writer->text);
+    return writer->result;
+}
+
+/**
+ * appends bytes to the report, unless it failed.
+ * @param writer - ptr to the writer
+ * @param text - the bytes
+ * @param length - the num of bytes
+ */
+static void append(ReportWriter *writer, const char *text, size_t length) {
+    if (writer->result == OK) {
+        writer->result = string_builder_append(&writer->text, text, length);
+    }
+}
+
+/**
+ * appends a terminated string to the report as is.
+ * @param writer - ptr to the writer
+ * @param text - the string
+ */
+static void append_text(ReportWriter *writer, const char *text) {
+    append(writer, text, strlen(text));
+}
+
+/**
+ * writes what comes before the next field of a record.
+ * @param writer - ptr to the writer
+ */
+static void begin_field(ReportWriter *writer) {
+    assert(writer != NULL && writer->field < writer->num_fields);
+    if (writer->field > 0) {
+        append_text(writer, ",");
+    }
+    if (writer->format == JSON_REPORT) {
+        append_json_string(writer, writer->fields[writer->field]);
+        append_text(writer, ":");
+    }
+    writer->field++;
+}
+
+/**
+ * appends a CSV field, quoted with its quotes doubled if it has a comma,
+ * a quote or a line break.
+ * @param writer - ptr to the writer
+ * @param value - the string
+ */
+static void append_csv_string(ReportWriter *writer, const char *value) {
+    if (strpbrk(value, ",\"\r\n") == NULL) {
+        append_text(writer, value);
+        return;
+    }
+    append_text(writer, "\"");
+    for (const char *quote = strchr(value, '"'); quote != NULL;
+         quote = strchr(value, '"')) {
+        append(writer, value, (size_t) (quote - value) + 1);
+        append_text(writer, "\"");
+        value = quote + 1;
+    }
+    append_text(writer, value);
+    append_text(writer, "\"");
+}
+
+/**
+ * appends a JSON string, escaping quotes, backslashes and control chars.
+ * @param writer - ptr to the writer
+ * @param value - the string
+ */
+static void append_json_string(ReportWriter *writer, const char *value) {
+    static const char hex[] = "0123456789abcdef";
+    append_text(writer, "\"");
+    const char *start = value;
+    for (; *value != '\0'; ++value) {
+        unsigned char c = (unsigned char) *value;
+        if (c != '"' && c != '\\' && c >= 0x20) {
+            continue;
+        }
+        append(writer, start, (size_t) (value - start));
+        if (c == '"' || c == '\\') {
+            char escaped[] = {'\\', (char) c};
+            append(writer, escaped, sizeof(escaped));
+        } else {
+            char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+            append(writer, escaped, sizeof(escaped));
+        }
+        start = value + 1;
+    }
+    append(writer, start, (size_t) (value - start));
+    append_text(writer, "\"");
+}
+
+/**
+ * writes out the report gathered so far and clears the builder for reuse.
+ * @param writer - ptr to the writer
+ */
+static void flush_report(ReportWriter *writer) {
+    if (writer->result != OK || writer->text.length == 0) {
+        return;
+    }
+    if (fwrite(writer->text.text, 1, writer->text.length, writer->output) !=
+        writer->text.length) {
+        writer->result = MEMORY_PROBLEM;
+    }
+    string_builder_clear(&writer->text);
+}
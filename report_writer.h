@@ -0,0 +1,55 @@
+#ifndef REPORT_WRITER_H_
+#define REPORT_WRITER_H_
+
+#include <stdio.h>
+
+#include "string_builder.h"
+
+typedef enum EReportFormat {CSV_REPORT, JSON_REPORT} ReportFormat;
+
+/* the bytes a report gathers before it writes them out, a record is always
+   much shorter */
+#define REPORT_CHUNK_SIZE 4096
+
+/*
+ * writes a report of sections of records as CSV or JSON to a file. the
+ * records are formatted into a single builder that is written out once it
+ * holds a chunk and then reused, so a record takes no allocation of its
+ * own. as CSV each section is a header line with the names of its fields
+ * and a line for each record, sections are separated by an empty line. as
+ * JSON the report is an object with a member for each section, an object
+ * for a single record section and an array of objects for the others.
+ * a failure is kept and every later call does nothing.
+ */
+typedef struct SReportWriter {
+    StringBuilder text;
+    FILE *output;
+    ReportFormat format;
+    /* the names of the fields of the section being written */
+    const char *const *fields;
+    int num_fields;
+    int single;
+    int num_sections;
+    int num_records;
+    /* the next field of the record being written */
+    int field;
+    Result result;
+} ReportWriter;
+
+Result init_report_writer(ReportWriter *writer, FILE *output, ReportFormat format);
+
+void report_begin_section(ReportWriter *writer, const char *name, const char *const *fields, int num_fields, int single);
+
+void report_begin_record(ReportWriter *writer);
+
+void report_string_field(ReportWriter *writer, const char *value);
+
+void report_int_field(ReportWriter *writer, long long value);
+
+void report_end_record(ReportWriter *writer);
+
+void report_end_section(ReportWriter *writer);
+
+Result finish_report_writer(ReportWriter *writer);
+
+#endif // REPORT_WRITER_H_
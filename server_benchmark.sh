@@ -0,0 +1,28 @@
+#!/bin/sh
+# measures the throughput of the challenge server with the load client.
+# a fresh server is started on test_1.txt and every pipeline depth sends
+# num_requests arrivals to room_4 and their quits, each run continues the
+# times of the run before it so all the requests are accepted.
+# usage: server_benchmark.sh [build_dir] [num_requests] [depths...]
+# the defaults are _gate_build, 2000000 and the depths 2 32 128 512, the
+# requests/s of the server are reported at depth 128.
+set -e
+build_dir=${1:-_gate_build}
+num_requests=${2:-2000000}
+[ $# -gt 2 ] && shift 2 || set -- 2 32 128 512
+socket_path=${TMPDIR:-/tmp}/escapy_benchmark.sock
+
+"$build_dir/EscapyServer" test_1.txt "$socket_path" &
+server=$!
+trap 'kill $server 2>/dev/null; wait $server 2>/dev/null' EXIT
+while [ ! -S "$socket_path" ]; do
+    sleep 0.1
+done
+
+time=0
+for depth in "$@"; do
+    result=$("$build_dir/EscapyLoadClient" "$socket_path" room_4 \
+             "$num_requests" "$depth" "$time")
+    echo "depth $depth: $result"
+    time=${result##* }
+done
@@ -0,0 +1,265 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "server_connection.h"
+#include "server_protocol.h"
+
+#define INITIAL_BUFFER_SIZE (64 * 1024)
+
+static int reserve(unsigned char **buffer, size_t *capacity, size_t needed);
+
+static size_t process_frames(ChallengeRoomSystem *sys,
+                             ServerConnection *connection);
+
+static size_t handle_request(ChallengeRoomSystem *sys,
+                             const unsigned char *body,
+                             const unsigned char *end, unsigned char *reply);
+
+/**
+ * initializes a connection of a socket, its buffers are allocated by the
+ * first read.
+ * @param connection - ptr to the connection
+ * @param fd - the socket, non blocking
+ */
+void init_server_connection(ServerConnection *connection, int fd) {
+    assert(connection != NULL);
+    connection->fd = fd;
+    connection->input = NULL;
+    connection->input_size = 0;
+    connection->input_capacity = 0;
+    connection->output = NULL;
+    connection->output_start = 0;
+    connection->output_end = 0;
+    connection->output_capacity = 0;
+}
+
+/**
+ * frees the buffers of a connection, the socket is left to the caller.
+ * @param connection - ptr to the connection
+ */
+void reset_server_connection(ServerConnection *connection) {
+    assert(connection != NULL);
+    free(connection->input);
+    free(connection->output);
+    init_server_connection(connection, connection->fd);
+}
+
+/**
+ * reads everything the client sent and answers all the complete requests,
+ * a frame that is split over reads is answered once it is whole.
+ * @param sys - ptr to the system
+ * @param connection - ptr to the connection
+ * @return 1 if the connection is still open, 0 if it should be closed
+ */
+int server_connection_read(ChallengeRoomSystem *sys,
+                           ServerConnection *connection) {
+    assert(sys != NULL && connection != NULL);
+    while (1) {
+        if (!reserve(&connection->input, &connection->input_capacity,
+                     connection->input_size + MAX_FRAME_SIZE)) {
+            return 0;
+        }
+        ssize_t received = read(connection->fd,
+                                connection->input + connection->input_size,
+                                connection->input_capacity -
+                                connection->input_size);
+        if (received == 0) {
+            return 0;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return 0;
+            }
+            break;
+        }
+        connection->input_size += (size_t) received;
+        size_t used = process_frames(sys, connection);
+        if (used == (size_t) -1) {
+            return 0;
+        }
+        memmove(connection->input, connection->input + used,
+                connection->input_size - used);
+        connection->input_size -= used;
+    }
+    return 1;
+}
+
+/**
+ * writes as much of the pending replies as the socket takes, the rest stay
+ * pending until the socket is writable again.
+ * @param connection - ptr to the connection
+ * @return 1 if the connection is still open, 0 if it should be closed
+ */
+int server_connection_write(ServerConnection *connection) {
+    assert(connection != NULL);
+    while (connection->output_start < connection->output_end) {
+        ssize_t sent = write(connection->fd,
+                             connection->output + connection->output_start,
+                             connection->output_end -
+                             connection->output_start);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return 0;
+            }
+            break;
+        }
+        connection->output_start += (size_t) sent;
+    }
+    if (connection->output_start == connection->output_end) {
+        connection->output_start = connection->output_end = 0;
+    }
+    return 1;
+}
+
+/**
+ * tells whether a connection has replies the socket did not take yet.
+ * @param connection - ptr to the connection
+ * @return 1 if replies are pending, 0 otherwise
+ */
+int server_connection_pending(ServerConnection *connection) {
+    assert(connection != NULL);
+    return connection->output_start < connection->output_end;
+}
+
+/**
+ * makes sure a buffer can hold a given num of bytes, growing it by doubling.
+ * @param buffer - ptr to the buffer
+ * @param capacity - ptr to the capacity of the buffer
+ * @param needed - the num of bytes the buffer should hold
+ * @return 1 if the buffer is big enough, 0 if allocation problems occurred
+ */
+static int reserve(unsigned char **buffer, size_t *capacity, size_t needed) {
+    if (needed <= *capacity) {
+        return 1;
+    }
+    size_t new_capacity = *capacity == 0 ? INITIAL_BUFFER_SIZE : *capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    unsigned char *new_buffer = realloc(*buffer, new_capacity);
+    if (new_buffer == NULL) {
+        return 0;
+    }
+    *buffer = new_buffer;
+    *capacity = new_capacity;
+    return 1;
+}
+
+/**
+ * answers all the complete requests in the input of a connection, the
+ * replies are appended to its output.
+ * @param sys - ptr to the system
+ * @param connection - ptr to the connection
+ * @return the num of input bytes that were used, (size_t) -1 if the client
+ *         sent a frame that is too big or allocation problems occurred
+ */
+static size_t process_frames(ChallengeRoomSystem *sys,
+                             ServerConnection *connection) {
+    size_t used = 0;
+    while (connection->input_size - used >= FRAME_HEADER_SIZE) {
+        int length = 0;
+        const unsigned char *header = connection->input + used;
+        protocol_get_int(&header, header + FRAME_HEADER_SIZE, &length);
+        if (length < 0 || length > MAX_FRAME_SIZE - FRAME_HEADER_SIZE) {
+            return (size_t) -1;
+        }
+        if (connection->input_size - used < FRAME_HEADER_SIZE +
+                                            (size_t) length) {
+            break;
+        }
+        if (!reserve(&connection->output, &connection->output_capacity,
+                     connection->output_end + MAX_FRAME_SIZE)) {
+            return (size_t) -1;
+        }
+        unsigned char *reply = connection->output + connection->output_end;
+        size_t reply_length = handle_request(sys, header, header + length,
+                                             reply + FRAME_HEADER_SIZE);
+        protocol_put_int(reply, (int) reply_length);
+        connection->output_end += FRAME_HEADER_SIZE + reply_length;
+        used += FRAME_HEADER_SIZE + (size_t) length;
+    }
+    return used;
+}
+
+/**
+ * applies a single request to the system and writes the body of its reply.
+ * @param sys - ptr to the system
+ * @param body - the body of the request
+ * @param end - the end of the body
+ * @param reply - where to write the body of the reply
+ * @return the length of the body of the reply
+ */
+static size_t handle_request(ChallengeRoomSystem *sys,
+                             const unsigned char *body,
+                             const unsigned char *end, unsigned char *reply) {
+    char first[MAX_STRING_LEN + 1], second[MAX_STRING_LEN + 1];
+    int id = 0, level = 0, time = 0;
+    Result result = ILLEGAL_PARAMETER;
+    size_t length = 1;
+    if (body == end) {
+        reply[0] = (unsigned char) result;
+        return length;
+    }
+    switch ((ServerOp) *body++) {
+        case OP_ARRIVE:
+            if (protocol_get_int(&body, end, &id) &&
+                protocol_get_int(&body, end, &level) &&
+                protocol_get_int(&body, end, &time) &&
+                protocol_get_string(&body, end, first) &&
+                protocol_get_string(&body, end, second) &&
+                level >= Easy && level <= All_Levels) {
+                result = visitor_arrive(sys, first, second, id, (Level) level,
+                                        time);
+            }
+            break;
+        case OP_QUIT:
+            if (protocol_get_int(&body, end, &id) &&
+                protocol_get_int(&body, end, &time)) {
+                result = visitor_quit(sys, id, time);
+            }
+            break;
+        case OP_ROOM_OF_VISITOR:
+            if (protocol_get_string(&body, end, first)) {
+                char *room_name = NULL;
+                result = system_room_of_visitor(sys, first, &room_name);
+                if (result == OK) {
+                    length += protocol_put_string(reply + length, room_name);
+                    system_free(room_name);
+                }
+            }
+            break;
+        case OP_BEST_TIME:
+            if (protocol_get_string(&body, end, first)) {
+                result = best_time_of_system_challenge(sys, first, &time);
+                if (result == OK) {
+                    length += protocol_put_int(reply + length, time);
+                }
+            }
+            break;
+        case OP_MOST_POPULAR: {
+            char *challenge_name = NULL;
+            result = most_popular_challenge(sys, &challenge_name);
+            if (result == OK) {
+                length += protocol_put_string(reply + length, challenge_name);
+                system_free(challenge_name);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    reply[0] = (unsigned char) result;
+    return length;
+}
@@ -0,0 +1,35 @@
+#ifndef SERVER_CONNECTION_H_
+#define SERVER_CONNECTION_H_
+
+#include <stddef.h>
+
+#include "challenge_system.h"
+
+/*
+ * a client connection of the challenge server, see server_protocol.h.
+ * requests are read into input and the replies of a whole read cycle are
+ * collected in output and written together. the socket is non blocking,
+ * so the replies the socket does not take yet stay pending in output.
+ */
+typedef struct SServerConnection {
+    int fd;
+    unsigned char *input;
+    size_t input_size;
+    size_t input_capacity;
+    unsigned char *output;
+    size_t output_start;
+    size_t output_end;
+    size_t output_capacity;
+} ServerConnection;
+
+void init_server_connection(ServerConnection *connection, int fd);
+
+void reset_server_connection(ServerConnection *connection);
+
+int server_connection_read(ChallengeRoomSystem *sys, ServerConnection *connection);
+
+int server_connection_write(ServerConnection *connection);
+
+int server_connection_pending(ServerConnection *connection);
+
+#endif // SERVER_CONNECTION_H_
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "server_protocol.h"
+
+/**
+ * writes an int to a message.
+ * @param out - where to write the int
+ * @param value - the int
+ * @return the num of bytes written
+ */
+size_t protocol_put_int(unsigned char *out, int value) {
+    assert(out != NULL);
+    memcpy(out, &value, sizeof(value));
+    return sizeof(value);
+}
+
+/**
+ * writes a string to a message, longer strings are cut to MAX_STRING_LEN.
+ * @param out - where to write the string
+ * @param value - the string, NULL is written as an empty string
+ * @return the num of bytes written
+ */
+size_t protocol_put_string(unsigned char *out, const char *value) {
+    assert(out != NULL);
+    size_t length = value == NULL ? 0 : strlen(value);
+    if (length > MAX_STRING_LEN) {
+        length = MAX_STRING_LEN;
+    }
+    out[0] = (unsigned char) length;
+    if (length > 0) {
+        memcpy(out + 1, value, length);
+    }
+    return length + 1;
+}
+
+/**
+ * reads an int from a message and advances the read position.
+ * @param in - ptr to the read position
+ * @param end - the end of the message
+ * @param value - the ptr that needs to be updated
+ * @return 1 if the int was read, 0 if the message is too short
+ */
+int protocol_get_int(const unsigned char **in, const unsigned char *end,
+                     int *value) {
+    assert(in != NULL && end != NULL && value != NULL);
+    if (end - *in < (long) sizeof(*value)) {
+        return 0;
+    }
+    memcpy(value, *in, sizeof(*value));
+    *in += sizeof(*value);
+    return 1;
+}
+
+/**
+ * reads a string from a message and advances the read position.
+ * @param in - ptr to the read position
+ * @param end - the end of the message
+ * @param value - the buffer that needs to be updated, must have room for
+ *                MAX_STRING_LEN + 1 chars
+ * @return 1 if the string was read, 0 if the message is too short
+ */
+int protocol_get_string(const unsigned char **in, const unsigned char *end,
+                        char *value) {
+    assert(in != NULL && end != NULL && value != NULL);
+    if (*in >= end || end - *in < 1 + (long) **in) {
+        return 0;
+    }
+    size_t length = **in;
+    memcpy(value, *in + 1, length);
+    value[length] = '\0';
+    *in += length + 1;
+    return 1;
+}
@@ -0,0 +1,35 @@
+#ifndef SERVER_PROTOCOL_H_
+#define SERVER_PROTOCOL_H_
+
+#include <stddef.h>
+
+/*
+ * the protocol of the challenge server.
+ * every message is a frame: a 4 byte length of the body and then the body.
+ * a request body is a 1 byte op and the arguments of the op, a reply body is
+ * a 1 byte Result and the values the op returns (only when it is OK).
+ * ints are 4 bytes in the byte order of the host, the server is local only.
+ * strings are a 1 byte length and the bytes, without a terminating 0.
+ * requests may be pipelined, the replies are sent in the order of requests.
+ */
+typedef enum EServerOp {
+    OP_ARRIVE,          /* int id, int level, int time, str room, str name */
+    OP_QUIT,            /* int id, int time */
+    OP_ROOM_OF_VISITOR, /* str name -> str room */
+    OP_BEST_TIME,       /* str challenge -> int time */
+    OP_MOST_POPULAR     /* -> str challenge, empty if there were no visits */
+} ServerOp;
+
+#define FRAME_HEADER_SIZE 4
+#define MAX_STRING_LEN 255
+#define MAX_FRAME_SIZE (FRAME_HEADER_SIZE + 1 + 3 * 4 + 2 * (1 + MAX_STRING_LEN))
+
+size_t protocol_put_int(unsigned char *out, int value);
+
+size_t protocol_put_string(unsigned char *out, const char *value);
+
+int protocol_get_int(const unsigned char **in, const unsigned char *end, int *value);
+
+int protocol_get_string(const unsigned char **in, const unsigned char *end, char *value);
+
+#endif // SERVER_PROTOCOL_H_
@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snapshot.h"
+#include "fixed_alloc.h"
+
+#define PAGE_RECORDS ESCAPY_SNAPSHOT_PAGE_RECORDS
+
+#ifdef ESCAPY_PERSISTENT_ARENA
+/* the tables stay in the arena file between processes, and so does this */
+#define snapshot_bytes (*fixed_arena_snapshot_bytes())
+#elif defined(ESCAPY_FIXED_CAPACITY)
+/* the bytes of the arena taken by all the snapshot tables */
+static size_t snapshot_bytes = 0;
+#endif
+
+static void *snapshot_alloc(size_t size);
+
+static void snapshot_free(void *ptr, size_t size);
+
+static size_t table_size(int capacity);
+
+static SnapshotName **name_of(SnapshotRecord *record);
+
+static void release_name(SnapshotName *name);
+
+static void release_page(SnapshotPage *page);
+
+static Result own_table(SnapshotTable **table, int num_pages);
+
+/**
+ * creates an empty table.
+ * @param table - ptr to the ptr that needs to be updated
+ * @param expected_size - num of records the table should hold without
+ *                        growing its directory
+ * @return NULL_PARAMETER: if the ptr to table is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_snapshot_table(SnapshotTable **table, int expected_size) {
+    assert(table != NULL);
+    if (table == NULL) {
+        return NULL_PARAMETER;
+    }
+    int capacity = expected_size > 0 ?
+                   (expected_size + PAGE_RECORDS - 1) / PAGE_RECORDS : 1;
+    *table = snapshot_alloc(table_size(capacity));
+    if (*table == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    (*table)->refs = 1;
+    (*table)->size = 0;
+    (*table)->capacity = capacity;
+    for (int i = 0; i < capacity; ++i) {
+        (*table)->pages[i] = NULL;
+    }
+    return OK;
+}
+
+/**
+ * takes a reference to the table as it is now, in O(1).
+ * @param table - ptr to the table
+ * @return the table
+ */
+SnapshotTable *snapshot_table_acquire(SnapshotTable *table) {
+    assert(table != NULL);
+    table->refs++;
+    return table;
+}
+
+/**
+ * drops a reference to a table, the last one frees the pages that are not
+ * held by other tables.
+ * @param table - ptr to the table, may be NULL
+ */
+void snapshot_table_release(SnapshotTable *table) {
+    if (table == NULL || --table->refs > 0) {
+        return;
+    }
+    for (int i = 0; i < table->capacity; ++i) {
+        release_page(table->pages[i]);
+    }
+    snapshot_free(table, table_size(table->capacity));
+}
+
+/**
+ * returns a record of the table for reading.
+ * @param table - ptr to the table
+ * @param idx - the idx of the record, smaller than the size of the table
+ * @return ptr to the record
+ */
+SnapshotRecord *snapshot_table_read(SnapshotTable *table, int idx) {
+    assert(table != NULL && idx >= 0 && idx < table->size);
+    return table->pages[idx / PAGE_RECORDS]->records + idx % PAGE_RECORDS;
+}
+
+/**
+ * returns a record of the table for writing. the directory and the page of
+ * the record are copied first if other tables hold them, in which case the
+ * ptr to the table is updated, so a snapshot holding the old ones does not
+ * see the write.
+ * @param table - ptr to the ptr to the table
+ * @param idx - the idx of the record, smaller than the size of the table
+ * @return ptr to the record, NULL if allocation problems have occurred, in
+ *         which case the table is not changed
+ */
+SnapshotRecord *snapshot_table_write(SnapshotTable **table, int idx) {
+    assert(table != NULL && *table != NULL);
+    assert(idx >= 0 && idx < (*table)->size);
+    if (own_table(table, (*table)->capacity) != OK) {
+        return NULL;
+    }
+    SnapshotPage **page = (*table)->pages + idx / PAGE_RECORDS;
+    if ((*page)->refs > 1) {
+        SnapshotPage *copy = snapshot_alloc(sizeof(*copy));
+        if (copy == NULL) {
+            return NULL;
+        }
+        memcpy(copy, *page, sizeof(*copy));
+        copy->refs = 1;
+        for (int i = 0; i < PAGE_RECORDS; ++i) {
+            if (*name_of(copy->records + i) != NULL) {
+                (*name_of(copy->records + i))->refs++;
+            }
+        }
+        (*page)->refs--;
+        *page = copy;
+    }
+    return (*page)->records + idx % PAGE_RECORDS;
+}
+
+/**
+ * adds a record at the end of the table, its fields are 0 and it has no
+ * name.
+ * @param table - ptr to the ptr to the table, updated as in
+ *                snapshot_table_write
+ * @return ptr to the record, NULL if allocation problems have occurred, in
+ *         which case the table is not changed
+ */
+SnapshotRecord *snapshot_table_append(SnapshotTable **table) {
+    assert(table != NULL && *table != NULL);
+    int page_idx = (*table)->size / PAGE_RECORDS;
+    if (own_table(table, page_idx + 1) != OK) {
+        return NULL;
+    }
+    if ((*table)->pages[page_idx] == NULL) {
+        SnapshotPage *page = snapshot_alloc(sizeof(*page));
+        if (page == NULL) {
+            return NULL;
+        }
+        memset(page, 0, sizeof(*page));
+        page->refs = 1;
+        (*table)->pages[page_idx] = page;
+    }
+    //the records past the end have no name, so the new one starts empty
+    (*table)->size++;
+    SnapshotRecord *record = snapshot_table_write(table, (*table)->size - 1);
+    if (record == NULL) {
+        (*table)->size--;
+    }
+    return record;
+}
+
+/**
+ * removes a record of the table, the last record takes its place.
+ * @param table - ptr to the ptr to the table, updated as in
+ *                snapshot_table_write
+ * @param idx - the idx of the record, smaller than the size of the table
+ * @return MEMORY_PROBLEM: if allocation problems have occurred, in which
+ *                         case the table is not changed
+ *         OK: if everything went well
+ */
+Result snapshot_table_remove(SnapshotTable **table, int idx) {
+    assert(table != NULL && *table != NULL);
+    //once the directory is owned, writing the last record can't move it
+    SnapshotRecord *record = snapshot_table_write(table, idx);
+    SnapshotRecord *last = record == NULL ? NULL :
+                           snapshot_table_write(table, (*table)->size - 1);
+    if (last == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    release_name(*name_of(record));
+    if (record != last) {
+        *record = *last;
+    }
+    memset(last, 0, sizeof(*last));
+    (*table)->size--;
+    return OK;
+}
+
+/**
+ * sets the name of a record, which keeps its name if it did not change.
+ * @param record - ptr to a record returned for writing
+ * @param name - the name, which is copied
+ * @return NULL_PARAMETER: if the ptr to record or name are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred, in which
+ *                         case the record is not changed
+ *         OK: if everything went well
+ */
+Result snapshot_record_name(SnapshotRecord *record, const char *name) {
+    assert(record != NULL && name != NULL);
+    if (record == NULL || name == NULL) {
+        return NULL_PARAMETER;
+    }
+    SnapshotName **record_name = name_of(record);
+    if (*record_name != NULL && strcmp((*record_name)->text, name) == 0) {
+        return OK;
+    }
+    SnapshotName *copy = snapshot_alloc(sizeof(*copy) + strlen(name) + 1);
+    if (copy == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    copy->refs = 1;
+    strcpy(copy->text, name);
+    release_name(*record_name);
+    *record_name = copy;
+    return OK;
+}
+
+/**
+ * allocates memory of a table. in the fixed capacity build the tables take
+ * at most ESCAPY_MAX_SNAPSHOT_BYTES of the arena, counted as the arena takes
+ * them, in whole 16 byte units and a unit for the header.
+ * @param size - the wanted num of bytes
+ * @return ptr to the memory, NULL if allocation problems have occurred
+ */
+static void *snapshot_alloc(size_t size) {
+#ifdef ESCAPY_FIXED_CAPACITY
+    size_t units = ((size + 15) / 16 + 1) * 16;
+    if (snapshot_bytes + units > ESCAPY_MAX_SNAPSHOT_BYTES) {
+        return NULL;
+    }
+    void *ptr = malloc(size);
+    if (ptr != NULL) {
+        snapshot_bytes += units;
+    }
+    return ptr;
+#else
+    return malloc(size);
+#endif
+}
+
+/**
+ * frees memory of a table.
+ * @param ptr - the memory
+ * @param size - the num of bytes it was allocated with
+ */
+static void snapshot_free(void *ptr, size_t size) {
+#ifdef ESCAPY_FIXED_CAPACITY
+    snapshot_bytes -= ((size + 15) / 16 + 1) * 16;
+#else
+    (void) size;
+#endif
+    free(ptr);
+}
+
+/**
+ * returns the num of bytes of a directory with room for some pages.
+ * @param capacity - the num of pages
+ * @return the num of bytes
+ */
+static size_t table_size(int capacity) {
+    return sizeof(SnapshotTable) + capacity * sizeof(SnapshotPage *);
+}
+
+/**
+ * returns the name of a record of either kind, both start with it.
+ * @param record - ptr to the record
+ * @return ptr to the name of the record
+ */
+static SnapshotName **name_of(SnapshotRecord *record) {
+    return &record->challenge.name;
+}
+
+/**
+ * drops a reference to a name, the last one frees it.
+ * @param name - ptr to the name, may be NULL
+ */
+static void release_name(SnapshotName *name) {
+    if (name == NULL || --name->refs > 0) {
+        return;
+    }
+    snapshot_free(name, sizeof(*name) + strlen(name->text) + 1);
+}
+
+/**
+ * drops a reference to a page, the last one frees it and drops its names.
+ * @param page - ptr to the page, may be NULL
+ */
+static void release_page(SnapshotPage *page) {
+    if (page == NULL || --page->refs > 0) {
+        return;
+    }
+    for (int i = 0; i < PAGE_RECORDS; ++i) {
+        release_name(*name_of(page->records + i));
+    }
+    snapshot_free(page, sizeof(*page));
+}
+
+/**
+ * makes the directory of a table its own and gives it room for a num of
+ * pages, doubling its capacity until they fit. a directory held by other
+ * tables is copied, and its pages are then held by the copy as well.
+ * @param table - ptr to the ptr to the table, updated if it is copied
+ * @param num_pages - the num of pages the directory should have room for
+ * @return MEMORY_PROBLEM: if allocation problems have occurred, in which
+ *                         case the table is not changed
+ *         OK: if everything went well
+ */
+static Result own_table(SnapshotTable **table, int num_pages) {
+    SnapshotTable *old_table = *table;
+    if (old_table->refs == 1 && num_pages <= old_table->capacity) {
+        return OK;
+    }
+    int capacity = old_table->capacity;
+    while (capacity < num_pages) {
+        capacity *= 2;
+    }
+    SnapshotTable *new_table = snapshot_alloc(table_size(capacity));
+    if (new_table == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    new_table->refs = 1;
+    new_table->size = old_table->size;
+    new_table->capacity = capacity;
+    for (int i = 0; i < capacity; ++i) {
+        new_table->pages[i] = i < old_table->capacity ?
+                              old_table->pages[i] : NULL;
+    }
+    if (old_table->refs > 1) {
+        for (int i = 0; i < old_table->capacity; ++i) {
+            if (old_table->pages[i] != NULL) {
+                old_table->pages[i]->refs++;
+            }
+        }
+        old_table->refs--;
+    } else {
+        snapshot_free(old_table, table_size(old_table->capacity));
+    }
+    *table = new_table;
+    return OK;
+}
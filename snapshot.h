@@ -0,0 +1,96 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <stddef.h>
+
+#include "constants.h"
+
+/* the num of records in a page of a snapshot table */
+#ifndef ESCAPY_SNAPSHOT_PAGE_RECORDS
+#define ESCAPY_SNAPSHOT_PAGE_RECORDS 32
+#endif
+
+/*
+ * a name kept by the records of snapshot tables. a name is never changed,
+ * a record that is renamed gets a new one, and it is freed with the last
+ * page holding it.
+ */
+typedef struct SSnapshotName
+{
+   int refs;
+   char text[];
+} SnapshotName;
+
+
+/* the statistics of a challenge as of a snapshot */
+typedef struct SChallengeStats
+{
+   SnapshotName *name;
+   int id;
+   Level level;
+   int num_visits;
+   int best_time;
+} ChallengeStats;
+
+
+/* the statistics of a room as of a snapshot */
+typedef struct SRoomStats
+{
+   SnapshotName *name;
+   int id;
+   int num_challenges;
+   int num_visitors;
+   int num_free;
+   int num_waiting;
+} RoomStats;
+
+
+/* both kinds of records start with their name */
+typedef union USnapshotRecord
+{
+   ChallengeStats challenge;
+   RoomStats room;
+} SnapshotRecord;
+
+
+typedef struct SSnapshotPage
+{
+   int refs;
+   SnapshotRecord records[ESCAPY_SNAPSHOT_PAGE_RECORDS];
+} SnapshotPage;
+
+
+/*
+ * a table of records split in pages, shared by the system and the snapshots
+ * taken of it. a snapshot takes a reference to the table in O(1), and the
+ * first write to a shared table copies its directory of pages and the first
+ * write to a shared page copies the page, so a snapshot never sees a later
+ * write and the writer never waits for the snapshot. the references are not
+ * atomic, the tables are used by a single thread.
+ */
+typedef struct SSnapshotTable
+{
+   int refs;
+   int size;
+   int capacity;
+   SnapshotPage *pages[];
+} SnapshotTable;
+
+
+Result init_snapshot_table(SnapshotTable **table, int expected_size);
+
+SnapshotTable *snapshot_table_acquire(SnapshotTable *table);
+
+void snapshot_table_release(SnapshotTable *table);
+
+SnapshotRecord *snapshot_table_read(SnapshotTable *table, int idx);
+
+SnapshotRecord *snapshot_table_write(SnapshotTable **table, int idx);
+
+SnapshotRecord *snapshot_table_append(SnapshotTable **table);
+
+Result snapshot_table_remove(SnapshotTable **table, int idx);
+
+Result snapshot_record_name(SnapshotRecord *record, const char *name);
+
+#endif // SNAPSHOT_H_
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "string_builder.h"
+#include "fixed_alloc.h"
+
+static Result reserve(StringBuilder *builder, size_t length);
+
+/**
+ * initializes an empty builder.
+ * @param builder - ptr to the builder to initialize
+ * @param capacity - num of bytes the builder should hold without growing
+ * @return NULL_PARAMETER: if the ptr to builder is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_string_builder(StringBuilder *builder, size_t capacity) {
+    assert(builder != NULL);
+    if (builder == NULL) {
+        return NULL_PARAMETER;
+    }
+    builder->text = malloc(capacity + 1);
+    if (builder->text == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    builder->text[0] = '\0';
+    builder->length = 0;
+    builder->capacity = capacity;
+    return OK;
+}
+
+/**
+ * frees the memory of a builder.
+ * @param builder - ptr to the builder
+ * @return NULL_PARAMETER: if the ptr to builder is NULL
+ *         OK: if everything went well
+ */
+Result reset_string_builder(StringBuilder *builder) {
+    if (builder == NULL) {
+        return NULL_PARAMETER;
+    }
+    free(builder->text);
+    builder->text = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+    return OK;
+}
+
+/**
+ * appends bytes to the text in O(length) amortized.
+ * @param builder - ptr to the builder
+ * @param text - the bytes to append
+ * @param length - the num of bytes
+ * @return MEMORY_PROBLEM: if allocation problems have occurred, in which
+ *                         case the text is not changed
+ *         OK: if everything went well
+ */
+Result string_builder_append(StringBuilder *builder, const char *text,
+                             size_t length) {
+    assert(builder != NULL && (text != NULL || length == 0));
+    if (reserve(builder, length) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    memcpy(builder->text + builder->length, text, length);
+    builder->length += length;
+    builder->text[builder->length] = '\0';
+    return OK;
+}
+
+/**
+ * appends a terminated string to the text.
+ * @param builder - ptr to the builder
+ * @param text - the string
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result string_builder_append_text(StringBuilder *builder, const char *text) {
+    assert(text != NULL);
+    return string_builder_append(builder, text, strlen(text));
+}
+
+/**
+ * appends a single char to the text.
+ * @param builder - ptr to the builder
+ * @param c - the char
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result string_builder_append_char(StringBuilder *builder, char c) {
+    return string_builder_append(builder, &c, 1);
+}
+
+/**
+ * appends a num in decimal to the text, without going through printf.
+ * @param builder - ptr to the builder
+ * @param value - the num
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result string_builder_append_int(StringBuilder *builder, long long value) {
+    char digits[24];
+    int start = sizeof(digits);
+    //counted as negative so the smallest value doesn't overflow
+    long long rest = value < 0 ? value : -value;
+    do {
+        digits[--start] = (char) ('0' - rest % 10);
+        rest /= 10;
+    } while (rest != 0);
+    if (value < 0) {
+        digits[--start] = '-';
+    }
+    return string_builder_append(builder, digits + start,
+                                 sizeof(digits) - start);
+}
+
+/**
+ * empties the text and keeps the memory.
+ * @param builder - ptr to the builder
+ */
+void string_builder_clear(StringBuilder *builder) {
+    assert(builder != NULL);
+    builder->length = 0;
+    builder->text[0] = '\0';
+}
+
+/**
+ * hands the text over to the caller, the builder is left without memory
+ * like after reset_string_builder.
+ * @param builder - ptr to the builder
+ * @return the text, which the caller frees
+ */
+char *string_builder_take(StringBuilder *builder) {
+    assert(builder != NULL);
+    char *text = builder->text;
+    builder->text = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+    return text;
+}
+
+/**
+ * makes room for more bytes, at least doubling the capacity when it grows.
+ * @param builder - ptr to the builder
+ * @param length - the num of bytes to make room for
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result reserve(StringBuilder *builder, size_t length) {
+    if (length > (size_t) -1 / 2 - builder->length) {
+        return MEMORY_PROBLEM;
+    }
+    size_t needed = builder->length + length;
+    if (needed <= builder->capacity) {
+        return OK;
+    }
+    size_t capacity = builder->capacity < 16 ? 16 : builder->capacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    char *text = realloc(builder->text, capacity + 1);
+    if (text == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    builder->text = text;
+    builder->capacity = capacity;
+    return OK;
+}
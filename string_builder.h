@@ -0,0 +1,35 @@
+#ifndef STRING_BUILDER_H_
+#define STRING_BUILDER_H_
+
+#include <stddef.h>
+
+#include "constants.h"
+
+/*
+ * a growable string. the capacity doubles whenever an append doesn't fit,
+ * so building a string of n bytes copies O(n) bytes in all. the text is
+ * always terminated, and clearing the builder keeps its memory for reuse.
+ */
+typedef struct SStringBuilder {
+    char *text;
+    size_t length;
+    size_t capacity;
+} StringBuilder;
+
+Result init_string_builder(StringBuilder *builder, size_t capacity);
+
+Result reset_string_builder(StringBuilder *builder);
+
+Result string_builder_append(StringBuilder *builder, const char *text, size_t length);
+
+Result string_builder_append_text(StringBuilder *builder, const char *text);
+
+Result string_builder_append_char(StringBuilder *builder, char c);
+
+Result string_builder_append_int(StringBuilder *builder, long long value);
+
+void string_builder_clear(StringBuilder *builder);
+
+char *string_builder_take(StringBuilder *builder);
+
+#endif // STRING_BUILDER_H_
@@ -6,11 +6,13 @@
 #define ESCAPY_SYSTEM_ADDITIONAL_TYPES_H
 
 /*
- * a linked list of visitors
+ * a doubly linked list of visitors, so a node can be unlinked in O(1) once it
+ * is found through the visitors index
  */
 typedef struct SVisitorsList {
     Visitor *visitor;
     struct SVisitorsList *next;
+    struct SVisitorsList *prev;
 } *VisitorsList;
 
 
@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "timer_wheel.h"
+
+#define UNDEFINED -1
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+/* the time units covered by the slots of all the wheels */
+#define WHEEL_RANGE (1LL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS))
+
+/* fails to compile if a bitmap can't hold the slots of a wheel */
+typedef char timer_wheel_slots_fit[TIMER_WHEEL_SLOTS == 64 ? 1 : -1];
+
+static void place_timer(TimerWheel *wheel, Timer *timer);
+
+static void unlink_timer(TimerWheel *wheel, Timer *timer);
+
+static long long next_step(TimerWheel *wheel);
+
+static void cascade(TimerWheel *wheel, int level);
+
+static int lowest_bit(uint64_t bits);
+
+/**
+ * initializes a wheel without timers.
+ * @param wheel - ptr to the wheel to initialize
+ * @param time - the current time, not negative
+ */
+void init_timer_wheel(TimerWheel *wheel, int time) {
+    assert(wheel != NULL && time >= 0);
+    wheel->now = time;
+    wheel->num_timers = 0;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; ++slot) {
+            wheel->slots[level][slot] = NULL_LINK;
+        }
+        wheel->occupied[level] = 0;
+    }
+}
+
+/**
+ * initializes a timer that is not scheduled.
+ * @param timer - ptr to the timer to initialize
+ */
+void init_timer(Timer *timer) {
+    assert(timer != NULL);
+    timer->next = NULL_LINK;
+    timer->prev = NULL_LINK;
+    timer->expiry = 0;
+    timer->slot = UNDEFINED;
+}
+
+/**
+ * schedules a timer in O(1), a timer that is scheduled already is moved.
+ * @param wheel - ptr to the wheel
+ * @param timer - ptr to the timer
+ * @param expiry - the time the timer expires, a timer whose time already
+ *                 passed expires at the current time of the wheel
+ */
+void timer_wheel_schedule(TimerWheel *wheel, Timer *timer, int expiry) {
+    assert(wheel != NULL && timer != NULL);
+    timer_wheel_cancel(wheel, timer);
+    timer->expiry = expiry;
+    place_timer(wheel, timer);
+    wheel->num_timers++;
+}
+
+/**
+ * cancels a timer in O(1), a timer that is not scheduled is left as is.
+ * @param wheel - ptr to the wheel
+ * @param timer - ptr to the timer
+ */
+void timer_wheel_cancel(TimerWheel *wheel, Timer *timer) {
+    assert(wheel != NULL && timer != NULL);
+    if (timer->slot == UNDEFINED) {
+        return;
+    }
+    unlink_timer(wheel, timer);
+    wheel->num_timers--;
+}
+
+/**
+ * moves the wheel forward to a time and takes out a timer that expired by
+ * then, in the order of their expiry apart from timers that were scheduled
+ * after their expiry. the wheel stops at the expiry of the timer, so the
+ * caller may schedule and cancel timers before it takes the next one, and
+ * calls again until no timer is returned. each timer takes O(1) amortized
+ * and empty time is skipped in O(levels) per occupied slot.
+ * @param wheel - ptr to the wheel
+ * @param time - the time to move to, a time before the current time of the
+ *               wheel leaves it where it is
+ * @return ptr to the timer, which is no longer scheduled, NULL if no timer
+ *         expires by the time, in which case the wheel is at the time
+ */
+Timer *timer_wheel_expire(TimerWheel *wheel, int time) {
+    assert(wheel != NULL);
+    for (;;) {
+        //the slot of the current time holds the timers expiring now and the
+        //ones scheduled later with an expiry that already passed, which are
+        //all expired unless the time is before the current time
+        Timer *timer = timer_at(wheel->slots[0][wheel->now & SLOT_MASK]);
+        while (timer != NULL && timer->expiry > time) {
+            timer = timer_at(timer->next);
+        }
+        if (timer != NULL) {
+            timer_wheel_cancel(wheel, timer);
+            return timer;
+        }
+        if (time <= wheel->now) {
+            return NULL;
+        }
+        long long next = wheel->num_timers > 0 ? next_step(wheel) : time + 1LL;
+        if (next > time) {
+            wheel->now = time;
+            return NULL;
+        }
+        wheel->now = (int) next;
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; --level) {
+            int bits = level * TIMER_WHEEL_SLOT_BITS;
+            if ((wheel->now & ((1 << bits) - 1)) == 0) {
+                cascade(wheel, level);
+            }
+        }
+    }
+}
+
+/**
+ * adds a timer to the slot of its expiry, in the lowest wheel whose slots
+ * reach it from the current time.
+ * @param wheel - ptr to the wheel
+ * @param timer - ptr to the timer, not scheduled
+ */
+static void place_timer(TimerWheel *wheel, Timer *timer) {
+    long long expiry = timer->expiry > wheel->now ? timer->expiry : wheel->now;
+    if (expiry - wheel->now >= WHEEL_RANGE) {
+        expiry = wheel->now + WHEEL_RANGE - 1;
+    }
+    long long delta = expiry - wheel->now;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= 1LL << ((level + 1) * TIMER_WHEEL_SLOT_BITS)) {
+        level++;
+    }
+    int slot = (int) (expiry >> (level * TIMER_WHEEL_SLOT_BITS)) & SLOT_MASK;
+    LINK(Timer) *head = &wheel->slots[level][slot];
+    timer->slot = level * TIMER_WHEEL_SLOTS + slot;
+    timer->prev = NULL_LINK;
+    timer->next = *head;
+    if (*head != NULL_LINK) {
+        timer_at(*head)->prev = timer_link(timer);
+    }
+    *head = timer_link(timer);
+    wheel->occupied[level] |= (uint64_t) 1 << slot;
+}
+
+/**
+ * takes a timer out of its slot.
+ * @param wheel - ptr to the wheel
+ * @param timer - ptr to the timer, scheduled
+ */
+static void unlink_timer(TimerWheel *wheel, Timer *timer) {
+    int level = timer->slot / TIMER_WHEEL_SLOTS;
+    int slot = timer->slot % TIMER_WHEEL_SLOTS;
+    if (timer->prev != NULL_LINK) {
+        timer_at(timer->prev)->next = timer->next;
+    } else {
+        wheel->slots[level][slot] = timer->next;
+    }
+    if (timer->next != NULL_LINK) {
+        timer_at(timer->next)->prev = timer->prev;
+    }
+    if (wheel->slots[level][slot] == NULL_LINK) {
+        wheel->occupied[level] &= ~((uint64_t) 1 << slot);
+    }
+    timer->next = NULL_LINK;
+    timer->prev = NULL_LINK;
+    timer->slot = UNDEFINED;
+}
+
+/**
+ * returns the next time after the current one at which the wheel reaches an
+ * occupied slot: the expiry of the slot in the first wheel, the time the
+ * slot is moved down in the others.
+ * @param wheel - ptr to the wheel, with timers
+ * @return the time
+ */
+static long long next_step(TimerWheel *wheel) {
+    long long next = -1;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        uint64_t occupied = wheel->occupied[level];
+        if (occupied == 0) {
+            continue;
+        }
+        int bits = level * TIMER_WHEEL_SLOT_BITS;
+        long long position = (long long) wheel->now >> bits;
+        int current = (int) (position & SLOT_MASK);
+        //the slots after the current one come in this turn of the wheel,
+        //the others in the next turn
+        uint64_t later = current == SLOT_MASK ? 0 :
+                         occupied & ~(((uint64_t) 2 << current) - 1);
+        int slot = lowest_bit(later != 0 ? later : occupied);
+        long long turn = position - current +
+                         (later != 0 ? 0 : TIMER_WHEEL_SLOTS);
+        long long step = (turn + slot) << bits;
+        if (next == -1 || step < next) {
+            next = step;
+        }
+    }
+    return next;
+}
+
+/**
+ * moves the timers of the current slot of a wheel down to the wheels below,
+ * when the wheels below start a new turn.
+ * @param wheel - ptr to the wheel
+ * @param level - the wheel, above the first one
+ */
+static void cascade(TimerWheel *wheel, int level) {
+    int bits = level * TIMER_WHEEL_SLOT_BITS;
+    int slot = (wheel->now >> bits) & SLOT_MASK;
+    Timer *timer = timer_at(wheel->slots[level][slot]);
+    while (timer != NULL) {
+        Timer *next = timer_at(timer->next);
+        unlink_timer(wheel, timer);
+        place_timer(wheel, timer);
+        timer = next;
+    }
+}
+
+/**
+ * returns the idx of the lowest set bit.
+ * @param bits - the bits, not 0
+ * @return the idx
+ */
+static int lowest_bit(uint64_t bits) {
+    assert(bits != 0);
+    int idx = 0;
+    while ((bits & 0xFF) == 0) {
+        bits >>= 8;
+        idx += 8;
+    }
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        idx++;
+    }
+    return idx;
+}
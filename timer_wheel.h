@@ -0,0 +1,56 @@
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+#include "constants.h"
+
+/* the wheels of a timer wheel and the slots of each wheel, a power of 2 */
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+/*
+ * a timer, kept inside the record it times. slot is the wheel and slot the
+ * timer is in, -1 while it is not scheduled.
+ */
+typedef struct STimer
+{
+   LINK(struct STimer) next;
+   LINK(struct STimer) prev;
+   int expiry;
+   int slot;
+} Timer;
+
+DEFINE_LINK(Timer, timer)
+
+
+/*
+ * a hierarchical timer wheel over the times of the system. the first wheel
+ * has a slot for each of the next TIMER_WHEEL_SLOTS time units and each
+ * wheel above it has slots TIMER_WHEEL_SLOTS times as wide, so a timer is
+ * scheduled and cancelled in O(1) and is moved down a wheel at most once per
+ * wheel before it expires. a timer past the top wheel waits in its farthest
+ * slot and is placed again from there. the bitmaps of the occupied slots
+ * let the wheel skip over empty time in O(levels), so the time may jump.
+ */
+typedef struct STimerWheel
+{
+   int now;
+   int num_timers;
+   LINK(Timer) slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+   uint64_t occupied[TIMER_WHEEL_LEVELS];
+} TimerWheel;
+
+
+void init_timer_wheel(TimerWheel *wheel, int time);
+
+void init_timer(Timer *timer);
+
+void timer_wheel_schedule(TimerWheel *wheel, Timer *timer, int expiry);
+
+void timer_wheel_cancel(TimerWheel *wheel, Timer *timer);
+
+Timer *timer_wheel_expire(TimerWheel *wheel, int time);
+
+#endif // TIMER_WHEEL_H_
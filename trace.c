@@ -0,0 +1,136 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "trace.h"
+
+#ifdef ESCAPY_TRACE
+
+#include <time.h>
+#include <pthread.h>
+
+/* a span that ended, the times are in ns of the monotonic clock */
+typedef struct STraceSpan
+{
+   const char *name;
+   long long start;
+   long long end;
+} TraceSpan;
+
+/*
+ * the spans of one thread. only the thread writes to its ring, num_spans
+ * counts all the spans it recorded and the last ESCAPY_TRACE_SPANS are kept.
+ */
+typedef struct STraceRing
+{
+   int thread_id;
+   unsigned long num_spans;
+   TraceSpan spans[ESCAPY_TRACE_SPANS];
+} TraceRing;
+
+/* fails to compile if the num of spans of a ring is not a power of 2 */
+typedef char trace_spans_power_of_2[
+        (ESCAPY_TRACE_SPANS & (ESCAPY_TRACE_SPANS - 1)) == 0 ? 1 : -1];
+
+/* the rings are static so the fixed capacity build can trace too */
+static TraceRing rings[ESCAPY_TRACE_THREADS];
+static int num_rings = 0;
+static unsigned long num_dropped = 0;
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* the ring of the calling thread, taken by its first span */
+static __thread TraceRing *thread_ring = NULL;
+static __thread int thread_has_no_ring = 0;
+
+static TraceRing *take_ring(void);
+
+/**
+ * returns the time of the monotonic clock, for the start of a span.
+ * @return the time in ns
+ */
+long long trace_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * records a span that ends now to the ring of the calling thread, in O(1)
+ * and without locking once the thread has its ring.
+ * @param name - the name of the span, which must outlive the trace
+ * @param start - the time the span started, see trace_now
+ */
+void trace_record(const char *name, long long start) {
+    long long end = trace_now();
+    TraceRing *ring = thread_ring != NULL ? thread_ring : take_ring();
+    if (ring == NULL) {
+        return;
+    }
+    TraceSpan *span = ring->spans +
+                      (ring->num_spans & (ESCAPY_TRACE_SPANS - 1));
+    span->name = name;
+    span->start = start;
+    span->end = end;
+    ring->num_spans++;
+}
+
+/**
+ * writes the spans kept by all the threads to a file as Chrome trace JSON,
+ * a complete event per span. the threads should not record spans during the
+ * dump, or some of their spans may be written half updated.
+ * @param trace_file - the name of the file
+ * @return NULL_PARAMETER: if trace_file is NULL or the file can't be opened
+ *         OK: if everything went well
+ */
+Result trace_dump(char *trace_file) {
+    FILE *output = trace_file == NULL ? NULL : fopen(trace_file, "w");
+    if (output == NULL) {
+        return NULL_PARAMETER;
+    }
+    pthread_mutex_lock(&rings_lock);
+    fprintf(output, "{\"traceEvents\":[");
+    const char *separator = "\n";
+    for (int i = 0; i < num_rings; ++i) {
+        TraceRing *ring = rings + i;
+        unsigned long first = ring->num_spans > ESCAPY_TRACE_SPANS ?
+                              ring->num_spans - ESCAPY_TRACE_SPANS : 0;
+        for (unsigned long j = first; j < ring->num_spans; ++j) {
+            TraceSpan *span = ring->spans + (j & (ESCAPY_TRACE_SPANS - 1));
+            fprintf(output, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                    "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", separator,
+                    span->name, ring->thread_id, span->start / 1000.0,
+                    (span->end - span->start) / 1000.0);
+            separator = ",\n";
+        }
+    }
+    fprintf(output, "\n],\"displayTimeUnit\":\"ns\","
+            "\"otherData\":{\"dropped_threads\":%lu}}\n", num_dropped);
+    pthread_mutex_unlock(&rings_lock);
+    return fclose(output) == 0 ? OK : NULL_PARAMETER;
+}
+
+/**
+ * gives the calling thread a ring of its own, once per thread.
+ * @return ptr to the ring, NULL if all the rings are taken
+ */
+static TraceRing *take_ring(void) {
+    if (thread_has_no_ring) {
+        return NULL;
+    }
+    pthread_mutex_lock(&rings_lock);
+    if (num_rings < ESCAPY_TRACE_THREADS) {
+        thread_ring = rings + num_rings;
+        thread_ring->thread_id = num_rings;
+        thread_ring->num_spans = 0;
+        num_rings++;
+    } else {
+        num_dropped++;
+        thread_has_no_ring = 1;
+    }
+    pthread_mutex_unlock(&rings_lock);
+    return thread_ring;
+}
+
+#endif // ESCAPY_TRACE
@@ -0,0 +1,42 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "constants.h"
+
+/*
+ * the tracing build (ESCAPY_TRACE) times the main steps of processing an
+ * event. a step is a span from TRACE_BEGIN to TRACE_END in one function,
+ * and each thread records its spans to a ring of its own without locking,
+ * the oldest spans are overwritten once the ring is full. trace_dump writes
+ * the spans of all the threads as Chrome trace JSON, which chrome://tracing
+ * and Perfetto open. in the other builds the macros compile to nothing.
+ */
+#ifdef ESCAPY_TRACE
+
+/* the num of spans each thread keeps, a power of 2 */
+#ifndef ESCAPY_TRACE_SPANS
+#define ESCAPY_TRACE_SPANS 16384
+#endif
+
+/* the most threads that record spans, the spans of more are dropped */
+#ifndef ESCAPY_TRACE_THREADS
+#define ESCAPY_TRACE_THREADS 8
+#endif
+
+long long trace_now(void);
+
+void trace_record(const char *name, long long start);
+
+Result trace_dump(char *trace_file);
+
+#define TRACE_BEGIN(span) long long span##_trace_start = trace_now()
+#define TRACE_END(span) trace_record(#span, span##_trace_start)
+
+#else
+
+#define TRACE_BEGIN(span)
+#define TRACE_END(span)
+
+#endif // ESCAPY_TRACE
+
+#endif // TRACE_H_
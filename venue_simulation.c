@@ -0,0 +1,503 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "venue_simulation.h"
+
+#define NONE -1
+
+typedef enum EEventKind {ARRIVAL, QUIT} EventKind;
+
+/*
+ * a future event of a replication, an arrival of a level or the quit of a
+ * visitor. events at the same time are taken in the order they were made.
+ */
+typedef struct SEvent
+{
+   double time;
+   long sequence;
+   EventKind kind;
+   int target;
+} Event;
+
+/* a min heap of events by time, the scheduler of a replication */
+typedef struct SEventQueue
+{
+   Event *events;
+   int size;
+   int capacity;
+   long next_sequence;
+} EventQueue;
+
+/* a visitor of a replication, its id is its idx in the visitors table */
+typedef struct SSimVisitor
+{
+   Level level;
+   int room;
+   double arrival_time;
+   int next_waiting;
+} SimVisitor;
+
+/* the state of one replication */
+typedef struct SReplication
+{
+   Simulation *simulation;
+   ChallengeRoomSystem *sys;
+   unsigned long long random_state;
+   EventQueue queue;
+   SimVisitor *visitors;
+   int num_visitors;
+   int visitors_capacity;
+   char **room_names;
+   int num_rooms;
+   int capacity;
+   /* FIFOs of the waiting visitors per room and level, as in the rooms */
+   int *wait_heads;
+   int *wait_tails;
+   int num_waiting;
+   int num_busy;
+   double last_time;
+   double queue_area;
+   double busy_area;
+   long num_arrivals;
+   long num_rejected;
+   long num_waited;
+   long num_completed;
+   double total_wait;
+   int max_waiting;
+} Replication;
+
+static int init_replication(Replication *replication);
+
+static void reset_replication(Replication *replication);
+
+static int schedule(EventQueue *queue, double time, EventKind kind,
+                    int target);
+
+static Event next_event(EventQueue *queue);
+
+static int event_before(Event *first, Event *second);
+
+static double next_random(Replication *replication);
+
+static double draw_duration(Replication *replication, Level level);
+
+static void advance_time(Replication *replication, double time);
+
+static int handle_arrival(Replication *replication, Level level,
+                          double time);
+
+static int handle_quit(Replication *replication, int visitor_id,
+                       double time);
+
+static int start_visit(Replication *replication, int visitor_id,
+                       double time);
+
+/**
+ * reads the arrivals and durations of a level from the command line.
+ * @param simulation - ptr to the simulation
+ * @param spec - <level>:<rate>:<mean_duration>[:<distribution>]
+ * @return 1 if the spec is valid, 0 if not
+ */
+int parse_level_spec(Simulation *simulation, char *spec) {
+    static const char *level_names[] = {"easy", "medium", "hard", "any"};
+    static const char *distribution_names[] = {"exp", "uniform", "fixed"};
+    char level_name[16] = "", distribution_name[16] = "exp";
+    double rate = 0, mean_duration = 0;
+    int num_fields = sscanf(spec, "%15[a-z]:%lf:%lf:%15[a-z]", level_name,
+                            &rate, &mean_duration, distribution_name);
+    if (num_fields < 3 || rate <= 0 || mean_duration < 0) {
+        return 0;
+    }
+    int level = NONE, distribution = NONE;
+    for (int i = 0; i < NUM_WAIT_LEVELS; ++i) {
+        if (strcmp(level_name, level_names[i]) == 0) {
+            level = i;
+        }
+    }
+    for (int i = EXPONENTIAL; i <= FIXED; ++i) {
+        if (strcmp(distribution_name, distribution_names[i]) == 0) {
+            distribution = i;
+        }
+    }
+    if (level == NONE || distribution == NONE) {
+        return 0;
+    }
+    LevelSpec *level_spec = simulation->levels + level;
+    level_spec->enabled = 1;
+    level_spec->rate = rate;
+    level_spec->mean_duration = mean_duration;
+    level_spec->distribution = (Distribution) distribution;
+    return 1;
+}
+
+/**
+ * runs one replication on a system of its own, up to the horizon. each
+ * replication has its own random stream, so the results don't depend on
+ * the num of threads.
+ * @param simulation - ptr to the simulation
+ * @param replication_idx - the idx of the replication
+ * @param result - ptr to the result that needs to be filled
+ */
+void run_replication(Simulation *simulation, int replication_idx,
+                     ReplicationResult *result) {
+    Replication replication;
+    memset(&replication, 0, sizeof(replication));
+    replication.simulation = simulation;
+    replication.random_state = (simulation->seed + 1) * 0x9E3779B97F4A7C15ULL +
+                               (unsigned long long) replication_idx *
+                               0xBF58476D1CE4E5B9ULL;
+    result->failed = 1;
+    if (!init_replication(&replication)) {
+        reset_replication(&replication);
+        return;
+    }
+    int ok = 1;
+    for (int level = Easy; level <= All_Levels && ok; ++level) {
+        LevelSpec *spec = simulation->levels + level;
+        if (spec->enabled) {
+            ok = schedule(&replication.queue,
+                          -log(1 - next_random(&replication)) / spec->rate,
+                          ARRIVAL, level);
+        }
+    }
+    while (ok && replication.queue.size > 0 &&
+           replication.queue.events[0].time <= simulation->horizon) {
+        Event event = next_event(&replication.queue);
+        advance_time(&replication, event.time);
+        ok = event.kind == ARRIVAL ?
+             handle_arrival(&replication, (Level) event.target, event.time) :
+             handle_quit(&replication, event.target, event.time);
+    }
+    advance_time(&replication, simulation->horizon);
+    if (ok) {
+        double horizon = simulation->horizon;
+        result->failed = 0;
+        result->arrivals = (double) replication.num_arrivals;
+        result->rejection_rate = replication.num_arrivals == 0 ? 0 :
+                                 (double) replication.num_rejected /
+                                 replication.num_arrivals;
+        result->mean_wait = replication.num_waited == 0 ? 0 :
+                            replication.total_wait / replication.num_waited;
+        result->mean_queue_length = replication.queue_area / horizon;
+        result->max_queue_length = replication.max_waiting;
+        result->utilization = replication.capacity == 0 ? 0 :
+                              replication.busy_area /
+                              (horizon * replication.capacity);
+        result->completed = (double) replication.num_completed;
+    }
+    reset_replication(&replication);
+}
+
+/**
+ * creates the system of a replication and finds its rooms.
+ * @param replication - ptr to the replication
+ * @return 1 if everything went well, 0 if not
+ */
+static int init_replication(Replication *replication) {
+    if (create_system(replication->simulation->init_file,
+                      &replication->sys) != OK) {
+        replication->sys = NULL;
+        return 0;
+    }
+    ChallengeRoomSystem *sys = replication->sys;
+    int num_rooms = sys->system_num_rooms;
+    replication->room_names = malloc(((size_t) num_rooms + 1) *
+                                     sizeof(char *));
+    replication->wait_heads = malloc(((size_t) num_rooms + 1) *
+                                     NUM_WAIT_LEVELS * sizeof(int));
+    replication->wait_tails = malloc(((size_t) num_rooms + 1) *
+                                     NUM_WAIT_LEVELS * sizeof(int));
+    replication->queue.capacity = 16;
+    replication->queue.events = malloc(replication->queue.capacity *
+                                       sizeof(Event));
+    if (replication->room_names == NULL || replication->wait_heads == NULL ||
+        replication->wait_tails == NULL || replication->queue.events == NULL) {
+        return 0;
+    }
+    PrefixIterator search;
+    RoomMatch match;
+    system_search_rooms(sys, "", &search);
+    while (system_next_room_match(&search, &match)) {
+        replication->room_names[replication->num_rooms++] = match.name;
+        replication->capacity += match.num_challenges;
+    }
+    for (int i = 0; i < num_rooms * NUM_WAIT_LEVELS; ++i) {
+        replication->wait_heads[i] = NONE;
+        replication->wait_tails[i] = NONE;
+    }
+    return num_rooms > 0;
+}
+
+/**
+ * destroys the system of a replication and frees its memory.
+ * @param replication - ptr to the replication
+ */
+static void reset_replication(Replication *replication) {
+    if (replication->sys != NULL) {
+        char *most_popular = NULL, *best_time = NULL;
+        int time = (int) replication->simulation->horizon;
+        if (time < replication->sys->system_last_known_time) {
+            time = replication->sys->system_last_known_time;
+        }
+        destroy_system(replication->sys, time, &most_popular, &best_time);
+        system_free(most_popular);
+        system_free(best_time);
+    }
+    free(replication->room_names);
+    free(replication->wait_heads);
+    free(replication->wait_tails);
+    free(replication->queue.events);
+    free(replication->visitors);
+}
+
+/**
+ * adds an event to the scheduler in O(log n).
+ * @param queue - ptr to the scheduler
+ * @param time - the time of the event
+ * @param kind - the kind of the event
+ * @param target - the level of an arrival or the visitor of a quit
+ * @return 1 if everything went well, 0 if allocation problems have occurred
+ */
+static int schedule(EventQueue *queue, double time, EventKind kind,
+                    int target) {
+    if (queue->size == queue->capacity) {
+        Event *events = realloc(queue->events, 2 * queue->capacity *
+                                               sizeof(*events));
+        if (events == NULL) {
+            return 0;
+        }
+        queue->events = events;
+        queue->capacity *= 2;
+    }
+    Event event;
+    event.time = time;
+    event.sequence = queue->next_sequence++;
+    event.kind = kind;
+    event.target = target;
+    int position = queue->size++;
+    while (position > 0 &&
+           event_before(&event, queue->events + (position - 1) / 2)) {
+        queue->events[position] = queue->events[(position - 1) / 2];
+        position = (position - 1) / 2;
+    }
+    queue->events[position] = event;
+    return 1;
+}
+
+/**
+ * takes the earliest event out of the scheduler in O(log n).
+ * @param queue - ptr to the scheduler, which must not be empty
+ * @return the event
+ */
+static Event next_event(EventQueue *queue) {
+    assert(queue->size > 0);
+    Event first = queue->events[0];
+    Event last = queue->events[--queue->size];
+    int position = 0;
+    for (;;) {
+        int child = 2 * position + 1;
+        if (child >= queue->size) {
+            break;
+        }
+        if (child + 1 < queue->size &&
+            event_before(queue->events + child + 1, queue->events + child)) {
+            child++;
+        }
+        if (!event_before(queue->events + child, &last)) {
+            break;
+        }
+        queue->events[position] = queue->events[child];
+        position = child;
+    }
+    queue->events[position] = last;
+    return first;
+}
+
+/**
+ * compares two events by time, then by the order they were made.
+ * @param first - ptr to the first event
+ * @param second - ptr to the second event
+ * @return 1 if the first event comes before the second, 0 if not
+ */
+static int event_before(Event *first, Event *second) {
+    return first->time < second->time ||
+           (first->time == second->time && first->sequence < second->sequence);
+}
+
+/**
+ * draws a random num from the stream of a replication, xorshift64*.
+ * @param replication - ptr to the replication
+ * @return a num uniform in [0, 1)
+ */
+static double next_random(Replication *replication) {
+    unsigned long long x = replication->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    replication->random_state = x;
+    return ((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * draws the duration of a visit of a level.
+ * @param replication - ptr to the replication
+ * @param level - the level the visitor asked for
+ * @return the duration
+ */
+static double draw_duration(Replication *replication, Level level) {
+    LevelSpec *spec = replication->simulation->levels + level;
+    switch (spec->distribution) {
+        case EXPONENTIAL:
+            return -log(1 - next_random(replication)) * spec->mean_duration;
+        case UNIFORM:
+            return 2 * spec->mean_duration * next_random(replication);
+        default:
+            return spec->mean_duration;
+    }
+}
+
+/**
+ * moves the clock of a replication, adding the time since the last event to
+ * the areas under the queue length and the num of busy challenges.
+ * @param replication - ptr to the replication
+ * @param time - the new time
+ */
+static void advance_time(Replication *replication, double time) {
+    double elapsed = time - replication->last_time;
+    replication->queue_area += elapsed * replication->num_waiting;
+    replication->busy_area += elapsed * replication->num_busy;
+    replication->last_time = time;
+}
+
+/**
+ * handles an arrival of a level: a new visitor arrives at a random room and
+ * the next arrival of the level is scheduled.
+ * @param replication - ptr to the replication
+ * @param level - the level of the arrival
+ * @param time - the time of the arrival
+ * @return 1 if everything went well, 0 if the system failed
+ */
+static int handle_arrival(Replication *replication, Level level,
+                          double time) {
+    LevelSpec *spec = replication->simulation->levels + level;
+    if (!schedule(&replication->queue,
+                  time - log(1 - next_random(replication)) / spec->rate,
+                  ARRIVAL, level)) {
+        return 0;
+    }
+    if (replication->num_visitors == replication->visitors_capacity) {
+        int capacity = replication->visitors_capacity > 0 ?
+                       2 * replication->visitors_capacity : 64;
+        SimVisitor *visitors = realloc(replication->visitors,
+                                       capacity * sizeof(*visitors));
+        if (visitors == NULL) {
+            return 0;
+        }
+        replication->visitors = visitors;
+        replication->visitors_capacity = capacity;
+    }
+    int visitor_id = replication->num_visitors++;
+    SimVisitor *visitor = replication->visitors + visitor_id;
+    visitor->level = level;
+    visitor->room = (int) (next_random(replication) * replication->num_rooms);
+    visitor->arrival_time = time;
+    visitor->next_waiting = NONE;
+    replication->num_arrivals++;
+
+    ChallengeRoomSystem *sys = replication->sys;
+    char *room_name = replication->room_names[visitor->room];
+    char visitor_name[32];
+    sprintf(visitor_name, "visitor_%d", visitor_id);
+    int length = 0;
+    set_system_wait_queues(sys, 0);
+    Result result = visitor_arrive(sys, room_name, visitor_name, visitor_id,
+                                   level, (int) time);
+    if (result == OK) {
+        return start_visit(replication, visitor_id, time);
+    }
+    if (result != NO_AVAILABLE_CHALLENGES ||
+        system_wait_queue_length(sys, room_name, level, &length) != OK) {
+        return 0;
+    }
+    if (length >= replication->simulation->max_queue) {
+        replication->num_rejected++;
+        return 1;
+    }
+    set_system_wait_queues(sys, 1);
+    if (visitor_arrive(sys, room_name, visitor_name, visitor_id, level,
+                       (int) time) != OK) {
+        return 0;
+    }
+    int queue = visitor->room * NUM_WAIT_LEVELS + level;
+    if (replication->wait_tails[queue] == NONE) {
+        replication->wait_heads[queue] = visitor_id;
+    } else {
+        replication->visitors[replication->wait_tails[queue]].next_waiting =
+                visitor_id;
+    }
+    replication->wait_tails[queue] = visitor_id;
+    replication->num_waiting++;
+    if (replication->num_waiting > replication->max_waiting) {
+        replication->max_waiting = replication->num_waiting;
+    }
+    return 1;
+}
+
+/**
+ * handles the quit of a visitor. the freed challenge may be given to a
+ * visitor waiting in the room, who is then at the head of one of the
+ * queues of the room and no longer waiting in the system.
+ * @param replication - ptr to the replication
+ * @param visitor_id - the id of the visitor
+ * @param time - the time of the quit
+ * @return 1 if everything went well, 0 if the system failed
+ */
+static int handle_quit(Replication *replication, int visitor_id,
+                       double time) {
+    ChallengeRoomSystem *sys = replication->sys;
+    if (visitor_quit(sys, visitor_id, (int) time) != OK) {
+        return 0;
+    }
+    replication->num_busy--;
+    replication->num_completed++;
+    int room = replication->visitors[visitor_id].room;
+    for (int level = Easy; level < NUM_WAIT_LEVELS; ++level) {
+        int queue = room * NUM_WAIT_LEVELS + level;
+        int head = replication->wait_heads[queue];
+        int wait_time = 0;
+        if (head == NONE || system_visitor_wait_time(sys, head, (int) time,
+                                                     &wait_time) == OK) {
+            continue;
+        }
+        replication->wait_heads[queue] =
+                replication->visitors[head].next_waiting;
+        if (replication->wait_heads[queue] == NONE) {
+            replication->wait_tails[queue] = NONE;
+        }
+        replication->num_waiting--;
+        replication->num_waited++;
+        replication->total_wait += time -
+                                   replication->visitors[head].arrival_time;
+        return start_visit(replication, head, time);
+    }
+    return 1;
+}
+
+/**
+ * schedules the quit of a visitor that got a challenge.
+ * @param replication - ptr to the replication
+ * @param visitor_id - the id of the visitor
+ * @param time - the time the visit started
+ * @return 1 if everything went well, 0 if allocation problems have occurred
+ */
+static int start_visit(Replication *replication, int visitor_id,
+                       double time) {
+    replication->num_busy++;
+    Level level = replication->visitors[visitor_id].level;
+    return schedule(&replication->queue,
+                    time + draw_duration(replication, level), QUIT,
+                    visitor_id);
+}
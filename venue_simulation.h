@@ -0,0 +1,56 @@
+#ifndef VENUE_SIMULATION_H_
+#define VENUE_SIMULATION_H_
+
+#include "challenge_system.h"
+
+/*
+ * the discrete event simulation of a venue behind challenge_simulator.
+ * visitors of each level arrive at random rooms of a system of their own
+ * and stay for random durations, see the usage in challenge_simulator.c.
+ * a replication is deterministic given the seed and its idx.
+ */
+#define NUM_WAIT_LEVELS (All_Levels + 1)
+
+typedef enum EDistribution {EXPONENTIAL, UNIFORM, FIXED} Distribution;
+
+/*
+ * the visitors of a level: they arrive as a poisson process of rate
+ * arrivals per time unit and spend a duration drawn from the distribution
+ * in their challenge, mean_duration on average
+ */
+typedef struct SLevelSpec
+{
+   int enabled;
+   double rate;
+   double mean_duration;
+   Distribution distribution;
+} LevelSpec;
+
+typedef struct SSimulation
+{
+   char *init_file;
+   double horizon;
+   int num_replications;
+   int max_queue;
+   unsigned long seed;
+   LevelSpec levels[NUM_WAIT_LEVELS];
+} Simulation;
+
+/* what a replication measured, see challenge_simulator.c */
+typedef struct SReplicationResult
+{
+   int failed;
+   double arrivals;
+   double rejection_rate;
+   double mean_wait;
+   double mean_queue_length;
+   double max_queue_length;
+   double utilization;
+   double completed;
+} ReplicationResult;
+
+int parse_level_spec(Simulation *simulation, char *spec);
+
+void run_replication(Simulation *simulation, int replication_idx, ReplicationResult *result);
+
+#endif // VENUE_SIMULATION_H_
@@ -0,0 +1,474 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "visit_history.h"
+#include "fixed_alloc.h"
+
+#define INITIAL_CAPACITY 8
+#define MAX_VARINT_LEN 5
+#define MAX_ONE_BYTE_CODES 256
+
+static Result seal_open_block(VisitHistory *history);
+
+static int build_dictionary(int *ids, int num_ids, int *dictionary);
+
+static int compare_ints(const void *first, const void *second);
+
+static size_t put_codes(unsigned char *out, int *ids, int num_ids,
+                        int *dictionary, int dictionary_size, int width);
+
+static size_t put_varint(unsigned char *out, uint32_t previous,
+                         uint32_t value);
+
+static uint32_t get_varint(const unsigned char **in, uint32_t previous);
+
+static void decode_block(VisitBlock *block, VisitColumns *columns);
+
+static int block_may_match(VisitHistoryIterator *iterator, VisitBlock *block);
+
+static int visit_matches(VisitHistoryIterator *iterator, int visit_idx);
+
+/**
+ * initializes an empty history, no blocks are allocated until the first one
+ * is sealed.
+ * @param history - ptr to the history to initialize
+ */
+void init_visit_history(VisitHistory *history) {
+    assert(history != NULL);
+    history->blocks = NULL;
+    history->num_blocks = 0;
+    history->capacity = 0;
+    history->open_block.num_visits = 0;
+    history->num_visits = 0;
+    history->num_dropped = 0;
+}
+
+/**
+ * frees all the blocks of a history.
+ * @param history - ptr to the history
+ * @return NULL_PARAMETER: if the ptr to history is NULL
+ *         OK: if everything went well
+ */
+Result reset_visit_history(VisitHistory *history) {
+    assert(history != NULL);
+    if (history == NULL) {
+        return NULL_PARAMETER;
+    }
+    for (int i = 0; i < history->num_blocks; ++i) {
+        free(history->blocks[i].dictionaries);
+    }
+    free(history->blocks);
+    init_visit_history(history);
+    return OK;
+}
+
+/**
+ * appends a completed visit to the history, the visits must be appended in
+ * the order of their end times. when the open block is full it is sealed,
+ * and if that fails its visits are dropped from the history.
+ * @param history - ptr to the history
+ * @param record - ptr to the visit
+ * @return NULL_PARAMETER: if the ptr to history or record are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result visit_history_append(VisitHistory *history, VisitRecord *record) {
+    assert(history != NULL && record != NULL);
+    if (history == NULL || record == NULL) {
+        return NULL_PARAMETER;
+    }
+    VisitColumns *open_block = &history->open_block;
+    int idx = open_block->num_visits;
+    open_block->start_times[idx] = record->start_time;
+    open_block->durations[idx] = record->duration;
+    open_block->visitor_ids[idx] = record->visitor_id;
+    open_block->challenge_ids[idx] = record->challenge_id;
+    open_block->room_ids[idx] = record->room_id;
+    open_block->num_visits++;
+    history->num_visits++;
+    if (open_block->num_visits < VISIT_BLOCK_SIZE) {
+        return OK;
+    }
+    Result result = seal_open_block(history);
+    if (result != OK) {
+        history->num_visits -= open_block->num_visits;
+        history->num_dropped += open_block->num_visits;
+        open_block->num_visits = 0;
+    }
+    return result;
+}
+
+/**
+ * returns the num of bytes the history takes.
+ * @param history - ptr to the history
+ * @return the num of bytes
+ */
+size_t visit_history_size(VisitHistory *history) {
+    assert(history != NULL);
+    size_t size = sizeof(*history) +
+                  (size_t) history->capacity * sizeof(*history->blocks);
+    for (int i = 0; i < history->num_blocks; ++i) {
+        size += history->blocks[i].size;
+    }
+    return size;
+}
+
+/**
+ * initializes an iterator over the visits of a history that match a filter:
+ * VISITS_IN_RANGE - visits that overlap the times first_value to
+ *                   second_value, inclusive
+ * VISITS_OF_CHALLENGE - visits of the challenge with the id first_value
+ * VISITS_OF_VISITOR - visits of the visitor with the id first_value
+ * the visits are returned in the order they were appended. the history must
+ * not change while it is iterated.
+ * @param iterator - ptr to the iterator to initialize
+ * @param history - ptr to the history
+ * @param filter - the kind of the filter
+ * @param first_value - the id, or the start of the range
+ * @param second_value - the end of the range, unused by the other filters
+ * @return NULL_PARAMETER: if the ptr to iterator or history are NULL
+ *         ILLEGAL_PARAMETER: if the filter is unknown
+ *         ILLEGAL_TIME: if the range ends before it starts
+ *         OK: if everything went well
+ */
+Result init_visit_history_iterator(VisitHistoryIterator *iterator,
+                                   VisitHistory *history, VisitFilter filter,
+                                   int first_value, int second_value) {
+    assert(iterator != NULL && history != NULL);
+    if (iterator == NULL || history == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (filter < VISITS_IN_RANGE || filter > VISITS_OF_VISITOR) {
+        return ILLEGAL_PARAMETER;
+    }
+    if (filter == VISITS_IN_RANGE && second_value < first_value) {
+        return ILLEGAL_TIME;
+    }
+    iterator->history = history;
+    iterator->filter = filter;
+    iterator->first_value = first_value;
+    iterator->second_value = second_value;
+    iterator->block_idx = 0;
+    iterator->visit_idx = 0;
+    iterator->columns = NULL;
+    return OK;
+}
+
+/**
+ * returns the next visit that matches the filter of the iterator. blocks
+ * that can't hold a match by their min/max values or dictionaries are
+ * skipped without being decoded.
+ * @param iterator - ptr to the iterator
+ * @param record - the ptr to the visit that needs to be updated
+ * @return 1 if a visit was returned, 0 if there are no more visits
+ */
+int visit_history_iterator_next(VisitHistoryIterator *iterator,
+                                VisitRecord *record) {
+    assert(iterator != NULL && record != NULL);
+    VisitHistory *history = iterator->history;
+    while (1) {
+        if (iterator->columns == NULL) {
+            while (iterator->block_idx < history->num_blocks &&
+                   !block_may_match(iterator, history->blocks +
+                                              iterator->block_idx)) {
+                iterator->block_idx++;
+            }
+            if (iterator->block_idx < history->num_blocks) {
+                decode_block(history->blocks + iterator->block_idx,
+                             &iterator->decoded);
+                iterator->columns = &iterator->decoded;
+            } else if (iterator->block_idx == history->num_blocks) {
+                iterator->columns = &history->open_block;
+            } else {
+                return 0;
+            }
+            iterator->block_idx++;
+            iterator->visit_idx = 0;
+        }
+        VisitColumns *columns = iterator->columns;
+        while (iterator->visit_idx < columns->num_visits) {
+            int idx = iterator->visit_idx++;
+            if (visit_matches(iterator, idx)) {
+                record->visitor_id = columns->visitor_ids[idx];
+                record->challenge_id = columns->challenge_ids[idx];
+                record->room_id = columns->room_ids[idx];
+                record->start_time = columns->start_times[idx];
+                record->duration = columns->durations[idx];
+                return 1;
+            }
+        }
+        iterator->columns = NULL;
+    }
+}
+
+/**
+ * compresses the open block into a new sealed block and empties it.
+ * @param history - ptr to the history
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result seal_open_block(VisitHistory *history) {
+    if (history->num_blocks == history->capacity) {
+        int capacity = history->capacity == 0 ? INITIAL_CAPACITY :
+                       2 * history->capacity;
+        VisitBlock *blocks = realloc(history->blocks,
+                                     capacity * sizeof(*blocks));
+        if (blocks == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        history->blocks = blocks;
+        history->capacity = capacity;
+    }
+    VisitColumns *open_block = &history->open_block;
+    int num_visits = open_block->num_visits;
+    int dictionaries[2 * VISIT_BLOCK_SIZE];
+    int num_challenge_ids = build_dictionary(open_block->challenge_ids,
+                                             num_visits, dictionaries);
+    int num_room_ids = build_dictionary(open_block->room_ids, num_visits,
+                                        dictionaries + num_challenge_ids);
+    int width = num_challenge_ids > MAX_ONE_BYTE_CODES ||
+                num_room_ids > MAX_ONE_BYTE_CODES ? 2 : 1;
+
+    VisitBlock *block = history->blocks + history->num_blocks;
+    unsigned char data[VISIT_BLOCK_SIZE * (4 + 3 * MAX_VARINT_LEN)];
+    size_t length = put_codes(data, open_block->challenge_ids, num_visits,
+                              dictionaries, num_challenge_ids, width);
+    length += put_codes(data + length, open_block->room_ids, num_visits,
+                        dictionaries + num_challenge_ids, num_room_ids, width);
+    uint32_t previous = 0;
+    block->min_start_time = open_block->start_times[0];
+    block->max_end_time = open_block->start_times[0] +
+                          open_block->durations[0];
+    for (int i = 0; i < num_visits; ++i) {
+        uint32_t end_time = (uint32_t) open_block->start_times[i] +
+                            (uint32_t) open_block->durations[i];
+        length += put_varint(data + length, previous, end_time);
+        previous = end_time;
+        if (open_block->start_times[i] < block->min_start_time) {
+            block->min_start_time = open_block->start_times[i];
+        }
+        if ((int) end_time > block->max_end_time) {
+            block->max_end_time = (int) end_time;
+        }
+    }
+    block->durations_offset = length;
+    for (int i = 0; i < num_visits; ++i) {
+        length += put_varint(data + length, 0,
+                             (uint32_t) open_block->durations[i]);
+    }
+    block->visitor_ids_offset = length;
+    previous = 0;
+    block->min_visitor_id = open_block->visitor_ids[0];
+    block->max_visitor_id = open_block->visitor_ids[0];
+    for (int i = 0; i < num_visits; ++i) {
+        length += put_varint(data + length, previous,
+                             (uint32_t) open_block->visitor_ids[i]);
+        previous = (uint32_t) open_block->visitor_ids[i];
+        if (open_block->visitor_ids[i] < block->min_visitor_id) {
+            block->min_visitor_id = open_block->visitor_ids[i];
+        }
+        if (open_block->visitor_ids[i] > block->max_visitor_id) {
+            block->max_visitor_id = open_block->visitor_ids[i];
+        }
+    }
+
+    size_t dictionaries_size = (size_t) (num_challenge_ids + num_room_ids) *
+                               sizeof(*dictionaries);
+#ifdef ESCAPY_FIXED_CAPACITY
+    if (visit_history_size(history) + dictionaries_size + length >
+        ESCAPY_MAX_HISTORY_BYTES) {
+        return MEMORY_PROBLEM;
+    }
+#endif
+    block->dictionaries = malloc(dictionaries_size + length);
+    if (block->dictionaries == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    memcpy(block->dictionaries, dictionaries, dictionaries_size);
+    block->data = (unsigned char *) block->dictionaries + dictionaries_size;
+    memcpy(block->data, data, length);
+    block->num_visits = num_visits;
+    block->num_challenge_ids = num_challenge_ids;
+    block->num_room_ids = num_room_ids;
+    block->code_width = width;
+    block->size = sizeof(*block) + dictionaries_size + length;
+    history->num_blocks++;
+    open_block->num_visits = 0;
+    return OK;
+}
+
+/**
+ * writes the distinct ids out of an array, sorted.
+ * @param ids - the ids
+ * @param num_ids - the num of ids
+ * @param dictionary - where to write the distinct ids, room for num_ids
+ * @return the num of distinct ids
+ */
+static int build_dictionary(int *ids, int num_ids, int *dictionary) {
+    memcpy(dictionary, ids, (size_t) num_ids * sizeof(*ids));
+    qsort(dictionary, (size_t) num_ids, sizeof(*dictionary), compare_ints);
+    int size = 0;
+    for (int i = 0; i < num_ids; ++i) {
+        if (size == 0 || dictionary[size - 1] != dictionary[i]) {
+            dictionary[size++] = dictionary[i];
+        }
+    }
+    return size;
+}
+
+/**
+ * compares two ints for qsort and bsearch.
+ */
+static int compare_ints(const void *first, const void *second) {
+    int first_value = *(const int *) first;
+    int second_value = *(const int *) second;
+    return (first_value > second_value) - (first_value < second_value);
+}
+
+/**
+ * writes the codes of ids in a dictionary, little endian.
+ * @param out - where to write the codes
+ * @param ids - the ids, all of them are in the dictionary
+ * @param num_ids - the num of ids
+ * @param dictionary - the sorted dictionary
+ * @param dictionary_size - the num of ids in the dictionary
+ * @param width - the num of bytes of a code
+ * @return the num of bytes written
+ */
+static size_t put_codes(unsigned char *out, int *ids, int num_ids,
+                        int *dictionary, int dictionary_size, int width) {
+    for (int i = 0; i < num_ids; ++i) {
+        int *entry = bsearch(ids + i, dictionary, (size_t) dictionary_size,
+                             sizeof(*dictionary), compare_ints);
+        int code = (int) (entry - dictionary);
+        for (int j = 0; j < width; ++j) {
+            out[i * width + j] = (unsigned char) (code >> (8 * j));
+        }
+    }
+    return (size_t) num_ids * width;
+}
+
+/**
+ * writes the difference of a value from the previous one as a zigzag
+ * varint, so small differences of either sign take a single byte.
+ * @param out - where to write the varint
+ * @param previous - the previous value
+ * @param value - the value
+ * @return the num of bytes written
+ */
+static size_t put_varint(unsigned char *out, uint32_t previous,
+                         uint32_t value) {
+    uint32_t delta = value - previous;
+    uint32_t zigzag = (delta << 1) ^ (0u - (delta >> 31));
+    size_t length = 0;
+    while (zigzag >= 0x80) {
+        out[length++] = (unsigned char) (zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    out[length++] = (unsigned char) zigzag;
+    return length;
+}
+
+/**
+ * reads a value written by put_varint and advances the read position.
+ * @param in - ptr to the read position
+ * @param previous - the previous value
+ * @return the value
+ */
+static uint32_t get_varint(const unsigned char **in, uint32_t previous) {
+    uint32_t zigzag = 0;
+    int shift = 0;
+    while (**in & 0x80) {
+        zigzag |= (uint32_t) (**in & 0x7f) << shift;
+        shift += 7;
+        (*in)++;
+    }
+    zigzag |= (uint32_t) **in << shift;
+    (*in)++;
+    return previous + ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+}
+
+/**
+ * decodes a sealed block into columns.
+ * @param block - ptr to the block
+ * @param columns - ptr to the columns that need to be updated
+ */
+static void decode_block(VisitBlock *block, VisitColumns *columns) {
+    int num_visits = block->num_visits, width = block->code_width;
+    int *room_dictionary = block->dictionaries + block->num_challenge_ids;
+    const unsigned char *room_codes = block->data +
+                                      (size_t) num_visits * width;
+    for (int i = 0; i < num_visits; ++i) {
+        int challenge_code = block->data[i * width];
+        int room_code = room_codes[i * width];
+        if (width == 2) {
+            challenge_code |= block->data[i * width + 1] << 8;
+            room_code |= room_codes[i * width + 1] << 8;
+        }
+        columns->challenge_ids[i] = block->dictionaries[challenge_code];
+        columns->room_ids[i] = room_dictionary[room_code];
+    }
+    const unsigned char *end_times = room_codes + (size_t) num_visits * width;
+    const unsigned char *durations = block->data + block->durations_offset;
+    const unsigned char *visitor_ids = block->data +
+                                       block->visitor_ids_offset;
+    uint32_t end_time = 0, visitor_id = 0;
+    for (int i = 0; i < num_visits; ++i) {
+        end_time = get_varint(&end_times, end_time);
+        uint32_t duration = get_varint(&durations, 0);
+        visitor_id = get_varint(&visitor_ids, visitor_id);
+        columns->durations[i] = (int) duration;
+        columns->start_times[i] = (int) (end_time - duration);
+        columns->visitor_ids[i] = (int) visitor_id;
+    }
+    columns->num_visits = num_visits;
+}
+
+/**
+ * checks by the min/max values and the dictionaries of a sealed block
+ * whether it may hold a visit that matches the filter of an iterator.
+ * @param iterator - ptr to the iterator
+ * @param block - ptr to the block
+ * @return 1 if the block may hold a match, 0 otherwise
+ */
+static int block_may_match(VisitHistoryIterator *iterator, VisitBlock *block) {
+    switch (iterator->filter) {
+        case VISITS_IN_RANGE:
+            return block->min_start_time <= iterator->second_value &&
+                   block->max_end_time >= iterator->first_value;
+        case VISITS_OF_CHALLENGE:
+            return bsearch(&iterator->first_value, block->dictionaries,
+                           (size_t) block->num_challenge_ids,
+                           sizeof(*block->dictionaries), compare_ints) != NULL;
+        case VISITS_OF_VISITOR:
+            return block->min_visitor_id <= iterator->first_value &&
+                   block->max_visitor_id >= iterator->first_value;
+    }
+    return 1;
+}
+
+/**
+ * checks whether a visit of the current columns of an iterator matches its
+ * filter.
+ * @param iterator - ptr to the iterator
+ * @param visit_idx - the idx of the visit in the columns
+ * @return 1 if the visit matches, 0 otherwise
+ */
+static int visit_matches(VisitHistoryIterator *iterator, int visit_idx) {
+    VisitColumns *columns = iterator->columns;
+    switch (iterator->filter) {
+        case VISITS_IN_RANGE:
+            return columns->start_times[visit_idx] <= iterator->second_value &&
+                   columns->start_times[visit_idx] +
+                   columns->durations[visit_idx] >= iterator->first_value;
+        case VISITS_OF_CHALLENGE:
+            return columns->challenge_ids[visit_idx] == iterator->first_value;
+        case VISITS_OF_VISITOR:
+            return columns->visitor_ids[visit_idx] == iterator->first_value;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef VISIT_HISTORY_H_
+#define VISIT_HISTORY_H_
+
+#include <stddef.h>
+
+#include "constants.h"
+
+#define VISIT_BLOCK_SIZE 512
+
+/*
+ * a completed visit of a challenge. the room is identified by its id, which
+ * is not reused after the room is removed.
+ */
+typedef struct SVisitRecord
+{
+   int visitor_id;
+   int challenge_id;
+   int room_id;
+   int start_time;
+   int duration;
+} VisitRecord;
+
+
+/*
+ * up to VISIT_BLOCK_SIZE visits stored column by column, used for the block
+ * that is still being filled and for decoding a sealed block
+ */
+typedef struct SVisitColumns
+{
+   int num_visits;
+   int start_times[VISIT_BLOCK_SIZE];
+   int durations[VISIT_BLOCK_SIZE];
+   int visitor_ids[VISIT_BLOCK_SIZE];
+   int challenge_ids[VISIT_BLOCK_SIZE];
+   int room_ids[VISIT_BLOCK_SIZE];
+} VisitColumns;
+
+
+/*
+ * a sealed block of visits. the end times and the visitor ids are delta
+ * encoded and the durations are stored as they are, all as zigzag varints.
+ * the challenge and room ids are codes into sorted dictionaries of the ids
+ * of the block, code_width bytes each. the min/max fields let a scan skip
+ * the block without decoding it.
+ */
+typedef struct SVisitBlock
+{
+   int num_visits;
+   int min_start_time;
+   int max_end_time;
+   int min_visitor_id;
+   int max_visitor_id;
+   int num_challenge_ids;
+   int num_room_ids;
+   int code_width;
+   size_t durations_offset;
+   size_t visitor_ids_offset;
+   size_t size;
+   /* the challenge dictionary, then the room dictionary, then data */
+   int *dictionaries;
+   unsigned char *data;
+} VisitBlock;
+
+
+/*
+ * an append only history of the completed visits, ordered by end time
+ */
+typedef struct SVisitHistory
+{
+   VisitBlock *blocks;
+   int num_blocks;
+   int capacity;
+   VisitColumns open_block;
+   long num_visits;
+   int num_dropped;
+} VisitHistory;
+
+
+typedef enum EVisitFilter {VISITS_IN_RANGE, VISITS_OF_CHALLENGE,
+    VISITS_OF_VISITOR} VisitFilter;
+
+
+/*
+ * walks over the visits of a history that match a filter, block by block
+ */
+typedef struct SVisitHistoryIterator
+{
+   VisitHistory *history;
+   VisitFilter filter;
+   int first_value;
+   int second_value;
+   int block_idx;
+   int visit_idx;
+   VisitColumns *columns;
+   VisitColumns decoded;
+} VisitHistoryIterator;
+
+
+void init_visit_history(VisitHistory *history);
+
+Result reset_visit_history(VisitHistory *history);
+
+Result visit_history_append(VisitHistory *history, VisitRecord *record);
+
+size_t visit_history_size(VisitHistory *history);
+
+Result init_visit_history_iterator(VisitHistoryIterator *iterator, VisitHistory *history, VisitFilter filter, int first_value, int second_value);
+
+int visit_history_iterator_next(VisitHistoryIterator *iterator, VisitRecord *record);
+
+#endif // VISIT_HISTORY_H_
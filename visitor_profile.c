@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <assert.h>
+
+#include "visitor_profile.h"
+#include "fixed_alloc.h"
+
+#define INITIAL_CAPACITY 2
+
+static int find_entry(VisitorProfile *profile, int challenge_id);
+
+static size_t profile_size(int capacity);
+
+static Result grow_profile(ProfileStore *store, int visitor_id,
+                           VisitorProfile **profile);
+
+/**
+ * initializes an empty store.
+ * @param store - ptr to the store to initialize
+ * @return NULL_PARAMETER: if the ptr to store is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result init_profile_store(ProfileStore *store) {
+    assert(store != NULL);
+    if (store == NULL) {
+        return NULL_PARAMETER;
+    }
+    store->num_profiles = 0;
+    store->num_dropped = 0;
+    store->num_bytes = 0;
+    return init_id_index(&store->profiles, 0);
+}
+
+/**
+ * frees all the profiles of a store.
+ * @param store - ptr to the store
+ * @return NULL_PARAMETER: if the ptr to store is NULL
+ *         OK: if everything went well
+ */
+Result reset_profile_store(ProfileStore *store) {
+    assert(store != NULL);
+    if (store == NULL) {
+        return NULL_PARAMETER;
+    }
+    //an entry with a NULL value is an empty slot of the index
+    for (int i = 0; i < store->profiles.capacity; ++i) {
+        free(store->profiles.entries[i].value);
+    }
+    reset_id_index(&store->profiles);
+    store->num_profiles = 0;
+    store->num_bytes = 0;
+    return OK;
+}
+
+/**
+ * records a completed visit of a challenge in the profile of its visitor,
+ * the profile is created by the first visit of the visitor. a visit that
+ * can't be recorded for lack of memory is counted as dropped.
+ * @param store - ptr to the store
+ * @param visitor_id - the id of the visitor
+ * @param challenge_id - the id of the challenge
+ * @param duration - the time the visit took
+ * @return NULL_PARAMETER: if the ptr to store is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result profile_store_record(ProfileStore *store, int visitor_id,
+                            int challenge_id, int duration) {
+    assert(store != NULL);
+    if (store == NULL) {
+        return NULL_PARAMETER;
+    }
+    VisitorProfile *profile = id_index_find(&store->profiles, visitor_id);
+    int idx = profile == NULL ? 0 : find_entry(profile, challenge_id);
+    if (profile == NULL || idx == profile->num_entries ||
+        profile->entries[idx].challenge_id != challenge_id) {
+        Result result = grow_profile(store, visitor_id, &profile);
+        if (result != OK) {
+            store->num_dropped++;
+            return result;
+        }
+        memmove(profile->entries + idx + 1, profile->entries + idx,
+                (profile->num_entries - idx) * sizeof(*profile->entries));
+        profile->entries[idx].challenge_id = challenge_id;
+        profile->entries[idx].num_completions = 0;
+        profile->entries[idx].best_time = duration;
+        profile->num_entries++;
+    }
+    ProfileEntry *entry = profile->entries + idx;
+    entry->num_completions++;
+    if (duration < entry->best_time) {
+        entry->best_time = duration;
+    }
+    profile->num_visits++;
+    return OK;
+}
+
+/**
+ * finds the profile of a visitor in O(1) on average.
+ * @param store - ptr to the store
+ * @param visitor_id - the id of the visitor
+ * @return ptr to the profile, NULL if the visitor completed no visit
+ */
+VisitorProfile *profile_store_find(ProfileStore *store, int visitor_id) {
+    assert(store != NULL);
+    return id_index_find(&store->profiles, visitor_id);
+}
+
+/**
+ * finds the entry of a challenge in a profile in O(log n).
+ * @param profile - ptr to the profile
+ * @param challenge_id - the id of the challenge
+ * @return ptr to the entry, NULL if the visitor never completed the
+ *         challenge
+ */
+ProfileEntry *visitor_profile_entry(VisitorProfile *profile,
+                                    int challenge_id) {
+    assert(profile != NULL);
+    int idx = find_entry(profile, challenge_id);
+    if (idx == profile->num_entries ||
+        profile->entries[idx].challenge_id != challenge_id) {
+        return NULL;
+    }
+    return profile->entries + idx;
+}
+
+/**
+ * returns the num of bytes taken by the profiles and the index of a store.
+ * @param store - ptr to the store
+ * @return the num of bytes
+ */
+size_t profile_store_size(ProfileStore *store) {
+    assert(store != NULL);
+    return sizeof(*store) + store->num_bytes +
+           store->profiles.capacity * sizeof(IdIndexEntry);
+}
+
+/**
+ * finds where the entry of a challenge is, or should be, in a profile.
+ * @param profile - ptr to the profile
+ * @param challenge_id - the id of the challenge
+ * @return the idx of the first entry whose challenge id is not smaller
+ */
+static int find_entry(VisitorProfile *profile, int challenge_id) {
+    int low = 0, high = profile->num_entries;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (profile->entries[middle].challenge_id < challenge_id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * returns the num of bytes of a profile with room for some entries.
+ * @param capacity - the num of entries
+ * @return the num of bytes
+ */
+static size_t profile_size(int capacity) {
+    return sizeof(VisitorProfile) + capacity * sizeof(ProfileEntry);
+}
+
+/**
+ * makes room for one more entry in a profile, a NULL profile is created
+ * and added to the store. a profile that grows may move, the store is
+ * updated and so is the ptr.
+ * @param store - ptr to the store
+ * @param visitor_id - the id of the visitor of the profile
+ * @param profile - ptr to the ptr to the profile
+ * @return MEMORY_PROBLEM: if allocation problems have occurred, or the fixed
+ *                         capacity build has no room left for profiles
+ *         OK: if everything went well
+ */
+static Result grow_profile(ProfileStore *store, int visitor_id,
+                           VisitorProfile **profile) {
+    VisitorProfile *old_profile = *profile;
+    if (old_profile != NULL &&
+        old_profile->num_entries < old_profile->capacity) {
+        return OK;
+    }
+    int capacity = old_profile == NULL ? INITIAL_CAPACITY :
+                   2 * old_profile->capacity;
+    size_t old_size = old_profile == NULL ? 0 :
+                      profile_size(old_profile->capacity);
+#ifdef ESCAPY_FIXED_CAPACITY
+    if ((old_profile == NULL && store->num_profiles >= ESCAPY_MAX_PROFILES) ||
+        store->num_bytes + profile_size(capacity) > ESCAPY_MAX_PROFILE_BYTES) {
+        return MEMORY_PROBLEM;
+    }
+#endif
+    VisitorProfile *new_profile = realloc(old_profile, profile_size(capacity));
+    if (new_profile == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    if (old_profile == NULL) {
+        new_profile->visitor_id = visitor_id;
+        new_profile->num_visits = 0;
+        new_profile->num_entries = 0;
+    }
+    new_profile->capacity = capacity;
+    //replacing the value of a key that is in the index never fails
+    if (id_index_insert(&store->profiles, visitor_id, new_profile) != OK) {
+        free(new_profile);
+        return MEMORY_PROBLEM;
+    }
+    if (old_profile == NULL) {
+        store->num_profiles++;
+    }
+    store->num_bytes += profile_size(capacity) - old_size;
+    *profile = new_profile;
+    return OK;
+}
@@ -0,0 +1,61 @@
+#ifndef VISITOR_PROFILE_H_
+#define VISITOR_PROFILE_H_
+
+#include <stddef.h>
+
+#include "constants.h"
+#include "hash_index.h"
+
+/*
+ * the completions of one challenge by a visitor and the visitor's best time
+ * in it
+ */
+typedef struct SProfileEntry
+{
+   int challenge_id;
+   int num_completions;
+   int best_time;
+} ProfileEntry;
+
+
+/*
+ * the completed visits of a visitor over all of its visits to the system.
+ * the entries are sorted by challenge id and are allocated with the profile,
+ * so a profile is a single allocation that grows by doubling.
+ */
+typedef struct SVisitorProfile
+{
+   int visitor_id;
+   int num_visits;
+   int num_entries;
+   int capacity;
+   ProfileEntry entries[];
+} VisitorProfile;
+
+
+/*
+ * the profiles of the visitors by visitor id. a profile outlives the visitor
+ * record, which is destroyed when the visitor quits.
+ */
+typedef struct SProfileStore
+{
+   IdIndex profiles;
+   int num_profiles;
+   int num_dropped;
+   size_t num_bytes;
+} ProfileStore;
+
+
+Result init_profile_store(ProfileStore *store);
+
+Result reset_profile_store(ProfileStore *store);
+
+Result profile_store_record(ProfileStore *store, int visitor_id, int challenge_id, int duration);
+
+VisitorProfile *profile_store_find(ProfileStore *store, int visitor_id);
+
+ProfileEntry *visitor_profile_entry(VisitorProfile *profile, int challenge_id);
+
+size_t profile_store_size(ProfileStore *store);
+
+#endif // VISITOR_PROFILE_H_
@@ -10,36 +10,118 @@
 
 
 #include "visitor_room.h"
+#include "hash_index.h"
+#include "trace.h"
+#include "fixed_alloc.h"
 
 #define UNDEFINED -1
 
-static int find_lex_smallest(ChallengeRoom *room, Level level);
+static int find_booked_challenge(ChallengeRoom *room, Visitor *visitor,
+                                 Level level, int time);
+
+static int is_booked_by_other(ChallengeActivity *activity, int visitor_id,
+                              int time);
+
+static int find_challenge_by_id(ChallengeRoom *room, int challenge_id);
 
 static Result visitor_update_fields(ChallengeRoom *room, Visitor *visitor,
                                     int challenge_idx, int start_time);
 
+static Result dispatch_waiting_visitor(ChallengeRoom *room, int challenge_idx,
+                                       int time);
+
+static Result room_append_activity(ChallengeRoom *room);
+
+static void track_bookings(ChallengeRoom *room, ChallengeActivity *activity,
+                           int time);
+
+static void prune_bookings(ChallengeRoom *room, ChallengeActivity *activity,
+                           int time);
+
+static void drop_bookings(ChallengeRoom *room, ChallengeActivity *activity);
+
+static int compare_activity_names(const void *first, const void *second);
+
+static void rank_activity(ChallengeRoom *room, int activity_idx);
+
+static void unrank_activity(ChallengeRoom *room, int activity_idx);
+
 /**
  * initializes all the fields of a 'ChallengeActivity' data type.
- * @param activity - ptr to a data type 'challenge_activity' to initialize
+ * @param activity - ptr to a data type 'challenge_activity' to initialize,
+ *        must be one of the activities of a room created by init_room
  * @param challenge - ptr to a challenge to connect it to the activity
- *        start_time is initialized to 0, visitor is set to NULL
+ *        start_time is initialized to 0, visitor is set to NULL and the
+ *        bookings calendar is empty. the activity is added to the instances
+ *        of the challenge and to the free activities of its room, ranking
+ *        its name in the room is O(n)
  * @return NULL_PARAMETER: if the ptr to activity or challenge are NULL
  *         OK: if everything went well
  */
 Result init_challenge_activity(ChallengeActivity *activity,
                                Challenge *challenge) {
+    Result result = init_room_challenge_activity(activity, challenge);
+    if (result != OK) {
+        return result;
+    }
+    ChallengeRoom *room = room_at(activity->room);
+    if (room != NULL) {
+        rank_activity(room, activity->idx);
+        assignment_index_release(&room->assignment, activity->idx);
+    }
+    link_challenge_instance(activity);
+    return OK;
+}
+
+/**
+ * initializes an activity like init_challenge_activity, but only touches
+ * the activity and its room. the activity is not added to the instances of
+ * the challenge until link_challenge_instance, so activities of different
+ * rooms may be initialized concurrently, and it is not ranked or free in its
+ * room until rank_room_activities.
+ * @param activity - ptr to the activity, one of the activities of a room
+ * @param challenge - ptr to a challenge to connect it to the activity
+ * @return NULL_PARAMETER: if the ptr to activity or challenge are NULL
+ *         OK: if everything went well
+ */
+Result init_room_challenge_activity(ChallengeActivity *activity,
+                                    Challenge *challenge) {
     assert(activity != NULL && challenge != NULL);
     if (activity == NULL || challenge == NULL) {
         return NULL_PARAMETER;
     }
-    activity->challenge = challenge;
+    activity->challenge = challenge_link(challenge);
     activity->start_time = 0;
-    activity->visitor = NULL;
+    activity->visitor = NULL_LINK;
+    init_booking_calendar(&activity->bookings);
+    activity->last_assigned = 0;
+    activity->next_instance = NULL_LINK;
+    ChallengeRoom *room = room_at(activity->room);
+    if (room != NULL) {
+        PackedActivity *packed = room->packed + activity->idx;
+        packed->challenge_id = challenge->id;
+        packed->level = (signed char) challenge->level;
+        packed->occupied = 0;
+        packed->booked = 0;
+        room->challenge_ids_hash += id_set_hash(challenge->id);
+    }
     return OK;
 }
 
 /**
- * resets all the fields of an activity.
+ * adds an activity to the instances of its challenge.
+ * @param activity - ptr to an activity initialized with a challenge
+ */
+void link_challenge_instance(ChallengeActivity *activity) {
+    assert(activity != NULL && activity->challenge != NULL_LINK);
+    Challenge *challenge = challenge_at(activity->challenge);
+    activity->next_instance = challenge->activities;
+    challenge->activities = activity_link(activity);
+}
+
+/**
+ * resets all the fields of an activity, frees its bookings and removes it
+ * from the instances of its challenge and the free activities of its room.
  * @param activity - ptr to a data type 'ChallengeActivity' for reset
  * @return NULL_PARAMETER: if the ptr to activity are NULL
  *         OK: if everything went well
@@ -49,9 +131,32 @@ Result reset_challenge_activity(ChallengeActivity *activity) {
     if (activity == NULL) {
         return NULL_PARAMETER;
     }
-    activity->challenge = NULL;
-    activity->visitor = NULL;
+    if (activity->challenge != NULL_LINK) {
+        LINK(ChallengeActivity) *instance =
+                &challenge_at(activity->challenge)->activities;
+        while (*instance != NULL_LINK && activity_at(*instance) != activity) {
+            instance = &activity_at(*instance)->next_instance;
+        }
+        if (*instance != NULL_LINK) {
+            *instance = activity->next_instance;
+        }
+        ChallengeRoom *room = room_at(activity->room);
+        if (room != NULL) {
+            drop_bookings(room, activity);
+            assignment_index_take(&room->assignment,
+                                  activity->idx);
+            unrank_activity(room, activity->idx);
+            room->challenge_ids_hash -= id_set_hash(challenge_at(
+                    activity->challenge)->id);
+            room->packed[activity->idx].level = UNDEFINED;
+            room->packed[activity->idx].occupied = 0;
+        }
+    }
+    activity->next_instance = NULL_LINK;
+    activity->challenge = NULL_LINK;
+    activity->visitor = NULL_LINK;
     activity->start_time = 0;
+    reset_booking_calendar(&activity->bookings);
     return OK;
 }
 
@@ -77,8 +182,15 @@ Result init_visitor(Visitor *visitor, char *name, int id) {
     strcpy(visitor->visitor_name, name);
 
     visitor->visitor_id = id;
-    visitor->room_name = NULL;
-    visitor->current_challenge = NULL;
+    visitor->room_name = NULL_LINK;
+    visitor->current_challenge = NULL_LINK;
+    visitor->current_room = NULL_LINK;
+    visitor->waiting_room = NULL_LINK;
+    visitor->waiting_level = Easy;
+    visitor->waiting_since = 0;
+    visitor->next_waiting = NULL_LINK;
+    visitor->prev_waiting = NULL_LINK;
+    init_timer(&visitor->session_timer);
     return OK;
 }
 
@@ -96,8 +208,12 @@ Result reset_visitor(Visitor *visitor) {
     free(visitor->visitor_name);
     visitor->visitor_name = NULL;
     visitor->visitor_id = 0;
-    visitor->room_name = NULL;
-    visitor->current_challenge = NULL;
+    visitor->room_name = NULL_LINK;
+    visitor->current_challenge = NULL_LINK;
+    visitor->current_room = NULL_LINK;
+    visitor->waiting_room = NULL_LINK;
+    visitor->next_waiting = NULL_LINK;
+    visitor->prev_waiting = NULL_LINK;
     return OK;
 }
 
@@ -106,10 +222,12 @@ Result reset_visitor(Visitor *visitor) {
  * @param room - ptr to a data type 'ChallengeRoom' to initialize
  * @param name - allocates and duplicate the name to the room
  * @param num_challenges - value is inserted to room
- *        allocates memory for an array of the type 'ChallengeActivity'
- *        according to the num of challenges
+ *        allocates a table of 'ChallengeActivity' records and a table of
+ *        their packed fields according to the num of challenges, more may be
+ *        attached later
  * @return NULL_PARAMETER: if the ptr to room or name is NULL
- *         ILLEGAL_PARAMETER: if num_challenges is less than 1
+ *         ILLEGAL_PARAMETER: if num_challenges is negative
+ *         MEMORY_PROBLEM: if allocation problems have occurred
  *         OK: if everything went well
  */
 Result init_room(ChallengeRoom *room, char *name, int num_challenges) {
@@ -117,7 +235,7 @@ Result init_room(ChallengeRoom *room, char *name, int num_challenges) {
     if (room == NULL || name == NULL) {
         return NULL_PARAMETER;
     }
-    if (num_challenges < 1) {
+    if (num_challenges < 0) {
         return ILLEGAL_PARAMETER;
     }
 
@@ -127,25 +245,44 @@ Result init_room(ChallengeRoom *room, char *name, int num_challenges) {
     }
     strcpy(room->name, name);
 
-    room->challenges = malloc(num_challenges * sizeof(*(room->challenges)));
-    if (room->challenges == NULL) {
+    room->id = 0;
+    room->system_idx = 0;
+    room->num_of_challenges = 0;
+    room->challenge_ids_hash = 0;
+    room->challenges_capacity = num_challenges > 0 ? num_challenges : 1;
+    room->challenges = malloc(room->challenges_capacity *
+                              sizeof(*(room->challenges)));
+    room->packed = malloc(room->challenges_capacity * sizeof(*(room->packed)));
+    if (room->challenges == NULL || room->packed == NULL ||
+        init_assignment_index(&room->assignment, room->challenges,
+                              room->packed, 0) != OK) {
         //free the already allocated memory name
+        free(room->challenges);
+        room->challenges = NULL;
+        free(room->packed);
+        room->packed = NULL;
         free(room->name);
         room->name = NULL;
         return MEMORY_PROBLEM;
     }
+    for (int level = Easy; level <= All_Levels; ++level) {
+        room->wait_queues[level].head = NULL_LINK;
+        room->wait_queues[level].tail = NULL_LINK;
+        room->wait_queues[level].length = 0;
+    }
+    init_visitor_bookings(&room->visitor_bookings);
+    room->booking_timers = NULL;
     for (int i = 0; i < num_challenges; ++i) {
-        (room->challenges + i)->visitor = NULL;
-        (room->challenges + i)->challenge = NULL;
-        (room->challenges + i)->start_time = 0;
+        if (room_append_activity(room) != OK) {
+            reset_room(room);
+            return MEMORY_PROBLEM;
+        }
     }
-
-    room->num_of_challenges = num_challenges;
     return OK;
 }
 
 /**
- * resets all the fields of room, frees name & challenge activity array
+ * resets all the fields of room, frees name & challenge activities
  * previously allocated memory.
  * @param room - ptr to a data type 'ChallengeRoom' for reset
  * @return NULL_PARAMETER: if the ptr to room is NULL
@@ -160,11 +297,149 @@ Result reset_room(ChallengeRoom *room) {
     room->name = NULL;
     //loops through all the challenge activities in the room and resets them
     for (int i = 0; i < room->num_of_challenges; ++i) {
-        reset_challenge_activity(room->challenges + i);
+        //the whole room goes, so its indexes and ranks are not kept up
+        if (room->booking_timers != NULL) {
+            timer_wheel_cancel(room->booking_timers,
+                               &room->challenges[i]->booking_timer);
+        }
+        room->challenges[i]->room = NULL_LINK;
+        reset_challenge_activity(room->challenges[i]);
+        free(room->challenges[i]);
     }
+    reset_assignment_index(&room->assignment);
+    reset_visitor_bookings(&room->visitor_bookings);
     free(room->challenges);
     room->challenges = NULL;
+    free(room->packed);
+    room->packed = NULL;
     room->num_of_challenges = 0;
+    room->challenges_capacity = 0;
+    return OK;
+}
+
+/**
+ * attaches a challenge to a room at runtime, as a new activity at the end of
+ * the activities table of the room. the table doubles when it is full and
+ * the activities themselves are never moved. ranking the name of the
+ * challenge in the room is O(n).
+ * @param room - ptr to the room
+ * @param challenge - ptr to the challenge
+ * @return NULL_PARAMETER: if the ptr to room or challenge are NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result room_attach_challenge(ChallengeRoom *room, Challenge *challenge) {
+    assert(room != NULL && challenge != NULL);
+    if (room == NULL || challenge == NULL) {
+        return NULL_PARAMETER;
+    }
+    Result result = room_append_activity(room);
+    if (result != OK) {
+        return result;
+    }
+    ChallengeActivity *activity = room->challenges[room->num_of_challenges - 1];
+    return init_challenge_activity(activity, challenge);
+}
+
+/**
+ * ranks the names of the challenges of all the activities of a room at once
+ * by sorting them, and adds the free activities to the assignment index of
+ * the room. should be used once the activities of a new room were
+ * initialized by init_room_challenge_activity, so building a room is
+ * O(n log n).
+ * @param room - ptr to the room
+ * @return NULL_PARAMETER: if the ptr to room is NULL
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result rank_room_activities(ChallengeRoom *room) {
+    assert(room != NULL);
+    if (room == NULL) {
+        return NULL_PARAMETER;
+    }
+    ChallengeActivity **sorted = malloc(room->challenges_capacity *
+                                        sizeof(*sorted));
+    if (sorted == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    int num_sorted = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        if (room->packed[i].level != UNDEFINED) {
+            sorted[num_sorted++] = room->challenges[i];
+        }
+    }
+    qsort(sorted, num_sorted, sizeof(*sorted), compare_activity_names);
+    for (int i = 0; i < num_sorted; ++i) {
+        //equal names share the rank of the first of them
+        PackedActivity *packed = room->packed + sorted[i]->idx;
+        packed->name_rank = i;
+        if (i > 0 && compare_activity_names(sorted + i - 1, sorted + i) == 0) {
+            packed->name_rank = room->packed[sorted[i - 1]->idx].name_rank;
+        }
+    }
+    free(sorted);
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        if (!room->packed[i].occupied) {
+            assignment_index_release(&room->assignment, i);
+        }
+    }
+    return OK;
+}
+
+/**
+ * detaches a free activity of a challenge from a room at runtime. its
+ * bookings are cancelled and the last activity of the room takes its idx.
+ * @param room - ptr to the room
+ * @param challenge_id - the id of the challenge
+ * @return NULL_PARAMETER: if the ptr to room is NULL
+ *         ILLEGAL_PARAMETER: if the challenge is not in the room
+ *         ALREADY_IN_ROOM: if all the activities of the challenge in the
+ *                          room are occupied by visitors
+ *         OK: if everything went well
+ */
+Result room_detach_challenge(ChallengeRoom *room, int challenge_id) {
+    assert(room != NULL);
+    if (room == NULL) {
+        return NULL_PARAMETER;
+    }
+    Result result = ILLEGAL_PARAMETER;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        if (room->packed[i].level != UNDEFINED &&
+            room->packed[i].challenge_id == challenge_id) {
+            result = room_detach_activity(room->challenges[i]);
+            if (result == OK) {
+                return OK;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * detaches a free activity from its room, see room_detach_challenge.
+ * @param activity - ptr to the activity, one of the activities of a room
+ * @return NULL_PARAMETER: if the ptr to activity is NULL
+ *         ALREADY_IN_ROOM: if a visitor is in the activity
+ *         OK: if everything went well
+ */
+Result room_detach_activity(ChallengeActivity *activity) {
+    assert(activity != NULL);
+    if (activity == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (activity->visitor != NULL_LINK) {
+        return ALREADY_IN_ROOM;
+    }
+    ChallengeRoom *room = room_at(activity->room);
+    int idx = activity->idx;
+    reset_challenge_activity(activity);
+    assignment_index_remove(&room->assignment, idx);
+    ChallengeActivity *last = room->challenges[room->num_of_challenges - 1];
+    room->challenges[idx] = last;
+    room->packed[idx] = room->packed[room->num_of_challenges - 1];
+    last->idx = idx;
+    room->num_of_challenges--;
+    free(activity);
     return OK;
 }
 
@@ -182,27 +457,8 @@ Result num_of_free_places_for_level(ChallengeRoom *room, Level level,
     if (room == NULL || places == NULL) {
         return NULL_PARAMETER;
     }
-    int count = 0;
-    //if the level is All_Levels returns the num of challenges in the room
-    if (level == All_Levels) {
-        for (int i = 0; i < room->num_of_challenges; ++i) {
-            //checks that the room is empty
-            if ((room->challenges + i)->visitor == NULL) {
-                count++;
-            }
-        }
-        *places = count;
-        return OK;
-    }
-
-    for (int i = 0; i < room->num_of_challenges; ++i) {
-        //checks the challenge's level & that the room is empty
-        if ((room->challenges + i)->challenge->level == level
-            && (room->challenges + i)->visitor == NULL) {
-            count++;
-        }
-    }
-    *places = count;
+    //the free activities are exactly the ones in the assignment index
+    *places = assignment_index_num_free(&room->assignment, level);
     return OK;
 }
 
@@ -245,40 +501,114 @@ Result room_of_visitor(Visitor *visitor, char **room_name) {
     if (room_name == NULL || visitor == NULL) {
         return NULL_PARAMETER;
     }
-    if (visitor->room_name == NULL) {
+    if (visitor->room_name == NULL_LINK) {
         return NOT_IN_ROOM;
     }
-    *room_name = malloc(strlen(*(visitor->room_name)) + 1);
+    *room_name = malloc(strlen(*room_name_at(visitor->room_name)) + 1);
     if (*room_name == NULL) {
         return MEMORY_PROBLEM;
     }
-    strcpy(*room_name, *(visitor->room_name));
+    strcpy(*room_name, *room_name_at(visitor->room_name));
     return OK;
 }
 
 /**
- * finds the smallest lexicographically challenge that matches the required
- * level and non taken.
+ * changes the rule by which the room chooses challenges for visitors.
  * @param room - ptr to the room
- * @param level - wanted level of challenge
- * @return the idx of the challenge
+ * @param policy - the wanted policy
+ * @return NULL_PARAMETER: if the ptr to room is NULL
+ *         ILLEGAL_PARAMETER: if the policy is not one of AssignmentPolicy
+ *         OK: if everything went well
  */
-static int find_lex_smallest(ChallengeRoom *room, Level level) {
+Result set_room_assignment_policy(ChallengeRoom *room,
+                                  AssignmentPolicy policy) {
     assert(room != NULL);
-    int challenge_idx = UNDEFINED;
-    for (int i = 0; i < room->num_of_challenges; ++i) {
-        if ((level == All_Levels ||
-             room->challenges[i].challenge->level == level) &&
-            room->challenges[i].visitor == NULL) {
-
-            if (challenge_idx == UNDEFINED ||
-                strcmp(room->challenges[i].challenge->name,
-                       room->challenges[challenge_idx].challenge->name) < 0) {
-                challenge_idx = i;
-            }
+    if (room == NULL) {
+        return NULL_PARAMETER;
+    }
+    return assignment_index_set_policy(&room->assignment, policy);
+}
+
+/**
+ * reorders the free activities of a challenge in the assignment indexes of
+ * all the rooms, should be used after the name, best time or num of visits
+ * of the challenge changed.
+ * @param challenge - ptr to the challenge
+ * @return NULL_PARAMETER: if the ptr to challenge is NULL
+ *         OK: if everything went well
+ */
+Result refresh_challenge_activities(Challenge *challenge) {
+    assert(challenge != NULL);
+    if (challenge == NULL) {
+        return NULL_PARAMETER;
+    }
+    for (ChallengeActivity *activity = activity_at(challenge->activities);
+         activity != NULL; activity = activity_at(activity->next_instance)) {
+        ChallengeRoom *room = room_at(activity->room);
+        assignment_index_update(&room->assignment,
+                                activity->idx);
+    }
+    return OK;
+}
+
+/**
+ * ranks the new name of a challenge in all the rooms and reorders its free
+ * activities in their assignment indexes, should be used after the name of
+ * the challenge changed. this is O(n) in each room of the challenge.
+ * @param challenge - ptr to the challenge
+ * @return NULL_PARAMETER: if the ptr to challenge is NULL
+ *         OK: if everything went well
+ */
+Result rename_challenge_activities(Challenge *challenge) {
+    assert(challenge != NULL);
+    if (challenge == NULL) {
+        return NULL_PARAMETER;
+    }
+    //all the activities are unranked first, a room may have a few of them
+    for (ChallengeActivity *activity = activity_at(challenge->activities);
+         activity != NULL; activity = activity_at(activity->next_instance)) {
+        unrank_activity(room_at(activity->room), activity->idx);
+    }
+    for (ChallengeActivity *activity = activity_at(challenge->activities);
+         activity != NULL; activity = activity_at(activity->next_instance)) {
+        rank_activity(room_at(activity->room), activity->idx);
+    }
+    return refresh_challenge_activities(challenge);
+}
+
+/**
+ * changes the level of a challenge and moves its free activities to the
+ * free activities of the new level in the assignment indexes of all the
+ * rooms. an occupied activity gets the new level when it is freed.
+ * @param challenge - ptr to the challenge
+ * @param level - the new level of the challenge
+ * @return NULL_PARAMETER: if the ptr to challenge is NULL
+ *         ILLEGAL_PARAMETER: if level is not one of Easy, Medium and Hard
+ *         OK: if everything went well
+ */
+Result change_challenge_level(Challenge *challenge, Level level) {
+    assert(challenge != NULL);
+    if (challenge == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (level < Easy || level >= All_Levels) {
+        return ILLEGAL_PARAMETER;
+    }
+    for (ChallengeActivity *activity = activity_at(challenge->activities);
+         activity != NULL; activity = activity_at(activity->next_instance)) {
+        assignment_index_withdraw(&room_at(activity->room)->assignment,
+                                  activity->idx);
+    }
+    challenge->level = level;
+    for (ChallengeActivity *activity = activity_at(challenge->activities);
+         activity != NULL; activity = activity_at(activity->next_instance)) {
+        ChallengeRoom *room = room_at(activity->room);
+        room->packed[activity->idx].level = (signed char) level;
+        if (activity->visitor == NULL_LINK) {
+            assignment_index_release(&room->assignment, activity->idx);
         }
     }
-    return challenge_idx;
+    return OK;
 }
 
 /**
@@ -294,20 +624,32 @@ static Result visitor_update_fields(ChallengeRoom *room, Visitor *visitor,
                                     int challenge_idx, int start_time) {
     assert(room != NULL && visitor != NULL);
     //updates the room_name field in the visitor
-    visitor->room_name = &(room->name);
+    visitor->room_name = room_name_link(&(room->name));
+    visitor->current_room = room_link(room);
     //updates the chosen ChallengeActivity in the room
-    room->challenges[challenge_idx].visitor = visitor;
-    room->challenges[challenge_idx].start_time = start_time;
+    room->challenges[challenge_idx]->visitor = visitor_link(visitor);
+    room->challenges[challenge_idx]->start_time = start_time;
+    room->packed[challenge_idx].occupied = 1;
+    assignment_index_take(&room->assignment, challenge_idx);
+    //time only moves forward so bookings that already ended can be dropped
+    prune_bookings(room, room->challenges[challenge_idx], start_time);
     //connecting the ChallengeActivity ptr to the Visitor
-    visitor->current_challenge = &(room->challenges[challenge_idx]);
+    visitor->current_challenge =
+            activity_link(room->challenges[challenge_idx]);
     //increase the num of visits for the Challenge
-    return inc_num_visits(visitor->current_challenge->challenge);
+    Challenge *challenge =
+            challenge_at(room->challenges[challenge_idx]->challenge);
+    Result result = inc_num_visits(challenge);
+    if (result != OK) {
+        return result;
+    }
+    return refresh_challenge_activities(challenge);
 }
 
 /**
  * answers the request of a visitor to enter a room, the chosen challenge
- * will be the lexicographically named smaller, available and matching the
- * wanted level one.
+ * will be the first available one matching the wanted level by the
+ * assignment policy of the room.
  * @param room - ptr to the room
  * @param visitor - ptr to the visitor
  * @param level - wanted level of challenge
@@ -324,21 +666,25 @@ Result visitor_enter_room(ChallengeRoom *room, Visitor *visitor, Level level,
     if (room == NULL || visitor == NULL) {
         return NULL_PARAMETER;
     }
-    if (visitor->room_name != NULL) {
+    if (visitor->room_name != NULL_LINK || visitor->waiting_room != NULL_LINK) {
         return ALREADY_IN_ROOM;
     }
-    int matching_challenges = 0;
-    num_of_free_places_for_level(room, level, &matching_challenges);
-    if (matching_challenges == 0) {
-        return NO_AVAILABLE_CHALLENGES;
+    TRACE_BEGIN(visitor_enter_room);
+    int challenge_idx = find_booked_challenge(room, visitor, level,
+                                              start_time);
+    if (challenge_idx == UNDEFINED) {
+        challenge_idx = assignment_index_choose(&room->assignment, level);
     }
-    int challenge_idx = find_lex_smallest(room, level);
-
-    return visitor_update_fields(room, visitor, challenge_idx, start_time);
+    Result result = challenge_idx == UNDEFINED ? NO_AVAILABLE_CHALLENGES :
+                    visitor_update_fields(room, visitor, challenge_idx,
+                                          start_time);
+    TRACE_END(visitor_enter_room);
+    return result;
 }
 
 /**
- * updates all the fields when a visitor is quiting a room
+ * updates all the fields when a visitor is quiting a room, if visitors are
+ * waiting in the room for the freed challenge the first of them enters it
  * @param visitor - ptr to the visitor
  * @param quit_time - the time in which the visitor has left
  * @return NULL_PARAMETER: if the ptr to visitor is NULL
@@ -349,22 +695,591 @@ Result visitor_quit_room(Visitor *visitor, int quit_time) {
     if (visitor == NULL) {
         return NULL_PARAMETER;
     }
-    if (visitor->room_name == NULL) {
+    if (visitor->room_name == NULL_LINK) {
         return NOT_IN_ROOM;
     }
+    TRACE_BEGIN(visitor_quit_room);
+    ChallengeActivity *activity = activity_at(visitor->current_challenge);
+    Challenge *challenge = challenge_at(activity->challenge);
     //calculates the total time that took the visitor to finish the challenge
-    int visitor_total_time = quit_time -
-                             (visitor->current_challenge->start_time);
+    int visitor_total_time = quit_time - (activity->start_time);
 
     //update the best time in the Challenge
-    Result result = set_best_time_of_challenge
-            (visitor->current_challenge->challenge, visitor_total_time);
+    Result result = set_best_time_of_challenge(challenge, visitor_total_time);
     if (result != OK && result != ILLEGAL_PARAMETER) {
+        TRACE_END(visitor_quit_room);
         return result;
     }
-    visitor->current_challenge->visitor = NULL;
-    visitor->current_challenge->start_time = 0;
-    visitor->current_challenge = NULL;
-    visitor->room_name = NULL;
+    ChallengeRoom *room = room_at(visitor->current_room);
+    int challenge_idx = activity->idx;
+    activity->visitor = NULL_LINK;
+    activity->start_time = 0;
+    room->packed[challenge_idx].occupied = 0;
+    visitor->current_challenge = NULL_LINK;
+    visitor->current_room = NULL_LINK;
+    visitor->room_name = NULL_LINK;
+    assignment_index_release(&room->assignment, challenge_idx);
+    //the best time may have changed
+    refresh_challenge_activities(challenge);
+    result = dispatch_waiting_visitor(room, challenge_idx, quit_time);
+    TRACE_END(visitor_quit_room);
+    return result;
+}
+
+/**
+ * puts a visitor at the end of the queue of a room for a challenge level,
+ * should be used when the room has no available challenge of that level.
+ * @param room - ptr to the room
+ * @param visitor - ptr to the visitor
+ * @param level - wanted level of challenge
+ * @param time - the time that the visitor arrived
+ * @return NULL_PARAMETER: if the ptr to room or visitor are NULL
+ *         ALREADY_IN_ROOM: if the visitor is already in a room or a queue
+ *         OK: if everything went well
+ */
+Result visitor_wait_for_room(ChallengeRoom *room, Visitor *visitor,
+                             Level level, int time) {
+    assert(room != NULL && visitor != NULL);
+    if (room == NULL || visitor == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (visitor->room_name != NULL_LINK || visitor->waiting_room != NULL_LINK) {
+        return ALREADY_IN_ROOM;
+    }
+    WaitQueue *queue = room->wait_queues + level;
+    visitor->waiting_room = room_link(room);
+    visitor->waiting_level = level;
+    visitor->waiting_since = time;
+    visitor->next_waiting = NULL_LINK;
+    visitor->prev_waiting = queue->tail;
+    if (queue->tail == NULL_LINK) {
+        queue->head = visitor_link(visitor);
+    } else {
+        visitor_at(queue->tail)->next_waiting = visitor_link(visitor);
+    }
+    queue->tail = visitor_link(visitor);
+    queue->length++;
+    return OK;
+}
+
+/**
+ * removes a visitor from the queue it is waiting in.
+ * @param visitor - ptr to the visitor
+ * @return NULL_PARAMETER: if the ptr to visitor is NULL
+ *         NOT_IN_ROOM: if the visitor is not waiting in any queue
+ *         OK: if everything went well
+ */
+Result visitor_leave_wait_queue(Visitor *visitor) {
+    assert(visitor != NULL);
+    if (visitor == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (visitor->waiting_room == NULL_LINK) {
+        return NOT_IN_ROOM;
+    }
+    WaitQueue *queue = room_at(visitor->waiting_room)->wait_queues +
+                       visitor->waiting_level;
+    if (visitor->prev_waiting == NULL_LINK) {
+        queue->head = visitor->next_waiting;
+    } else {
+        visitor_at(visitor->prev_waiting)->next_waiting =
+                visitor->next_waiting;
+    }
+    if (visitor->next_waiting == NULL_LINK) {
+        queue->tail = visitor->prev_waiting;
+    } else {
+        visitor_at(visitor->next_waiting)->prev_waiting =
+                visitor->prev_waiting;
+    }
+    queue->length--;
+    visitor->waiting_room = NULL_LINK;
+    visitor->next_waiting = NULL_LINK;
+    visitor->prev_waiting = NULL_LINK;
     return OK;
-}
\ No newline at end of file
+}
+
+/**
+ * returns the num of visitors waiting in a room for a challenge level.
+ * @param room - ptr to the room
+ * @param level - the level of the queue, All_Levels is the queue of the
+ *                visitors that accept any level
+ * @param length - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to room or length are NULL
+ *         OK: if everything went well
+ */
+Result room_wait_queue_length(ChallengeRoom *room, Level level, int *length) {
+    assert(room != NULL && length != NULL);
+    if (room == NULL || length == NULL) {
+        return NULL_PARAMETER;
+    }
+    *length = room->wait_queues[level].length;
+    return OK;
+}
+
+/**
+ * returns for how long a visitor has been waiting in a queue.
+ * @param visitor - ptr to the visitor
+ * @param time - the current time
+ * @param wait_time - the ptr that needs to be updated
+ * @return NULL_PARAMETER: if the ptr to visitor or wait_time are NULL
+ *         NOT_IN_ROOM: if the visitor is not waiting in any queue
+ *         OK: if everything went well
+ */
+Result visitor_wait_time(Visitor *visitor, int time, int *wait_time) {
+    assert(visitor != NULL && wait_time != NULL);
+    if (visitor == NULL || wait_time == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (visitor->waiting_room == NULL_LINK) {
+        return NOT_IN_ROOM;
+    }
+    *wait_time = time - visitor->waiting_since;
+    return OK;
+}
+
+/**
+ * gives a freed challenge to the visitor that waits the longest for it, out
+ * of the heads of the queue of its level and of the queue for any level.
+ * @param room - ptr to the room
+ * @param challenge_idx - the idx of the freed challenge
+ * @param time - the time that the challenge was freed
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result dispatch_waiting_visitor(ChallengeRoom *room, int challenge_idx,
+                                       int time) {
+    assert(room != NULL);
+    ChallengeActivity *activity = room->challenges[challenge_idx];
+    Level level = (Level) room->packed[challenge_idx].level;
+    Visitor *level_head = visitor_at(room->wait_queues[level].head);
+    Visitor *any_head = visitor_at(room->wait_queues[All_Levels].head);
+    Visitor *next = level_head;
+    if (next == NULL || (any_head != NULL &&
+                         any_head->waiting_since < next->waiting_since)) {
+        next = any_head;
+    }
+    if (next == NULL || is_booked_by_other(activity, next->visitor_id, time)) {
+        return OK;
+    }
+    visitor_leave_wait_queue(next);
+    return visitor_update_fields(room, next, challenge_idx, time);
+}
+
+/**
+ * initializes an iterator over the visitors that are currently in a room.
+ * @param iterator - ptr to the iterator to initialize
+ * @param room - ptr to the room
+ * @return NULL_PARAMETER: if the ptr to iterator or room are NULL
+ *         OK: if everything went well
+ */
+Result init_room_occupant_iterator(RoomOccupantIterator *iterator,
+                                   ChallengeRoom *room) {
+    assert(iterator != NULL && room != NULL);
+    if (iterator == NULL || room == NULL) {
+        return NULL_PARAMETER;
+    }
+    iterator->room = room;
+    iterator->activity_idx = 0;
+    return OK;
+}
+
+/**
+ * returns the next occupied challenge activity of the room, the visitor in it
+ * may quit the room before the next call.
+ * @param iterator - ptr to the iterator
+ * @return the next occupied activity, NULL if there are no more occupants
+ */
+ChallengeActivity *room_occupant_iterator_next(RoomOccupantIterator *iterator) {
+    assert(iterator != NULL);
+    ChallengeRoom *room = iterator->room;
+    while (iterator->activity_idx < room->num_of_challenges) {
+        int idx = iterator->activity_idx++;
+        if (room->packed[idx].occupied) {
+            return room->challenges[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * books a challenge of a room for a visitor in the window [start, end). while
+ * the window is open the challenge is kept out of the free activities of the
+ * room, from the time the wheel of the room reaches its start.
+ * @param room - ptr to the room
+ * @param challenge_id - the id of the challenge to book
+ * @param visitor_id - the id of the visitor
+ * @param start_time - the time the window starts
+ * @param end_time - the time the window ends
+ * @return NULL_PARAMETER: if the ptr to room is NULL
+ *         ILLEGAL_PARAMETER: if the challenge is not in the room
+ *         ILLEGAL_TIME: if end_time is not greater than start_time
+ *         NO_AVAILABLE_CHALLENGES: if the window overlaps another booking
+ *         MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+Result room_book_challenge(ChallengeRoom *room, int challenge_id,
+                           int visitor_id, int start_time, int end_time) {
+    assert(room != NULL);
+    if (room == NULL) {
+        return NULL_PARAMETER;
+    }
+    int challenge_idx = find_challenge_by_id(room, challenge_id);
+    if (challenge_idx == UNDEFINED) {
+        return ILLEGAL_PARAMETER;
+    }
+    ChallengeActivity *activity = room->challenges[challenge_idx];
+    Result result = booking_calendar_add(&activity->bookings, start_time,
+                                         end_time, visitor_id);
+    if (result != OK) {
+        return result;
+    }
+    if (visitor_bookings_add(&room->visitor_bookings, visitor_id, start_time,
+                             end_time, activity_link(activity)) != OK) {
+        booking_calendar_remove(&activity->bookings, start_time);
+        return MEMORY_PROBLEM;
+    }
+    if (room->booking_timers != NULL) {
+        track_bookings(room, activity, room->booking_timers->now);
+    }
+    return OK;
+}
+
+/**
+ * cancels the booking of a challenge of a room that starts at a given time.
+ * @param room - ptr to the room
+ * @param challenge_id - the id of the booked challenge
+ * @param start_time - the time the booking starts
+ * @return NULL_PARAMETER: if the ptr to room is NULL
+ *         ILLEGAL_PARAMETER: if the challenge is not in the room or there is
+ *                            no such booking
+ *         OK: if everything went well
+ */
+Result room_cancel_booking(ChallengeRoom *room, int challenge_id,
+                           int start_time) {
+    assert(room != NULL);
+    if (room == NULL) {
+        return NULL_PARAMETER;
+    }
+    int challenge_idx = find_challenge_by_id(room, challenge_id);
+    if (challenge_idx == UNDEFINED) {
+        return ILLEGAL_PARAMETER;
+    }
+    ChallengeActivity *activity = room->challenges[challenge_idx];
+    Booking *booking = booking_calendar_at(&activity->bookings, start_time);
+    if (booking == NULL || booking->start_time != start_time) {
+        return ILLEGAL_PARAMETER;
+    }
+    visitor_bookings_remove(&room->visitor_bookings, booking->visitor_id,
+                            start_time, activity_link(activity));
+    booking_calendar_remove(&activity->bookings, start_time);
+    if (room->booking_timers != NULL) {
+        track_bookings(room, activity, room->booking_timers->now);
+    }
+    return OK;
+}
+
+/**
+ * passes the time at which the booking timer of an activity expired, a
+ * booking window of the activity started or ended then.
+ * @param activity - ptr to the activity, one of the activities of a room
+ * @param time - the expiry of the timer
+ */
+void room_pass_booking_boundary(ChallengeActivity *activity, int time) {
+    assert(activity != NULL);
+    track_bookings(room_at(activity->room), activity, time);
+}
+
+/**
+ * finds the earliest window of a given length, starting at after_time or
+ * later, in which a challenge of the level is not booked. out of challenges
+ * that are free at the same time the lexicographically smallest is chosen.
+ * @param room - ptr to the room
+ * @param level - wanted level of challenge
+ * @param after_time - the earliest time the window may start
+ * @param duration - the length of the window
+ * @param slot_time - the ptr to the start of the window that needs to be
+ *                    updated
+ * @param challenge_idx - the ptr to the idx of the challenge that needs to be
+ *                        updated
+ * @return NULL_PARAMETER: if the ptr to room, slot_time or challenge_idx are
+ *                         NULL
+ *         ILLEGAL_PARAMETER: if duration is not positive
+ *         NO_AVAILABLE_CHALLENGES: if there are no challenges of the level
+ *         OK: if everything went well
+ */
+Result room_first_free_slot(ChallengeRoom *room, Level level, int after_time,
+                            int duration, int *slot_time,
+                            int *challenge_idx) {
+    assert(room != NULL && slot_time != NULL && challenge_idx != NULL);
+    if (room == NULL || slot_time == NULL || challenge_idx == NULL) {
+        return NULL_PARAMETER;
+    }
+    if (duration <= 0) {
+        return ILLEGAL_PARAMETER;
+    }
+    int best_idx = UNDEFINED, best_time = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        PackedActivity *packed = room->packed + i;
+        if (packed->level == UNDEFINED ||
+            (level != All_Levels && packed->level != level)) {
+            continue;
+        }
+        int time = booking_calendar_first_free(&room->challenges[i]->bookings,
+                                               after_time, duration);
+        if (best_idx == UNDEFINED || time < best_time ||
+            (time == best_time &&
+             packed->name_rank < room->packed[best_idx].name_rank)) {
+            best_idx = i;
+            best_time = time;
+        }
+    }
+    if (best_idx == UNDEFINED) {
+        return NO_AVAILABLE_CHALLENGES;
+    }
+    *slot_time = best_time;
+    *challenge_idx = best_idx;
+    return OK;
+}
+
+/**
+ * finds a free challenge of the level that the visitor booked for the time,
+ * out of the bookings of the visitor in the room that started by then.
+ * @param room - ptr to the room
+ * @param visitor - ptr to the visitor
+ * @param level - wanted level of challenge
+ * @param time - the time the visitor arrived
+ * @return the idx of the challenge, UNDEFINED if there is none
+ */
+static int find_booked_challenge(ChallengeRoom *room, Visitor *visitor,
+                                 Level level, int time) {
+    assert(room != NULL && visitor != NULL);
+    VisitorBookings *index = &room->visitor_bookings;
+    VisitorBooking *bookings = visitor_booking_at(index->bookings);
+    for (int i = visitor_bookings_first(index, visitor->visitor_id);
+         i < index->num_bookings &&
+         bookings[i].visitor_id == visitor->visitor_id &&
+         bookings[i].start_time <= time; ++i) {
+        if (bookings[i].end_time <= time) {
+            continue;
+        }
+        int idx = activity_at(bookings[i].activity)->idx;
+        PackedActivity *packed = room->packed + idx;
+        if ((level == All_Levels || packed->level == level) &&
+            !packed->occupied) {
+            return idx;
+        }
+    }
+    return UNDEFINED;
+}
+
+/**
+ * checks whether an activity is booked at a time by a different visitor.
+ * @param activity - ptr to the activity
+ * @param visitor_id - the id of the visitor that wants the activity
+ * @param time - the wanted time
+ * @return 1 if the activity is booked by someone else, 0 otherwise
+ */
+static int is_booked_by_other(ChallengeActivity *activity, int visitor_id,
+                              int time) {
+    Booking *booking = booking_calendar_at(&activity->bookings, time);
+    return booking != NULL && booking->visitor_id != visitor_id;
+}
+
+/**
+ * finds the activity of a challenge in a room by the challenge id.
+ * @param room - ptr to the room
+ * @param challenge_id - the id of the challenge
+ * @return the idx of the activity, UNDEFINED if the challenge is not in the
+ *         room
+ */
+static int find_challenge_by_id(ChallengeRoom *room, int challenge_id) {
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        if (room->packed[i].level != UNDEFINED &&
+            room->packed[i].challenge_id == challenge_id) {
+            return i;
+        }
+    }
+    return UNDEFINED;
+}
+
+/**
+ * appends an activity without a challenge to the activities tables of a
+ * room, doubling the tables and the assignment index when they are full.
+ * @param room - ptr to the room
+ * @return MEMORY_PROBLEM: if allocation problems have occurred
+ *         OK: if everything went well
+ */
+static Result room_append_activity(ChallengeRoom *room) {
+    assert(room != NULL);
+    if (room->num_of_challenges == room->challenges_capacity) {
+        int capacity = 2 * room->challenges_capacity;
+        ChallengeActivity **challenges = realloc(room->challenges,
+                                                 capacity *
+                                                 sizeof(*challenges));
+        if (challenges == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        room->challenges = challenges;
+        PackedActivity *packed = realloc(room->packed,
+                                         capacity * sizeof(*packed));
+        if (packed == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        room->packed = packed;
+        room->challenges_capacity = capacity;
+    }
+    //the tables may have moved even if the index has room
+    if (assignment_index_reserve(&room->assignment, room->challenges,
+                                 room->packed,
+                                 room->challenges_capacity) != OK) {
+        return MEMORY_PROBLEM;
+    }
+    ChallengeActivity *activity = malloc(sizeof(*activity));
+    if (activity == NULL) {
+        return MEMORY_PROBLEM;
+    }
+    activity->visitor = NULL_LINK;
+    activity->challenge = NULL_LINK;
+    activity->start_time = 0;
+    init_booking_calendar(&activity->bookings);
+    activity->room = room_link(room);
+    activity->next_instance = NULL_LINK;
+    activity->last_assigned = 0;
+    init_timer(&activity->booking_timer);
+    activity->idx = room->num_of_challenges;
+    room->challenges[room->num_of_challenges] = activity;
+    room->packed[activity->idx].challenge_id = 0;
+    room->packed[activity->idx].name_rank = UNDEFINED;
+    room->packed[activity->idx].level = UNDEFINED;
+    room->packed[activity->idx].occupied = 0;
+    room->packed[activity->idx].booked = 0;
+    room->num_of_challenges++;
+    assignment_index_append(&room->assignment);
+    return OK;
+}
+
+/**
+ * marks whether a booking window of an activity is open at a time, taking it
+ * out of the free activities of its room while it is, and sets its booking
+ * timer to the next time a window starts or ends.
+ * @param room - ptr to the room of the activity
+ * @param activity - ptr to the activity
+ * @param time - the time
+ */
+static void track_bookings(ChallengeRoom *room, ChallengeActivity *activity,
+                           int time) {
+    PackedActivity *packed = room->packed + activity->idx;
+    Booking *booking = booking_calendar_next(&activity->bookings, time);
+    packed->booked = booking != NULL && booking->start_time <= time;
+    if (packed->booked) {
+        assignment_index_withdraw(&room->assignment, activity->idx);
+    } else if (!packed->occupied) {
+        assignment_index_release(&room->assignment, activity->idx);
+    }
+    if (room->booking_timers == NULL) {
+        return;
+    }
+    if (booking == NULL) {
+        timer_wheel_cancel(room->booking_timers, &activity->booking_timer);
+    } else {
+        timer_wheel_schedule(room->booking_timers, &activity->booking_timer,
+                             packed->booked ? booking->end_time :
+                             booking->start_time);
+    }
+}
+
+/**
+ * removes the bookings of an activity that ended by a time from its calendar
+ * and from the visitor bookings of its room.
+ * @param room - ptr to the room of the activity
+ * @param activity - ptr to the activity
+ * @param time - the current time
+ */
+static void prune_bookings(ChallengeRoom *room, ChallengeActivity *activity,
+                           int time) {
+    Booking *bookings = booking_at(activity->bookings.bookings);
+    for (int i = 0; i < activity->bookings.num_bookings &&
+                    bookings[i].end_time <= time; ++i) {
+        visitor_bookings_remove(&room->visitor_bookings,
+                                bookings[i].visitor_id,
+                                bookings[i].start_time,
+                                activity_link(activity));
+    }
+    booking_calendar_prune(&activity->bookings, time);
+}
+
+/**
+ * removes all the bookings of an activity that leaves its room from the
+ * visitor bookings of the room and stops its booking timer.
+ * @param room - ptr to the room of the activity
+ * @param activity - ptr to the activity
+ */
+static void drop_bookings(ChallengeRoom *room, ChallengeActivity *activity) {
+    Booking *bookings = booking_at(activity->bookings.bookings);
+    for (int i = 0; i < activity->bookings.num_bookings; ++i) {
+        visitor_bookings_remove(&room->visitor_bookings,
+                                bookings[i].visitor_id,
+                                bookings[i].start_time,
+                                activity_link(activity));
+    }
+    if (room->booking_timers != NULL) {
+        timer_wheel_cancel(room->booking_timers, &activity->booking_timer);
+    }
+    room->packed[activity->idx].booked = 0;
+}
+
+/**
+ * compares the names of the challenges of two activities for qsort.
+ * @param first - ptr to the ptr to the first activity
+ * @param second - ptr to the ptr to the second activity
+ * @return negative, 0 or positive as strcmp of the names
+ */
+static int compare_activity_names(const void *first, const void *second) {
+    ChallengeActivity *const *first_activity = first;
+    ChallengeActivity *const *second_activity = second;
+    return strcmp(challenge_at((*first_activity)->challenge)->name,
+                  challenge_at((*second_activity)->challenge)->name);
+}
+
+/**
+ * ranks the name of the challenge of an activity among the ranked activities
+ * of its room, the ranks of the bigger names grow by one. this is O(n).
+ * @param room - ptr to the room
+ * @param activity_idx - the idx of an unranked activity with a challenge
+ */
+static void rank_activity(ChallengeRoom *room, int activity_idx) {
+    char *name = challenge_at(room->challenges[activity_idx]->challenge)->name;
+    int rank = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        if (i == activity_idx || room->packed[i].name_rank == UNDEFINED) {
+            continue;
+        }
+        int result = strcmp(challenge_at(room->challenges[i]->challenge)->name,
+                            name);
+        if (result < 0) {
+            rank++;
+        } else if (result > 0) {
+            room->packed[i].name_rank++;
+        }
+    }
+    room->packed[activity_idx].name_rank = rank;
+}
+
+/**
+ * takes the rank of an activity out of its room, the ranks of the bigger
+ * names shrink by one. this is O(n).
+ * @param room - ptr to the room
+ * @param activity_idx - the idx of the activity
+ */
+static void unrank_activity(ChallengeRoom *room, int activity_idx) {
+    int rank = room->packed[activity_idx].name_rank;
+    if (rank == UNDEFINED) {
+        return;
+    }
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        if (room->packed[i].name_rank > rank) {
+            room->packed[i].name_rank--;
+        }
+    }
+    room->packed[activity_idx].name_rank = UNDEFINED;
+}
@@ -7,36 +7,124 @@
 #include <assert.h>
 
 #include "challenge.h"
+#include "booking.h"
+#include "assignment_policy.h"
+#include "timer_wheel.h"
 
 
 struct SChallengeActivity;
+struct SChallengeRoom;
 typedef struct SVisitor
 {
   char *visitor_name;
   int visitor_id;
-  char **room_name;
-  struct SChallengeActivity *current_challenge;
+  LINK(char *) room_name;
+  LINK(struct SChallengeActivity) current_challenge;
+  LINK(struct SChallengeRoom) current_room;
+  /* set while the visitor waits in a room's queue for a free challenge */
+  LINK(struct SChallengeRoom) waiting_room;
+  Level waiting_level;
+  int waiting_since;
+  LINK(struct SVisitor) next_waiting;
+  LINK(struct SVisitor) prev_waiting;
+  /* scheduled while the visitor is in a challenge with a session limit */
+  Timer session_timer;
 } Visitor;
 
+DEFINE_LINK(Visitor, visitor)
+DEFINE_LINK(char *, room_name)
+
 
 typedef struct SChallengeActivity
 {
-   Challenge *challenge;
-   Visitor *visitor;
+   LINK(Challenge) challenge;
+   LINK(Visitor) visitor;
    int start_time;
+   BookingCalendar bookings;
+   LINK(struct SChallengeRoom) room;
+   /* the next activity of the same challenge in another room */
+   LINK(struct SChallengeActivity) next_instance;
+   int last_assigned;
+   /* the idx of the activity in the activities table of its room */
+   int idx;
+   /* scheduled at the next time a booking of the activity starts or ends */
+   Timer booking_timer;
 } ChallengeActivity;
 
+DEFINE_LINK(ChallengeActivity, activity)
+
+
+/*
+ * the fields of an activity that the scans of its room read, packed in a
+ * table of the room parallel to its activities table, so a scan stays in the
+ * room's own memory. name_rank is the num of challenges of the room with a
+ * smaller name, level is -1 for an activity without a challenge. booked is
+ * set while the window of a booking of the activity is open.
+ */
+typedef struct SPackedActivity
+{
+   int challenge_id;
+   int name_rank;
+   signed char level;
+   unsigned char occupied;
+   unsigned char booked;
+} PackedActivity;
+
+
+/*
+ * a FIFO of the visitors waiting for a challenge of one level in a room,
+ * linked through the visitors themselves
+ */
+typedef struct SWaitQueue
+{
+   LINK(Visitor) head;
+   LINK(Visitor) tail;
+   int length;
+} WaitQueue;
+
 
 typedef struct SChallengeRoom
 {
    char *name;
+   /* a stable id, kept while the room exists and never reused */
+   int id;
+   /* the idx of the room in the rooms table of the system */
+   int system_idx;
    int num_of_challenges;
-   ChallengeActivity *challenges;
+   /* a table of the activities, which are never moved once allocated */
+   ChallengeActivity **challenges;
+   PackedActivity *packed;
+   int challenges_capacity;
+   /* the sum of id_set_hash of the challenges of the activities, so a
+      reloaded file tells the rooms it changes, see reload_system */
+   unsigned long long challenge_ids_hash;
+   WaitQueue wait_queues[All_Levels + 1];
+   AssignmentIndex assignment;
+   VisitorBookings visitor_bookings;
+   /* the wheel of the system that times the booking windows of the room,
+      NULL while the room is not in a system */
+   TimerWheel *booking_timers;
 } ChallengeRoom;
 
+DEFINE_LINK(ChallengeRoom, room)
+
+
+/*
+ * walks over the occupied challenge activities of a single room
+ */
+typedef struct SRoomOccupantIterator
+{
+   ChallengeRoom *room;
+   int activity_idx;
+} RoomOccupantIterator;
+
 
 Result init_challenge_activity(ChallengeActivity *activity, Challenge *challenge);
 
+Result init_room_challenge_activity(ChallengeActivity *activity, Challenge *challenge);
+
+void link_challenge_instance(ChallengeActivity *activity);
+
 Result reset_challenge_activity(ChallengeActivity *activity);
 
 Result init_visitor(Visitor *visitor, char *name, int id);
@@ -47,17 +135,58 @@ Result init_room(ChallengeRoom *room, char *name, int num_challenges);
 
 Result reset_room(ChallengeRoom *room);
 
+Result room_attach_challenge(ChallengeRoom *room, Challenge *challenge);
+
+Result rank_room_activities(ChallengeRoom *room);
+
+Result room_detach_challenge(ChallengeRoom *room, int challenge_id);
+
+Result room_detach_activity(ChallengeActivity *activity);
+
 Result num_of_free_places_for_level(ChallengeRoom *room, Level level, int *places);
 
 Result change_room_name(ChallengeRoom *room, char *new_name);
 
 Result room_of_visitor(Visitor *visitor, char **room_name);
 
+Result set_room_assignment_policy(ChallengeRoom *room, AssignmentPolicy policy);
+
+Result refresh_challenge_activities(Challenge *challenge);
+
+Result rename_challenge_activities(Challenge *challenge);
+
+Result change_challenge_level(Challenge *challenge, Level level);
+
 Result visitor_enter_room(ChallengeRoom *room, Visitor *visitor, Level level, int start_time);
-/* the challenge to be chosen is the lexicographically named smaller one that has
-   the required level. assume all names are different. */
+/* the challenge to be chosen is the first one by the assignment policy of the
+   room (the lexicographically named smaller one by default) that has the
+   required level. a challenge the visitor booked for start_time is preferred,
+   one whose booking window is open is not free for anyone else. */
 
 Result visitor_quit_room(Visitor *visitor, int quit_time);
+/* the freed challenge is given to the visitor that waits the longest for its
+   level (or for any level) in the room, if there is one. */
+
+Result visitor_wait_for_room(ChallengeRoom *room, Visitor *visitor, Level level, int time);
+
+Result visitor_leave_wait_queue(Visitor *visitor);
+
+Result room_wait_queue_length(ChallengeRoom *room, Level level, int *length);
+
+Result visitor_wait_time(Visitor *visitor, int time, int *wait_time);
+
+Result room_book_challenge(ChallengeRoom *room, int challenge_id, int visitor_id, int start_time, int end_time);
+
+Result room_cancel_booking(ChallengeRoom *room, int challenge_id, int start_time);
+
+void room_pass_booking_boundary(ChallengeActivity *activity, int time);
+
+Result room_first_free_slot(ChallengeRoom *room, Level level, int after_time, int duration, int *slot_time, int *challenge_idx);
+
+Result init_room_occupant_iterator(RoomOccupantIterator *iterator,
+                                   ChallengeRoom *room);
+
+ChallengeActivity *room_occupant_iterator_next(RoomOccupantIterator *iterator);
 
 
 #endif // VISITOR_ROOM_H_